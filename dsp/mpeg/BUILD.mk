@@ -35,6 +35,7 @@ DSP_MPEG_A_DIRECTDEPS =				\
 	LIBC_STDIO				\
 	LIBC_STR				\
 	LIBC_SYSV				\
+	LIBC_THREAD				\
 	LIBC_TIME				\
 	LIBC_TINYMATH				\
 	THIRD_PARTY_COMPILER_RT
@@ -54,6 +55,16 @@ o/$(MODE)/dsp/mpeg/clamp4int256-k8.o: private	\
 		CFLAGS +=			\
 			-Os
 
+ifeq ($(ARCH), x86_64)
+o/$(MODE)/dsp/mpeg/idct-avx2.o			\
+o/$(MODE)/dsp/mpeg/slowrgb-avx2.o: private	\
+		TARGET_ARCH +=			\
+			-mavx2
+o/$(MODE)/dsp/mpeg/slowrgb-ssse3.o: private	\
+		TARGET_ARCH +=			\
+			-mssse3
+endif
+
 DSP_MPEG_LIBS = $(foreach x,$(DSP_MPEG_ARTIFACTS),$($(x)))
 DSP_MPEG_SRCS = $(foreach x,$(DSP_MPEG_ARTIFACTS),$($(x)_SRCS))
 DSP_MPEG_HDRS = $(foreach x,$(DSP_MPEG_ARTIFACTS),$($(x)_HDRS))
@@ -0,0 +1,72 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/idct.h"
+#include "dsp/mpeg/idct.internal.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef int v4si __attribute__((__vector_size__(16)));
+typedef int v4si_u __attribute__((__vector_size__(16), __aligned__(1)));
+
+static inline void plm_video_idct_transpose4_sse2(v4si *o, const v4si *r) {
+  v4si t0, t1, t2, t3;
+  t0 = __builtin_shufflevector(r[0], r[1], 0, 4, 1, 5);
+  t1 = __builtin_shufflevector(r[0], r[1], 2, 6, 3, 7);
+  t2 = __builtin_shufflevector(r[2], r[3], 0, 4, 1, 5);
+  t3 = __builtin_shufflevector(r[2], r[3], 2, 6, 3, 7);
+  o[0] = __builtin_shufflevector(t0, t2, 0, 1, 4, 5);
+  o[1] = __builtin_shufflevector(t0, t2, 2, 3, 6, 7);
+  o[2] = __builtin_shufflevector(t1, t3, 0, 1, 4, 5);
+  o[3] = __builtin_shufflevector(t1, t3, 2, 3, 6, 7);
+}
+
+// transposes 8x8 matrix stored as left and right halves of its rows
+static inline void plm_video_idct_transpose_sse2(v4si lo[8], v4si hi[8]) {
+  v4si a[4], b[4], c[4], d[4];
+  plm_video_idct_transpose4_sse2(a, lo);
+  plm_video_idct_transpose4_sse2(b, hi);
+  plm_video_idct_transpose4_sse2(c, lo + 4);
+  plm_video_idct_transpose4_sse2(d, hi + 4);
+  __builtin_memcpy(lo, a, sizeof(a));
+  __builtin_memcpy(hi, c, sizeof(c));
+  __builtin_memcpy(lo + 4, b, sizeof(b));
+  __builtin_memcpy(hi + 4, d, sizeof(d));
+}
+
+/**
+ * Computes 8x8 inverse DCT using two xmm registers per row.
+ *
+ * @see plm_video_idct_k8()
+ */
+void plm_video_idct_sse2(int *block) {
+  v4si_u *p = (v4si_u *)block;
+  v4si lo[8] = {p[0], p[2], p[4], p[6], p[8], p[10], p[12], p[14]};
+  v4si hi[8] = {p[1], p[3], p[5], p[7], p[9], p[11], p[13], p[15]};
+  PLM_VIDEO_IDCT_PASS(lo, 0, 0);
+  PLM_VIDEO_IDCT_PASS(hi, 0, 0);
+  plm_video_idct_transpose_sse2(lo, hi);
+  PLM_VIDEO_IDCT_PASS(lo, 128, 8);
+  PLM_VIDEO_IDCT_PASS(hi, 128, 8);
+  plm_video_idct_transpose_sse2(lo, hi);
+  p[0] = lo[0], p[2] = lo[1], p[4] = lo[2], p[6] = lo[3];
+  p[8] = lo[4], p[10] = lo[5], p[12] = lo[6], p[14] = lo[7];
+  p[1] = hi[0], p[3] = hi[1], p[5] = hi[2], p[7] = hi[3];
+  p[9] = hi[4], p[11] = hi[5], p[13] = hi[6], p[15] = hi[7];
+}
+
+#endif /* __x86_64__ */
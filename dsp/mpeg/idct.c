@@ -28,6 +28,8 @@
 │  SOFTWARE.                                                                   │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "dsp/core/half.h"
+#include "dsp/mpeg/idct.h"
+#include "libc/nexgen32e/x86feature.h"
 
 asm(".ident\t\"\\n\\n\
 PL_MPEG (MIT License)\\n\
@@ -38,9 +40,13 @@ asm(".include \"libc/disclaimer.inc\"");
 /**
  * Computes Fixed-Point 8x8 Inverse Discrete Cosine Transform.
  *
+ * This is the portable implementation. The SIMD versions compute the
+ * same columns and rows in parallel, producing bit-identical output.
+ *
  * @note discovered by Nasir Ahmed
  */
-void plm_video_idct(int block[8][8]) {
+void plm_video_idct_k8(int *p) {
+  int(*block)[8] = (int(*)[8])p;
   int i, t1, t2, m0;
   int b1, b3, b4, b6, b7;
   int y3, y4, y5, y6, y7;
@@ -104,3 +110,21 @@ void plm_video_idct(int block[8][8]) {
     block[i][7] = (y4 - b7 + 128) >> 8;
   }
 }
+
+/**
+ * Computes Fixed-Point 8x8 Inverse Discrete Cosine Transform.
+ *
+ * @param block is row-major 8x8 matrix of dequantized coefficients
+ *     which is overwritten with the reconstructed samples
+ */
+void plm_video_idct(int *block) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2)) {
+    plm_video_idct_avx2(block);
+  } else {
+    plm_video_idct_sse2(block);
+  }
+#else
+  plm_video_idct_k8(block);
+#endif
+}
@@ -3,6 +3,9 @@
 COSMOPOLITAN_C_START_
 
 void plm_video_idct(int *);
+void plm_video_idct_k8(int *);
+void plm_video_idct_sse2(int *);
+void plm_video_idct_avx2(int *);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_DSP_MPEG_IDCT_H_ */
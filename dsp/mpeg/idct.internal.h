@@ -0,0 +1,47 @@
+#ifndef COSMOPOLITAN_DSP_MPEG_IDCT_INTERNAL_H_
+#define COSMOPOLITAN_DSP_MPEG_IDCT_INTERNAL_H_
+
+/**
+ * Performs one pass of plm_video_idct_k8() on eight vectors at once.
+ *
+ * Each lane of `b[0..7]` holds one column of the pass, so a vector of
+ * eight ints computes an entire pass and four ints compute half. The
+ * arithmetic is identical to the scalar code, operation for operation,
+ * since GCC vector multiplies and shifts wrap and round the same way.
+ * The outputs are computed as `(x + R) >> S`, which lets the first pass
+ * be expressed with R=0, S=0 and the second with R=128, S=8.
+ */
+#define PLM_VIDEO_IDCT_PASS(b, R, S)                     \
+  do {                                                   \
+    __typeof__((b)[0]) b1_, b3_, b4_, b6_, b7_, t1_, t2_; \
+    __typeof__((b)[0]) m0_, x0_, x1_, x2_, x3_, x4_;      \
+    __typeof__((b)[0]) y3_, y4_, y5_, y6_, y7_;          \
+    b1_ = (b)[4];                                        \
+    b3_ = (b)[2] + (b)[6];                               \
+    b4_ = (b)[5] - (b)[3];                               \
+    t1_ = (b)[1] + (b)[7];                               \
+    t2_ = (b)[3] + (b)[5];                               \
+    b6_ = (b)[1] - (b)[7];                               \
+    b7_ = t1_ + t2_;                                     \
+    m0_ = (b)[0];                                        \
+    x4_ = ((b6_ * 473 - b4_ * 196 + 128) >> 8) - b7_;    \
+    x0_ = x4_ - (((t1_ - t2_) * 362 + 128) >> 8);        \
+    x1_ = m0_ - b1_;                                     \
+    x2_ = ((((b)[2] - (b)[6]) * 362 + 128) >> 8) - b3_;  \
+    x3_ = m0_ + b1_;                                     \
+    y3_ = x1_ + x2_;                                     \
+    y4_ = x3_ + b3_;                                     \
+    y5_ = x1_ - x2_;                                     \
+    y6_ = x3_ - b3_;                                     \
+    y7_ = -x0_ - ((b4_ * 473 + b6_ * 196 + 128) >> 8);   \
+    (b)[0] = (b7_ + y4_ + (R)) >> (S);                   \
+    (b)[1] = (x4_ + y3_ + (R)) >> (S);                   \
+    (b)[2] = (y5_ - x0_ + (R)) >> (S);                   \
+    (b)[3] = (y6_ - y7_ + (R)) >> (S);                   \
+    (b)[4] = (y6_ + y7_ + (R)) >> (S);                   \
+    (b)[5] = (x0_ + y5_ + (R)) >> (S);                   \
+    (b)[6] = (y3_ - x4_ + (R)) >> (S);                   \
+    (b)[7] = (y4_ - b7_ + (R)) >> (S);                   \
+  } while (0)
+
+#endif /* COSMOPOLITAN_DSP_MPEG_IDCT_INTERNAL_H_ */
@@ -192,6 +192,11 @@ void plm_rewind(plm_t *self);
 int plm_get_loop(plm_t *self);
 void plm_set_loop(plm_t *self, int loop);
 
+/**
+ * Set whether video slices are decoded on multiple threads. Default false.
+ */
+void plm_set_slice_threading(plm_t *self, int enabled);
+
 /**
  * Get whether the file has ended. If looping is enabled, this will always
  * return false.
@@ -379,6 +384,12 @@ int plm_video_get_height(plm_video_t *);
  */
 void plm_video_set_no_delay(plm_video_t *self, int no_delay);
 
+/**
+ * Set slice threading. When enabled, the slices of each picture are
+ * decoded concurrently on the fork-join thread pool. Default false.
+ */
+void plm_video_set_slice_threading(plm_video_t *self, int enabled);
+
 /**
  * Get the current internal time in seconds
  */
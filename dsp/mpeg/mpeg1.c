@@ -39,6 +39,7 @@
 #include "libc/math.h"
 #include "libc/mem/mem.h"
 #include "libc/str/str.h"
+#include "libc/thread/forkjoin.h"
 #include "libc/time/time.h"
 #include "libc/x/x.h"
 
@@ -489,6 +490,10 @@ void plm_video_set_no_delay(plm_video_t *self, int no_delay) {
   self->assume_no_b_frames = no_delay;
 }
 
+void plm_video_set_slice_threading(plm_video_t *self, int enabled) {
+  self->slice_threading = enabled;
+}
+
 double plm_video_get_time(plm_video_t *self) {
   return self->time;
 }
@@ -981,6 +986,93 @@ static void plm_video_decode_slice(plm_video_t *self, int slice) {
            plm_buffer_no_start_code(self->buffer));
 }
 
+#define PLM_VIDEO_MAX_SLICES 256
+
+struct plm_video_slices {
+  plm_video_t *video;
+  unsigned char *bytes;  // first byte of the first slice
+  unsigned length;       // number of bytes buffered from there
+  unsigned offset[PLM_VIDEO_MAX_SLICES];
+  unsigned char code[PLM_VIDEO_MAX_SLICES];
+};
+
+static void plm_video_decode_slice_range(void *arg, size_t lo, size_t hi) {
+  plm_buffer_t view;
+  plm_video_t video;
+  struct plm_video_slices *s = arg;
+  for (; lo < hi; ++lo) {
+    memset(&view, 0, sizeof(view));
+    view.bytes = s->bytes + s->offset[lo];
+    view.length = view.capacity = s->length - s->offset[lo];
+    view.mode = PLM_BUFFER_MODE_FIXED_MEM;
+    video = *s->video;
+    video.buffer = &view;
+    plm_video_decode_slice(&video, s->code[lo]);
+  }
+}
+
+// Buffers at least `bytes` past the read position without consuming.
+static bool plm_video_preload(plm_buffer_t *b, unsigned bytes) {
+  unsigned have;
+  for (;;) {
+    have = b->length - (b->bit_index >> 3);
+    if (have >= bytes) return true;
+    if (!b->load_callback) return false;
+    b->load_callback(b, b->load_callback_user_data);
+    if (b->length - (b->bit_index >> 3) == have) return false;
+  }
+}
+
+// Decodes slices of the current picture concurrently.
+//
+// Slices are independent within a picture: each one resets the motion
+// vectors and dc predictors, and writes its own macroblocks. We scan a
+// picture's slice start codes ahead of the read position, then decode
+// each slice on a private copy of the decoder, reading from a fixed
+// memory view of the buffer. When we return, the buffer is positioned
+// after the first start code that we didn't handle, so the serial loop
+// picks up any slice whose end we couldn't buffer.
+static void plm_video_decode_slices(plm_video_t *self) {
+  int code;
+  unsigned char *q;
+  unsigned n, p, done, end;
+  struct plm_video_slices s;
+  plm_buffer_t *b = self->buffer;
+  s.offset[0] = 0;
+  s.code[0] = self->start_code;
+  for (n = 1, p = 0;;) {
+    if (!plm_video_preload(b, p + 4)) {
+      done = n - 1;
+      end = s.offset[done];
+      code = s.code[done];
+      break;
+    }
+    q = b->bytes + (b->bit_index >> 3) + p;
+    if (q[0] == 0x00 && q[1] == 0x00 && q[2] == 0x01) {
+      code = q[3];
+      if (code < PLM_START_SLICE_FIRST || code > PLM_START_SLICE_LAST ||
+          n == PLM_VIDEO_MAX_SLICES) {
+        done = n;
+        end = p + 4;
+        break;
+      }
+      s.offset[n] = p + 4;
+      s.code[n++] = code;
+      p += 4;
+    } else {
+      ++p;
+    }
+  }
+  if (done) {
+    s.video = self;
+    s.bytes = b->bytes + (b->bit_index >> 3);
+    s.length = b->length - (b->bit_index >> 3);
+    forkjoin_for(done, 1, plm_video_decode_slice_range, &s);
+  }
+  b->bit_index += end << 3;
+  self->start_code = code;
+}
+
 static void plm_video_decode_picture(plm_video_t *self) {
   plm_buffer_skip(self->buffer, 10);  // skip temporalReference
   self->picture_type = plm_buffer_read(self->buffer, 3);
@@ -1028,6 +1120,12 @@ static void plm_video_decode_picture(plm_video_t *self) {
   } while (self->start_code == PLM_START_EXTENSION ||
            self->start_code == PLM_START_USER_DATA);
 
+  if (self->slice_threading && forkjoin_concurrency() > 1 &&
+      self->start_code >= PLM_START_SLICE_FIRST &&
+      self->start_code <= PLM_START_SLICE_LAST) {
+    plm_video_decode_slices(self);
+  }
+
   while (self->start_code >= PLM_START_SLICE_FIRST &&
          self->start_code <= PLM_START_SLICE_LAST) {
     plm_video_decode_slice(self, self->start_code & 0x000000FF);
@@ -196,6 +196,10 @@ void plm_set_loop(plm_t *self, int loop) {
 	self->loop = loop;
 }
 
+void plm_set_slice_threading(plm_t *self, int enabled) {
+	plm_video_set_slice_threading(self->video_decoder, enabled);
+}
+
 int plm_has_ended(plm_t *self) {
 	return self->has_ended;
 }
@@ -0,0 +1,51 @@
+#ifndef COSMOPOLITAN_DSP_MPEG_RGB_INTERNAL_H_
+#define COSMOPOLITAN_DSP_MPEG_RGB_INTERNAL_H_
+#include "dsp/mpeg/mpeg.h"
+COSMOPOLITAN_C_START_
+
+/**
+ * Converts leading columns of two luma rows sharing one chroma row.
+ *
+ * @param cols is the number of chroma samples in `cb` and `cr`
+ * @return number of chroma samples converted, which the caller must
+ *     finish itself; each one covers 2 pixels (6 bytes) per row
+ */
+typedef int plm_rows_to_rgb_f(uint8_t *, uint8_t *, const uint8_t *,
+                              const uint8_t *, const uint8_t *,
+                              const uint8_t *, int);
+
+plm_rows_to_rgb_f plm_rows_to_rgb_ssse3;
+plm_rows_to_rgb_f plm_rows_to_rgb_avx2;
+
+void plm_frame_to_rgb_with(plm_frame_t *, uint8_t *, plm_rows_to_rgb_f *);
+
+#ifdef __SSSE3__
+typedef char plm_xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+
+/**
+ * Interleaves sixteen pixels of planar RGB into 48 bytes of RGB24.
+ */
+static inline void plm_interleave_rgb(uint8_t *o, plm_xmm_t r, plm_xmm_t g,
+                                      plm_xmm_t b) {
+  static const plm_xmm_t kShuf[3][3] = /* clang-format off */ {
+    {{0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128, -128, 5},
+     {-128, 0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128, -128},
+     {-128, -128, 0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128}},
+    {{-128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128, 10, -128},
+     {5, -128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128, 10},
+     {-128, 5, -128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128}},
+    {{-128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15, -128, -128},
+     {-128, -128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15, -128},
+     {10, -128, -128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15}},
+  } /* clang-format on */;
+  int i;
+  for (i = 0; i < 3; ++i) {
+    *(plm_xmm_t *)(o + i * 16) = __builtin_ia32_pshufb128(r, kShuf[i][0]) |
+                                 __builtin_ia32_pshufb128(g, kShuf[i][1]) |
+                                 __builtin_ia32_pshufb128(b, kShuf[i][2]);
+  }
+}
+#endif /* __SSSE3__ */
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_DSP_MPEG_RGB_INTERNAL_H_ */
@@ -0,0 +1,99 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/rgb.internal.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef unsigned char u8x16
+    __attribute__((__vector_size__(16), __aligned__(1)));
+typedef unsigned char u8x32
+    __attribute__((__vector_size__(32), __aligned__(1)));
+typedef unsigned short u16x16 __attribute__((__vector_size__(32)));
+typedef short s16x16 __attribute__((__vector_size__(32)));
+typedef char s8x32 __attribute__((__vector_size__(32)));
+typedef long long s64x4 __attribute__((__vector_size__(32)));
+
+static plm_xmm_t plm_pack_avx2(s16x16 lo, s16x16 hi, int i) {
+  s8x32 v;
+  // vpackuswb works within lanes so put the quadwords back in order
+  v = (s8x32)__builtin_ia32_permdi256(
+      (s64x4)__builtin_ia32_packuswb256(lo, hi), 0xD8);
+  return i ? __builtin_shufflevector(v, v, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+                                     25, 26, 27, 28, 29, 30, 31)
+           : __builtin_shufflevector(v, v, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                     11, 12, 13, 14, 15);
+}
+
+static void plm_row_to_rgb_avx2(uint8_t *o, const uint8_t *y, s16x16 rl,
+                                s16x16 rh, s16x16 gl, s16x16 gh, s16x16 bl,
+                                s16x16 bh) {
+  int i;
+  u8x32 v;
+  s16x16 yl, yh;
+  v = *(const u8x32 *)y;
+  yl = (s16x16)__builtin_convertvector(
+      __builtin_shufflevector(v, v, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                              13, 14, 15),
+      u16x16);
+  yh = (s16x16)__builtin_convertvector(
+      __builtin_shufflevector(v, v, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26,
+                              27, 28, 29, 30, 31),
+      u16x16);
+  for (i = 0; i < 2; ++i) {
+    plm_interleave_rgb(o + i * 48, plm_pack_avx2(yl + rl, yh + rh, i),
+                       plm_pack_avx2(yl - gl, yh - gh, i),
+                       plm_pack_avx2(yl + bl, yh + bh, i));
+  }
+}
+
+/**
+ * Converts YCbCr to RGB, thirty-two pixels by two rows at a time.
+ *
+ * @see plm_rows_to_rgb_ssse3()
+ */
+int plm_rows_to_rgb_avx2(uint8_t *rgb1, uint8_t *rgb2, const uint8_t *y1,
+                         const uint8_t *y2, const uint8_t *cb,
+                         const uint8_t *cr, int cols) {
+  int i;
+  u16x16 ccb, ccr;
+  s16x16 r, g, b, rl, rh, gl, gh, bl, bh;
+  for (i = 0; i + 16 <= cols; i += 16) {
+    ccb = __builtin_convertvector(*(const u8x16 *)(cb + i), u16x16);
+    ccr = __builtin_convertvector(*(const u8x16 *)(cr + i), u16x16);
+    r = (s16x16)(ccr + ((ccr * 103) >> 8)) - 179;
+    g = (s16x16)((ccb * 88) >> 8) + (s16x16)((ccr * 183) >> 8) - 135;
+    b = (s16x16)(ccb + ((ccb * 198) >> 8)) - 227;
+    rl = __builtin_shufflevector(r, r, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                 6, 7, 7);
+    rh = __builtin_shufflevector(r, r, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13,
+                                 13, 14, 14, 15, 15);
+    gl = __builtin_shufflevector(g, g, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                 6, 7, 7);
+    gh = __builtin_shufflevector(g, g, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13,
+                                 13, 14, 14, 15, 15);
+    bl = __builtin_shufflevector(b, b, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                 6, 7, 7);
+    bh = __builtin_shufflevector(b, b, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13,
+                                 13, 14, 14, 15, 15);
+    plm_row_to_rgb_avx2(rgb1 + i * 6, y1 + i * 2, rl, rh, gl, gh, bl, bh);
+    plm_row_to_rgb_avx2(rgb2 + i * 6, y2 + i * 2, rl, rh, gl, gh, bl, bh);
+  }
+  return i;
+}
+
+#endif /* __x86_64__ */
@@ -0,0 +1,74 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/rgb.internal.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef unsigned char u8x8 __attribute__((__vector_size__(8), __aligned__(1)));
+typedef unsigned char u8x16
+    __attribute__((__vector_size__(16), __aligned__(1)));
+typedef unsigned short u16x8 __attribute__((__vector_size__(16)));
+typedef short s16x8 __attribute__((__vector_size__(16)));
+
+static void plm_row_to_rgb_ssse3(uint8_t *o, const uint8_t *y, s16x8 rl,
+                                 s16x8 rh, s16x8 gl, s16x8 gh, s16x8 bl,
+                                 s16x8 bh) {
+  u8x16 v;
+  s16x8 yl, yh;
+  v = *(const u8x16 *)y;
+  yl = (s16x8)__builtin_convertvector(
+      __builtin_shufflevector(v, v, 0, 1, 2, 3, 4, 5, 6, 7), u16x8);
+  yh = (s16x8)__builtin_convertvector(
+      __builtin_shufflevector(v, v, 8, 9, 10, 11, 12, 13, 14, 15), u16x8);
+  plm_interleave_rgb(o, __builtin_ia32_packuswb128(yl + rl, yh + rh),
+                     __builtin_ia32_packuswb128(yl - gl, yh - gh),
+                     __builtin_ia32_packuswb128(yl + bl, yh + bh));
+}
+
+/**
+ * Converts YCbCr to RGB, sixteen pixels by two rows at a time.
+ *
+ * The chroma terms are computed exactly as plm_frame_to_rgb() does in
+ * sixteen-bit lanes, where no product overflows, and PACKUSWB performs
+ * the clamping to [0,255], so output is identical to the scalar code.
+ */
+int plm_rows_to_rgb_ssse3(uint8_t *rgb1, uint8_t *rgb2, const uint8_t *y1,
+                          const uint8_t *y2, const uint8_t *cb,
+                          const uint8_t *cr, int cols) {
+  int i;
+  u16x8 ccb, ccr;
+  s16x8 r, g, b, rl, rh, gl, gh, bl, bh;
+  for (i = 0; i + 8 <= cols; i += 8) {
+    ccb = __builtin_convertvector(*(const u8x8 *)(cb + i), u16x8);
+    ccr = __builtin_convertvector(*(const u8x8 *)(cr + i), u16x8);
+    r = (s16x8)(ccr + ((ccr * 103) >> 8)) - 179;
+    g = (s16x8)((ccb * 88) >> 8) + (s16x8)((ccr * 183) >> 8) - 135;
+    b = (s16x8)(ccb + ((ccb * 198) >> 8)) - 227;
+    rl = __builtin_shufflevector(r, r, 0, 0, 1, 1, 2, 2, 3, 3);
+    rh = __builtin_shufflevector(r, r, 4, 4, 5, 5, 6, 6, 7, 7);
+    gl = __builtin_shufflevector(g, g, 0, 0, 1, 1, 2, 2, 3, 3);
+    gh = __builtin_shufflevector(g, g, 4, 4, 5, 5, 6, 6, 7, 7);
+    bl = __builtin_shufflevector(b, b, 0, 0, 1, 1, 2, 2, 3, 3);
+    bh = __builtin_shufflevector(b, b, 4, 4, 5, 5, 6, 6, 7, 7);
+    plm_row_to_rgb_ssse3(rgb1 + i * 6, y1 + i * 2, rl, rh, gl, gh, bl, bh);
+    plm_row_to_rgb_ssse3(rgb2 + i * 6, y2 + i * 2, rl, rh, gl, gh, bl, bh);
+  }
+  return i;
+}
+
+#endif /* __x86_64__ */
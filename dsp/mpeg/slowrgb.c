@@ -28,7 +28,9 @@
 │  SOFTWARE.                                                                   │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "dsp/mpeg/mpeg.h"
+#include "dsp/mpeg/rgb.internal.h"
 #include "libc/macros.internal.h"
+#include "libc/nexgen32e/x86feature.h"
 
 asm(".ident\t\"\\n\\n\
 PL_MPEG (MIT License)\\n\
@@ -37,9 +39,13 @@ https://phoboslab.org\"");
 asm(".include \"libc/disclaimer.inc\"");
 
 /**
+ * Converts frame to RGB using `kernel` for the bulk of each row pair.
+ *
+ * @param kernel may be NULL to convert every pixel with scalar code
  * @see YCbCr2RGB() in tool/viz/lib/ycbcr2rgb.c
  */
-void plm_frame_to_rgb(plm_frame_t *frame, uint8_t *rgb) {
+void plm_frame_to_rgb_with(plm_frame_t *frame, uint8_t *rgb,
+                           plm_rows_to_rgb_f *kernel) {
   // Chroma values are the same for each block of 4 pixels, so we process
   // 2 lines at a time, 2 neighboring pixels each.
   int w = frame->y.width, w2 = w >> 1;
@@ -51,7 +57,17 @@ void plm_frame_to_rgb(plm_frame_t *frame, uint8_t *rgb) {
   int ccb, ccr, r, g, b;
   uint8_t *y = frame->y.data, *cb = frame->cb.data, *cr = frame->cr.data;
   for (int row = 0; row < rows; row++) {
-    for (int col = 0; col < cols; col++) {
+    int col = 0;
+    if (kernel) {
+      col = kernel(rgb + rgb_index1, rgb + rgb_index2, y + y_index1,
+                   y + y_index2, cb + c_index, cr + c_index, cols);
+      y_index1 += col * 2;
+      y_index2 += col * 2;
+      c_index += col;
+      rgb_index1 += col * 6;
+      rgb_index2 += col * 6;
+    }
+    for (; col < cols; col++) {
       ccb = cb[c_index];
       ccr = cr[c_index];
       c_index++;
@@ -86,3 +102,15 @@ void plm_frame_to_rgb(plm_frame_t *frame, uint8_t *rgb) {
     c_index += c_next_line;
   }
 }
+
+void plm_frame_to_rgb(plm_frame_t *frame, uint8_t *rgb) {
+  plm_rows_to_rgb_f *kernel = 0;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2)) {
+    kernel = plm_rows_to_rgb_avx2;
+  } else if (X86_HAVE(SSSE3)) {
+    kernel = plm_rows_to_rgb_ssse3;
+  }
+#endif
+  plm_frame_to_rgb_with(frame, rgb, kernel);
+}
@@ -49,6 +49,7 @@ typedef struct plm_video_t {
   uint8_t non_intra_quant_matrix[64];
   int has_reference_frame;
   int assume_no_b_frames;
+  int slice_threading;
 } plm_video_t;
 
 void plm_video_process_macroblock_8(plm_video_t *, uint8_t *restrict,
@@ -31,6 +31,7 @@ DSP_SCALE_A_DIRECTDEPS =			\
 	LIBC_NEXGEN32E				\
 	LIBC_RUNTIME				\
 	LIBC_STR				\
+	LIBC_THREAD				\
 	LIBC_TIME				\
 	LIBC_TINYMATH				\
 	LIBC_X
@@ -48,11 +49,18 @@ $(DSP_SCALE_A).pkg:				\
 
 o/$(MODE)/dsp/scale/cdecimate2xuint8x8.o	\
 o/$(MODE)/dsp/scale/gyarados.o			\
+o/$(MODE)/dsp/scale/gyarados-avx2.o		\
 o/$(MODE)/dsp/scale/magikarp.o			\
 o/$(MODE)/dsp/scale/scale.o: private		\
 		CFLAGS +=			\
 			$(MATHEMATICAL)
 
+ifeq ($(ARCH), x86_64)
+o/$(MODE)/dsp/scale/gyarados-avx2.o: private	\
+		TARGET_ARCH +=			\
+			-mavx2
+endif
+
 DSP_SCALE_LIBS = $(foreach x,$(DSP_SCALE_ARTIFACTS),$($(x)))
 DSP_SCALE_SRCS = $(foreach x,$(DSP_SCALE_ARTIFACTS),$($(x)_SRCS))
 DSP_SCALE_HDRS = $(foreach x,$(DSP_SCALE_ARTIFACTS),$($(x)_HDRS))
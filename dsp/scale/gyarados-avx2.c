@@ -0,0 +1,107 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/core/q.h"
+#include "dsp/scale/gyarados.internal.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+#define M 14
+
+typedef int i32x4 __attribute__((__vector_size__(16)));
+typedef int i32x4_u __attribute__((__vector_size__(16), __aligned__(1)));
+typedef int i32x8 __attribute__((__vector_size__(32)));
+typedef int i32x8_u __attribute__((__vector_size__(32), __aligned__(1)));
+
+/**
+ * Computes one row of the vertical pass, sixteen columns at a time.
+ *
+ * @see GyaradosVertical()
+ */
+void GyaradosVerticalAvx2(int *r, long n, const int *s, long stride,
+                          const short *y, const short *w, long k) {
+  long i, x;
+  const int *p;
+  i32x8 a, b;
+  for (x = 0; x + 16 <= n; x += 16) {
+    a = b = (i32x8){0};
+    for (i = 0; i < k; ++i) {
+      p = s + y[i] * stride + x;
+      a += w[i] * *(const i32x8_u *)p;
+      b += w[i] * *(const i32x8_u *)(p + 8);
+    }
+    *(i32x8_u *)(r + x) = (a + (1 << (M - 1))) >> M;
+    *(i32x8_u *)(r + x + 8) = (b + (1 << (M - 1))) >> M;
+  }
+  if (x + 8 <= n) {
+    a = (i32x8){0};
+    for (i = 0; i < k; ++i) {
+      a += w[i] * *(const i32x8_u *)(s + y[i] * stride + x);
+    }
+    *(i32x8_u *)(r + x) = (a + (1 << (M - 1))) >> M;
+    x += 8;
+  }
+  if (x < n) {
+    GyaradosVertical(r + x, n - x, s + x, stride, y, w, k);
+  }
+}
+
+/**
+ * Computes one row of the horizontal pass.
+ *
+ * When there are four taps, which is always the case when enlarging,
+ * two outputs are computed per ymm register.
+ *
+ * @see GyaradosHorizontal()
+ */
+void GyaradosHorizontalAvx2(int *r, long n, const int *p, const int *first,
+                            const int *t, long w) {
+  long i, x;
+  i32x4 c;
+  i32x8 a, u, v;
+  if (w == 4) {
+    for (x = 0; x + 2 <= n; x += 2, t += 8) {
+      u = *(const i32x8_u *)t;
+      v = __builtin_shufflevector(*(const i32x4_u *)(p + first[x]),
+                                  *(const i32x4_u *)(p + first[x + 1]), 0, 1,
+                                  2, 3, 4, 5, 6, 7);
+      a = u * v;
+      a += __builtin_shufflevector(a, a, 2, 3, 0, 1, 6, 7, 4, 5);
+      a += __builtin_shufflevector(a, a, 1, 0, 3, 2, 5, 4, 7, 6);
+      r[x + 0] = QRS(M, a[0]);
+      r[x + 1] = QRS(M, a[4]);
+    }
+  } else {
+    for (x = 0; x < n; ++x, t += w) {
+      a = (i32x8){0};
+      for (i = 0; i + 8 <= w; i += 8) {
+        a += *(const i32x8_u *)(t + i) * *(const i32x8_u *)(p + first[x] + i);
+      }
+      c = __builtin_shufflevector(a, a, 0, 1, 2, 3) +
+          __builtin_shufflevector(a, a, 4, 5, 6, 7);
+      if (i < w) {
+        c += *(const i32x4_u *)(t + i) * *(const i32x4_u *)(p + first[x] + i);
+      }
+      r[x] = QRS(M, c[0] + c[1] + c[2] + c[3]);
+    }
+  }
+  if (x < n) {
+    GyaradosHorizontal(r + x, n - x, p, first + x, t, w);
+  }
+}
+
+#endif /* __x86_64__ */
@@ -21,6 +21,7 @@
 #include "dsp/core/ituround.h"
 #include "dsp/core/q.h"
 #include "dsp/core/twixt8.h"
+#include "dsp/scale/gyarados.internal.h"
 #include "libc/intrin/bsr.h"
 #include "libc/limits.h"
 #include "libc/log/check.h"
@@ -29,8 +30,11 @@
 #include "libc/math.h"
 #include "libc/mem/gc.internal.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "libc/testlib/testlib.h"
+#include "libc/thread/forkjoin.h"
+#include "libc/thread/thread.h"
 #include "libc/x/x.h"
 #include "tool/viz/lib/knobs.h"
 
@@ -44,12 +48,50 @@
 #define M      14
 #define SQR(X) ((X) * (X))
 
+typedef int i32x4 __attribute__((__vector_size__(16)));
+typedef int i32x4_u __attribute__((__vector_size__(16), __aligned__(1)));
+
+/**
+ * Output area below which we won't bother handing bands to other cores.
+ */
+#define GYARADOS_PARALLEL_PIXELS 65536
+
 struct SamplingSolution {
-  int n, s;
-  void *weights;
-  void *indices;
+  int n, s;       /* n outputs, each reading at most s source samples */
+  int w, lo, hi;  /* taps per output in `taps` and range of `first` + w */
+  void *weights;  /* short[n][s] */
+  void *indices;  /* short[n][s] clamped to [0,sn) */
+  int *first;     /* int[n] unclamped source position of first tap */
+  int *count;     /* int[n] number of leading entries that are used */
+  int *taps;      /* int[n][w] weights zero padded to vector width */
+  long dn, sn;    /* arguments to ComputeSamplingSolution() */
+  double dar, off, par;
+  int refs;
 };
 
+struct Gyarados {
+  long sxw, dxw;
+  long dyn, dxn, sxn;
+  const int *src;
+  void *dst;
+  const unsigned char *tout;
+  const struct SamplingSolution *cy, *cx;
+  bool sharpen;
+  void (*vertical)(int *, long, const int *, long, const short *,
+                   const short *, long);
+  void (*horizontal)(int *, long, const int *, const int *, const int *,
+                     long);
+};
+
+static struct {
+  pthread_mutex_t lock;
+  struct SamplingSolution *cache[8];
+  struct {
+    void *p;
+    size_t n;
+  } scratch[4];
+} g_gyarados = {PTHREAD_MUTEX_INITIALIZER};
+
 static double ComputeWeight(double x) {
   if (-1.5 < x && x < 1.5) {
     if (-.5 < x && x < .5) {
@@ -69,8 +111,11 @@ static struct SamplingSolution *NewSamplingSolution(long n, long s) {
   ss = xcalloc(1, sizeof(struct SamplingSolution));
   ss->n = n;
   ss->s = s;
+  ss->refs = 1;
   ss->weights = xcalloc(n * s, sizeof(short));
   ss->indices = xcalloc(n * s, sizeof(short));
+  ss->first = xcalloc(n, sizeof(int));
+  ss->count = xcalloc(n, sizeof(int));
   return ss;
 }
 
@@ -81,42 +126,72 @@ static bool IsNormalized(int n, double A[n]) {
   return fabs(x - 1) < 1e-4;
 }
 
+static void DestroySamplingSolution(struct SamplingSolution *ss) {
+  free(ss->taps);
+  free(ss->count);
+  free(ss->first);
+  free(ss->indices);
+  free(ss->weights);
+  free(ss);
+}
+
+/**
+ * Releases reference to sampling solution.
+ */
 void FreeSamplingSolution(struct SamplingSolution *ss) {
+  bool last;
   if (ss) {
-    free(ss->indices);
-    free(ss->weights);
-    free(ss);
+    pthread_mutex_lock(&g_gyarados.lock);
+    last = !--ss->refs;
+    pthread_mutex_unlock(&g_gyarados.lock);
+    if (last) DestroySamplingSolution(ss);
   }
 }
 
+/**
+ * Precomputes filter taps for resampling one dimension.
+ *
+ * The result may be reused for any number of images or channels having
+ * the same dimensions, and must be released with FreeSamplingSolution()
+ */
 struct SamplingSolution *ComputeSamplingSolution(long dn, long sn, double dar,
                                                  double off, double par) {
+  int *taps;
   double *fweights;
   double sum, hw, x, f;
   short *weights, *indices;
   struct SamplingSolution *res;
-  long j, i, k, n, min, max, s, N[6];
+  long j, i, k, n, w, min, max, s, N[6];
+  double dar0 = dar, off0 = off;
   if (!dar) dar = sn, dar /= dn;
   if (!off) off = (dar - 1) / 2;
   f = dar < 1 ? 1 / dar : dar;
   s = 3 * f + 4;
   fweights = gc(xcalloc(s + /*xxx*/ 2, sizeof(double)));
   res = NewSamplingSolution(dn, s);
+  res->dn = dn;
+  res->sn = sn;
+  res->dar = dar0;
+  res->off = off0;
+  res->par = par;
   weights = res->weights;
   indices = res->indices;
-  for (i = 0; i < dn; ++i) {
+  for (w = i = 0; i < dn; ++i) {
     x = off + i * dar;
     hw = 1.5 * f;
     min = ceil(x - hw);
     max = floor(x + hw);
     n = max - min + 1;
     CHECK_LE(n, s);
+    w = MAX(w, n);
     for (k = 0, j = min; j <= max; ++j) {
       fweights[k++] = ComputeWeight((j - x) / (f / par));
     }
     for (sum = k = 0; k < n; ++k) sum += fweights[k];
     for (j = 0; j < n; ++j) fweights[j] *= 1 / sum;
     DCHECK(IsNormalized(n, fweights));
+    res->first[i] = min;
+    res->count[i] = n;
     for (j = 0; j < n; ++j) {
       indices[i * s + j] = MIN(sn - 1, MAX(0, min + j));
     }
@@ -127,9 +202,118 @@ struct SamplingSolution *ComputeSamplingSolution(long dn, long sn, double dar,
       }
     }
   }
+  w = ROUNDUP(MAX(1, w), 4);
+  taps = res->taps = xcalloc(MAX(1, dn) * w, sizeof(int));
+  res->w = w;
+  res->lo = dn ? INT_MAX : 0;
+  res->hi = dn ? INT_MIN : 0;
+  for (i = 0; i < dn; ++i) {
+    res->lo = MIN(res->lo, res->first[i]);
+    res->hi = MAX(res->hi, res->first[i] + w);
+    for (j = 0; j < s && j < w; ++j) {
+      taps[i * w + j] = weights[i * s + j];
+    }
+  }
   return res;
 }
 
+static struct SamplingSolution *GetSamplingSolution(long dn, long sn,
+                                                    double dar, double off,
+                                                    double par) {
+  long i;
+  struct SamplingSolution *ss, *evict;
+  pthread_mutex_lock(&g_gyarados.lock);
+  for (i = 0; i < ARRAYLEN(g_gyarados.cache); ++i) {
+    if ((ss = g_gyarados.cache[i]) && ss->dn == dn && ss->sn == sn &&
+        ss->dar == dar && ss->off == off && ss->par == par) {
+      memmove(g_gyarados.cache + 1, g_gyarados.cache, i * sizeof(ss));
+      g_gyarados.cache[0] = ss;
+      ++ss->refs;
+      pthread_mutex_unlock(&g_gyarados.lock);
+      return ss;
+    }
+  }
+  pthread_mutex_unlock(&g_gyarados.lock);
+  ss = ComputeSamplingSolution(dn, sn, dar, off, par);
+  pthread_mutex_lock(&g_gyarados.lock);
+  ++ss->refs;
+  evict = g_gyarados.cache[ARRAYLEN(g_gyarados.cache) - 1];
+  memmove(g_gyarados.cache + 1, g_gyarados.cache,
+          (ARRAYLEN(g_gyarados.cache) - 1) * sizeof(ss));
+  g_gyarados.cache[0] = ss;
+  if (evict && --evict->refs) evict = 0;
+  pthread_mutex_unlock(&g_gyarados.lock);
+  if (evict) DestroySamplingSolution(evict);
+  return ss;
+}
+
+static void *TakeScratch(size_t n) {
+  long i;
+  void *p;
+  pthread_mutex_lock(&g_gyarados.lock);
+  for (i = 0; i < ARRAYLEN(g_gyarados.scratch); ++i) {
+    if ((p = g_gyarados.scratch[i].p) && g_gyarados.scratch[i].n >= n) {
+      g_gyarados.scratch[i].p = 0;
+      pthread_mutex_unlock(&g_gyarados.lock);
+      return p;
+    }
+  }
+  pthread_mutex_unlock(&g_gyarados.lock);
+  return xmemalign(64, n);
+}
+
+static void GiveScratch(void *p, size_t n) {
+  long i, j;
+  void *q;
+  pthread_mutex_lock(&g_gyarados.lock);
+  for (j = i = 0; i < ARRAYLEN(g_gyarados.scratch); ++i) {
+    if (!g_gyarados.scratch[i].p) {
+      j = i;
+      break;
+    }
+    if (g_gyarados.scratch[i].n < g_gyarados.scratch[j].n) {
+      j = i;
+    }
+  }
+  if (!g_gyarados.scratch[j].p || g_gyarados.scratch[j].n <= n) {
+    q = g_gyarados.scratch[j].p;
+    g_gyarados.scratch[j].p = p;
+    g_gyarados.scratch[j].n = n;
+    p = q;
+  }
+  pthread_mutex_unlock(&g_gyarados.lock);
+  free(p);
+}
+
+/**
+ * Frees sampling solutions and scratch memory Gyarados has held onto.
+ *
+ * Solutions still referenced by a caller stay alive until they're
+ * released with FreeSamplingSolution().
+ */
+void FreeGyaradosCache(void) {
+  long i;
+  void *scratch[ARRAYLEN(g_gyarados.scratch)];
+  struct SamplingSolution *cache[ARRAYLEN(g_gyarados.cache)];
+  pthread_mutex_lock(&g_gyarados.lock);
+  for (i = 0; i < ARRAYLEN(cache); ++i) {
+    if ((cache[i] = g_gyarados.cache[i]) && --cache[i]->refs) cache[i] = 0;
+    g_gyarados.cache[i] = 0;
+  }
+  for (i = 0; i < ARRAYLEN(scratch); ++i) {
+    scratch[i] = g_gyarados.scratch[i].p;
+    g_gyarados.scratch[i].p = 0;
+    g_gyarados.scratch[i].n = 0;
+  }
+  pthread_mutex_unlock(&g_gyarados.lock);
+  for (i = 0; i < ARRAYLEN(cache); ++i) {
+    if (cache[i]) DestroySamplingSolution(cache[i]);
+  }
+  for (i = 0; i < ARRAYLEN(scratch); ++i) {
+    free(scratch[i]);
+  }
+}
+
 static void *ZeroMatrix(long yw, long xw, int p[yw][xw], long yn, long xn) {
   long y;
   for (y = 0; y < yn; ++y) {
@@ -142,53 +326,195 @@ static int Sharpen(int ax, int bx, int cx) {
   return (-1 * ax + 6 * bx + -1 * cx + 2) / 4;
 }
 
-static void GyaradosImpl(long dyw, long dxw, int dst[dyw][dxw], long syw,
-                         long sxw, const int src[syw][sxw], long dyn, long dxn,
-                         long syn, long sxn, int tmp0[restrict dyn][sxn],
-                         int tmp1[restrict dyn][sxn],
-                         int tmp2[restrict dyn][dxn], long yfn, long xfn,
-                         const short fyi[dyn][yfn], const short fyw[dyn][yfn],
-                         const short fxi[dxn][xfn], const short fxw[dxn][xfn],
-                         bool sharpen) {
-  long i;
-  int eax, dy, dx, sx;
-  for (sx = 0; sx < sxn; ++sx) {
-    for (dy = 0; dy < dyn; ++dy) {
-      for (eax = i = 0; i < yfn; ++i) {
-        eax += fyw[dy][i] * src[fyi[dy][i]][sx];
-      }
-      tmp0[dy][sx] = QRS(M, eax);
+/**
+ * Computes one row of the vertical pass.
+ *
+ *     r[x] = (Σᵢ w[i] × s[y[i]][x] + 2¹³) >> 14
+ *
+ * @param r receives n ints
+ * @param s is source plane whose rows are stride ints apart
+ * @param y has the k source rows to blend
+ * @param w has the k Q14 weights
+ */
+void GyaradosVertical(int *r, long n, const int *s, long stride,
+                      const short *y, const short *w, long k) {
+  long i, x;
+  i32x4 acc;
+  for (x = 0; x + 8 <= n; x += 8) {
+    i32x4 a = {0}, b = {0};
+    for (i = 0; i < k; ++i) {
+      a += w[i] * *(const i32x4_u *)(s + y[i] * stride + x);
+      b += w[i] * *(const i32x4_u *)(s + y[i] * stride + x + 4);
     }
+    *(i32x4_u *)(r + x) = (a + (1 << (M - 1))) >> M;
+    *(i32x4_u *)(r + x + 4) = (b + (1 << (M - 1))) >> M;
   }
-  for (dy = 0; dy < dyn; ++dy) {
-    for (sx = 0; sx < sxn; ++sx) {
-      tmp1[dy][sx] = sharpen ? Sharpen(tmp0[MIN(dyn - 1, MAX(0, dy - 1))][sx],
-                                       tmp0[dy][sx],
-                                       tmp0[MIN(dyn - 1, MAX(0, dy + 1))][sx])
-                             : tmp0[dy][sx];
+  for (; x + 4 <= n; x += 4) {
+    acc = (i32x4){0};
+    for (i = 0; i < k; ++i) {
+      acc += w[i] * *(const i32x4_u *)(s + y[i] * stride + x);
     }
+    *(i32x4_u *)(r + x) = (acc + (1 << (M - 1))) >> M;
   }
-  for (dx = 0; dx < dxn; ++dx) {
-    for (dy = 0; dy < dyn; ++dy) {
-      for (eax = i = 0; i < xfn; ++i) {
-        eax += fxw[dx][i] * tmp1[dy][fxi[dx][i]];
-      }
-      tmp2[dy][dx] = QRS(M, eax);
+  for (; x < n; ++x) {
+    int eax = 0;
+    for (i = 0; i < k; ++i) {
+      eax += w[i] * s[y[i] * stride + x];
     }
+    r[x] = QRS(M, eax);
   }
-  for (dx = 0; dx < dxn; ++dx) {
-    for (dy = 0; dy < dyn; ++dy) {
-      dst[dy][dx] = sharpen ? Sharpen(tmp2[dy][MIN(dxn - 1, MAX(0, dx - 1))],
-                                      tmp2[dy][dx],
-                                      tmp2[dy][MIN(dxn - 1, MAX(0, dx + 1))])
-                            : tmp2[dy][dx];
+}
+
+/**
+ * Computes one row of the horizontal pass.
+ *
+ *     r[x] = (Σᵢ t[x][i] × p[first[x] + i] + 2¹³) >> 14
+ *
+ * @param r receives n ints
+ * @param p is source row, indexable over [lo,hi) of the solution
+ * @param t has n×w taps where w is a multiple of four
+ */
+void GyaradosHorizontal(int *r, long n, const int *p, const int *first,
+                        const int *t, long w) {
+  long i, x;
+  i32x4 acc;
+  for (x = 0; x < n; ++x, t += w) {
+    acc = (i32x4){0};
+    for (i = 0; i < w; i += 4) {
+      acc += *(const i32x4_u *)(t + i) * *(const i32x4_u *)(p + first[x] + i);
+    }
+    r[x] = QRS(M, acc[0] + acc[1] + acc[2] + acc[3]);
+  }
+}
+
+/**
+ * Applies the 3-tap sharpen filter elementwise to three rows.
+ */
+void GyaradosSharpen(int *r, long n, const int *a, const int *b,
+                     const int *c) {
+  long x;
+  for (x = 0; x + 4 <= n; x += 4) {
+    *(i32x4_u *)(r + x) = (-*(const i32x4_u *)(a + x) +
+                           6 * *(const i32x4_u *)(b + x) -
+                           *(const i32x4_u *)(c + x) + 2) /
+                          4;
+  }
+  for (; x < n; ++x) {
+    r[x] = Sharpen(a[x], b[x], c[x]);
+  }
+}
+
+static void GyaradosBand(void *arg, size_t y0, size_t y1) {
+  long i, j, k, dy, x, sn, rn, pn, need, have[3];
+  int *buf, *ring[3], *row, *pad, *hor, *out, *dst;
+  const struct Gyarados *g = arg;
+  const struct SamplingSolution *cy = g->cy;
+  const struct SamplingSolution *cx = g->cx;
+  sn = MIN(cx->sn, g->sxn);
+  rn = ROUNDUP(MAX(g->sxn, g->dxn) + 2, 16);
+  pn = ROUNDUP(cx->hi - cx->lo, 16);
+  need = (5 * rn + pn) * sizeof(int);
+  buf = TakeScratch(need);
+  for (i = 0; i < 3; ++i) {
+    ring[i] = buf + i * rn;
+    have[i] = -1;
+  }
+  hor = buf + 3 * rn;
+  out = buf + 4 * rn;
+  pad = buf + 5 * rn;
+  for (dy = y0; dy < y1; ++dy) {
+    long ys[3] = {MAX(0, dy - 1), dy, MIN(g->dyn - 1, dy + 1)};
+    for (j = !g->sharpen; j < (g->sharpen ? 3 : 2); ++j) {
+      if (have[(k = ys[j] % 3)] != ys[j]) {
+        g->vertical(ring[k], g->sxn, g->src, g->sxw,
+                    (short *)cy->indices + ys[j] * cy->s,
+                    (short *)cy->weights + ys[j] * cy->s, cy->count[ys[j]]);
+        have[k] = ys[j];
+      }
+    }
+    if (g->sharpen) {
+      GyaradosSharpen(out, g->sxn, ring[ys[0] % 3], ring[ys[1] % 3],
+                      ring[ys[2] % 3]);
+      row = out;
+    } else {
+      row = ring[ys[1] % 3];
+    }
+    for (x = cx->lo; x < cx->hi; ++x) {
+      pad[x - cx->lo] = row[MIN(sn - 1, MAX(0, x))];
+    }
+    g->horizontal(hor + 1, g->dxn, pad - cx->lo, cx->first, cx->taps, cx->w);
+    dst = g->tout ? out : (int *)g->dst + dy * g->dxw;
+    if (g->sharpen) {
+      hor[0] = hor[1];
+      hor[g->dxn + 1] = hor[g->dxn];
+      GyaradosSharpen(dst, g->dxn, hor, hor + 1, hor + 2);
+    } else {
+      memcpy(dst, hor + 1, g->dxn * sizeof(int));
+    }
+    if (g->tout) {
+      unsigned char *d = (unsigned char *)g->dst + dy * g->dxw;
+      for (x = 0; x < g->dxn; ++x) {
+        d[x] = g->tout[MIN(32767, MAX(0, dst[x]))];
+      }
     }
   }
+  GiveScratch(buf, need);
+}
+
+static void GyaradosRun(struct Gyarados *g) {
+  long grain;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2)) {
+    g->vertical = GyaradosVerticalAvx2;
+    g->horizontal = GyaradosHorizontalAvx2;
+  } else {
+    g->vertical = GyaradosVertical;
+    g->horizontal = GyaradosHorizontal;
+  }
+#else
+  g->vertical = GyaradosVertical;
+  g->horizontal = GyaradosHorizontal;
+#endif
+  if (forkjoin_concurrency() > 1 &&
+      g->dyn * MAX(g->sxn, g->dxn) >= GYARADOS_PARALLEL_PIXELS) {
+    grain = MAX(16, g->dyn / (forkjoin_concurrency() * 4));
+    forkjoin_for(g->dyn, grain, GyaradosBand, g);
+  } else {
+    GyaradosBand(g, 0, g->dyn);
+  }
+}
+
+static void CheckGyarados(long dyw, long dxw, long syw, long sxw, long dyn,
+                          long dxn, long syn, long sxn,
+                          const struct SamplingSolution *cy,
+                          const struct SamplingSolution *cx) {
+  CHECK_LE(syn, syw);
+  CHECK_LE(sxn, sxw);
+  CHECK_LE(dyn, dyw);
+  CHECK_LE(dxn, dxw);
+  CHECK_LT(_bsrl(syn) + _bsrl(sxn), 32);
+  CHECK_LT(_bsrl(dyn) + _bsrl(dxn), 32);
+  CHECK_LE(dyw, 0x7fff);
+  CHECK_LE(dxw, 0x7fff);
+  CHECK_LE(syw, 0x7fff);
+  CHECK_LE(sxw, 0x7fff);
+  CHECK_LE(dyn, 0x7fff);
+  CHECK_LE(dxn, 0x7fff);
+  CHECK_LE(syn, 0x7fff);
+  CHECK_LE(sxn, 0x7fff);
+  CHECK_GE(cy->n, dyn);
+  CHECK_GE(cx->n, dxn);
 }
 
 /**
  * Scales image.
  *
+ * Each band of output rows is computed a row at a time, by running the
+ * vertical pass on just the source rows it needs, then the horizontal
+ * pass, so the working set fits in cache. Large images are divided into
+ * bands which are computed on multiple cores via forkjoin_for().
+ *
+ * @param dst may overlap src
  * @note gyarados is magikarp in its infinite form
  * @see Magikarp2xY(), Magikarp2xX()
  */
@@ -196,27 +522,35 @@ void *Gyarados(long dyw, long dxw, int dst[dyw][dxw], long syw, long sxw,
                const int src[syw][sxw], long dyn, long dxn, long syn, long sxn,
                struct SamplingSolution *cy, struct SamplingSolution *cx,
                bool sharpen) {
+  size_t n;
+  int *tmp = 0;
+  struct Gyarados g;
   if (dyn > 0 && dxn > 0) {
     if (syn > 0 && sxn > 0) {
-      CHECK_LE(syn, syw);
-      CHECK_LE(sxn, sxw);
-      CHECK_LE(dyn, dyw);
-      CHECK_LE(dxn, dxw);
-      CHECK_LT(_bsrl(syn) + _bsrl(sxn), 32);
-      CHECK_LT(_bsrl(dyn) + _bsrl(dxn), 32);
-      CHECK_LE(dyw, 0x7fff);
-      CHECK_LE(dxw, 0x7fff);
-      CHECK_LE(syw, 0x7fff);
-      CHECK_LE(sxw, 0x7fff);
-      CHECK_LE(dyn, 0x7fff);
-      CHECK_LE(dxn, 0x7fff);
-      CHECK_LE(syn, 0x7fff);
-      CHECK_LE(sxn, 0x7fff);
-      GyaradosImpl(dyw, dxw, dst, syw, sxw, src, dyn, dxn, syn, sxn,
-                   gc(xmemalign(64, sizeof(int) * dyn * sxn)),
-                   gc(xmemalign(64, sizeof(int) * dyn * sxn)),
-                   gc(xmemalign(64, sizeof(int) * dyn * dxn)), cy->s, cx->s,
-                   cy->indices, cy->weights, cx->indices, cx->weights, sharpen);
+      CheckGyarados(dyw, dxw, syw, sxw, dyn, dxn, syn, sxn, cy, cx);
+      g.src = (const int *)src;
+      g.sxw = sxw;
+      if ((const int *)dst < (const int *)src + syn * sxw &&
+          (const int *)src < (const int *)dst + dyn * dxw) {
+        n = syn * sxn * sizeof(int);
+        tmp = TakeScratch(n);
+        for (long y = 0; y < syn; ++y) {
+          memcpy(tmp + y * sxn, src[y], sxn * sizeof(int));
+        }
+        g.src = tmp;
+        g.sxw = sxn;
+      }
+      g.dst = dst;
+      g.dxw = dxw;
+      g.tout = 0;
+      g.dyn = dyn;
+      g.dxn = dxn;
+      g.sxn = sxn;
+      g.cy = cy;
+      g.cx = cx;
+      g.sharpen = sharpen;
+      GyaradosRun(&g);
+      if (tmp) GiveScratch(tmp, n);
     } else {
       ZeroMatrix(dyw, dxw, dst, dyn, dxn);
     }
@@ -224,6 +558,11 @@ void *Gyarados(long dyw, long dxw, int dst[dyw][dxw], long syw, long sxw,
   return dst;
 }
 
+/**
+ * Scales 8-bit sRGB channel in linear light.
+ *
+ * @param dst may be the same as src
+ */
 void *GyaradosUint8(long dyw, long dxw, unsigned char dst[dyw][dxw], long syw,
                     long sxw, const unsigned char src[syw][sxw], long dyn,
                     long dxn, long syn, long sxn, long lo, long hi,
@@ -232,8 +571,10 @@ void *GyaradosUint8(long dyw, long dxw, unsigned char dst[dyw][dxw], long syw,
   static bool once;
   static int Tin[256];
   static unsigned char Tout[32768];
+  size_t n;
   long i, y, x;
-  int(*tmp)[MAX(dyn, syn)][MAX(dxn, sxn)];
+  int *tmp;
+  struct Gyarados g;
   if (!once) {
     for (i = 0; i < ARRAYLEN(Tin); ++i) {
       Tin[i] = F2Q(15, rgb2linpc(i / 255., 2.4));
@@ -243,23 +584,44 @@ void *GyaradosUint8(long dyw, long dxw, unsigned char dst[dyw][dxw], long syw,
     }
     once = true;
   }
-  tmp = xmemalign(64, sizeof(int) * MAX(dyn, syn) * MAX(dxn, sxn));
-  for (y = 0; y < syn; ++y) {
-    for (x = 0; x < sxn; ++x) {
-      (*tmp)[y][x] = Tin[src[y][x]];
-    }
-  }
-  Gyarados(MAX(dyn, syn), MAX(dxn, sxn), *tmp, MAX(dyn, syn), MAX(dxn, sxn),
-           *tmp, dyn, dxn, syn, sxn, cy, cx, sharpen);
-  for (y = 0; y < dyn; ++y) {
-    for (x = 0; x < dxn; ++x) {
-      dst[y][x] = Tout[MIN(32767, MAX(0, (*tmp)[y][x]))];
+  if (dyn > 0 && dxn > 0) {
+    if (syn > 0 && sxn > 0) {
+      CheckGyarados(dyw, dxw, syw, sxw, dyn, dxn, syn, sxn, cy, cx);
+      n = syn * sxn * sizeof(int);
+      tmp = TakeScratch(n);
+      for (y = 0; y < syn; ++y) {
+        for (x = 0; x < sxn; ++x) {
+          tmp[y * sxn + x] = Tin[src[y][x]];
+        }
+      }
+      g.src = tmp;
+      g.sxw = sxn;
+      g.dst = dst;
+      g.dxw = dxw;
+      g.tout = Tout;
+      g.dyn = dyn;
+      g.dxn = dxn;
+      g.sxn = sxn;
+      g.cy = cy;
+      g.cx = cx;
+      g.sharpen = sharpen;
+      GyaradosRun(&g);
+      GiveScratch(tmp, n);
+    } else {
+      for (y = 0; y < dyn; ++y) {
+        memset(dst[y], Tout[0], dxn);
+      }
     }
   }
-  free(tmp);
   return dst;
 }
 
+/**
+ * Scales multichannel 8-bit sRGB image.
+ *
+ * Sampling solutions are cached, so scaling many frames or thumbnails
+ * of the same dimensions only computes the filter taps once.
+ */
 void *EzGyarados(long dcw, long dyw, long dxw, unsigned char dst[dcw][dyw][dxw],
                  long scw, long syw, long sxw,
                  const unsigned char src[scw][syw][sxw], long c0, long cn,
@@ -267,8 +629,8 @@ void *EzGyarados(long dcw, long dyw, long dxw, unsigned char dst[dcw][dyw][dxw],
                  double oy, double ox) {
   long c;
   struct SamplingSolution *cy, *cx;
-  cy = ComputeSamplingSolution(dyn, syn, ry, oy, 1);
-  cx = ComputeSamplingSolution(dxn, sxn, rx, ox, 1);
+  cy = GetSamplingSolution(dyn, syn, ry, oy, 1);
+  cx = GetSamplingSolution(dxn, sxn, rx, ox, 1);
   for (c = c0; c < cn; ++c) {
     GyaradosUint8(dyw, dxw, dst[c], syw, sxw, src[c], dyn, dxn, syn, sxn, 0,
                   255, cy, cx, true);
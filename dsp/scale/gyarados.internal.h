@@ -0,0 +1,16 @@
+#ifndef COSMOPOLITAN_DSP_SCALE_GYARADOS_INTERNAL_H_
+#define COSMOPOLITAN_DSP_SCALE_GYARADOS_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+void GyaradosVertical(int *, long, const int *, long, const short *,
+                      const short *, long);
+void GyaradosVerticalAvx2(int *, long, const int *, long, const short *,
+                          const short *, long);
+void GyaradosHorizontal(int *, long, const int *, const int *, const int *,
+                        long);
+void GyaradosHorizontalAvx2(int *, long, const int *, const int *,
+                            const int *, long);
+void GyaradosSharpen(int *, long, const int *, const int *, const int *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_DSP_SCALE_GYARADOS_INTERNAL_H_ */
@@ -13,6 +13,7 @@ struct SamplingSolution;
 void FreeSamplingSolution(struct SamplingSolution *);
 struct SamplingSolution *ComputeSamplingSolution(long, long, double, double,
                                                  double);
+void FreeGyaradosCache(void);
 
 void *Scale2xX(long, long, void *, long, long);
 void *Scale2xY(long, long, void *, long, long);
@@ -56,6 +56,15 @@ o/$(MODE)/dsp/tty/ttyraster.o: private		\
 		CFLAGS +=			\
 			$(MATHEMATICAL)
 
+ifeq ($(ARCH), x86_64)
+o/$(MODE)/dsp/tty/ttyraster-avx2.o: private	\
+		TARGET_ARCH +=			\
+			-mavx2
+o/$(MODE)/dsp/tty/ttyraster-ssse3.o: private	\
+		TARGET_ARCH +=			\
+			-mssse3
+endif
+
 ifeq ($(ARCH), aarch64)
 # takes 14 seconds to compile with aarch64 gcc
 o/$(MODE)/dsp/tty/ttyraster.o: private CFLAGS += -O1
@@ -5,6 +5,12 @@
 #include "third_party/intel/xmmintrin.internal.h"
 COSMOPOLITAN_C_START_
 
+struct TtyMix {
+  uint8_t from[32];
+  uint8_t to[32];
+  uint8_t ratio[32];
+};
+
 struct TtyRgb rgb2tty24f_(ttyrgb_m128);
 struct TtyRgb rgb2ttyf2i_(ttyrgb_m128);
 struct TtyRgb rgb2ttyi2f_(int, int, int);
@@ -28,5 +34,15 @@ char *setfg24_(char *, struct TtyRgb);
 char *setbgfg24_(char *, struct TtyRgb, struct TtyRgb);
 struct TtyRgb rgb2ansi8_(int, int, int);
 
+void ttypicks_k8(uint16_t *, const uint16_t[4][4], const uint8_t *, size_t);
+void ttypicks_ssse3(uint16_t *, const uint16_t[4][4], const uint8_t *, size_t);
+void ttypicks_avx2(uint16_t *, const uint16_t[4][4], const uint8_t *, size_t);
+void ttymix_k8(uint16_t[32], const struct TtyRgb[4], const struct TtyRgb[4],
+               const struct TtyMix *);
+void ttymix_ssse3(uint16_t[32], const struct TtyRgb[4], const struct TtyRgb[4],
+                  const struct TtyMix *);
+void ttymix_avx2(uint16_t[32], const struct TtyRgb[4], const struct TtyRgb[4],
+                 const struct TtyMix *);
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_DSP_TTY_INTERNAL_H_ */
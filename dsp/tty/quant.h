@@ -70,6 +70,8 @@ void ttyquantsetup(enum TtyQuantizationAlgorithm, enum TtyQuantizationChannels,
 
 extern char *ttyraster(char *, const struct TtyRgb *, size_t, size_t,
                        struct TtyRgb, struct TtyRgb);
+void rgb2ttyn(struct TtyRgb *, const uint8_t *, const uint8_t *,
+              const uint8_t *, size_t);
 
 #ifndef ttyquant
 #define ttyquant()    (&g_ttyquant_)
@@ -0,0 +1,124 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/internal.h"
+#include "dsp/tty/quant.h"
+#include "libc/limits.h"
+
+typedef int i32x4 __attribute__((__vector_size__(16)));
+typedef unsigned u32x4 __attribute__((__vector_size__(16)));
+typedef unsigned u32x4_u __attribute__((__vector_size__(16), __aligned__(1)));
+typedef unsigned char u8x4 __attribute__((__vector_size__(4), __aligned__(1)));
+
+static inline i32x4 Load(const uint8_t *p) {
+  return __builtin_convertvector(*(const u8x4 *)p, i32x4);
+}
+
+static inline i32x4 Select(i32x4 m, i32x4 a, i32x4 b) {
+  return (a & m) | (b & ~m);
+}
+
+static inline i32x4 Uncube(i32x4 x) {
+  return -((x >= 48) + (x >= 115) + (x >= 155) + (x >= 195) + (x >= 235));
+}
+
+static inline i32x4 Cube(i32x4 i) {
+  return (i * 40 + 55) & (i != 0);
+}
+
+static inline i32x4 Dist(i32x4 r, i32x4 g, i32x4 b, i32x4 x, i32x4 y,
+                         i32x4 z) {
+  return (r - x) * (r - x) + (g - y) * (g - y) + (b - z) * (b - z);
+}
+
+/**
+ * Computes rgb2xterm256_() four pixels at a time.
+ *
+ * The gray luminance is computed in 23-bit fixed point which has been
+ * checked over all 2²⁴ colors to round exactly the same as the doubles
+ * used by the scalar version.
+ */
+static i32x4 Xterm256(i32x4 r, i32x4 g, i32x4 b) {
+  i32x4 ir, ig, ib, cr, cg, cb, gv, gray, grai;
+  gray = (r * 1783727 + g * 5999390 + b * 605491 + (1 << 22)) >> 23;
+  gray = (gray - 3) & (gray >= 3);
+  grai = (gray * 205) >> 11;
+  grai -= (grai - 23) & (grai > 23);
+  ir = Uncube(r);
+  ig = Uncube(g);
+  ib = Uncube(b);
+  cr = Cube(ir);
+  cg = Cube(ig);
+  cb = Cube(ib);
+  gv = 8 + 10 * grai;
+  return Select(Dist(r, g, b, cr, cg, cb) <= Dist(r, g, b, gv, gv, gv),
+                16 + 36 * ir + 6 * ig + ib, 232 + grai);
+}
+
+/**
+ * Computes rgb2ansi_() palette search four pixels at a time.
+ */
+static i32x4 Palette(i32x4 r, i32x4 g, i32x4 b, int min, int max) {
+  int c;
+  i32x4 d, m, best, least;
+  best = (i32x4){0};
+  least = (i32x4){0} + INT_MAX;
+  for (c = min; c < max; ++c) {
+    d = Dist(r, g, b, (i32x4){0} + g_ansi2rgb_[c].r,
+             (i32x4){0} + g_ansi2rgb_[c].g, (i32x4){0} + g_ansi2rgb_[c].b);
+    m = d < least;
+    least = Select(m, d, least);
+    best = Select(m, (i32x4){0} + c, best);
+  }
+  return best;
+}
+
+/**
+ * Quantizes row of planar RGB pixels.
+ *
+ * This is equivalent to calling rgb2tty() for each pixel, except the
+ * builtin quantizers are computed four pixels at a time.
+ *
+ * @param p receives `n` cells
+ */
+void rgb2ttyn(struct TtyRgb *p, const uint8_t *r, const uint8_t *g,
+              const uint8_t *b, size_t n) {
+  size_t i;
+  i32x4 R, G, B, X;
+  rgb2tty_f f = ttyquant()->rgb2tty;
+  i = 0;
+  if (f == rgb2ansi_ || f == rgb2xterm24_) {
+    for (; i + 4 <= n; i += 4) {
+      R = Load(r + i);
+      G = Load(g + i);
+      B = Load(b + i);
+      if (f == rgb2xterm24_) {
+        X = (i32x4){0};
+      } else if (ttyquant()->min == 16 && ttyquant()->max == 256) {
+        X = Xterm256(R, G, B);
+      } else {
+        X = Palette(R, G, B, ttyquant()->min, ttyquant()->max);
+      }
+      *(u32x4_u *)(p + i) =
+          (u32x4)R | (u32x4)G << 8 | (u32x4)B << 16 | (u32x4)X << 24;
+    }
+  }
+  for (; i < n; ++i) {
+    p[i] = f(r[i], g[i], b[i]);
+  }
+}
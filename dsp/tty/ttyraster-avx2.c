@@ -0,0 +1,95 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/internal.h"
+#include "libc/str/str.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef char i8x32 __attribute__((__vector_size__(32)));
+typedef unsigned char u8x16
+    __attribute__((__vector_size__(16), __aligned__(1)));
+typedef short s16x16 __attribute__((__vector_size__(32)));
+typedef unsigned short u16x16 __attribute__((__vector_size__(32)));
+typedef unsigned short u16x16_u
+    __attribute__((__vector_size__(32), __aligned__(1)));
+
+static inline u16x16 ttyload(const uint8_t *p) {
+  return __builtin_convertvector(*(const u8x16 *)p, u16x16);
+}
+
+static inline u16x16 ttylookup(i8x32 table, u16x16 index) {
+  return (u16x16)__builtin_ia32_pshufb256(table, (i8x32)index);
+}
+
+/**
+ * Scores glyph candidates for 2×2 chunk, sixteen at a time.
+ *
+ * @see ttypicks_ssse3()
+ */
+void ttypicks_avx2(uint16_t *p, const uint16_t d[4][4], const uint8_t *c,
+                   size_t n) {
+  size_t i, k;
+  u16x16 s, t[4];
+  for (i = 0; i < 4; ++i) {
+    t[i] = (u16x16){d[i][0], d[i][1], d[i][2], d[i][3], 0, 0, 0, 0,
+                    d[i][0], d[i][1], d[i][2], d[i][3]};
+  }
+  for (k = 0; k < n; k += 16) {
+    s = (u16x16){0};
+    for (i = 0; i < 4; ++i) {
+      s += ttylookup((i8x32)t[i], ttyload(c + i * n + k) * 0x0202 + 0x0100);
+    }
+    *(u16x16_u *)(p + k) = s;
+  }
+}
+
+/**
+ * Scores stipple candidates for 2×2 chunk, sixteen at a time.
+ *
+ * @see ttymix_ssse3()
+ */
+void ttymix_avx2(uint16_t p[32], const struct TtyRgb t[4],
+                 const struct TtyRgb q[4], const struct TtyMix *m) {
+  i8x32 qq;
+  size_t i, j, k;
+  u16x16 a, b, r, x, y, l, s, tt[3][4];
+  memcpy(&qq, q, 16);
+  memcpy((char *)&qq + 16, q, 16);
+  for (i = 0; i < 4; ++i) {
+    tt[0][i] = (u16x16){0} + t[i].r;
+    tt[1][i] = (u16x16){0} + t[i].g;
+    tt[2][i] = (u16x16){0} + t[i].b;
+  }
+  for (k = 0; k < 32; k += 16) {
+    a = ttyload(m->from + k) * 4 + 0x8000;
+    b = ttyload(m->to + k) * 4 + 0x8000;
+    r = ttyload(m->ratio + k);
+    s = (u16x16){0};
+    for (j = 0; j < 3; ++j, a += 1, b += 1) {
+      x = ttylookup(qq, a);
+      y = ttylookup(qq, b);
+      l = ((u16x16)((s16x16)((y - x) * r) >> 8) + x) & 255;
+      for (i = 0; i < 4; ++i) {
+        s += (u16x16)__builtin_ia32_pabsw256((s16x16)(tt[j][i] - l));
+      }
+    }
+    *(u16x16_u *)(p + k) = s;
+  }
+}
+
+#endif /* __x86_64__ */
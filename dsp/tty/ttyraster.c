@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "dsp/core/twixt8.h"
+#include "dsp/tty/internal.h"
 #include "dsp/tty/quant.h"
 #include "dsp/tty/tty.h"
 #include "dsp/tty/ttyrgb.h"
@@ -33,12 +34,6 @@
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 
-#define SQR(X)        ((X) * (X))
-#define DIST(X, Y)    ((X) - (Y))
-#define QSUB(A, B, C) ABS(DIST(A##C, B##C))
-#define DIFF(A, B)    (QSUB(A, B, r) + QSUB(A, B, g) + QSUB(A, B, b))
-#define JUDGE(M)      (DIFF(ttl, M) + DIFF(ttr, M) + DIFF(tbl, M) + DIFF(tbr, M))
-
 static const struct Glyph {
   char c1, c2, c3, len;
 } kGlyphs[2][11] = {
@@ -238,421 +233,147 @@ static const struct Pick kPicksMixBlock[32] = {
     {TL, TR, 9}, /* ▓ */
 };
 
-static unsigned short GetBlockDist(struct TtyRgb a, struct TtyRgb b,
-                                   struct TtyRgb c, struct TtyRgb d,
-                                   struct TtyRgb w, struct TtyRgb x,
-                                   struct TtyRgb y, struct TtyRgb z) {
-  unsigned short dist;
-  dist = 0;
-  dist += ABS(a.r - w.r);
-  dist += ABS(a.g - w.g);
-  dist += ABS(a.b - w.b);
-  dist += ABS(b.r - x.r);
-  dist += ABS(b.g - x.g);
-  dist += ABS(b.b - x.b);
-  dist += ABS(c.r - y.r);
-  dist += ABS(c.g - y.g);
-  dist += ABS(c.b - y.b);
-  dist += ABS(d.r - z.r);
-  dist += ABS(d.g - z.g);
-  dist += ABS(d.b - z.b);
-  return dist;
-}
+/**
+ * Blend of quantized cell `from` into cell `to` by `ratio/256` that's
+ * drawn by each of kPicksMixBlock.
+ */
+static const struct TtyMix kMixBlock = {
+    {BL, BL, BL, BL, BL, BL, BL, BL, BL, BR, BR, BR, BR, BR, BR, TL,
+     TL, TL, TL, TL, TL, TL, TL, TL, TR, TR, TR, TR, TR, TR, TR, TR},
+    {BR, BR, BR, TL, TL, TL, TR, TR, TR, TL, TL, TL, TR, TR, TR, BL,
+     BL, BL, BR, BR, BR, TR, TR, TR, BL, BL, BL, BR, BR, BR, TL, TL},
+    {0100, 0300, 0200, 0100, 0300, 0200, 0100, 0300, 0200, 0100, 0300,
+     0200, 0100, 0300, 0200, 0100, 0300, 0200, 0100, 0300, 0200, 0100,
+     0300, 0200, 0100, 0300, 0200, 0100, 0300, 0200, 0100, 0300},
+};
+
+/**
+ * Quadrants of each glyph in kGlyphs[0] that are painted foreground,
+ * where bit i is set for quadrant i ∈ {TL,TR,BL,BR}.
+ */
+static const unsigned char kQuadrants[8] = {
+    0, 014, 005, 002, 010, 004, 006, 001,
+};
+
+/**
+ * Quadrant colors of each pick, as indices of the chunk in [4][n] order.
+ */
+static struct {
+  uint8_t unicode[4][ARRAYLEN(kPicksUnicode)];
+  uint8_t cp437[4][ARRAYLEN(kPicksCp437)];
+} g_cells;
+
+static void (*ttypicks)(uint16_t *, const uint16_t[4][4], const uint8_t *,
+                        size_t);
+static void (*ttymix)(uint16_t[32], const struct TtyRgb[4],
+                      const struct TtyRgb[4], const struct TtyMix *);
 
-static uint16_t *MixBlock(uint16_t *p, struct TtyRgb ttl, struct TtyRgb ttr,
-                          struct TtyRgb tbl, struct TtyRgb tbr,
-                          struct TtyRgb qtl, struct TtyRgb qtr,
-                          struct TtyRgb qbl, struct TtyRgb qbr) {
-  unsigned char ttlr, ttlg, ttlb, qtlr, qtlg, qtlb, ttrr, ttrg, ttrb, qtrr,
-      qtrg, qtrb, tblr, tblg, tblb, qblr, qblg, qblb, tbrr, tbrg, tbrb, qbrr,
-      qbrg, qbrb, l00r, l00g, l00b, l01r, l01g, l01b, l02r, l02g, l02b, l03r,
-      l03g, l03b, l04r, l04g, l04b, l05r, l05g, l05b, l06r, l06g, l06b, l07r,
-      l07g, l07b, l08r, l08g, l08b, l09r, l09g, l09b, l10r, l10g, l10b, l11r,
-      l11g, l11b, l12r, l12g, l12b, l13r, l13g, l13b, l14r, l14g, l14b, l15r,
-      l15g, l15b, l16r, l16g, l16b, l17r, l17g, l17b, l18r, l18g, l18b, l19r,
-      l19g, l19b, l20r, l20g, l20b, l21r, l21g, l21b, l22r, l22g, l22b, l23r,
-      l23g, l23b, l24r, l24g, l24b, l25r, l25g, l25b, l26r, l26g, l26b, l27r,
-      l27g, l27b, l28r, l28g, l28b, l29r, l29g, l29b, l30r, l30g, l30b, l31r,
-      l31g, l31b;
-  unsigned short p00, p01, p02, p03, p04, p05, p06, p07, p08, p09, p10, p11,
-      p12, p13, p14, p15, p16, p17, p18, p19, p20, p21, p22, p23, p24, p25, p26,
-      p27, p28, p29, p30, p31;
-  ttlr = ttl.r;
-  ttlg = ttl.g;
-  ttlb = ttl.b;
-  qtlr = qtl.r;
-  qtlg = qtl.g;
-  qtlb = qtl.b;
-  ttrr = ttr.r;
-  ttrg = ttr.g;
-  ttrb = ttr.b;
-  qtrr = qtr.r;
-  qtrg = qtr.g;
-  qtrb = qtr.b;
-  tblr = tbl.r;
-  tblg = tbl.g;
-  tblb = tbl.b;
-  qblr = qbl.r;
-  qblg = qbl.g;
-  qblb = qbl.b;
-  tbrr = tbr.r;
-  tbrg = tbr.g;
-  tbrb = tbr.b;
-  qbrr = qbr.r;
-  qbrg = qbr.g;
-  qbrb = qbr.b;
-  l00r = twixt8(qblr, qbrr, 0100);
-  l00g = twixt8(qblg, qbrg, 0100);
-  l00b = twixt8(qblb, qbrb, 0100);
-  l01r = twixt8(qblr, qbrr, 0300);
-  l01g = twixt8(qblg, qbrg, 0300);
-  l01b = twixt8(qblb, qbrb, 0300);
-  l02r = twixt8(qblr, qbrr, 0200);
-  l02g = twixt8(qblg, qbrg, 0200);
-  l02b = twixt8(qblb, qbrb, 0200);
-  l03r = twixt8(qblr, qtlr, 0100);
-  l03g = twixt8(qblg, qtlg, 0100);
-  l03b = twixt8(qblb, qtlb, 0100);
-  l04r = twixt8(qblr, qtlr, 0300);
-  l04g = twixt8(qblg, qtlg, 0300);
-  l04b = twixt8(qblb, qtlb, 0300);
-  l05r = twixt8(qblr, qtlr, 0200);
-  l05g = twixt8(qblg, qtlg, 0200);
-  l05b = twixt8(qblb, qtlb, 0200);
-  l06r = twixt8(qblr, qtrr, 0100);
-  l06g = twixt8(qblg, qtrg, 0100);
-  l06b = twixt8(qblb, qtrb, 0100);
-  l07r = twixt8(qblr, qtrr, 0300);
-  l07g = twixt8(qblg, qtrg, 0300);
-  l07b = twixt8(qblb, qtrb, 0300);
-  l08r = twixt8(qblr, qtrr, 0200);
-  l08g = twixt8(qblg, qtrg, 0200);
-  l08b = twixt8(qblb, qtrb, 0200);
-  l09r = twixt8(qbrr, qtlr, 0100);
-  l09g = twixt8(qbrg, qtlg, 0100);
-  l09b = twixt8(qbrb, qtlb, 0100);
-  l10r = twixt8(qbrr, qtlr, 0300);
-  l10g = twixt8(qbrg, qtlg, 0300);
-  l10b = twixt8(qbrb, qtlb, 0300);
-  l11r = twixt8(qbrr, qtlr, 0200);
-  l11g = twixt8(qbrg, qtlg, 0200);
-  l11b = twixt8(qbrb, qtlb, 0200);
-  l12r = twixt8(qbrr, qtrr, 0100);
-  l12g = twixt8(qbrg, qtrg, 0100);
-  l12b = twixt8(qbrb, qtrb, 0100);
-  l13r = twixt8(qbrr, qtrr, 0300);
-  l13g = twixt8(qbrg, qtrg, 0300);
-  l13b = twixt8(qbrb, qtrb, 0300);
-  l14r = twixt8(qbrr, qtrr, 0200);
-  l14g = twixt8(qbrg, qtrg, 0200);
-  l14b = twixt8(qbrb, qtrb, 0200);
-  l15r = twixt8(qtlr, qblr, 0100);
-  l15g = twixt8(qtlg, qblg, 0100);
-  l15b = twixt8(qtlb, qblb, 0100);
-  l16r = twixt8(qtlr, qblr, 0300);
-  l16g = twixt8(qtlg, qblg, 0300);
-  l16b = twixt8(qtlb, qblb, 0300);
-  l17r = twixt8(qtlr, qblr, 0200);
-  l17g = twixt8(qtlg, qblg, 0200);
-  l17b = twixt8(qtlb, qblb, 0200);
-  l18r = twixt8(qtlr, qbrr, 0100);
-  l18g = twixt8(qtlg, qbrg, 0100);
-  l18b = twixt8(qtlb, qbrb, 0100);
-  l19r = twixt8(qtlr, qbrr, 0300);
-  l19g = twixt8(qtlg, qbrg, 0300);
-  l19b = twixt8(qtlb, qbrb, 0300);
-  l20r = twixt8(qtlr, qbrr, 0200);
-  l20g = twixt8(qtlg, qbrg, 0200);
-  l20b = twixt8(qtlb, qbrb, 0200);
-  l21r = twixt8(qtlr, qtrr, 0100);
-  l21g = twixt8(qtlg, qtrg, 0100);
-  l21b = twixt8(qtlb, qtrb, 0100);
-  l22r = twixt8(qtlr, qtrr, 0300);
-  l22g = twixt8(qtlg, qtrg, 0300);
-  l22b = twixt8(qtlb, qtrb, 0300);
-  l23r = twixt8(qtlr, qtrr, 0200);
-  l23g = twixt8(qtlg, qtrg, 0200);
-  l23b = twixt8(qtlb, qtrb, 0200);
-  l24r = twixt8(qtrr, qblr, 0100);
-  l24g = twixt8(qtrg, qblg, 0100);
-  l24b = twixt8(qtrb, qblb, 0100);
-  l25r = twixt8(qtrr, qblr, 0300);
-  l25g = twixt8(qtrg, qblg, 0300);
-  l25b = twixt8(qtrb, qblb, 0300);
-  l26r = twixt8(qtrr, qblr, 0200);
-  l26g = twixt8(qtrg, qblg, 0200);
-  l26b = twixt8(qtrb, qblb, 0200);
-  l27r = twixt8(qtrr, qbrr, 0100);
-  l27g = twixt8(qtrg, qbrg, 0100);
-  l27b = twixt8(qtrb, qbrb, 0100);
-  l28r = twixt8(qtrr, qbrr, 0300);
-  l28g = twixt8(qtrg, qbrg, 0300);
-  l28b = twixt8(qtrb, qbrb, 0300);
-  l29r = twixt8(qtrr, qbrr, 0200);
-  l29g = twixt8(qtrg, qbrg, 0200);
-  l29b = twixt8(qtrb, qbrb, 0200);
-  l30r = twixt8(qtrr, qtlr, 0100);
-  l30g = twixt8(qtrg, qtlg, 0100);
-  l30b = twixt8(qtrb, qtlb, 0100);
-  l31r = twixt8(qtrr, qtlr, 0300);
-  l31g = twixt8(qtrg, qtlg, 0300);
-  l31b = twixt8(qtrb, qtlb, 0300);
-  p00 = JUDGE(l00);
-  p01 = JUDGE(l01);
-  p02 = JUDGE(l02);
-  p03 = JUDGE(l03);
-  p04 = JUDGE(l04);
-  p05 = JUDGE(l05);
-  p06 = JUDGE(l06);
-  p07 = JUDGE(l07);
-  p08 = JUDGE(l08);
-  p09 = JUDGE(l09);
-  p10 = JUDGE(l10);
-  p11 = JUDGE(l11);
-  p12 = JUDGE(l12);
-  p13 = JUDGE(l13);
-  p14 = JUDGE(l14);
-  p15 = JUDGE(l15);
-  p16 = JUDGE(l16);
-  p17 = JUDGE(l17);
-  p18 = JUDGE(l18);
-  p19 = JUDGE(l19);
-  p20 = JUDGE(l20);
-  p21 = JUDGE(l21);
-  p22 = JUDGE(l22);
-  p23 = JUDGE(l23);
-  p24 = JUDGE(l24);
-  p25 = JUDGE(l25);
-  p26 = JUDGE(l26);
-  p27 = JUDGE(l27);
-  p28 = JUDGE(l28);
-  p29 = JUDGE(l29);
-  p30 = JUDGE(l30);
-  p31 = JUDGE(l31);
-  *p++ = p00;
-  *p++ = p01;
-  *p++ = p02;
-  *p++ = p03;
-  *p++ = p04;
-  *p++ = p05;
-  *p++ = p06;
-  *p++ = p07;
-  *p++ = p08;
-  *p++ = p09;
-  *p++ = p10;
-  *p++ = p11;
-  *p++ = p12;
-  *p++ = p13;
-  *p++ = p14;
-  *p++ = p15;
-  *p++ = p16;
-  *p++ = p17;
-  *p++ = p18;
-  *p++ = p19;
-  *p++ = p20;
-  *p++ = p21;
-  *p++ = p22;
-  *p++ = p23;
-  *p++ = p24;
-  *p++ = p25;
-  *p++ = p26;
-  *p++ = p27;
-  *p++ = p28;
-  *p++ = p29;
-  *p++ = p30;
-  *p++ = p31;
-  return p;
+/**
+ * Scores glyph candidates for 2×2 chunk.
+ *
+ * Since each quadrant of a candidate is painted with the color of some
+ * chunk cell, its distance is the sum of four entries in the matrix of
+ * distances between the chunk and its colors; this way only sixteen
+ * distances need to be computed rather than four for every candidate.
+ *
+ * @param d[i][j] is distance of chunk cell i from (quantized) cell j
+ * @param c is [4][n] array of which cell j paints quadrant i of pick k
+ * @param n is number of picks, which must be a multiple of 16
+ */
+void ttypicks_k8(uint16_t *p, const uint16_t d[4][4], const uint8_t *c,
+                 size_t n) {
+  size_t k;
+  for (k = 0; k < n; ++k) {
+    p[k] = d[TL][c[0 * n + k]] + d[TR][c[1 * n + k]] +
+           d[BL][c[2 * n + k]] + d[BR][c[3 * n + k]];
+  }
 }
 
-static struct TtyRgb GetQuant(struct TtyRgb rgb) {
-  return g_ansi2rgb_[rgb.xt];
+/**
+ * Scores stipple candidates for 2×2 chunk.
+ *
+ * @param t is chunk of original colors
+ * @param q is chunk of quantized colors
+ */
+void ttymix_k8(uint16_t p[32], const struct TtyRgb t[4],
+               const struct TtyRgb q[4], const struct TtyMix *m) {
+  unsigned i, k, r, g, b;
+  for (k = 0; k < 32; ++k) {
+    r = twixt8(q[m->from[k]].r, q[m->to[k]].r, m->ratio[k]);
+    g = twixt8(q[m->from[k]].g, q[m->to[k]].g, m->ratio[k]);
+    b = twixt8(q[m->from[k]].b, q[m->to[k]].b, m->ratio[k]);
+    for (p[k] = i = 0; i < 4; ++i) {
+      p[k] += ABS(t[i].r - (int)r) + ABS(t[i].g - (int)g) +
+              ABS(t[i].b - (int)b);
+    }
+  }
 }
 
-static uint16_t *PickUnicode(uint16_t *p, struct TtyRgb tl, struct TtyRgb tr,
-                             struct TtyRgb bl, struct TtyRgb br,
-                             struct TtyRgb tl2, struct TtyRgb tr2,
-                             struct TtyRgb bl2, struct TtyRgb br2) {
-#define PICK(A, B, C, D) *p++ = GetBlockDist(tl, tr, bl, br, A, B, C, D)
-  PICK(bl2, bl2, bl2, bl2); /*   k=0  bg=bl fg=NULL */
-  PICK(bl2, bl2, bl2, br2); /* ▗ k=4  bg=bl fg=br   */
-  PICK(bl2, bl2, bl2, tl2); /* ▗ k=4  bg=bl fg=tl   */
-  PICK(bl2, bl2, bl2, tr2); /* ▗ k=4  bg=bl fg=tr   */
-  PICK(bl2, bl2, br2, bl2); /* ▖ k=5  bg=bl fg=br   */
-  PICK(bl2, bl2, br2, br2); /* ▄ k=1  bg=bl fg=br   */
-  PICK(bl2, bl2, tl2, bl2); /* ▖ k=5  bg=bl fg=tl   */
-  PICK(bl2, bl2, tl2, tl2); /* ▄ k=1  bg=bl fg=tl   */
-  PICK(bl2, bl2, tr2, bl2); /* ▖ k=5  bg=bl fg=tr   */
-  PICK(bl2, bl2, tr2, tr2); /* ▄ k=1  bg=bl fg=tr   */
-  PICK(bl2, br2, bl2, bl2); /* ▝ k=3  bg=bl fg=br   */
-  PICK(bl2, br2, bl2, br2); /* ▌ k=2  bg=br fg=bl   */
-  PICK(bl2, br2, br2, bl2); /* ▞ k=6  bg=bl fg=br   */
-  PICK(bl2, br2, br2, br2); /* ▘ k=7  bg=br fg=bl   */
-  PICK(bl2, tl2, bl2, bl2); /* ▝ k=3  bg=bl fg=tl   */
-  PICK(bl2, tl2, bl2, tl2); /* ▌ k=2  bg=tl fg=bl   */
-  PICK(bl2, tl2, tl2, bl2); /* ▞ k=6  bg=bl fg=tl   */
-  PICK(bl2, tl2, tl2, tl2); /* ▘ k=7  bg=tl fg=bl   */
-  PICK(bl2, tr2, bl2, bl2); /* ▝ k=3  bg=bl fg=tr   */
-  PICK(bl2, tr2, bl2, tr2); /* ▌ k=2  bg=tr fg=bl   */
-  PICK(bl2, tr2, tr2, bl2); /* ▞ k=6  bg=bl fg=tr   */
-  PICK(bl2, tr2, tr2, tr2); /* ▘ k=7  bg=tr fg=bl   */
-  PICK(br2, bl2, bl2, bl2); /* ▘ k=7  bg=bl fg=br   */
-  PICK(br2, bl2, bl2, br2); /* ▞ k=6  bg=br fg=bl   */
-  PICK(br2, bl2, br2, bl2); /* ▌ k=2  bg=bl fg=br   */
-  PICK(br2, bl2, br2, br2); /* ▝ k=3  bg=br fg=bl   */
-  PICK(br2, br2, bl2, bl2); /* ▄ k=1  bg=br fg=bl   */
-  PICK(br2, br2, bl2, br2); /* ▖ k=5  bg=br fg=bl   */
-  PICK(br2, br2, br2, bl2); /* ▗ k=4  bg=br fg=bl   */
-  PICK(br2, br2, br2, br2); /*   k=0  bg=br fg=NULL */
-  PICK(br2, br2, br2, tl2); /* ▗ k=4  bg=br fg=tl   */
-  PICK(br2, br2, br2, tr2); /* ▗ k=4  bg=br fg=tr   */
-  PICK(br2, br2, tl2, br2); /* ▖ k=5  bg=br fg=tl   */
-  PICK(br2, br2, tl2, tl2); /* ▄ k=1  bg=br fg=tl   */
-  PICK(br2, br2, tr2, br2); /* ▖ k=5  bg=br fg=tr   */
-  PICK(br2, br2, tr2, tr2); /* ▄ k=1  bg=br fg=tr   */
-  PICK(br2, tl2, br2, br2); /* ▝ k=3  bg=br fg=tl   */
-  PICK(br2, tl2, br2, tl2); /* ▌ k=2  bg=tl fg=br   */
-  PICK(br2, tl2, tl2, br2); /* ▞ k=6  bg=br fg=tl   */
-  PICK(br2, tl2, tl2, tl2); /* ▘ k=7  bg=tl fg=br   */
-  PICK(br2, tr2, br2, br2); /* ▝ k=3  bg=br fg=tr   */
-  PICK(br2, tr2, br2, tr2); /* ▌ k=2  bg=tr fg=br   */
-  PICK(br2, tr2, tr2, br2); /* ▞ k=6  bg=br fg=tr   */
-  PICK(br2, tr2, tr2, tr2); /* ▘ k=7  bg=tr fg=br   */
-  PICK(tl2, bl2, bl2, bl2); /* ▘ k=7  bg=bl fg=tl   */
-  PICK(tl2, bl2, bl2, tl2); /* ▞ k=6  bg=tl fg=bl   */
-  PICK(tl2, bl2, tl2, bl2); /* ▌ k=2  bg=bl fg=tl   */
-  PICK(tl2, bl2, tl2, tl2); /* ▝ k=3  bg=tl fg=bl   */
-  PICK(tl2, br2, br2, br2); /* ▘ k=7  bg=br fg=tl   */
-  PICK(tl2, br2, br2, tl2); /* ▞ k=6  bg=tl fg=br   */
-  PICK(tl2, br2, tl2, br2); /* ▌ k=2  bg=br fg=tl   */
-  PICK(tl2, br2, tl2, tl2); /* ▝ k=3  bg=tl fg=br   */
-  PICK(tl2, tl2, bl2, bl2); /* ▄ k=1  bg=tl fg=bl   */
-  PICK(tl2, tl2, bl2, tl2); /* ▖ k=5  bg=tl fg=bl   */
-  PICK(tl2, tl2, br2, br2); /* ▄ k=1  bg=tl fg=br   */
-  PICK(tl2, tl2, br2, tl2); /* ▖ k=5  bg=tl fg=br   */
-  PICK(tl2, tl2, tl2, bl2); /* ▗ k=4  bg=tl fg=bl   */
-  PICK(tl2, tl2, tl2, br2); /* ▗ k=4  bg=tl fg=br   */
-  PICK(tl2, tl2, tl2, tl2); /*   k=0  bg=tl fg=NULL */
-  PICK(tl2, tl2, tl2, tr2); /* ▗ k=4  bg=tl fg=tr   */
-  PICK(tl2, tl2, tr2, tl2); /* ▖ k=5  bg=tl fg=tr   */
-  PICK(tl2, tl2, tr2, tr2); /* ▄ k=1  bg=tl fg=tr   */
-  PICK(tl2, tr2, tl2, tl2); /* ▝ k=3  bg=tl fg=tr   */
-  PICK(tl2, tr2, tl2, tr2); /* ▌ k=2  bg=tr fg=tl   */
-  PICK(tl2, tr2, tr2, tl2); /* ▞ k=6  bg=tl fg=tr   */
-  PICK(tl2, tr2, tr2, tr2); /* ▘ k=7  bg=tr fg=tl   */
-  PICK(tr2, bl2, bl2, bl2); /* ▘ k=7  bg=bl fg=tr   */
-  PICK(tr2, bl2, bl2, tr2); /* ▞ k=6  bg=tr fg=bl   */
-  PICK(tr2, bl2, tr2, bl2); /* ▌ k=2  bg=bl fg=tr   */
-  PICK(tr2, bl2, tr2, tr2); /* ▝ k=3  bg=tr fg=bl   */
-  PICK(tr2, br2, br2, br2); /* ▘ k=7  bg=br fg=tr   */
-  PICK(tr2, br2, br2, tr2); /* ▞ k=6  bg=tr fg=br   */
-  PICK(tr2, br2, tr2, br2); /* ▌ k=2  bg=br fg=tr   */
-  PICK(tr2, br2, tr2, tr2); /* ▝ k=3  bg=tr fg=br   */
-  PICK(tr2, tl2, tl2, tl2); /* ▘ k=7  bg=tl fg=tr   */
-  PICK(tr2, tl2, tl2, tr2); /* ▞ k=6  bg=tr fg=tl   */
-  PICK(tr2, tl2, tr2, tl2); /* ▌ k=2  bg=tl fg=tr   */
-  PICK(tr2, tl2, tr2, tr2); /* ▝ k=3  bg=tr fg=tl   */
-  PICK(tr2, tr2, bl2, bl2); /* ▄ k=1  bg=tr fg=bl   */
-  PICK(tr2, tr2, bl2, tr2); /* ▖ k=5  bg=tr fg=bl   */
-  PICK(tr2, tr2, br2, br2); /* ▄ k=1  bg=tr fg=br   */
-  PICK(tr2, tr2, br2, tr2); /* ▖ k=5  bg=tr fg=br   */
-  PICK(tr2, tr2, tl2, tl2); /* ▄ k=1  bg=tr fg=tl   */
-  PICK(tr2, tr2, tl2, tr2); /* ▖ k=5  bg=tr fg=tl   */
-  PICK(tr2, tr2, tr2, bl2); /* ▗ k=4  bg=tr fg=bl   */
-  PICK(tr2, tr2, tr2, br2); /* ▗ k=4  bg=tr fg=br   */
-  PICK(tr2, tr2, tr2, tl2); /* ▗ k=4  bg=tr fg=tl   */
-  PICK(tr2, tr2, tr2, tr2); /*   k=0  bg=tr fg=NULL */
-#undef PICK
-  return p;
+static void GetCellDists(uint16_t d[4][4], const struct TtyRgb t[4],
+                         const struct TtyRgb q[4]) {
+  unsigned i, j;
+  for (i = 0; i < 4; ++i) {
+    for (j = 0; j < 4; ++j) {
+      d[i][j] = ABS(t[i].r - q[j].r) + ABS(t[i].g - q[j].g) +
+                ABS(t[i].b - q[j].b);
+    }
+  }
 }
 
-static uint16_t *PickCp437(uint16_t *p, struct TtyRgb tl, struct TtyRgb tr,
-                           struct TtyRgb bl, struct TtyRgb br,
-                           struct TtyRgb tl2, struct TtyRgb tr2,
-                           struct TtyRgb bl2, struct TtyRgb br2) {
-#define PICK(A, B, C, D) *p++ = GetBlockDist(tl, tr, bl, br, A, B, C, D)
-  PICK(bl2, bl2, bl2, bl2); /*   k=0  bg=bl fg=NULL */
-  PICK(bl2, bl2, br2, br2); /* ▄ k=1  bg=bl fg=br   */
-  PICK(bl2, bl2, tl2, tl2); /* ▄ k=1  bg=bl fg=tl   */
-  PICK(bl2, bl2, tr2, tr2); /* ▄ k=1  bg=bl fg=tr   */
-  PICK(br2, br2, bl2, bl2); /* ▄ k=1  bg=br fg=bl   */
-  PICK(tl2, tl2, bl2, bl2); /* ▄ k=1  bg=tl fg=bl   */
-  PICK(tr2, tr2, bl2, bl2); /* ▄ k=1  bg=tr fg=bl   */
-  PICK(bl2, br2, bl2, br2); /* ▌ k=2  bg=br fg=bl   */
-  PICK(bl2, tl2, bl2, tl2); /* ▌ k=2  bg=tl fg=bl   */
-  PICK(bl2, tr2, bl2, tr2); /* ▌ k=2  bg=tr fg=bl   */
-  PICK(br2, bl2, br2, bl2); /* ▌ k=2  bg=bl fg=br   */
-  PICK(br2, br2, br2, br2); /*   k=0  bg=br fg=NULL */
-  PICK(br2, br2, tl2, tl2); /* ▄ k=1  bg=br fg=tl   */
-  PICK(br2, br2, tr2, tr2); /* ▄ k=1  bg=br fg=tr   */
-  PICK(br2, tl2, br2, tl2); /* ▌ k=2  bg=tl fg=br   */
-  PICK(br2, tr2, br2, tr2); /* ▌ k=2  bg=tr fg=br   */
-  PICK(tl2, bl2, tl2, bl2); /* ▌ k=2  bg=bl fg=tl   */
-  PICK(tl2, br2, tl2, br2); /* ▌ k=2  bg=br fg=tl   */
-  PICK(tl2, tl2, br2, br2); /* ▄ k=1  bg=tl fg=br   */
-  PICK(tl2, tl2, tl2, tl2); /*   k=0  bg=tl fg=NULL */
-  PICK(tl2, tl2, tr2, tr2); /* ▄ k=1  bg=tl fg=tr   */
-  PICK(tl2, tr2, tl2, tr2); /* ▌ k=2  bg=tr fg=tl   */
-  PICK(tr2, bl2, tr2, bl2); /* ▌ k=2  bg=bl fg=tr   */
-  PICK(tr2, br2, tr2, br2); /* ▌ k=2  bg=br fg=tr   */
-  PICK(tr2, tl2, tr2, tl2); /* ▌ k=2  bg=tl fg=tr   */
-  PICK(tr2, tr2, br2, br2); /* ▄ k=1  bg=tr fg=br   */
-  PICK(tr2, tr2, tl2, tl2); /* ▄ k=1  bg=tr fg=tl   */
-  PICK(tr2, tr2, tr2, tr2); /*   k=0  bg=tr fg=NULL */
-#undef PICK
-  return p;
+static void GetQuants(struct TtyRgb q[4], const struct TtyRgb t[4]) {
+  q[TL] = g_ansi2rgb_[t[TL].xt];
+  q[TR] = g_ansi2rgb_[t[TR].xt];
+  q[BL] = g_ansi2rgb_[t[BL].xt];
+  q[BR] = g_ansi2rgb_[t[BR].xt];
 }
 
-static struct Pick PickBlockUnicodeAnsi(struct TtyRgb tl, struct TtyRgb tr,
-                                        struct TtyRgb bl, struct TtyRgb br) {
-  struct TtyRgb tl2 = GetQuant(tl);
-  struct TtyRgb tr2 = GetQuant(tr);
-  struct TtyRgb bl2 = GetQuant(bl);
-  struct TtyRgb br2 = GetQuant(br);
+static struct Pick PickBlockUnicodeAnsi(const struct TtyRgb t[4]) {
   unsigned p1, p2;
+  uint16_t d[4][4];
+  struct TtyRgb q[4];
   uint16_t picks1[96] forcealign(32);
   uint16_t picks2[32] forcealign(32);
-  memset(picks1, 0x79, sizeof(picks1));
-  memset(picks2, 0x79, sizeof(picks2));
-  PickUnicode(picks1, tl, tr, bl, br, tl2, tr2, bl2, br2);
-  MixBlock(picks2, tl, tr, bl, br, tl2, tr2, bl2, br2);
+  GetQuants(q, t);
+  GetCellDists(d, t, q);
+  ttypicks(picks1, d, g_cells.unicode[0], 96);
+  ttymix(picks2, t, q, &kMixBlock);
+  memset(picks1 + 88, 0x79, 8 * sizeof(uint16_t));
   p1 = windex(picks1, 96);
   p2 = windex(picks2, 32);
   return picks1[p1] <= picks2[p2] ? kPicksUnicode[p1] : kPicksMixBlock[p2];
 }
 
-static struct Pick PickBlockUnicodeTrue(struct TtyRgb tl, struct TtyRgb tr,
-                                        struct TtyRgb bl, struct TtyRgb br) {
-  unsigned i;
+static struct Pick PickBlockUnicodeTrue(const struct TtyRgb t[4]) {
+  uint16_t d[4][4];
   uint16_t picks[96] forcealign(32);
-  memset(picks, 0x79, sizeof(picks));
-  PickUnicode(picks, tl, tr, bl, br, tl, tr, bl, br);
-  i = windex(picks, 96);
-  return kPicksUnicode[i];
+  GetCellDists(d, t, t);
+  ttypicks(picks, d, g_cells.unicode[0], 96);
+  memset(picks + 88, 0x79, 8 * sizeof(uint16_t));
+  return kPicksUnicode[windex(picks, 96)];
 }
 
-static struct Pick PickBlockCp437Ansi(struct TtyRgb tl, struct TtyRgb tr,
-                                      struct TtyRgb bl, struct TtyRgb br) {
-  struct TtyRgb tl2 = GetQuant(tl);
-  struct TtyRgb tr2 = GetQuant(tr);
-  struct TtyRgb bl2 = GetQuant(bl);
-  struct TtyRgb br2 = GetQuant(br);
+static struct Pick PickBlockCp437Ansi(const struct TtyRgb t[4]) {
   unsigned p1, p2;
+  uint16_t d[4][4];
+  struct TtyRgb q[4];
   uint16_t picks1[32] forcealign(32);
   uint16_t picks2[32] forcealign(32);
-  memset(picks1, 0x79, sizeof(picks1));
-  memset(picks2, 0x79, sizeof(picks2));
-  PickCp437(picks1, tl, tr, bl, br, tl2, tr2, bl2, br2);
-  MixBlock(picks2, tl, tr, bl, br, tl2, tr2, bl2, br2);
+  GetQuants(q, t);
+  GetCellDists(d, t, q);
+  ttypicks(picks1, d, g_cells.cp437[0], 32);
+  ttymix(picks2, t, q, &kMixBlock);
+  memset(picks1 + 28, 0x79, 4 * sizeof(uint16_t));
   p1 = windex(picks1, 32);
   p2 = windex(picks2, 32);
   return picks1[p1] <= picks2[p2] ? kPicksCp437[p1] : kPicksMixBlock[p2];
 }
 
-static struct Pick PickBlockCp437True(struct TtyRgb tl, struct TtyRgb tr,
-                                      struct TtyRgb bl, struct TtyRgb br) {
+static struct Pick PickBlockCp437True(const struct TtyRgb t[4]) {
+  uint16_t d[4][4];
   uint16_t picks[32] forcealign(32);
-  memset(picks, 0x79, sizeof(picks));
-  PickCp437(picks, tl, tr, bl, br, tl, tr, bl, br);
+  GetCellDists(d, t, t);
+  ttypicks(picks, d, g_cells.cp437[0], 32);
+  memset(picks + 28, 0x79, 4 * sizeof(uint16_t));
   return kPicksCp437[windex(picks, 32)];
 }
 
@@ -754,6 +475,10 @@ static dontinline char *CopyRun(char *v, size_t n,
 
 /**
  * Maps 2×2 pixel chunks onto ANSI UNICODE cells.
+ *
+ * Runs of identical chunks are only scored once, after which the cell
+ * is copied with just the escape codes needed to get the glyph colors.
+ *
  * @note h/t Nick Black for his quadrant blitting work on notcurses
  * @note yn and xn need to be even
  */
@@ -763,6 +488,20 @@ char *ttyraster(char *v, const struct TtyRgb *c, size_t yn, size_t xn,
   struct Pick p;
   struct Glyph glyph;
   struct TtyRgb chun[4], lastchunk[4];
+  struct Pick (*pick)(const struct TtyRgb[4]);
+  if (ttyquant()->alg == kTtyQuantTrue) {
+    if (ttyquant()->blocks == kTtyBlocksCp437) {
+      pick = PickBlockCp437True;
+    } else {
+      pick = PickBlockUnicodeTrue;
+    }
+  } else {
+    if (ttyquant()->blocks == kTtyBlocksCp437) {
+      pick = PickBlockCp437Ansi;
+    } else {
+      pick = PickBlockUnicodeAnsi;
+    }
+  }
   for (y = 0; y < yn; y += 2, c += xn) {
     if (y) {
       v = stpcpy(v, "\e[0m\r\n");
@@ -770,23 +509,48 @@ char *ttyraster(char *v, const struct TtyRgb *c, size_t yn, size_t xn,
     }
     for (x = 0; x < xn; x += 2, c += 2) {
       CopyChunk(chun, c, xn);
-      if (ttyquant()->alg == kTtyQuantTrue) {
-        if (ttyquant()->blocks == kTtyBlocksCp437) {
-          p = PickBlockCp437True(chun[TL], chun[TR], chun[BL], chun[BR]);
-        } else {
-          p = PickBlockUnicodeTrue(chun[TL], chun[TR], chun[BL], chun[BR]);
-        }
-      } else {
-        if (ttyquant()->blocks == kTtyBlocksCp437) {
-          p = PickBlockCp437Ansi(chun[TL], chun[TR], chun[BL], chun[BR]);
-        } else {
-          p = PickBlockUnicodeAnsi(chun[TL], chun[TR], chun[BL], chun[BR]);
-        }
+      if ((!y && !x) || memcmp(chun, lastchunk, sizeof(chun))) {
+        p = pick(chun);
+        memcpy(lastchunk, chun, sizeof(chun));
       }
       v = CopyBlock(v, chun, p, &bg, &fg, &glyph);
-      memcpy(lastchunk, chun, sizeof(chun));
     }
   }
   v = stpcpy(v, "\e[0m");
   return v;
 }
+
+static void InitCells(uint8_t *c, const struct Pick *picks, size_t n) {
+  size_t i, k;
+  for (k = 0; k < n; ++k) {
+    if (picks[k].k < ARRAYLEN(kQuadrants)) {
+      for (i = 0; i < 4; ++i) {
+        if (kQuadrants[picks[k].k] & 1 << i) {
+          c[i * n + k] = picks[k].fg;
+        } else {
+          c[i * n + k] = picks[k].bg;
+        }
+      }
+    }
+  }
+}
+
+__attribute__((__constructor__)) static void init_ttyraster(void) {
+  InitCells(g_cells.unicode[0], kPicksUnicode, ARRAYLEN(kPicksUnicode));
+  InitCells(g_cells.cp437[0], kPicksCp437, ARRAYLEN(kPicksCp437));
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2)) {
+    ttypicks = ttypicks_avx2;
+    ttymix = ttymix_avx2;
+  } else if (X86_HAVE(SSSE3)) {
+    ttypicks = ttypicks_ssse3;
+    ttymix = ttymix_ssse3;
+  } else {
+    ttypicks = ttypicks_k8;
+    ttymix = ttymix_k8;
+  }
+#else
+  ttypicks = ttypicks_k8;
+  ttymix = ttymix_k8;
+#endif
+}
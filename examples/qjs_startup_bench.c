@@ -0,0 +1,220 @@
+#if 0
+/*─────────────────────────────────────────────────────────────────╗
+│ To the extent possible under law, Justine Tunney has waived      │
+│ all copyright and related or neighboring rights to this file,    │
+│ as it is written in the following disclaimers:                   │
+│   • http://unlicense.org/                                        │
+│   • http://creativecommons.org/publicdomain/zero/1.0/            │
+╚─────────────────────────────────────────────────────────────────*/
+#endif
+#include "libc/calls/struct/timespec.h"
+#include "libc/calls/weirdtypes.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/clock.h"
+#include "third_party/quickjs/cutils.h"
+#include "third_party/quickjs/quickjs-libc.h"
+#include "third_party/quickjs/quickjs.h"
+
+/**
+ * @fileoverview QuickJS startup benchmark
+ *
+ * Compares what `qjs` spends getting a script ready to run when it has
+ * to parse the source, versus loading the bytecode snapshot that `qjsc
+ * -b` produces for /zip/.qjs/. Every iteration uses a fresh runtime, as
+ * a short-lived process would. Like qjs, snapshots are read before the
+ * intrinsics are added, since JS_READ_OBJ_ROM_DATA only avoids copying
+ * the bytecode when the context has no atoms besides the builtin ones.
+ *
+ *     make -j8 o//examples/qjs_startup_bench.com
+ *     o//examples/qjs_startup_bench.com third_party/quickjs/repl.js
+ */
+
+#define ITERATIONS 100
+
+static struct timespec SubtractTime(struct timespec a, struct timespec b) {
+  a.tv_sec -= b.tv_sec;
+  if (a.tv_nsec < b.tv_nsec) {
+    a.tv_nsec += 1000000000;
+    a.tv_sec--;
+  }
+  a.tv_nsec -= b.tv_nsec;
+  return a;
+}
+
+static time_t ToNanoseconds(struct timespec ts) {
+  return ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static char *Ithoa(char p[27], unsigned long x) {
+  char m[26];
+  unsigned i;
+  i = 0;
+  do {
+    m[i++] = x % 10 + '0';
+    x = x / 10;
+  } while (x);
+  for (;;) {
+    *p++ = m[--i];
+    if (!i) break;
+    if (!(i % 3)) *p++ = ',';
+  }
+  *p = '\0';
+  return p;
+}
+
+#define BENCH(name, x)                                             \
+  {                                                                \
+    int i;                                                         \
+    char ibuf[27];                                                 \
+    struct timespec t1, t2;                                        \
+    clock_gettime(CLOCK_REALTIME, &t1);                            \
+    for (i = 0; i < ITERATIONS; ++i) {                             \
+      x;                                                           \
+    }                                                              \
+    clock_gettime(CLOCK_REALTIME, &t2);                            \
+    Ithoa(ibuf, ToNanoseconds(SubtractTime(t2, t1)) / ITERATIONS); \
+    printf("%-50s %16s ns\n", name, ibuf);                         \
+  }
+
+const char *path;
+uint8_t *source;
+size_t sourcesize;
+uint8_t *snapshot;
+size_t snapshotsize;
+int ismodule;
+
+static int DummyInit(JSContext *ctx, JSModuleDef *m) {
+  return 0;
+}
+
+// imports aren't part of a snapshot, so keep them out of the parse time
+static JSModuleDef *DummyLoader(JSContext *ctx, const char *name, void *arg) {
+  return JS_NewCModule(ctx, name, DummyInit);
+}
+
+static JSContext *NewRawContext(void) {
+  JSRuntime *rt;
+  JSContext *ctx;
+  if (!(rt = JS_NewRuntime()) || !(ctx = JS_NewContextRaw(rt))) {
+    fprintf(stderr, "error: out of memory\n");
+    exit(1);
+  }
+  JS_SetModuleLoaderFunc(rt, NULL, DummyLoader, NULL);
+  return ctx;
+}
+
+// same as what JS_NewContext() adds to JS_NewContextRaw()
+static void AddIntrinsics(JSContext *ctx) {
+  JS_AddIntrinsicBaseObjects(ctx);
+  JS_AddIntrinsicDate(ctx);
+  JS_AddIntrinsicEval(ctx);
+  JS_AddIntrinsicStringNormalize(ctx);
+  JS_AddIntrinsicRegExp(ctx);
+  JS_AddIntrinsicJSON(ctx);
+  JS_AddIntrinsicProxy(ctx);
+  JS_AddIntrinsicMapSet(ctx);
+  JS_AddIntrinsicTypedArrays(ctx);
+  JS_AddIntrinsicPromise(ctx);
+  JS_AddIntrinsicBigInt(ctx);
+}
+
+static JSContext *NewContext(void) {
+  JSContext *ctx = NewRawContext();
+  AddIntrinsics(ctx);
+  return ctx;
+}
+
+static void FreeContext(JSContext *ctx, JSValue obj) {
+  JSRuntime *rt;
+  if (JS_IsException(obj)) {
+    js_std_dump_error(ctx);
+    exit(1);
+  }
+  JS_FreeValue(ctx, obj);
+  rt = JS_GetRuntime(ctx);
+  JS_FreeContext(ctx);
+  JS_FreeRuntime(rt);
+}
+
+static JSValue Parse(JSContext *ctx) {
+  return JS_Eval(ctx, (const char *)source, sourcesize, path,
+                 JS_EVAL_FLAG_COMPILE_ONLY |
+                     (ismodule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL));
+}
+
+void Startup(void) {
+  FreeContext(NewContext(), JS_UNDEFINED);
+}
+
+void ParseSource(void) {
+  JSContext *ctx = NewContext();
+  FreeContext(ctx, Parse(ctx));
+}
+
+void LoadSnapshot(void) {
+  JSValue obj;
+  JSContext *ctx = NewRawContext();
+  obj = JS_ReadObject(ctx, snapshot, snapshotsize, JS_READ_OBJ_BYTECODE);
+  AddIntrinsics(ctx);
+  FreeContext(ctx, obj);
+}
+
+void LoadSnapshotInPlace(void) {
+  JSValue obj;
+  JSContext *ctx = NewRawContext();
+  obj = JS_ReadObject(ctx, snapshot, snapshotsize,
+                      JS_READ_OBJ_BYTECODE | JS_READ_OBJ_ROM_DATA);
+  AddIntrinsics(ctx);
+  FreeContext(ctx, obj);
+}
+
+void HashSource(void) {
+  char name[JS_SNAPSHOT_NAME_MAX];
+  js_snapshot_name(name, source, sourcesize);
+}
+
+int main(int argc, char *argv[]) {
+  uint8_t *p;
+  JSContext *ctx;
+  JSValue obj;
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s FILE.js\n", argv[0]);
+    return 1;
+  }
+  path = argv[1];
+  if (!(source = js_load_file(NULL, &sourcesize, path))) {
+    perror(path);
+    return 1;
+  }
+  ismodule = has_suffix(path, ".mjs") ||
+             JS_DetectModule((const char *)source, sourcesize);
+
+  // same as `qjsc -b` would write
+  ctx = NewContext();
+  obj = Parse(ctx);
+  if (JS_IsException(obj) ||
+      !(p = JS_WriteObject(ctx, &snapshotsize, obj, JS_WRITE_OBJ_BYTECODE))) {
+    js_std_dump_error(ctx);
+    return 1;
+  }
+  snapshot = malloc(snapshotsize);
+  memcpy(snapshot, p, snapshotsize);
+  js_free(ctx, p);
+  FreeContext(ctx, obj);
+
+  printf("%s is a %zu byte %s with a %zu byte snapshot\n", path, sourcesize,
+         ismodule ? "module" : "script", snapshotsize);
+  BENCH("JS_NewRuntime() + JS_NewContext()", Startup());
+  BENCH("js_snapshot_name()", HashSource());
+  BENCH("JS_Eval(JS_EVAL_FLAG_COMPILE_ONLY)", ParseSource());
+  BENCH("JS_ReadObject()", LoadSnapshot());
+  BENCH("JS_ReadObject(JS_READ_OBJ_ROM_DATA)", LoadSnapshotInPlace());
+
+  free(snapshot);
+  free(source);
+  return 0;
+}
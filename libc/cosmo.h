@@ -2,7 +2,16 @@
 #define COSMOPOLITAN_LIBC_COSMO_H_
 COSMOPOLITAN_C_START_
 
+struct CosmoZiposStats {
+  uint64_t hits;      /* opens of compressed assets sharing a blob */
+  uint64_t misses;    /* opens of compressed assets decoded anew */
+  uint64_t evictions; /* blobs dropped to stay within budget */
+  uint64_t idlebytes; /* decoded size of blobs no fd references */
+  uint64_t budget;    /* see COSMOPOLITAN_ZIPOS_CACHE */
+};
+
 errno_t cosmo_once(_Atomic(uint32_t) *, void (*)(void));
+void cosmo_zipos_stats(struct CosmoZiposStats *);
 int systemvpe(const char *, char *const[], char *const[]);
 
 COSMOPOLITAN_C_END_
@@ -56,6 +56,45 @@ static inline const unsigned char *memchr_sse(const unsigned char *s,
   }
   return 0;
 }
+
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef char zmm_t __attribute__((__vector_size__(64), __aligned__(1)));
+
+_Microarchitecture("avx2") static const unsigned char *memchr_avx2(
+    const unsigned char *s, unsigned char c, size_t n) {
+  unsigned m;
+  uint64_t w;
+  ymm_t v, x, t = (ymm_t){} + (char)c;
+  for (; n >= 64; n -= 64, s += 64) {
+    v = ((const ymm_t *)s)[0] == t;
+    x = ((const ymm_t *)s)[1] == t;
+    if (__builtin_ia32_pmovmskb256(v | x)) {
+      w = (uint64_t)(unsigned)__builtin_ia32_pmovmskb256(x) << 32 |
+          (unsigned)__builtin_ia32_pmovmskb256(v);
+      return s + __builtin_ctzll(w);
+    }
+  }
+  if (n >= 32) {
+    if ((m = __builtin_ia32_pmovmskb256(*(const ymm_t *)s == t))) {
+      return s + __builtin_ctz(m);
+    }
+    n -= 32;
+    s += 32;
+  }
+  return memchr_sse(s, c, n);
+}
+
+_Microarchitecture("avx2,avx512f,avx512bw") static const unsigned char *
+memchr_avx512(const unsigned char *s, unsigned char c, size_t n) {
+  uint64_t m;
+  zmm_t t = (zmm_t){} + (char)c;
+  for (; n >= 64; n -= 64, s += 64) {
+    if ((m = __builtin_ia32_pcmpeqb512_mask(*(const zmm_t *)s, t, -1))) {
+      return s + __builtin_ctzll(m);
+    }
+  }
+  return memchr_avx2(s, c, n);
+}
 #endif
 
 /**
@@ -71,7 +110,13 @@ void *memchr(const void *s, int c, size_t n) {
 #if defined(__x86_64__) && !defined(__chibicc__)
   const void *r;
   if (IsAsan()) __asan_verify(s, n);
-  r = memchr_sse(s, c, n);
+  if (n >= 4096 && X86_HAVE(AVX512BW)) {
+    r = memchr_avx512(s, c, n);
+  } else if (n >= 32 && X86_HAVE(AVX2)) {
+    r = memchr_avx2(s, c, n);
+  } else {
+    r = memchr_sse(s, c, n);
+  }
   return (void *)r;
 #else
   return (void *)memchr_pure(s, c, n);
@@ -101,6 +101,53 @@ _Microarchitecture("avx") static int memcmp_avx(const unsigned char *p,
   }
 }
 
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+
+_Microarchitecture("avx2") static int memcmp_avx2(const unsigned char *p,
+                                                  const unsigned char *q,
+                                                  size_t n) {
+  uint64_t w;
+  unsigned u;
+  while (n >= 32 + 64) {
+    w = (uint64_t)(unsigned)__builtin_ia32_pmovmskb256(
+            ((ymm_t *)p)[0] == ((ymm_t *)q)[0]) |
+        (uint64_t)(unsigned)__builtin_ia32_pmovmskb256(
+            ((ymm_t *)p)[1] == ((ymm_t *)q)[1])
+            << 040;
+    if (w == -1) {
+      n -= 64;
+      p += 64;
+      q += 64;
+    } else {
+      w = __builtin_ctzll(w ^ -1);
+      return p[w] - q[w];
+    }
+  }
+  while (n > 32 + 32) {
+    if (!(u = __builtin_ia32_pmovmskb256(*(ymm_t *)p == *(ymm_t *)q) ^ -1u)) {
+      n -= 32;
+      p += 32;
+      q += 32;
+    } else {
+      u = __builtin_ctzl(u);
+      return p[u] - q[u];
+    }
+  }
+  if (!(u = __builtin_ia32_pmovmskb256(*(ymm_t *)p == *(ymm_t *)q) ^ -1u)) {
+    if (!(u = __builtin_ia32_pmovmskb256(*(ymm_t *)(p + n - 32) ==
+                                         *(ymm_t *)(q + n - 32)) ^
+              -1u)) {
+      return 0;
+    } else {
+      u = __builtin_ctzl(u);
+      return p[n - 32 + u] - q[n - 32 + u];
+    }
+  } else {
+    u = __builtin_ctzl(u);
+    return p[u] - q[u];
+  }
+}
+
 #endif /* __x86_64__ */
 
 /**
@@ -191,6 +238,8 @@ int memcmp(const void *a, const void *b, size_t n) {
         u = u & -8;
         return ((i >> u) & 255) - ((j >> u) & 255);
       }
+    } else if (n >= 32 && X86_HAVE(AVX2)) {
+      return memcmp_avx2(p, q, n);
     } else if (LIKELY(X86_HAVE(AVX))) {
       return memcmp_avx(p, q, n);
     } else {
@@ -26,6 +26,65 @@
 
 typedef long long xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
 typedef long long xmm_a __attribute__((__vector_size__(16), __aligned__(16)));
+typedef long long ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef long long ymm_a __attribute__((__vector_size__(32), __aligned__(32)));
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+// copies 64-byte blocks forward leaving n%64 bytes, returns bytes done
+_Microarchitecture("avx2") static size_t memmove_avx2_fwd(char *d,
+                                                         const char *s,
+                                                         size_t n, bool nt) {
+  size_t i = 0;
+  ymm_t v, w;
+  if (nt) {
+    while ((uintptr_t)(d + i) & 31) {
+      d[i] = s[i];
+      ++i;
+    }
+  }
+  while (i + 64 <= n) {
+    v = *(const ymm_t *)(s + i);
+    w = *(const ymm_t *)(s + i + 32);
+    if (nt) {
+      __builtin_ia32_movntdq256((ymm_a *)(d + i), v);
+      __builtin_ia32_movntdq256((ymm_a *)(d + i + 32), w);
+    } else {
+      *(ymm_t *)(d + i) = v;
+      *(ymm_t *)(d + i + 32) = w;
+    }
+    i += 64;
+  }
+  return i;
+}
+
+// copies 64-byte blocks backward leaving n%64 bytes, returns bytes left
+_Microarchitecture("avx2") static size_t memmove_avx2_bwd(char *d,
+                                                         const char *s,
+                                                         size_t n, bool nt) {
+  ymm_t v, w;
+  if (nt) {
+    while ((uintptr_t)(d + n) & 31) {
+      --n;
+      d[n] = s[n];
+    }
+  }
+  while (n >= 64) {
+    n -= 64;
+    v = *(const ymm_t *)(s + n);
+    w = *(const ymm_t *)(s + n + 32);
+    if (nt) {
+      __builtin_ia32_movntdq256((ymm_a *)(d + n), v);
+      __builtin_ia32_movntdq256((ymm_a *)(d + n + 32), w);
+    } else {
+      *(ymm_t *)(d + n) = v;
+      *(ymm_t *)(d + n + 32) = w;
+    }
+  }
+  return n;
+}
+
+#endif /* __x86_64__ */
 
 /**
  * Copies memory.
@@ -215,7 +274,31 @@ void *memmove(void *dst, const void *src, size_t n) {
       if (d == s) return d;
 
 #if defined(__x86_64__) && !defined(__chibicc__)
-      if (n < kHalfCache3 || !kHalfCache3) {
+      if (!IsAsan() && X86_HAVE(AVX2) &&
+          (n < 900 || d > s || !X86_HAVE(ERMS) ||
+           (kHalfCache3 && n >= kHalfCache3))) {
+        bool nt = kHalfCache3 && n >= kHalfCache3;
+        if (d > s) {
+          n = memmove_avx2_bwd(d, s, n, nt);
+        } else {
+          i = memmove_avx2_fwd(d, s, n, nt);
+          d += i;
+          s += i;
+          n -= i;
+        }
+        if (nt) asm("sfence");
+        if (n > 32) {
+          v = *(const xmm_t *)s;
+          w = *(const xmm_t *)(s + 16);
+          x = *(const xmm_t *)(s + n - 32);
+          y = *(const xmm_t *)(s + n - 16);
+          *(xmm_t *)d = v;
+          *(xmm_t *)(d + 16) = w;
+          *(xmm_t *)(d + n - 32) = x;
+          *(xmm_t *)(d + n - 16) = y;
+          return dst;
+        }
+      } else if (n < kHalfCache3 || !kHalfCache3) {
         if (d > s) {
           if (IsAsan() || n < 900 || !X86_HAVE(ERMS)) {
             do {
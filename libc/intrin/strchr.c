@@ -53,6 +53,31 @@ static inline const char *strchr_sse(const char *s, unsigned char c) {
   if (c && !*s) s = 0;
   return s;
 }
+
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(32)));
+_Microarchitecture("avx2") static const char *strchr_avx2(const char *s,
+                                                          unsigned char c) {
+  unsigned k;
+  unsigned m;
+  const ymm_t *p;
+  ymm_t v;
+  ymm_t z = {0};
+  ymm_t n = (ymm_t){} + (char)c;
+  k = (uintptr_t)s & 31;
+  p = (const ymm_t *)((uintptr_t)s & -32);
+  v = *p;
+  m = __builtin_ia32_pmovmskb256((v == z) | (v == n));
+  m >>= k;
+  m <<= k;
+  while (!m) {
+    v = *++p;
+    m = __builtin_ia32_pmovmskb256((v == z) | (v == n));
+  }
+  m = __builtin_ctzl(m);
+  s = (const char *)p + m;
+  if (c && !*s) s = 0;
+  return s;
+}
 #endif
 
 static inline const char *strchr_x64(const char *p, uint64_t c) {
@@ -97,7 +122,9 @@ static inline const char *strchr_x64(const char *p, uint64_t c) {
 char *strchr(const char *s, int c) {
 #if defined(__x86_64__) && !defined(__chibicc__)
   const char *r;
-  if (X86_HAVE(SSE)) {
+  if (X86_HAVE(AVX2)) {
+    r = strchr_avx2(s, c);
+  } else if (X86_HAVE(SSE)) {
     r = strchr_sse(s, c);
   } else {
     r = strchr_pure(s, c);
@@ -17,9 +17,23 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/dce.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #ifndef __aarch64__
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(32)));
+
+_Microarchitecture("avx2") static size_t strlen_avx2(const char *s) {
+  ymm_t z = {0};
+  unsigned m, k = (uintptr_t)s & 31;
+  const ymm_t *p = (const ymm_t *)((uintptr_t)s & -32);
+  m = (unsigned)__builtin_ia32_pmovmskb256(*p == z) >> k << k;
+  while (!m) m = __builtin_ia32_pmovmskb256(*++p == z);
+  return (const char *)p + __builtin_ctz(m) - s;
+}
+#endif
+
 /**
  * Returns length of NUL-terminated string.
  *
@@ -30,6 +44,7 @@
 size_t strlen(const char *s) {
 #if defined(__x86_64__) && !defined(__chibicc__)
   typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+  if (X86_HAVE(AVX2)) return strlen_avx2(s);
   xmm_t z = {0};
   unsigned m, k = (uintptr_t)s & 15;
   const xmm_t *p = (const xmm_t *)((uintptr_t)s & -16);
@@ -30,6 +30,7 @@ int mergesort_r(void *, size_t, size_t,
 
 int radix_sort_int32(int32_t *, size_t);
 int radix_sort_int64(int64_t *, size_t);
+int radix_sort_uint64_pairs(uint64_t (*)[2], size_t);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_ALG_ALG_H_ */
@@ -0,0 +1,99 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+
+#define HIST_SIZE         (size_t)2048
+#define get_digit(v, j)   (((v) >> (11 * (j))) & 0x7FF)
+
+static int CompareKeys(const void *a, const void *b) {
+  const uint64_t *x = a;
+  const uint64_t *y = b;
+  if (x[0] < y[0]) return -1;
+  if (x[0] > y[0]) return +1;
+  return 0;
+}
+
+/**
+ * Sorts key/value pairs by unsigned 64-bit key.
+ *
+ * Element `A[i][0]` is the key and `A[i][1]` is carried along with it.
+ * This is a stable least significant digit radix sort, which moves 16
+ * bytes per element per pass. Passes where every key has the same
+ * digit are skipped, so keys which only use the low bits are cheaper.
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int radix_sort_uint64_pairs(uint64_t (*A)[2], size_t n) {
+  size_t i, j, pos, sum, tsum, *b, *h;
+  uint64_t(*T)[2], (*reader)[2], (*writer)[2], (*swap)[2];
+
+  if (n < HIST_SIZE) {
+    return mergesort(A, n, sizeof(*A), CompareKeys);
+  }
+
+  if (!(T = malloc(n * sizeof(*A)))) {
+    return -1;
+  }
+
+  if (!(b = calloc(HIST_SIZE * 6, sizeof(size_t)))) {
+    free(T);
+    return -1;
+  }
+
+  for (i = 0; i < n; i++) {
+    b[HIST_SIZE * 0 + get_digit(A[i][0], 0)]++;
+    b[HIST_SIZE * 1 + get_digit(A[i][0], 1)]++;
+    b[HIST_SIZE * 2 + get_digit(A[i][0], 2)]++;
+    b[HIST_SIZE * 3 + get_digit(A[i][0], 3)]++;
+    b[HIST_SIZE * 4 + get_digit(A[i][0], 4)]++;
+    b[HIST_SIZE * 5 + get_digit(A[i][0], 5)]++;
+  }
+
+  reader = A;
+  writer = T;
+  for (j = 0; j < 6; j++) {
+    h = b + HIST_SIZE * j;
+    if (h[get_digit(reader[0][0], j)] == n) {
+      continue;
+    }
+    for (sum = i = 0; i < HIST_SIZE; i++) {
+      tsum = h[i] + sum;
+      h[i] = sum;
+      sum = tsum;
+    }
+    for (i = 0; i < n; i++) {
+      pos = h[get_digit(reader[i][0], j)]++;
+      writer[pos][0] = reader[i][0];
+      writer[pos][1] = reader[i][1];
+    }
+    swap = reader;
+    reader = writer;
+    writer = swap;
+  }
+
+  if (reader != A) {
+    memcpy(A, reader, n * sizeof(*A));
+  }
+
+  free(b);
+  free(T);
+  return 0;
+}
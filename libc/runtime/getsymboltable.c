@@ -76,6 +76,14 @@ static struct SymbolTable *GetSymbolTableFromZip(struct Zipos *zipos) {
             res = 0;
           }
           break;
+        case kZipCompressionZstd:
+          if (__unzstd((void *)res, size,
+                       (void *)ZIP_LFILE_CONTENT(zipos->map + lf),
+                       GetZipLfileCompressedSize(zipos->map + lf))) {
+            munmap(res, size2);
+            res = 0;
+          }
+          break;
         default:
           munmap(res, size2);
           res = 0;
@@ -0,0 +1,207 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/fmt/conv.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/dll.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview Shared decompression cache for zipos.
+ *
+ * Compressed assets are decoded into a blob that's shared by every
+ * file descriptor opened on the same central directory record. Blobs
+ * which no file descriptor references are kept around on a least
+ * recently used list until their combined decoded size exceeds the
+ * budget, which may be configured using the `COSMOPOLITAN_ZIPOS_CACHE`
+ * environment variable. The budget only limits idle blobs, so assets
+ * larger than it are still shared by concurrent opens, but they're
+ * dropped as soon as the last file descriptor using them is closed.
+ */
+
+#define ZIPOS_CACHE_BUCKETS 1024
+#define ZIPOS_CACHE_BUDGET  (32 * 1024 * 1024)
+
+static struct ZiposCache {
+  pthread_mutex_t lock;
+  atomic_uint once;
+  size_t budget;
+  size_t idlebytes;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  struct Dll *idle;
+  struct ZiposHandle *buckets[ZIPOS_CACHE_BUCKETS];
+} __zipos_cache;
+
+static void __zipos_cache_setup(void) {
+  char *s, *e;
+  long x;
+  __zipos_cache.budget = ZIPOS_CACHE_BUDGET;
+  if ((s = getenv("COSMOPOLITAN_ZIPOS_CACHE")) &&
+      (x = strtol(s, &e, 10)) >= 0 && !*e) {
+    __zipos_cache.budget = x;
+  }
+}
+
+static void __zipos_cache_wipe(void) {
+  pthread_mutex_init(&__zipos_cache.lock, 0);
+}
+
+static void __zipos_cache_lock(void) {
+  cosmo_once(&__zipos_cache.once, __zipos_cache_setup);
+  pthread_mutex_lock(&__zipos_cache.lock);
+}
+
+static void __zipos_cache_unlock(void) {
+  pthread_mutex_unlock(&__zipos_cache.lock);
+}
+
+static struct ZiposHandle **__zipos_cache_bucket(size_t cfile) {
+  return __zipos_cache.buckets + (cfile * 0x9e3779b97f4a7c15 >> 54) %
+                                     ZIPOS_CACHE_BUCKETS;
+}
+
+static void __zipos_cache_unhash(struct ZiposHandle *b) {
+  struct ZiposHandle **p;
+  for (p = __zipos_cache_bucket(b->cfile); *p != b; p = &(*p)->chain) {
+  }
+  *p = b->chain;
+}
+
+// removes blob from idle list so that it can't be evicted
+static void __zipos_cache_claim(struct ZiposHandle *b) {
+  if (!atomic_load_explicit(&b->refs, memory_order_relaxed)) {
+    dll_remove(&__zipos_cache.idle, &b->elem);
+    __zipos_cache.idlebytes -= b->size;
+  }
+  __zipos_keep(b);
+}
+
+/**
+ * Returns shared inflation of central directory record.
+ *
+ * @return blob with a new reference, or null if not cached
+ */
+struct ZiposHandle *__zipos_cache_get(struct Zipos *zipos, size_t cfile) {
+  struct ZiposHandle *b;
+  __zipos_cache_lock();
+  for (b = *__zipos_cache_bucket(cfile); b; b = b->chain) {
+    if (b->zipos == zipos && b->cfile == cfile) {
+      __zipos_cache_claim(b);
+      break;
+    }
+  }
+  if (b) {
+    ++__zipos_cache.hits;
+  } else {
+    ++__zipos_cache.misses;
+  }
+  __zipos_cache_unlock();
+  return b;
+}
+
+/**
+ * Publishes newly created blob to cache.
+ *
+ * If another thread inflated the same record concurrently then its blob
+ * is returned instead, and the one passed to this function is freed.
+ *
+ * @return blob with a new reference
+ */
+struct ZiposHandle *__zipos_cache_put(struct ZiposHandle *b) {
+  struct ZiposHandle *o, **p;
+  __zipos_cache_lock();
+  p = __zipos_cache_bucket(b->cfile);
+  for (o = *p; o; o = o->chain) {
+    if (o->zipos == b->zipos && o->cfile == b->cfile) {
+      __zipos_cache_claim(o);
+      break;
+    }
+  }
+  if (!o) {
+    b->chain = *p;
+    *p = b;
+    __zipos_keep(b);
+  }
+  __zipos_cache_unlock();
+  if (o) {
+    __zipos_free(b);
+    return o;
+  }
+  return b;
+}
+
+/**
+ * Releases reference to blob obtained from cache.
+ */
+void __zipos_cache_release(struct ZiposHandle *b) {
+  struct Dll *e;
+  struct ZiposHandle *v, *evicted = 0;
+  __zipos_cache_lock();
+  if (atomic_fetch_sub_explicit(&b->refs, 1, memory_order_release) != 1) {
+    // other file descriptors are still using it
+  } else if (b->size > __zipos_cache.budget) {
+    // keeping it idle would push out everything else, so drop it now
+    __zipos_cache_unhash(b);
+    ++__zipos_cache.evictions;
+    b->chain = evicted;
+    evicted = b;
+  } else {
+    dll_init(&b->elem);
+    dll_make_first(&__zipos_cache.idle, &b->elem);
+    __zipos_cache.idlebytes += b->size;
+    while (__zipos_cache.idlebytes > __zipos_cache.budget &&
+           (e = dll_last(__zipos_cache.idle))) {
+      v = DLL_CONTAINER(struct ZiposHandle, elem, e);
+      dll_remove(&__zipos_cache.idle, e);
+      __zipos_cache.idlebytes -= v->size;
+      __zipos_cache_unhash(v);
+      ++__zipos_cache.evictions;
+      v->chain = evicted;
+      evicted = v;
+    }
+  }
+  __zipos_cache_unlock();
+  while ((v = evicted)) {
+    evicted = v->chain;
+    __zipos_free(v);
+  }
+}
+
+/**
+ * Reports statistics on the zipos decompression cache.
+ */
+void cosmo_zipos_stats(struct CosmoZiposStats *st) {
+  __zipos_cache_lock();
+  st->hits = __zipos_cache.hits;
+  st->misses = __zipos_cache.misses;
+  st->evictions = __zipos_cache.evictions;
+  st->idlebytes = __zipos_cache.idlebytes;
+  st->budget = __zipos_cache.budget;
+  __zipos_cache_unlock();
+}
+
+__attribute__((__constructor__)) static void __zipos_cache_ctor(void) {
+  __zipos_cache_wipe();
+  pthread_atfork(__zipos_cache_lock, __zipos_cache_unlock, __zipos_cache_wipe);
+}
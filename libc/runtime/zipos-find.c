@@ -40,6 +40,45 @@ static ssize_t __zipos_match(struct Zipos *z, struct ZiposUri *name, int len,
   }
 }
 
+static struct ZiposNode *__zipos_lookup(struct Zipos *zipos, const char *path,
+                                        size_t len, bool isdir) {
+  size_t i;
+  uint32_t h;
+  struct ZiposNode *n;
+  for (h = ZIPOS_HASH_INIT, i = 0; i < len; ++i) {
+    h = ZIPOS_HASH_STEP(h, path[i]);
+  }
+  for (i = h & zipos->mask; (n = zipos->nodes + i)->hi;
+       i = (i + 1) & zipos->mask) {
+    if (n->hash == h && n->len == len && (!isdir || n->isdir) &&
+        !memcmp(ZIP_CFILE_NAME(zipos->map + zipos->index[n->lo]), path, len)) {
+      return n;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Returns range of `zipos->index` positions that are beneath directory.
+ *
+ * If the directory is unknown, then the whole index is returned, since
+ * the caller is expected to filter names by prefix regardless.
+ *
+ * @param path is directory name, which may have trailing slash
+ */
+void __zipos_children(struct Zipos *zipos, const char *path, size_t len,
+                      size_t range[2]) {
+  struct ZiposNode *n;
+  if (len && path[len - 1] == '/') --len;
+  if (len && zipos->nodes && (n = __zipos_lookup(zipos, path, len, true))) {
+    range[0] = n->lo;
+    range[1] = n->hi;
+  } else {
+    range[0] = 0;
+    range[1] = zipos->records;
+  }
+}
+
 ssize_t __zipos_scan(struct Zipos *zipos, struct ZiposUri *name) {
 
   // strip trailing slash from search name
@@ -53,6 +92,23 @@ ssize_t __zipos_scan(struct Zipos *zipos, struct ZiposUri *name) {
     return ZIPOS_SYNTHETIC_DIRECTORY;
   }
 
+  // use hash table if it was able to be created
+  //
+  // files are inserted before any directory having the same name, and
+  // an explicit "dir/" record always sorts first among its descendants
+  if (zipos->nodes) {
+    struct ZiposNode *n;
+    if ((n = __zipos_lookup(zipos, name->path, len, false))) {
+      size_t cfile = zipos->index[n->lo];
+      if (!n->isdir || ZIP_CFILE_NAMESIZE(zipos->map + cfile) == len + 1) {
+        return cfile;
+      } else {
+        return ZIPOS_SYNTHETIC_DIRECTORY;
+      }
+    }
+    return -1;
+  }
+
   // binary search for leftmost name in central directory
   int l = 0;
   int r = zipos->records;
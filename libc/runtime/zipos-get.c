@@ -101,6 +101,84 @@ static void __zipos_generate_index(struct Zipos *zipos) {
                __zipos_compare_names, zipos);
 }
 
+static size_t __zipos_common_prefix(struct Zipos *zipos, size_t i) {
+  size_t j, n;
+  const char *x, *y;
+  if (!i) return 0;
+  x = ZIP_CFILE_NAME(zipos->map + zipos->index[i - 1]);
+  y = ZIP_CFILE_NAME(zipos->map + zipos->index[i]);
+  n = MIN(ZIP_CFILE_NAMESIZE(zipos->map + zipos->index[i - 1]),
+          ZIP_CFILE_NAMESIZE(zipos->map + zipos->index[i]));
+  for (j = 0; j < n && x[j] == y[j]; ++j) donothing;
+  return j;
+}
+
+static struct ZiposNode *__zipos_insert(struct Zipos *zipos, uint32_t hash,
+                                        size_t len, size_t pos, bool isdir) {
+  uint32_t i;
+  struct ZiposNode *n;
+  i = hash & zipos->mask;
+  while (zipos->nodes[i].hi) i = (i + 1) & zipos->mask;
+  n = zipos->nodes + i;
+  n->hash = hash;
+  n->len = len;
+  n->lo = pos;
+  n->hi = pos + 1;
+  n->isdir = isdir;
+  return n;
+}
+
+// creates hash table of names and directory prefixes in sorted index
+//
+// since the index is asciibetical, everything beneath a directory "d/"
+// lives in a contiguous run of positions, which we record in the node
+// so opendir() doesn't need to scan the whole central directory. each
+// directory prefix that's new in a name is one the previous name lacks
+static void __zipos_generate_nodes(struct Zipos *zipos) {
+  uint32_t h;
+  const char *s;
+  struct ZiposNode **open;
+  size_t i, j, k, n, lcp, cap, nodes, depth, maxdepth;
+  if (zipos->records >= 0x80000000) return;
+  for (nodes = maxdepth = i = 0; i < zipos->records; ++i) {
+    s = ZIP_CFILE_NAME(zipos->map + zipos->index[i]);
+    n = ZIP_CFILE_NAMESIZE(zipos->map + zipos->index[i]);
+    for (depth = 0, j = 0; j < n; ++j) depth += s[j] == '/';
+    maxdepth = MAX(maxdepth, depth);
+    for (j = __zipos_common_prefix(zipos, i); j < n; ++j) nodes += s[j] == '/';
+    nodes += n && s[n - 1] != '/';
+  }
+  for (cap = 16; cap < nodes + nodes / 3; cap += cap) donothing;
+  if (!(zipos->nodes = _mapanon(cap * sizeof(struct ZiposNode)))) return;
+  if (!(open = _mapanon((maxdepth + 1) * sizeof(struct ZiposNode *)))) {
+    munmap(zipos->nodes, cap * sizeof(struct ZiposNode));
+    zipos->nodes = 0;
+    return;
+  }
+  zipos->mask = cap - 1;
+  for (depth = i = 0; i < zipos->records; ++i) {
+    s = ZIP_CFILE_NAME(zipos->map + zipos->index[i]);
+    n = ZIP_CFILE_NAMESIZE(zipos->map + zipos->index[i]);
+    lcp = __zipos_common_prefix(zipos, i);
+    while (depth && open[depth - 1]->len >= lcp) {
+      open[--depth]->hi = i;
+    }
+    for (h = ZIPOS_HASH_INIT, j = 0; j < n; ++j) {
+      if (s[j] == '/' && j >= lcp) {
+        open[depth++] = __zipos_insert(zipos, h, j, i, true);
+      }
+      h = ZIPOS_HASH_STEP(h, s[j]);
+    }
+    if (n && s[n - 1] != '/') {
+      __zipos_insert(zipos, h, n, i, false);
+    }
+  }
+  for (k = 0; k < depth; ++k) {
+    open[k]->hi = zipos->records;
+  }
+  munmap(open, (maxdepth + 1) * sizeof(struct ZiposNode *));
+}
+
 static void __zipos_init(void) {
   char *endptr;
   const char *s;
@@ -134,6 +212,7 @@ static void __zipos_init(void) {
             __zipos.dev = st.st_ino;
             __zipos.pagesz = pagesz;
             __zipos_generate_index(&__zipos);
+            __zipos_generate_nodes(&__zipos);
             msg = kZipOk;
           } else {
             munmap(map, st.st_size);
@@ -0,0 +1,208 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/assert.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/dll.h"
+#include "libc/intrin/likely.h"
+#include "libc/intrin/weaken.h"
+#include "libc/limits.h"
+#include "libc/macros.internal.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/thread/thread.h"
+#include "third_party/zlib/zlib.h"
+
+// minimum number of bytes to inflate each time a reader gets ahead of
+// us. zlib copies the trailing 32kb of each call's output into its own
+// sliding window, so making this too small doubles the memcpy overhead
+#define ZIPOS_INFLATE_CHUNK 65536
+
+struct ZiposInflater {
+  pthread_mutex_t lock;
+  struct Dll elem;
+  const uint8_t *in;
+  size_t insize;
+  size_t inpos;
+  size_t used;
+  bool failed;
+  z_stream zs;
+  _Alignas(16) char arena[];
+};
+
+_Static_assert(sizeof(struct ZiposInflater) < ZIPOS_INFLATER_SIZE, "");
+
+// every live inflater, so fork() can make sure none are locked
+static struct ZiposInflaters {
+  pthread_mutex_t lock;
+  struct Dll *list;
+} __zipos_inflaters;
+
+// zlib wants ~7kb for its state plus a 32kb window. we carve these out
+// of the handle mapping, so reading doesn't depend on malloc() and the
+// pages of memory are recycled along with the handle by the freelist.
+static void *__zipos_zalloc(void *opaque, unsigned items, unsigned size) {
+  size_t n;
+  void *res;
+  struct ZiposInflater *zi = opaque;
+  n = ROUNDUP((size_t)items * size, 16);
+  if (n > ZIPOS_INFLATER_SIZE - sizeof(*zi) - zi->used) return Z_NULL;
+  res = zi->arena + zi->used;
+  zi->used += n;
+  return res;
+}
+
+static void __zipos_zfree(void *opaque, void *ptr) {
+  // memory is released when the handle is freed
+}
+
+/**
+ * Prepares zip handle for on-demand decompression.
+ *
+ * @param mem points to `ZIPOS_INFLATER_SIZE` bytes of scratch memory
+ * @param in is raw deflate data which must outlive the handle
+ * @return inflater object, or null if zlib isn't linked
+ */
+struct ZiposInflater *__zipos_inflater_new(void *mem, const void *in,
+                                           size_t insize) {
+  struct ZiposInflater *zi;
+  if (!_weaken(inflateInit2) || !_weaken(inflate) || !_weaken(inflateEnd)) {
+    return 0;
+  }
+  zi = mem;
+  pthread_mutex_init(&zi->lock, 0);
+  zi->in = in;
+  zi->insize = insize;
+  zi->inpos = 0;
+  zi->used = 0;
+  zi->failed = false;
+  zi->zs.next_in = Z_NULL;
+  zi->zs.avail_in = 0;
+  zi->zs.zalloc = __zipos_zalloc;
+  zi->zs.zfree = __zipos_zfree;
+  zi->zs.opaque = zi;
+  if (_weaken(inflateInit2)(&zi->zs, -MAX_WBITS) != Z_OK) {
+    return 0;
+  }
+  dll_init(&zi->elem);
+  pthread_mutex_lock(&__zipos_inflaters.lock);
+  dll_make_first(&__zipos_inflaters.list, &zi->elem);
+  pthread_mutex_unlock(&__zipos_inflaters.lock);
+  return zi;
+}
+
+/**
+ * Forgets inflater before its handle memory is recycled.
+ */
+void __zipos_inflater_free(struct ZiposInflater *zi) {
+  pthread_mutex_lock(&__zipos_inflaters.lock);
+  dll_remove(&__zipos_inflaters.list, &zi->elem);
+  pthread_mutex_unlock(&__zipos_inflaters.lock);
+}
+
+static void __zipos_inflate_impl(struct ZiposHandle *h, size_t want) {
+  int rc;
+  size_t n, out;
+  struct ZiposInflater *zi = h->inflater;
+  while (!zi->failed && (out = zi->zs.total_out) < want) {
+    if (!zi->zs.avail_in && zi->inpos < zi->insize) {
+      n = MIN(zi->insize - zi->inpos, UINT_MAX);
+      zi->zs.next_in = zi->in + zi->inpos;
+      zi->zs.avail_in = n;
+      zi->inpos += n;
+    }
+    n = MAX(want - out, ZIPOS_INFLATE_CHUNK);
+    n = MIN(n, h->size - out);
+    n = MIN(n, UINT_MAX);
+    zi->zs.next_out = h->mem + out;
+    zi->zs.avail_out = n;
+    rc = _weaken(inflate)(&zi->zs, Z_NO_FLUSH);
+    if (rc == Z_STREAM_END) {
+      _weaken(inflateEnd)(&zi->zs);
+      if (zi->zs.total_out != h->size) {
+        zi->failed = true;
+      }
+      break;
+    } else if (rc != Z_OK) {
+      zi->failed = true;
+    }
+  }
+  atomic_store_explicit(&h->avail, zi->zs.total_out, memory_order_release);
+}
+
+/**
+ * Ensures the first `want` bytes of zip handle content are inflated.
+ *
+ * Handles for deflated assets are decompressed incrementally, as they
+ * are read. The output buffer is retained, so seeking backwards costs
+ * nothing and seeking forwards only inflates as far as the reader is.
+ *
+ * @return 0 on success, or -1 w/ errno if asset is corrupted
+ * @asyncsignalsafe
+ */
+int __zipos_inflate(struct ZiposHandle *h, size_t want) {
+  bool failed;
+  struct ZiposInflater *zi;
+  want = MIN(want, h->size);
+  if (LIKELY(atomic_load_explicit(&h->avail, memory_order_acquire) >= want)) {
+    return 0;
+  }
+  zi = h->inflater;
+  unassert(zi);
+  BLOCK_SIGNALS;
+  pthread_mutex_lock(&zi->lock);
+  __zipos_inflate_impl(h, want);
+  failed = atomic_load_explicit(&h->avail, memory_order_relaxed) < want;
+  pthread_mutex_unlock(&zi->lock);
+  ALLOW_SIGNALS;
+  return failed ? eio() : 0;
+}
+
+static void __zipos_inflaters_lock(void) {
+  struct Dll *e;
+  pthread_mutex_lock(&__zipos_inflaters.lock);
+  for (e = dll_first(__zipos_inflaters.list); e;
+       e = dll_next(__zipos_inflaters.list, e)) {
+    pthread_mutex_lock(&DLL_CONTAINER(struct ZiposInflater, elem, e)->lock);
+  }
+}
+
+static void __zipos_inflaters_unlock(void) {
+  struct Dll *e;
+  for (e = dll_first(__zipos_inflaters.list); e;
+       e = dll_next(__zipos_inflaters.list, e)) {
+    pthread_mutex_unlock(&DLL_CONTAINER(struct ZiposInflater, elem, e)->lock);
+  }
+  pthread_mutex_unlock(&__zipos_inflaters.lock);
+}
+
+static void __zipos_inflaters_wipe(void) {
+  struct Dll *e;
+  for (e = dll_first(__zipos_inflaters.list); e;
+       e = dll_next(__zipos_inflaters.list, e)) {
+    pthread_mutex_init(&DLL_CONTAINER(struct ZiposInflater, elem, e)->lock, 0);
+  }
+  pthread_mutex_init(&__zipos_inflaters.lock, 0);
+}
+
+__attribute__((__constructor__)) static void __zipos_inflaters_ctor(void) {
+  pthread_mutex_init(&__zipos_inflaters.lock, 0);
+  pthread_atfork(__zipos_inflaters_lock, __zipos_inflaters_unlock,
+                 __zipos_inflaters_wipe);
+}
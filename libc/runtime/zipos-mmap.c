@@ -36,6 +36,11 @@
 /**
  * Map zipos file into memory. See mmap.
  *
+ * Deflated assets are copied out of the shared decompression cache,
+ * so only the pages being mapped need to have been inflated. They're
+ * copied rather than aliased since the cache lives in anonymous memory
+ * which, unlike a file, can't be mapped a second time.
+ *
  * @param addr should be 0 or a compatible address
  * @param size must be >0 and will be rounded up to FRAMESIZE
  *     automatically.
@@ -100,6 +100,14 @@ void __zipos_free(struct ZiposHandle *h) {
   if (!__zipos_drop(h)) {
     return;
   }
+  if (h->blob) {
+    __zipos_cache_release(h->blob);
+    h->blob = 0;
+  }
+  if (h->inflater) {
+    __zipos_inflater_free(h->inflater);
+    h->inflater = 0;
+  }
   if (IsAsan()) {
     __asan_poison((char *)h + sizeof(struct ZiposHandle),
                   h->mapsize - sizeof(struct ZiposHandle), kAsanHeapFree);
@@ -140,6 +148,9 @@ StartOver:
     h->size = size;
     h->zipos = zipos;
     h->mapsize = mapsize;
+    h->blob = 0;
+    h->inflater = 0;
+    atomic_store_explicit(&h->avail, SIZE_MAX, memory_order_relaxed);
   }
   return h;
 }
@@ -167,12 +178,51 @@ static int __zipos_setfd(int fd, struct ZiposHandle *h, unsigned flags) {
   return fd;
 }
 
+// decompresses central directory record, which cache may then share
+static struct ZiposHandle *__zipos_blob(struct Zipos *zipos, size_t cf,
+                                        size_t lf, size_t size, int method) {
+  int rc;
+  struct ZiposHandle *b;
+  if (method == kZipCompressionDeflate && size > ZIPOS_INFLATER_SIZE / 4) {
+    // large assets get inflated lazily as they're read, since the
+    // handle memory is only committed by the kernel once touched
+    if (!(b = __zipos_alloc(zipos, ROUNDUP(size, 16) + ZIPOS_INFLATER_SIZE))) {
+      return 0;
+    }
+    if ((b->inflater = __zipos_inflater_new(
+             b->data + ROUNDUP(size, 16), ZIP_LFILE_CONTENT(zipos->map + lf),
+             GetZipLfileCompressedSize(zipos->map + lf)))) {
+      atomic_store_explicit(&b->avail, 0, memory_order_relaxed);
+    }
+  } else if (!(b = __zipos_alloc(zipos, size))) {
+    return 0;
+  }
+  if (!b->inflater) {
+    if (method == kZipCompressionDeflate) {
+      rc = __inflate(b->data, size, ZIP_LFILE_CONTENT(zipos->map + lf),
+                     GetZipLfileCompressedSize(zipos->map + lf));
+    } else {
+      rc = __unzstd(b->data, size, ZIP_LFILE_CONTENT(zipos->map + lf),
+                    GetZipLfileCompressedSize(zipos->map + lf));
+    }
+    if (rc) {
+      __zipos_free(b);
+      eio();
+      return 0;
+    }
+  }
+  b->mem = b->data;
+  b->cfile = cf;
+  b->size = size;
+  return b;
+}
+
 static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
                         struct ZiposUri *name) {
   size_t lf;
   size_t size;
-  int fd, minfd;
-  struct ZiposHandle *h;
+  int fd, minfd, method;
+  struct ZiposHandle *h, *blob;
   if (cf == ZIPOS_SYNTHETIC_DIRECTORY) {
     size = name->len;
     if (!(h = __zipos_alloc(zipos, size + 1))) return -1;
@@ -183,20 +233,23 @@ static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
     lf = GetZipCfileOffset(zipos->map + cf);
     npassert((ZIP_LFILE_MAGIC(zipos->map + lf) == kZipLfileHdrMagic));
     size = GetZipLfileUncompressedSize(zipos->map + lf);
-    switch (ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf)) {
+    switch ((method = ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf))) {
       case kZipCompressionNone:
         if (!(h = __zipos_alloc(zipos, 0))) return -1;
         h->mem = ZIP_LFILE_CONTENT(zipos->map + lf);
         break;
       case kZipCompressionDeflate:
-        if (!(h = __zipos_alloc(zipos, size))) return -1;
-        if (!__inflate(h->data, size, ZIP_LFILE_CONTENT(zipos->map + lf),
-                       GetZipLfileCompressedSize(zipos->map + lf))) {
-          h->mem = h->data;
-        } else {
-          h->mem = 0;
-          eio();
+      case kZipCompressionZstd:
+        if (!(blob = __zipos_cache_get(zipos, cf))) {
+          if (!(blob = __zipos_blob(zipos, cf, lf, size, method))) return -1;
+          blob = __zipos_cache_put(blob);
+        }
+        if (!(h = __zipos_alloc(zipos, 0))) {
+          __zipos_cache_release(blob);
+          return -1;
         }
+        h->blob = blob;
+        h->mem = blob->mem;
         break;
       default:
         return eio();
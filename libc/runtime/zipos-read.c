@@ -32,7 +32,7 @@
 static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
                                  size_t iovlen, ssize_t opt_offset) {
   int i;
-  int64_t b, x, y, start_pos;
+  int64_t b, x, y, z, start_pos;
   if (h->cfile == ZIPOS_SYNTHETIC_DIRECTORY ||
       S_ISDIR(GetZipCfileMode(h->zipos->map + h->cfile))) {
     return eisdir();
@@ -53,6 +53,17 @@ static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
   } else {
     x = y = opt_offset;
   }
+  if (h->blob && h->blob->inflater && y < h->size) {
+    for (z = y, i = 0; i < iovlen && z < h->size; ++i) {
+      z += MIN(iov[i].iov_len, h->size - z);
+    }
+    if (__zipos_inflate(h->blob, z) == -1) {
+      if (opt_offset == -1) {
+        atomic_store_explicit(&h->pos, x, memory_order_release);
+      }
+      return -1;
+    }
+  }
   for (i = 0; i < iovlen && y < h->size; ++i, y += b) {
     b = MIN(iov[i].iov_len, h->size - y);
     if (b) memcpy(iov[i].iov_base, h->mem + y, b);
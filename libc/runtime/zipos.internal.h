@@ -1,14 +1,29 @@
 #ifndef COSMOPOLITAN_LIBC_ZIPOS_ZIPOS_H_
 #define COSMOPOLITAN_LIBC_ZIPOS_ZIPOS_H_
+#include "libc/intrin/dll.h"
 COSMOPOLITAN_C_START_
 
 #define ZIPOS_PATH_MAX 1024
 
 #define ZIPOS_SYNTHETIC_DIRECTORY 0
 
+#define ZIPOS_INFLATER_SIZE 65536
+
+#define ZIPOS_HASH_INIT       2166136261u
+#define ZIPOS_HASH_STEP(h, c) (((h) ^ ((c)&255)) * 16777619u)
+
 struct stat;
 struct iovec;
 struct Zipos;
+struct ZiposInflater;
+
+struct ZiposNode {
+  uint32_t hash;  /* fnv-1a of name w/o trailing slash */
+  uint32_t lo;    /* first position in index having this name or prefix */
+  uint32_t hi;    /* one past last descendant position, or zero if empty */
+  uint16_t len;   /* length of name w/o trailing slash */
+  uint16_t isdir; /* true if node describes directory prefix */
+};
 
 struct ZiposUri {
   uint32_t len;
@@ -17,12 +32,17 @@ struct ZiposUri {
 
 struct ZiposHandle {
   struct ZiposHandle *next;
+  struct ZiposHandle *blob;  /* shared inflated content */
+  struct ZiposHandle *chain; /* cache hash table bucket chain */
+  struct Dll elem;           /* cache least recently used list */
   struct Zipos *zipos;
   size_t size;
   size_t mapsize;
   size_t cfile;
   _Atomic(size_t) refs;
   _Atomic(size_t) pos;
+  _Atomic(size_t) avail;
+  struct ZiposInflater *inflater;
   uint8_t *mem;
   uint8_t data[];
 };
@@ -34,6 +54,8 @@ struct Zipos {
   uint64_t dev;
   size_t *index;
   size_t records;
+  uint32_t mask;
+  struct ZiposNode *nodes;
   struct ZiposHandle *freelist;
 };
 
@@ -44,6 +66,7 @@ struct Zipos *__zipos_get(void) pureconst;
 size_t __zipos_normpath(char *, const char *, size_t);
 ssize_t __zipos_find(struct Zipos *, struct ZiposUri *);
 ssize_t __zipos_scan(struct Zipos *, struct ZiposUri *);
+void __zipos_children(struct Zipos *, const char *, size_t, size_t[2]);
 ssize_t __zipos_parseuri(const char *, struct ZiposUri *);
 uint64_t __zipos_inode(struct Zipos *, int64_t, const void *, size_t);
 int __zipos_open(struct ZiposUri *, int);
@@ -57,6 +80,12 @@ ssize_t __zipos_read(struct ZiposHandle *, const struct iovec *, size_t,
 int64_t __zipos_seek(struct ZiposHandle *, int64_t, unsigned);
 int __zipos_fcntl(int, int, uintptr_t);
 int __zipos_notat(int, const char *);
+int __zipos_inflate(struct ZiposHandle *, size_t);
+struct ZiposHandle *__zipos_cache_get(struct Zipos *, size_t);
+struct ZiposHandle *__zipos_cache_put(struct ZiposHandle *);
+void __zipos_cache_release(struct ZiposHandle *);
+struct ZiposInflater *__zipos_inflater_new(void *, const void *, size_t);
+void __zipos_inflater_free(struct ZiposInflater *);
 void *__zipos_mmap(void *, uint64_t, int32_t, int32_t, struct ZiposHandle *,
                    int64_t);
 
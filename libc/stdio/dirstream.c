@@ -79,8 +79,9 @@ struct dirstream {
     struct {
       struct Zipos *zipos;
       uint64_t inode;
-      uint64_t offset;
-      uint64_t records;
+      uint64_t pos;
+      uint64_t begin;
+      uint64_t end;
       struct ZiposUri prefix;
       struct critbit0 found;
     } zip;
@@ -341,8 +342,10 @@ DIR *fdopendir(int fd) {
 
   // setup state values for directory iterator
   dir->zip.zipos = h->zipos;
-  dir->zip.offset = GetZipCdirOffset(h->zipos->cdir);
-  dir->zip.records = GetZipCdirRecords(h->zipos->cdir);
+  size_t range[2];
+  __zipos_children(h->zipos, dir->zip.prefix.path, dir->zip.prefix.len, range);
+  dir->zip.pos = dir->zip.begin = range[0];
+  dir->zip.end = range[1];
   dir->zip.inode = __zipos_inode(h->zipos, h->cfile, dir->zip.prefix.path,
                                  dir->zip.prefix.len);
 
@@ -385,7 +388,7 @@ DIR *opendir(const char *name) {
 
 static struct dirent *readdir_zipos(DIR *dir) {
   struct dirent *ent = 0;
-  while (!ent && dir->tell < dir->zip.records + 2) {
+  while (!ent && (dir->tell < 2 || dir->zip.pos < dir->zip.end)) {
     if (!dir->tell) {
       ent = &dir->ent;
       ent->d_off = dir->tell;
@@ -410,8 +413,9 @@ static struct dirent *readdir_zipos(DIR *dir) {
       ent->d_ino = __zipos_inode(
           dir->zip.zipos, __zipos_scan(dir->zip.zipos, &p), p.path, p.len);
     } else {
-      const char *s = ZIP_CFILE_NAME(dir->zip.zipos->map + dir->zip.offset);
-      size_t n = ZIP_CFILE_NAMESIZE(dir->zip.zipos->map + dir->zip.offset);
+      size_t cfile = dir->zip.zipos->index[dir->zip.pos];
+      const char *s = ZIP_CFILE_NAME(dir->zip.zipos->map + cfile);
+      size_t n = ZIP_CFILE_NAMESIZE(dir->zip.zipos->map + cfile);
       if (n > dir->zip.prefix.len &&
           !memcmp(dir->zip.prefix.path, s, dir->zip.prefix.len)) {
         s += dir->zip.prefix.len;
@@ -421,8 +425,7 @@ static struct dirent *readdir_zipos(DIR *dir) {
         if (p) {
           n = p - s;
           d_type = DT_DIR;
-        } else if (S_ISDIR(GetZipCfileMode(dir->zip.zipos->map +
-                                           dir->zip.offset))) {
+        } else if (S_ISDIR(GetZipCfileMode(dir->zip.zipos->map + cfile))) {
           d_type = DT_DIR;
         } else {
           d_type = DT_REG;
@@ -430,15 +433,14 @@ static struct dirent *readdir_zipos(DIR *dir) {
         if ((n = MIN(n, sizeof(ent->d_name) - 1)) &&
             critbit0_emplace(&dir->zip.found, s, n) == 1) {
           ent = &dir->ent;
-          ent->d_ino = dir->zip.offset;
+          ent->d_ino = cfile;
           ent->d_off = dir->tell;
           ent->d_type = d_type;
           memcpy(ent->d_name, s, n);
           ent->d_name[n] = 0;
         }
       }
-      dir->zip.offset +=
-          ZIP_CFILE_HDRSIZE(dir->zip.zipos->map + dir->zip.offset);
+      dir->zip.pos++;
     }
     dir->tell++;
   }
@@ -624,7 +626,7 @@ void rewinddir(DIR *dir) {
   if (dir->iszip) {
     critbit0_clear(&dir->zip.found);
     dir->tell = 0;
-    dir->zip.offset = GetZipCdirOffset(dir->zip.zipos->cdir);
+    dir->zip.pos = dir->zip.begin;
   } else if (!IsWindows()) {
     if (!lseek(dir->fd, 0, SEEK_SET)) {
       dir->buf_pos = dir->buf_end = 0;
@@ -650,7 +652,7 @@ void seekdir(DIR *dir, long tell) {
   if (dir->iszip) {
     critbit0_clear(&dir->zip.found);
     dir->tell = 0;
-    dir->zip.offset = GetZipCdirOffset(dir->zip.zipos->cdir);
+    dir->zip.pos = dir->zip.begin;
     while (dir->tell < tell) {
       if (!readdir_zipos(dir)) {
         break;
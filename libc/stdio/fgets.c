@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/stdio/internal.h"
 #include "libc/stdio/stdio.h"
 
 /**
@@ -37,8 +38,8 @@
  */
 char *fgets(char *s, int size, FILE *f) {
   char *res;
-  flockfile(f);
+  bool locked = __stdio_lock(f);
   res = fgets_unlocked(s, size, f);
-  funlockfile(f);
+  __stdio_unlock(f, locked);
   return res;
 }
@@ -78,12 +78,11 @@
 #define FLAGS_GROUPING  FLAGS_NOQUOTE
 #define FLAGS_REPR      FLAGS_PLUS
 
-#define __FMT_PUT(C)              \
-  do {                            \
-    char Buf[1] = {C};            \
-    if (out(Buf, arg, 1) == -1) { \
-      return -1;                  \
-    }                             \
+#define __FMT_PUT(C)               \
+  do {                             \
+    if (__fmt_putc(&b, C) == -1) { \
+      return -1;                   \
+    }                              \
   } while (0)
 
 struct FPBits {
@@ -123,8 +122,16 @@ static const char kSpecialFloats[2][2][4] = {
     {"NAN", "nan"},
 };
 
-typedef int (*out_f)(const char *, void *, size_t);
-typedef int (*emit_f)(out_f, void *, uint64_t);
+// output is staged here so the callback gets called once per chunk
+// rather than once per fragment, digit, sign, and padding character
+struct FmtBuf {
+  int (*out)(const char *, void *, size_t);
+  void *arg;
+  unsigned n;
+  char p[256];
+};
+
+typedef int (*emit_f)(struct FmtBuf *, uint64_t);
 
 uint128_t __udivmodti4(uint128_t, uint128_t, uint128_t *);
 
@@ -137,18 +144,55 @@ static int __fmt_atoi(const char **str) {
   return i;
 }
 
-static int __fmt_pad(int out(const char *, void *, size_t), void *arg,
-                     unsigned long n) {
-  int i, rc;
-  for (rc = i = 0; i < n; ++i) rc |= out(" ", arg, 1);
-  return rc;
+static int __fmt_flush(struct FmtBuf *b) {
+  unsigned n;
+  if (!(n = b->n)) return 0;
+  b->n = 0;
+  return b->out(b->p, b->arg, n);
+}
+
+static int __fmt_write(struct FmtBuf *b, const char *s, size_t n) {
+  if (n <= sizeof(b->p) - b->n) {
+    memcpy(b->p + b->n, s, n);
+    b->n += n;
+    return 0;
+  }
+  if (__fmt_flush(b) == -1) return -1;
+  if (n < sizeof(b->p)) {
+    memcpy(b->p, s, n);
+    b->n = n;
+    return 0;
+  }
+  return b->out(s, b->arg, n);
+}
+
+static int __fmt_putc(struct FmtBuf *b, int c) {
+  if (b->n == sizeof(b->p) && __fmt_flush(b) == -1) return -1;
+  b->p[b->n++] = c;
+  return 0;
+}
+
+static int __fmt_fill(struct FmtBuf *b, int c, unsigned long n) {
+  unsigned k;
+  while (n) {
+    if (b->n == sizeof(b->p) && __fmt_flush(b) == -1) return -1;
+    k = MIN(n, sizeof(b->p) - b->n);
+    memset(b->p + b->n, c, k);
+    b->n += k;
+    n -= k;
+  }
+  return 0;
 }
 
-static int __fmt_ntoa_format(int out(const char *, void *, size_t), void *arg,
-                             char *buf, unsigned len, bool negative,
-                             unsigned log2base, unsigned prec, unsigned width,
-                             unsigned char flags, const char *alphabet) {
-  unsigned i, prec_width_zeros;
+static int __fmt_pad(struct FmtBuf *b, unsigned long n) {
+  return __fmt_fill(b, ' ', n);
+}
+
+static int __fmt_ntoa_format(struct FmtBuf *b, char *buf, unsigned len,
+                             bool negative, unsigned log2base, unsigned prec,
+                             unsigned width, unsigned char flags,
+                             const char *alphabet) {
+  unsigned prec_width_zeros;
   char alternate_form_middle_char, sign_character;
   unsigned actual_buf_len;
   actual_buf_len = len;
@@ -212,33 +256,33 @@ static int __fmt_ntoa_format(int out(const char *, void *, size_t), void *arg,
   /* pad spaces up to given width */
   if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD)) {
     if (len < width) {
-      if (__fmt_pad(out, arg, width - len) == -1) return -1;
+      if (__fmt_pad(b, width - len) == -1) return -1;
     }
   }
-  if (sign_character != '\0' && out(&sign_character, arg, 1) == -1) return -1;
+  if (sign_character != '\0' && __fmt_putc(b, sign_character) == -1) {
+    return -1;
+  }
   if (flags & FLAGS_HASH) {
-    if (out("0", arg, 1) == -1) return -1;
+    if (__fmt_putc(b, '0') == -1) return -1;
     if (alternate_form_middle_char != '\0' &&
-        out(&alternate_form_middle_char, arg, 1) == -1)
+        __fmt_putc(b, alternate_form_middle_char) == -1)
       return -1;
   }
-  for (i = 0; i < prec_width_zeros; ++i)
-    if (out("0", arg, 1) == -1) return -1;
+  if (__fmt_fill(b, '0', prec_width_zeros) == -1) return -1;
   reverse(buf, actual_buf_len);
-  if (out(buf, arg, actual_buf_len) == -1) return -1;
+  if (__fmt_write(b, buf, actual_buf_len) == -1) return -1;
   /* append pad spaces up to given width */
   if (flags & FLAGS_LEFT) {
     if (len < width) {
-      if (__fmt_pad(out, arg, width - len) == -1) return -1;
+      if (__fmt_pad(b, width - len) == -1) return -1;
     }
   }
   return 0;
 }
 
-static int __fmt_ntoa2(int out(const char *, void *, size_t), void *arg,
-                       uint128_t value, bool neg, unsigned log2base,
-                       unsigned prec, unsigned width, unsigned flags,
-                       const char *alphabet) {
+static int __fmt_ntoa2(struct FmtBuf *b, uint128_t value, bool neg,
+                       unsigned log2base, unsigned prec, unsigned width,
+                       unsigned flags, const char *alphabet) {
   uint128_t remainder;
   unsigned len, count, digit;
   char buf[BUFFER_SIZE];
@@ -271,15 +315,14 @@ static int __fmt_ntoa2(int out(const char *, void *, size_t), void *arg,
     } while (value);
     npassert(count <= BUFFER_SIZE);
   }
-  return __fmt_ntoa_format(out, arg, buf, len, neg, log2base, prec, width,
-                           flags, alphabet);
+  return __fmt_ntoa_format(b, buf, len, neg, log2base, prec, width, flags,
+                           alphabet);
 }
 
-static int __fmt_ntoa(int out(const char *, void *, size_t), void *arg,
-                      uint128_t value, unsigned char signbit,
-                      unsigned long log2base, unsigned long prec,
-                      unsigned long width, unsigned char flags,
-                      const char *lang) {
+static int __fmt_ntoa(struct FmtBuf *b, uint128_t value,
+                      unsigned char signbit, unsigned long log2base,
+                      unsigned long prec, unsigned long width,
+                      unsigned char flags, const char *lang) {
   bool neg;
   uint128_t sign;
 
@@ -310,7 +353,7 @@ static int __fmt_ntoa(int out(const char *, void *, size_t), void *arg,
     }
   }
 
-  return __fmt_ntoa2(out, arg, value, neg, log2base, prec, width, flags, lang);
+  return __fmt_ntoa2(b, value, neg, log2base, prec, width, flags, lang);
 }
 
 /**
@@ -350,26 +393,25 @@ static int __fmt_cescapec(int c) {
   }
 }
 
-static int __fmt_stoa_byte(out_f out, void *a, uint64_t c) {
-  char buf[1] = {c};
-  return out(buf, a, 1);
+static int __fmt_stoa_byte(struct FmtBuf *b, uint64_t c) {
+  return __fmt_putc(b, c);
 }
 
-static int __fmt_stoa_wide(out_f out, void *a, uint64_t w) {
+static int __fmt_stoa_wide(struct FmtBuf *b, uint64_t w) {
   char buf[8];
   if (!isascii(w)) w = tpenc(w);
   WRITE64LE(buf, w);
-  return out(buf, a, w ? (_bsr(w) >> 3) + 1 : 1);
+  return __fmt_write(b, buf, w ? (_bsr(w) >> 3) + 1 : 1);
 }
 
-static int __fmt_stoa_bing(out_f out, void *a, uint64_t w) {
+static int __fmt_stoa_bing(struct FmtBuf *b, uint64_t w) {
   char buf[8];
   w = tpenc(kCp437[w & 0xFF]);
   WRITE64LE(buf, w);
-  return out(buf, a, w ? (_bsr(w) >> 3) + 1 : 1);
+  return __fmt_write(b, buf, w ? (_bsr(w) >> 3) + 1 : 1);
 }
 
-static int __fmt_stoa_quoted(out_f out, void *a, uint64_t w) {
+static int __fmt_stoa_quoted(struct FmtBuf *b, uint64_t w) {
   char buf[8];
   if (isascii(w)) {
     w = __fmt_cescapec(w);
@@ -377,7 +419,7 @@ static int __fmt_stoa_quoted(out_f out, void *a, uint64_t w) {
     w = tpenc(w);
   }
   WRITE64LE(buf, w);
-  return out(buf, a, w ? (_bsr(w) >> 3) + 1 : 1);
+  return __fmt_write(b, buf, w ? (_bsr(w) >> 3) + 1 : 1);
 }
 
 /**
@@ -389,14 +431,13 @@ static int __fmt_stoa_quoted(out_f out, void *a, uint64_t w) {
  *
  * @see __fmt()
  */
-static int __fmt_stoa(int out(const char *, void *, size_t), void *arg,
-                      void *data, unsigned long flags, unsigned long precision,
-                      unsigned long width, unsigned char signbit,
-                      unsigned char qchar) {
+static int __fmt_stoa(struct FmtBuf *b, void *data, unsigned long flags,
+                      unsigned long precision, unsigned long width,
+                      unsigned char signbit, unsigned char qchar) {
   wint_t wc;
   unsigned n;
   emit_f emit;
-  char *p, buf[1];
+  char *p;
   unsigned w, pad;
   bool justdobytes, ignorenul;
 
@@ -461,24 +502,23 @@ static int __fmt_stoa(int out(const char *, void *, size_t), void *arg,
   }
 
   if (pad && !(flags & FLAGS_LEFT)) {
-    if (__fmt_pad(out, arg, pad) == -1) return -1;
+    if (__fmt_pad(b, pad) == -1) return -1;
   }
 
   if (!(flags & FLAGS_NOQUOTE) && (flags & FLAGS_REPR)) {
     if (signbit == 63) {
-      if (out("L", arg, 1) == -1) return -1;
+      if (__fmt_putc(b, 'L') == -1) return -1;
     } else if (signbit == 15) {
-      if (out("u", arg, 1) == -1) return -1;
+      if (__fmt_putc(b, 'u') == -1) return -1;
     }
-    buf[0] = qchar;
-    if (out(buf, arg, 1) == -1) return -1;
+    if (__fmt_putc(b, qchar) == -1) return -1;
   }
 
   if (justdobytes) {
     while (precision--) {
       wc = *p++ & 0xff;
       if (!wc && !ignorenul) break;
-      if (emit(out, arg, wc) == -1) return -1;
+      if (emit(b, wc) == -1) return -1;
     }
   } else {
     while (precision--) {
@@ -515,17 +555,16 @@ static int __fmt_stoa(int out(const char *, void *, size_t), void *arg,
           }
         }
       }
-      if (emit(out, arg, wc) == -1) return -1;
+      if (emit(b, wc) == -1) return -1;
     }
   }
 
   if (!(flags & FLAGS_NOQUOTE) && (flags & FLAGS_REPR)) {
-    buf[0] = qchar;
-    if (out(buf, arg, 1) == -1) return -1;
+    if (__fmt_putc(b, qchar) == -1) return -1;
   }
 
   if (pad && (flags & FLAGS_LEFT)) {
-    if (__fmt_pad(out, arg, pad) == -1) return -1;
+    if (__fmt_pad(b, pad) == -1) return -1;
   }
 
   return 0;
@@ -794,20 +833,22 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
   const char *alphabet;
   unsigned char signbit, log2base;
   int c, k, i1, bw, rc, bex, prec1, decpt;
-  int (*out)(const char *, void *, size_t);
+  struct FmtBuf b;
   char *se, *s0, *s, *q, qchar, special[8];
   int d, w, n, sign, prec, flags, width, lasterr;
 
   x = 0;
   lasterr = errno;
-  out = fn ? fn : __fmt_noop;
+  b.out = fn ? fn : __fmt_noop;
+  b.arg = arg;
+  b.n = 0;
 
   while (*format) {
     if (*format != '%') {
       for (n = 1; format[n]; ++n) {
         if (format[n] == '%') break;
       }
-      if (out(format, arg, n) == -1) return -1;
+      if (__fmt_write(&b, format, n) == -1) return -1;
       format += n;
       continue;
     }
@@ -816,37 +857,47 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
       if (format[1] == 's') {  // FAST PATH: PLAIN STRING
         s = va_arg(va, char *);
         if (!s) s = "(null)";
-        if (out(s, arg, strlen(s)) == -1) return -1;
+        if (__fmt_write(&b, s, strlen(s)) == -1) return -1;
         format += 2;
         continue;
       } else if (format[1] == 'd') {  // FAST PATH: PLAIN INTEGER
         d = va_arg(va, int);
-        if (out(ibuf, arg, FormatInt32(ibuf, d) - ibuf) == -1) return -1;
+        if (__fmt_write(&b, ibuf, FormatInt32(ibuf, d) - ibuf) == -1) return -1;
         format += 2;
         continue;
       } else if (format[1] == 'u') {  // FAST PATH: PLAIN UNSIGNED
         u = va_arg(va, unsigned);
-        if (out(ibuf, arg, FormatUint32(ibuf, u) - ibuf) == -1) return -1;
+        if (__fmt_write(&b, ibuf, FormatUint32(ibuf, u) - ibuf) == -1) {
+          return -1;
+        }
         format += 2;
         continue;
       } else if (format[1] == 'x') {  // FAST PATH: PLAIN HEX
         u = va_arg(va, unsigned);
-        if (out(ibuf, arg, uint64toarray_radix16(u, ibuf)) == -1) return -1;
+        if (__fmt_write(&b, ibuf, uint64toarray_radix16(u, ibuf)) == -1) {
+          return -1;
+        }
         format += 2;
         continue;
       } else if (format[1] == 'l' && format[2] == 'x') {
         lu = va_arg(va, unsigned long);  // FAST PATH: PLAIN LONG HEX
-        if (out(ibuf, arg, uint64toarray_radix16(lu, ibuf)) == -1) return -1;
+        if (__fmt_write(&b, ibuf, uint64toarray_radix16(lu, ibuf)) == -1) {
+          return -1;
+        }
         format += 3;
         continue;
       } else if (format[1] == 'l' && format[2] == 'd') {
         ld = va_arg(va, long);  // FAST PATH: PLAIN LONG
-        if (out(ibuf, arg, FormatInt64(ibuf, ld) - ibuf) == -1) return -1;
+        if (__fmt_write(&b, ibuf, FormatInt64(ibuf, ld) - ibuf) == -1) {
+          return -1;
+        }
         format += 3;
         continue;
       } else if (format[1] == 'l' && format[2] == 'u') {
         lu = va_arg(va, unsigned long);  // FAST PATH: PLAIN UNSIGNED LONG
-        if (out(ibuf, arg, FormatUint64(ibuf, lu) - ibuf) == -1) return -1;
+        if (__fmt_write(&b, ibuf, FormatUint64(ibuf, lu) - ibuf) == -1) {
+          return -1;
+        }
         format += 3;
         continue;
       } else if (format[1] == '.' && format[2] == '*' && format[3] == 's') {
@@ -858,7 +909,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
           s = "(null)";
           n = MIN(6, n);
         }
-        if (out(s, arg, n) == -1) return -1;
+        if (__fmt_write(&b, s, n) == -1) return -1;
         format += 4;
         continue;
       }
@@ -1014,7 +1065,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
         } else {
           value = va_arg(va, uint64_t);
         }
-        if (__fmt_ntoa(out, arg, value, signbit, log2base, prec, width, flags,
+        if (__fmt_ntoa(&b, value, signbit, log2base, prec, width, flags,
                        alphabet) == -1) {
           return -1;
         }
@@ -1064,7 +1115,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
       FormatStringPNotFetchedYet:
         p = va_arg(va, void *);
       FormatString:
-        if (__fmt_stoa(out, arg, p, flags, prec, width, signbit, qchar) == -1) {
+        if (__fmt_stoa(&b, p, flags, prec, width, signbit, qchar) == -1) {
           return -1;
         }
         break;
@@ -1106,7 +1157,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
           memcpy(q, kSpecialFloats[fpb.kind == STRTOG_NaN][d >= 'a'], 4);
           flags &= ~(FLAGS_PRECISION | FLAGS_PLUS | FLAGS_HASH | FLAGS_SPACE);
           prec = 0;
-          rc = __fmt_stoa(out, arg, s, flags, prec, width, signbit, qchar);
+          rc = __fmt_stoa(&b, s, flags, prec, width, signbit, qchar);
           if (rc == -1) return -1;
           break;
         }
@@ -1381,5 +1432,5 @@ int __fmt(void *fn, void *arg, const char *format, va_list va) {
     }
   }
 
-  return 0;
+  return __fmt_flush(&b);
 }
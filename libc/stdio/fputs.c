@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/stdio/internal.h"
 #include "libc/stdio/stdio.h"
 
 /**
@@ -31,8 +32,8 @@
  */
 int fputs(const char *s, FILE *f) {
   int rc;
-  flockfile(f);
+  bool locked = __stdio_lock(f);
   rc = fputs_unlocked(s, f);
-  funlockfile(f);
+  __stdio_unlock(f, locked);
   return rc;
 }
@@ -30,10 +30,10 @@
  */
 size_t fread(void *buf, size_t stride, size_t count, FILE *f) {
   size_t rc;
-  flockfile(f);
+  bool locked = __stdio_lock(f);
   rc = fread_unlocked(buf, stride, count, f);
   STDIOTRACE("fread(%p, %'zu, %'zu, %p) → %'zu %s", buf, stride, count, f, rc,
              DescribeStdioState(f->state));
-  funlockfile(f);
+  __stdio_unlock(f, locked);
   return rc;
 }
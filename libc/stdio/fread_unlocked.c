@@ -31,7 +31,9 @@
  *
  * @param stride specifies the size of individual items
  * @param count is the number of strides to fetch
- * @return count on success, [0,count) on eof, or 0 on error or count==0
+ * @return count on success, [0,count) on eof or error, or 0 if count
+ *     is zero; if an error happens after some items were transferred,
+ *     those items are still counted, and ferror() will report it
  */
 size_t fread_unlocked(void *buf, size_t stride, size_t count, FILE *f) {
   char *p;
@@ -72,32 +74,54 @@ size_t fread_unlocked(void *buf, size_t stride, size_t count, FILE *f) {
     f->state = -1;
     return m / stride;
   }
-  iov[0].iov_base = p + m;
-  iov[0].iov_len = n - m;
-  if (f->bufmode != _IONBF && n < f->size) {
-    iov[1].iov_base = f->buf;
-    if (f->size > PUSHBACK) {
-      iov[1].iov_len = f->size - PUSHBACK;
-    } else {
-      iov[1].iov_len = f->size;
-    }
-  } else {
-    iov[1].iov_base = NULL;
-    iov[1].iov_len = 0;
-  }
-  if ((rc = readv(f->fd, iov, 2)) == -1) {
-    f->state = errno;
-    return 0;
-  }
-  n = rc;
   f->beg = 0;
   f->end = 0;
-  if (n > iov[0].iov_len) {
-    f->end += n - iov[0].iov_len;
-    return count;
+  if (f->bufmode == _IONBF || n - m >= f->size) {
+    // large reads are copied directly into the caller's memory. we keep
+    // going on short reads, since pipes will hand us data piecemeal and
+    // a short count would otherwise be mistaken for end of file
+    for (;;) {
+      if ((rc = read(f->fd, p + m, n - m)) == -1) {
+        f->state = errno;
+        return m / stride;
+      }
+      if (!rc) {
+        f->state = -1;
+        return m / stride;
+      }
+      if ((m += rc) == n) {
+        return count;
+      }
+    }
+  }
+  // small reads will refill the buffer at the same time. we keep going
+  // on short reads for the same reason, until the request is satisfied
+  // or some bytes spill over into the buffer
+  __stdio_grow(f);
+  iov[1].iov_base = f->buf;
+  if (f->size > PUSHBACK) {
+    iov[1].iov_len = f->size - PUSHBACK;
   } else {
-    n = (m + n) / stride;
-    if (n < count) f->state = -1;
-    return n;
+    iov[1].iov_len = f->size;
+  }
+  for (;;) {
+    iov[0].iov_base = p + m;
+    iov[0].iov_len = n - m;
+    if ((rc = readv(f->fd, iov, 2)) == -1) {
+      f->state = errno;
+      return m / stride;
+    }
+    if (!rc) {
+      f->state = -1;
+      return m / stride;
+    }
+    if (rc > iov[0].iov_len) {
+      f->end += rc - iov[0].iov_len;
+      __stdio_filled(f, f->end, iov[1].iov_len);
+      return count;
+    }
+    if ((m += rc) == n) {
+      return count;
+    }
   }
 }
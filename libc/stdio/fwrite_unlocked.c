@@ -109,5 +109,10 @@ size_t fwrite_unlocked(const void *data, size_t stride, size_t count, FILE *f) {
     return 0;
   }
   f->beg = 0;
+  if (iov[1].iov_len < f->size) {
+    // lots of small writes are filling up the buffer
+    __stdio_filled(f, iov[0].iov_len + iov[1].iov_len, f->size);
+    __stdio_grow(f);
+  }
   return count;
 }
@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/stdio/internal.h"
 #include "libc/stdio/stdio.h"
 
 /**
@@ -41,8 +42,8 @@
  */
 ssize_t getdelim(char **s, size_t *n, int delim, FILE *f) {
   ssize_t rc;
-  flockfile(f);
+  bool locked = __stdio_lock(f);
   rc = getdelim_unlocked(s, n, delim, f);
-  funlockfile(f);
+  __stdio_unlock(f, locked);
   return rc;
 }
@@ -48,6 +48,9 @@ ssize_t getdelim_unlocked(char **s, size_t *n, int delim, FILE *f) {
     }
     if (i + m + 1 > *n) {
       n2 = i + m + 1;
+      if (!p && n2 < *n + (*n >> 1)) {
+        n2 = *n + (*n >> 1);
+      }
       s2 = realloc(*s, n2);
       if (s2) {
         *s = s2;
@@ -66,9 +69,12 @@ ssize_t getdelim_unlocked(char **s, size_t *n, int delim, FILE *f) {
       return i + m;
     } else if (f->fd == -1) {
       break;
-    } else if ((rc = read(f->fd, f->buf, f->size)) != -1) {
+    }
+    __stdio_grow(f);
+    if ((rc = read(f->fd, f->buf, f->size)) != -1) {
       if (!rc) break;
       f->end = rc;
+      __stdio_filled(f, rc, f->size);
     } else if (errno != EINTR) {
       f->state = errno;
       return -1;
@@ -0,0 +1,55 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/weaken.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/internal.h"
+#include "libc/stdio/stdio.h"
+
+/**
+ * Doubles size of stdio buffer for large sequential streams.
+ *
+ * Streams start off with a small `BUFSIZ` buffer. If the last couple
+ * reads or writes each needed the whole buffer, then it's probably a
+ * bulk transfer, so we trade a little memory for fewer system calls,
+ * up to `BUFMAX` bytes. Buffers which were supplied by the caller via
+ * setvbuf() are never changed. Nothing happens if malloc() isn't
+ * linked or fails.
+ *
+ * @param f is stream whose buffer must currently be empty
+ */
+void __stdio_grow(FILE *f) {
+  char *b;
+  size_t n;
+  if (f->fills < 2) return;
+  if (f->fd == -1) return;
+  if (f->nofree) return;
+  if (f->bufmode != _IOFBF) return;
+  if (f->beg || f->end) return;
+  if (f->size >= BUFMAX) return;
+  if (!_weaken(malloc)) return;
+  n = f->size * 2;
+  if (n > BUFMAX) n = BUFMAX;
+  if (!(b = _weaken(malloc)(n))) return;
+  if (f->buf != f->mem) {
+    _weaken(free)(f->buf);
+  }
+  f->buf = b;
+  f->size = n;
+  f->fills = 0;
+}
@@ -2,8 +2,10 @@
 #define COSMOPOLITAN_LIBC_STDIO_INTERNAL_H_
 #include "libc/stdio/stdio.h"
 #include "libc/thread/thread.h"
+#include "libc/thread/tls.h"
 
 #define PUSHBACK 12
+#define BUFMAX   1048576 /* largest size buffers will automatically grow */
 
 COSMOPOLITAN_C_START_
 
@@ -11,6 +13,7 @@ struct FILE {
   uint8_t bufmode; /* _IOFBF, etc. (ignored if fd=-1) */
   char noclose;    /* for fake dup() todo delete! */
   char dynamic;    /* did malloc() create this object? */
+  uint8_t fills;   /* consecutive i/o operations that used whole buffer */
   uint32_t iomode; /* O_RDONLY, etc. (ignored if fd=-1) */
   int32_t state;   /* 0=OK, -1=EOF, >0=errno */
   int fd;          /* ≥0=fd, -1=closed|buffer */
@@ -34,6 +37,27 @@ void __fflush_unregister(FILE *);
 bool __stdio_isok(FILE *);
 FILE *__stdio_alloc(void);
 void __stdio_free(FILE *);
+void __stdio_grow(FILE *);
+
+/* skips locking if no threads have been created, like dlmalloc */
+forceinline bool __stdio_lock(FILE *f) {
+  if (!__threaded) return false;
+  flockfile(f);
+  return true;
+}
+
+forceinline void __stdio_unlock(FILE *f, bool locked) {
+  if (locked) funlockfile(f);
+}
+
+/* tracks whether a stream is moving data faster than buffer size */
+forceinline void __stdio_filled(FILE *f, size_t used, size_t size) {
+  if (used >= size) {
+    if (f->fills < 255) ++f->fills;
+  } else {
+    f->fills = 0;
+  }
+}
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_STDIO_INTERNAL_H_ */
@@ -30,7 +30,10 @@
  * @param buf may optionally be non-NULL to set the stream's underlying
  *     buffer which the caller still owns and won't free, otherwise the
  *     existing buffer is used
- * @param size is ignored if buf is NULL
+ * @param size is the buffer size, which if buf is NULL will cause an
+ *     internal buffer of that size to be allocated, provided nothing
+ *     is currently buffered; otherwise streams start at `BUFSIZ` and
+ *     grow automatically when used for large sequential transfers
  * @return 0 on success or -1 on error
  */
 int setvbuf(FILE *f, char *buf, int mode, size_t size) {
@@ -46,6 +49,15 @@ int setvbuf(FILE *f, char *buf, int mode, size_t size) {
     f->buf = buf;
     f->size = size;
     f->nofree = true;
+  } else if (f->fd != -1 && size && size != f->size && size <= 0xffffffff &&
+             mode != _IONBF && !f->beg && !f->end && _weaken(malloc) &&
+             (buf = _weaken(malloc)(size))) {
+    if (!f->nofree && f->buf != f->mem) {
+      _weaken(free)(f->buf);
+    }
+    f->buf = buf;
+    f->size = size;
+    f->nofree = false;
   }
   f->bufmode = mode;
   funlockfile(f);
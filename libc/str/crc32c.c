@@ -16,8 +16,69 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
 #include "libc/nexgen32e/crc32.h"
 #include "libc/nexgen32e/x86feature.h"
+#include "libc/serialize.h"
+
+static struct {
+  atomic_uint once;
+  uint32_t tab[256];
+} g_crc32c;
+
+static void crc32c_init(void) {
+  crc32init(g_crc32c.tab, 0x82f63b78);
+}
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef long long xmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+
+// x^(8n-33) mod P, which pclmul+crc32q turns into an n byte shift
+static const struct {
+  uint32_t n, k1, k2;
+} kCrc32cStreams[] = {
+    {1024, 0x170076fa, 0xa51b6135},  // k1 shifts n bytes, k2 shifts 2n
+    {128, 0x0d3b6092, 0xb9e02b86},   //
+};
+
+_Microarchitecture("sse4.2,pclmul") static inline uint64_t crc32c_shift(
+    uint64_t h, uint64_t k) {
+  xmm_t x = __builtin_ia32_pclmulqdq128((xmm_t){h}, (xmm_t){k}, 0);
+  return __builtin_ia32_crc32di(0, x[0]);
+}
+
+// the crc32q instruction has three cycles of latency but can retire one
+// per cycle, so we checksum three adjacent chunks as independent chains
+// and then use carryless multiplication to splice them back together
+_Microarchitecture("sse4.2,pclmul") static uint64_t crc32c_pclmul(
+    uint64_t h, const unsigned char *p, size_t n) {
+  size_t i, j, m;
+  uint64_t a, b, c;
+  for (j = 0; j < sizeof(kCrc32cStreams) / sizeof(*kCrc32cStreams); ++j) {
+    m = kCrc32cStreams[j].n;
+    for (; n >= m * 3; p += m * 3, n -= m * 3) {
+      a = h, b = 0, c = 0;
+      for (i = 0; i < m; i += 8) {
+        a = __builtin_ia32_crc32di(a, READ64LE(p + i));
+        b = __builtin_ia32_crc32di(b, READ64LE(p + i + m));
+        c = __builtin_ia32_crc32di(c, READ64LE(p + i + m * 2));
+      }
+      h = crc32c_shift(a, kCrc32cStreams[j].k2) ^
+          crc32c_shift(b, kCrc32cStreams[j].k1) ^ c;
+    }
+  }
+  for (; n >= 8; p += 8, n -= 8) {
+    h = __builtin_ia32_crc32di(h, READ64LE(p));
+  }
+  for (; n; ++p, --n) {
+    h = __builtin_ia32_crc32qi(h, *p);
+  }
+  return h;
+}
+
+#endif /* __x86_64__ */
 
 /**
  * Computes 32-bit Castagnoli Cyclic Redundancy Check.
@@ -25,27 +86,31 @@
  *     x^32+x^26+x^23+x^22+x^16+x^12+x^11+x^10+x^8+x^7+x^5+x^4+x^2+x+1
  *     0b00011110110111000110111101000001
  *
+ * On CPUs with SSE4.2 and PCLMUL, inputs larger than 384 bytes are
+ * checksummed as three interleaved streams, which is about 3x faster
+ * than a single crc32q chain.
+ *
  * @param init is the initial hash value
  * @param data points to the data
  * @param size is the byte size of data
  * @return eax is the new hash value
  * @note Used by ISCSI, TensorFlow, etc.
+ * @threadsafe
  */
 uint32_t crc32c(uint32_t init, const void *data, size_t size) {
   uint64_t h;
-  static bool once;
   const unsigned char *p, *pe;
-  static uint32_t kCrc32cTab[256];
-  if (!once) {
-    crc32init(kCrc32cTab, 0x82f63b78);
-    once = 1;
-  }
   p = data;
   pe = p + size;
   h = init ^ 0xffffffff;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (size >= 384 && X86_HAVE(SSE4_2) && X86_HAVE(PCLMUL)) {
+    return crc32c_pclmul(h, p, size) ^ 0xffffffff;
+  }
+#endif
   if (X86_HAVE(SSE4_2)) {
     while (p < pe && ((intptr_t)p & 7)) {
-      h = h >> 8 ^ kCrc32cTab[(h & 0xff) ^ *p++];
+      asm("crc32b\t%1,%0" : "+r"(h) : "rm"(*p++));
     }
     for (; p + 8 <= pe; p += 8) {
       asm("crc32q\t%1,%0" : "+r"(h) : "rm"(*(const uint64_t *)p));
@@ -54,8 +119,9 @@ uint32_t crc32c(uint32_t init, const void *data, size_t size) {
       asm("crc32b\t%1,%0" : "+r"(h) : "rm"(*p++));
     }
   } else {
+    cosmo_once(&g_crc32c.once, crc32c_init);
     while (p < pe) {
-      h = h >> 8 ^ kCrc32cTab[(h & 0xff) ^ *p++];
+      h = h >> 8 ^ g_crc32c.tab[(h & 0xff) ^ *p++];
     }
   }
   return h ^ 0xffffffff;
@@ -0,0 +1,421 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/thread/forkjoin.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview fork-join work stealing runtime
+ *
+ * Each participating thread owns a slot with a Chase-Lev deque. When a
+ * task forks, the second half is pushed onto the bottom of the deque
+ * and the first half runs immediately. Idle threads steal from the top
+ * of a random victim's deque. Joining a task that has been stolen means
+ * helping with other work until it completes, so threads never block
+ * while work remains. Slot zero belongs to whichever outside thread is
+ * calling into the pool, so the caller's own core does work too.
+ *
+ * Tasks live on the stack frame of forkjoin_invoke2(), so forking does
+ * not allocate memory. If a deque fills up, the task simply runs on
+ * the current thread.
+ */
+
+#define FJ_DEQUE 1024 /* must be two power */
+#define FJ_SLOTS 512
+#define FJ_SPINS 4096
+
+struct ForkJoinTask {
+  void (*fn)(void *);
+  void *arg;
+  atomic_int done;
+};
+
+struct ForkJoinSlot {
+  _Alignas(64) atomic_long top;
+  _Alignas(64) atomic_long bottom;
+  uint64_t rand;
+  struct ForkJoinTask *_Atomic tasks[FJ_DEQUE];
+};
+
+static struct ForkJoin {
+  atomic_uint once;
+  int slots;
+  bool atfork;
+  atomic_bool stop;
+  atomic_int limit;
+  atomic_int sleepers;
+  atomic_uint epoch;
+  struct ForkJoinSlot *slot;
+  pthread_t *threads;
+} g_fj;
+
+static pthread_mutex_t g_fj_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_fj_park = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_fj_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_fj_unpark = PTHREAD_COND_INITIALIZER;
+
+static _Thread_local struct ForkJoinSlot *__fj_self;
+
+static bool forkjoin_push(struct ForkJoinSlot *d, struct ForkJoinTask *t) {
+  long b, top;
+  b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  top = atomic_load_explicit(&d->top, memory_order_acquire);
+  if (b - top >= FJ_DEQUE) return false;
+  atomic_store_explicit(&d->tasks[b & (FJ_DEQUE - 1)], t, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static struct ForkJoinTask *forkjoin_pop(struct ForkJoinSlot *d) {
+  long b, top;
+  struct ForkJoinTask *t;
+  b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  top = atomic_load_explicit(&d->top, memory_order_relaxed);
+  if (top > b) {
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 0;
+  }
+  t = atomic_load_explicit(&d->tasks[b & (FJ_DEQUE - 1)], memory_order_relaxed);
+  if (top == b) {
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+      t = 0;
+    }
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  }
+  return t;
+}
+
+static struct ForkJoinTask *forkjoin_steal(struct ForkJoinSlot *d) {
+  long b, top;
+  struct ForkJoinTask *t;
+  top = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (top >= b) return 0;
+  t = atomic_load_explicit(&d->tasks[top & (FJ_DEQUE - 1)],
+                           memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed)) {
+    return 0;
+  }
+  return t;
+}
+
+static void forkjoin_exec(struct ForkJoinTask *t) {
+  t->fn(t->arg);
+  atomic_store_explicit(&t->done, 1, memory_order_release);
+}
+
+static bool forkjoin_help(struct ForkJoinSlot *self) {
+  int i, v, n;
+  struct ForkJoinTask *t;
+  n = atomic_load_explicit(&g_fj.limit, memory_order_relaxed);
+  self->rand ^= self->rand << 13;
+  self->rand ^= self->rand >> 7;
+  self->rand ^= self->rand << 17;
+  v = self->rand % n;
+  for (i = 0; i < n; ++i, v = v + 1 < n ? v + 1 : 0) {
+    if (g_fj.slot + v == self) continue;
+    if ((t = forkjoin_steal(g_fj.slot + v))) {
+      forkjoin_exec(t);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool forkjoin_haswork(void) {
+  int i, n;
+  n = atomic_load_explicit(&g_fj.limit, memory_order_relaxed);
+  for (i = 0; i < n; ++i) {
+    if (atomic_load(&g_fj.slot[i].top) < atomic_load(&g_fj.slot[i].bottom)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void forkjoin_notify(void) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&g_fj.sleepers, memory_order_relaxed)) {
+    atomic_fetch_add(&g_fj.epoch, 1);
+    pthread_mutex_lock(&g_fj_park);
+    pthread_cond_signal(&g_fj_wake);
+    pthread_mutex_unlock(&g_fj_park);
+  }
+}
+
+static void forkjoin_sleep(void) {
+  unsigned epoch;
+  atomic_fetch_add(&g_fj.sleepers, 1);
+  epoch = atomic_load(&g_fj.epoch);
+  if (!forkjoin_haswork()) {
+    pthread_mutex_lock(&g_fj_park);
+    while (epoch == atomic_load(&g_fj.epoch) && !atomic_load(&g_fj.stop)) {
+      pthread_cond_wait(&g_fj_wake, &g_fj_park);
+    }
+    pthread_mutex_unlock(&g_fj_park);
+  }
+  atomic_fetch_sub(&g_fj.sleepers, 1);
+}
+
+static void *forkjoin_worker(void *arg) {
+  int id, spins;
+  struct ForkJoinSlot *self = arg;
+  __fj_self = self;
+  id = self - g_fj.slot;
+  for (spins = 0; !atomic_load_explicit(&g_fj.stop, memory_order_acquire);) {
+    if (id >= atomic_load_explicit(&g_fj.limit, memory_order_acquire)) {
+      pthread_mutex_lock(&g_fj_park);
+      while (id >= atomic_load(&g_fj.limit) && !atomic_load(&g_fj.stop)) {
+        pthread_cond_wait(&g_fj_unpark, &g_fj_park);
+      }
+      pthread_mutex_unlock(&g_fj_park);
+      continue;
+    }
+    if (forkjoin_help(self)) {
+      spins = 0;
+    } else if (++spins < FJ_SPINS) {
+      pthread_pause_np();
+    } else {
+      forkjoin_sleep();
+      spins = 0;
+    }
+  }
+  return 0;
+}
+
+static void forkjoin_onfork(void) {
+  // worker threads don't survive fork(), so the child runs serially
+  if (g_fj.slots) g_fj.slots = 1;
+  atomic_store(&g_fj.limit, 1);
+  pthread_mutex_init(&g_fj_lock, 0);
+  pthread_mutex_init(&g_fj_park, 0);
+  pthread_cond_init(&g_fj_wake, 0);
+  pthread_cond_init(&g_fj_unpark, 0);
+}
+
+static void forkjoin_init(void) {
+  int i, n;
+  n = MIN(MAX(__get_cpu_count(), 1), FJ_SLOTS);
+  if (!(g_fj.slot = memalign(64, n * sizeof(*g_fj.slot))) ||
+      !(g_fj.threads = calloc(n, sizeof(*g_fj.threads)))) {
+    free(g_fj.slot);
+    g_fj.slot = 0;
+    g_fj.slots = 0;
+    return;
+  }
+  memset(g_fj.slot, 0, n * sizeof(*g_fj.slot));
+  for (i = 0; i < n; ++i) {
+    g_fj.slot[i].rand = (i + 1) * 0x9e3779b97f4a7c15;
+  }
+  g_fj.slots = 1;
+  atomic_store(&g_fj.stop, false);
+  atomic_store(&g_fj.limit, n);
+  for (i = 1; i < n; ++i) {
+    if (pthread_create(g_fj.threads + i, 0, forkjoin_worker, g_fj.slot + i)) {
+      break;
+    }
+    pthread_setname_np(g_fj.threads[i], "forkjoin");
+    g_fj.slots = i + 1;
+  }
+  atomic_store(&g_fj.limit, g_fj.slots);
+  if (!g_fj.atfork) {
+    pthread_atfork(0, 0, forkjoin_onfork);
+    g_fj.atfork = true;
+  }
+}
+
+/**
+ * Stops the fork-join worker threads and frees their memory.
+ *
+ * This waits for callers that are currently inside the pool to finish.
+ * The pool is started again by the next function that needs it. This
+ * is useful for tests and leak checkers, which expect every thread to
+ * have been joined before the program ends.
+ */
+void forkjoin_shutdown(void) {
+  int i;
+  if (atomic_load(&g_fj.once) != 2) return;  // never started
+  pthread_mutex_lock(&g_fj_lock);
+  pthread_mutex_lock(&g_fj_park);
+  atomic_store(&g_fj.stop, true);
+  atomic_fetch_add(&g_fj.epoch, 1);
+  pthread_cond_broadcast(&g_fj_wake);
+  pthread_cond_broadcast(&g_fj_unpark);
+  pthread_mutex_unlock(&g_fj_park);
+  for (i = 1; i < g_fj.slots; ++i) {
+    pthread_join(g_fj.threads[i], 0);
+  }
+  free(g_fj.threads);
+  free(g_fj.slot);
+  g_fj.threads = 0;
+  g_fj.slot = 0;
+  g_fj.slots = 0;
+  atomic_store(&g_fj.limit, 0);
+  atomic_store(&g_fj.stop, false);
+  atomic_store(&g_fj.once, 0);
+  pthread_mutex_unlock(&g_fj_lock);
+}
+
+/**
+ * Returns number of threads that participate in fork-join parallelism.
+ *
+ * The first call starts one worker thread per additional cpu.
+ */
+int forkjoin_concurrency(void) {
+  cosmo_once(&g_fj.once, forkjoin_init);
+  return MAX(1, atomic_load_explicit(&g_fj.limit, memory_order_relaxed));
+}
+
+/**
+ * Limits how many threads participate in fork-join parallelism.
+ *
+ * Workers beyond the limit are parked until the limit is raised. This
+ * is mostly useful for measuring how well an algorithm scales.
+ *
+ * @param n is thread count, or zero for one per cpu
+ * @return number of threads that'll actually be used
+ */
+int forkjoin_setconcurrency(int n) {
+  cosmo_once(&g_fj.once, forkjoin_init);
+  if (!g_fj.slots) return 1;
+  if (n <= 0 || n > g_fj.slots) n = g_fj.slots;
+  pthread_mutex_lock(&g_fj_park);
+  atomic_store(&g_fj.limit, n);
+  pthread_cond_broadcast(&g_fj_unpark);
+  pthread_mutex_unlock(&g_fj_park);
+  return n;
+}
+
+/**
+ * Calls `fn(arg)` as a participant of the fork-join thread pool.
+ *
+ * Outside threads take turns calling into the pool. When called from
+ * inside a task, `fn` is simply called.
+ */
+void forkjoin_run(void fn(void *), void *arg) {
+  if (__fj_self || forkjoin_concurrency() <= 1) {
+    fn(arg);
+    return;
+  }
+  pthread_mutex_lock(&g_fj_lock);
+  if (!g_fj.slot) {  // forkjoin_shutdown() won the race
+    pthread_mutex_unlock(&g_fj_lock);
+    fn(arg);
+    return;
+  }
+  __fj_self = g_fj.slot;
+  fn(arg);
+  __fj_self = 0;
+  pthread_mutex_unlock(&g_fj_lock);
+}
+
+struct ForkJoinInvoke2 {
+  void (*f)(void *);
+  void *a;
+  void (*g)(void *);
+  void *b;
+};
+
+static void forkjoin_invoke2_thunk(void *arg) {
+  struct ForkJoinInvoke2 *x = arg;
+  forkjoin_invoke2(x->f, x->a, x->g, x->b);
+}
+
+/**
+ * Calls `f(a)` and `g(b)`, possibly in parallel.
+ *
+ * This function returns once both calls have returned. The calls may
+ * themselves fork further work, which is how divide-and-conquer gets
+ * spread across threads.
+ */
+void forkjoin_invoke2(void f(void *), void *a, void g(void *), void *b) {
+  struct ForkJoinSlot *self;
+  struct ForkJoinTask t = {f, a};
+  if (!(self = __fj_self) && forkjoin_concurrency() > 1) {
+    struct ForkJoinInvoke2 x = {f, a, g, b};
+    forkjoin_run(forkjoin_invoke2_thunk, &x);
+    return;
+  }
+  if (!self || atomic_load_explicit(&g_fj.limit, memory_order_relaxed) <= 1 ||
+      !forkjoin_push(self, &t)) {
+    f(a);
+    g(b);
+    return;
+  }
+  forkjoin_notify();
+  g(b);
+  if (forkjoin_pop(self) == &t) {
+    f(a);
+    return;
+  }
+  while (!atomic_load_explicit(&t.done, memory_order_acquire)) {
+    if (!forkjoin_help(self)) {
+      pthread_pause_np();
+    }
+  }
+}
+
+struct ForkJoinFor {
+  void (*fn)(void *, size_t, size_t);
+  void *arg;
+  size_t lo, hi, grain;
+};
+
+static void forkjoin_for_worker(void *arg) {
+  struct ForkJoinFor *r = arg, left, right;
+  if (r->hi - r->lo <= r->grain) {
+    r->fn(r->arg, r->lo, r->hi);
+    return;
+  }
+  left = right = *r;
+  left.hi = right.lo = r->lo + (r->hi - r->lo) / 2;
+  forkjoin_invoke2(forkjoin_for_worker, &left, forkjoin_for_worker, &right);
+}
+
+/**
+ * Calls `fn(arg, lo, hi)` over subranges which partition `[0,n)`.
+ *
+ * @param grain is the largest subrange, or zero to choose automatically
+ */
+void forkjoin_for(size_t n, size_t grain,
+                  void fn(void *arg, size_t lo, size_t hi), void *arg) {
+  struct ForkJoinFor r;
+  if (!n) return;
+  if (!grain) grain = MAX(1, n / (forkjoin_concurrency() * 8));
+  r.fn = fn;
+  r.arg = arg;
+  r.lo = 0;
+  r.hi = n;
+  r.grain = grain;
+  forkjoin_run(forkjoin_for_worker, &r);
+}
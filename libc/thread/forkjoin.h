@@ -0,0 +1,18 @@
+#ifndef COSMOPOLITAN_LIBC_THREAD_FORKJOIN_H_
+#define COSMOPOLITAN_LIBC_THREAD_FORKJOIN_H_
+COSMOPOLITAN_C_START_
+
+int forkjoin_concurrency(void);
+int forkjoin_setconcurrency(int);
+void forkjoin_shutdown(void);
+void forkjoin_run(void (*)(void *), void *);
+void forkjoin_invoke2(void (*)(void *), void *, void (*)(void *), void *);
+void forkjoin_for(size_t, size_t, void (*)(void *, size_t, size_t), void *);
+
+void qsort_parallel(void *, size_t, size_t, int (*)(const void *, const void *))
+    paramsnonnull();
+void merge_parallel(const void *, size_t, const void *, size_t, void *, size_t,
+                    int (*)(const void *, const void *));
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_THREAD_FORKJOIN_H_ */
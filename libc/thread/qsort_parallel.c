@@ -0,0 +1,191 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/macros.internal.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/thread/forkjoin.h"
+
+#define MERGE_GRAIN 8192
+#define SORT_GRAIN  16384
+
+struct MergeParallel {
+  const char *x, *y;
+  char *z;
+  size_t nx, ny, size;
+  int (*cmp)(const void *, const void *);
+};
+
+struct SortParallel {
+  char *a, *t;
+  size_t n, size, leaf;
+  bool where;
+  int (*cmp)(const void *, const void *);
+};
+
+// returns number of elements in y that are less than k
+static size_t lower_bound(const char *y, size_t n, const void *k, size_t z,
+                          int cmp(const void *, const void *)) {
+  size_t l, r, m;
+  for (l = 0, r = n; l < r;) {
+    m = l + (r - l) / 2;
+    if (cmp(y + m * z, k) < 0) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  return l;
+}
+
+// returns number of elements in x that are less than or equal to k
+static size_t upper_bound(const char *x, size_t n, const void *k, size_t z,
+                          int cmp(const void *, const void *)) {
+  size_t l, r, m;
+  for (l = 0, r = n; l < r;) {
+    m = l + (r - l) / 2;
+    if (cmp(x + m * z, k) <= 0) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  return l;
+}
+
+static void merge_serial(struct MergeParallel *m) {
+  const char *x = m->x, *xe = m->x + m->nx * m->size;
+  const char *y = m->y, *ye = m->y + m->ny * m->size;
+  char *z = m->z;
+  while (x < xe && y < ye) {
+    if (m->cmp(y, x) < 0) {
+      memcpy(z, y, m->size);
+      y += m->size;
+    } else {
+      memcpy(z, x, m->size);
+      x += m->size;
+    }
+    z += m->size;
+  }
+  memcpy(z, x, xe - x);
+  memcpy(z + (xe - x), y, ye - y);
+}
+
+static void merge_parallel_worker(void *arg) {
+  const char *pivot;
+  size_t xm, ym, z;
+  struct MergeParallel *m = arg, lo, hi;
+  if (m->nx + m->ny <= MERGE_GRAIN) {
+    merge_serial(m);
+    return;
+  }
+  z = m->size;
+  lo = hi = *m;
+  if (m->nx >= m->ny) {
+    xm = m->nx / 2;
+    pivot = m->x + xm * z;
+    ym = lower_bound(m->y, m->ny, pivot, z, m->cmp);
+    hi.x += (xm + 1) * z;
+    hi.nx -= xm + 1;
+    hi.y += ym * z;
+    hi.ny -= ym;
+  } else {
+    ym = m->ny / 2;
+    pivot = m->y + ym * z;
+    xm = upper_bound(m->x, m->nx, pivot, z, m->cmp);
+    hi.x += xm * z;
+    hi.nx -= xm;
+    hi.y += (ym + 1) * z;
+    hi.ny -= ym + 1;
+  }
+  lo.nx = xm;
+  lo.ny = ym;
+  memcpy(m->z + (xm + ym) * z, pivot, z);
+  hi.z += (xm + ym + 1) * z;
+  forkjoin_invoke2(merge_parallel_worker, &lo, merge_parallel_worker, &hi);
+}
+
+/**
+ * Merges two sorted arrays using multiple threads.
+ *
+ * The merge is stable, i.e. elements of `x` come before equal elements
+ * of `y`. The output array `z` must have room for `nx + ny` elements,
+ * and may not overlap with either input.
+ */
+void merge_parallel(const void *x, size_t nx, const void *y, size_t ny,
+                    void *z, size_t size, int cmp(const void *, const void *)) {
+  struct MergeParallel m = {x, y, z, nx, ny, size, cmp};
+  forkjoin_run(merge_parallel_worker, &m);
+}
+
+static void qsort_parallel_worker(void *arg) {
+  size_t h;
+  struct SortParallel *s = arg, lo, hi;
+  if (s->n <= s->leaf) {
+    qsort(s->a, s->n, s->size, s->cmp);
+    if (s->where) memcpy(s->t, s->a, s->n * s->size);
+    return;
+  }
+  // sort each half into the other buffer then merge them back here
+  h = s->n / 2;
+  lo = hi = *s;
+  lo.n = h;
+  lo.where = hi.where = !s->where;
+  hi.a += h * s->size;
+  hi.t += h * s->size;
+  hi.n -= h;
+  forkjoin_invoke2(qsort_parallel_worker, &lo, qsort_parallel_worker, &hi);
+  if (s->where) {
+    merge_parallel(s->a, h, s->a + h * s->size, s->n - h, s->t, s->size,
+                   s->cmp);
+  } else {
+    merge_parallel(s->t, h, s->t + h * s->size, s->n - h, s->a, s->size,
+                   s->cmp);
+  }
+}
+
+/**
+ * Sorts array using multiple threads.
+ *
+ * This has the same contract as qsort(). The array is split into runs
+ * that get sorted by qsort() on separate threads, and these runs are
+ * then merged in parallel. This needs a temporary buffer as big as the
+ * array. If that can't be allocated, or only one thread is available,
+ * this just calls qsort().
+ *
+ * @see forkjoin_setconcurrency()
+ */
+void qsort_parallel(void *base, size_t n, size_t size,
+                    int cmp(const void *, const void *)) {
+  int c;
+  struct SortParallel s;
+  if (n < SORT_GRAIN * 2 || (c = forkjoin_concurrency()) <= 1 ||
+      !(s.t = malloc(n * size))) {
+    qsort(base, n, size, cmp);
+    return;
+  }
+  s.a = base;
+  s.n = n;
+  s.size = size;
+  s.leaf = MAX(SORT_GRAIN, n / (c * 4));
+  s.where = false;
+  s.cmp = cmp;
+  forkjoin_run(qsort_parallel_worker, &s);
+  free(s.t);
+}
@@ -58,6 +58,18 @@ o/$(MODE)/net/http/formathttpdatetime.o: private\
 		CFLAGS +=			\
 			-O3
 
+ifeq ($(ARCH), x86_64)
+o/$(MODE)/net/http/skiphttpfield-avx2.o: private	\
+		TARGET_ARCH +=				\
+			-mavx2
+o/$(MODE)/net/http/unescapedspan-ssse3.o: private	\
+		TARGET_ARCH +=				\
+			-mssse3
+o/$(MODE)/net/http/unescapedspan-avx2.o: private	\
+		TARGET_ARCH +=				\
+			-mavx2
+endif
+
 NET_HTTP_LIBS = $(foreach x,$(NET_HTTP_ARTIFACTS),$($(x)))
 NET_HTTP_SRCS = $(foreach x,$(NET_HTTP_ARTIFACTS),$($(x)_SRCS))
 NET_HTTP_HDRS = $(foreach x,$(NET_HTTP_ARTIFACTS),$($(x)_HDRS))
@@ -37,17 +37,25 @@
  */
 char *EncodeLatin1(const char *p, size_t n, size_t *z, int f) {
   int c;
-  size_t i;
-  char t[256];
+  size_t i, k;
+  char t[256], s[256];
+  struct UnescapedSpan u;
   char *r, *q;
   bzero(t, sizeof(t));
   if (f & kControlC0) memset(t + 0x00, 1, 0x20 - 0x00), t[0x7F] = 1;
   if (f & kControlC1) memset(t + 0x80, 1, 0xA0 - 0x80);
   t['\t'] = t['\r'] = t['\n'] = t['\v'] = !!(f & kControlWs);
+  memcpy(s, t, 0x80);
+  memset(s + 0x80, 1, 0x80);
+  InitUnescapedSpan(&u, s);
   if (z) *z = 0;
   if (n == -1) n = p ? strlen(p) : 0;
   if ((q = r = malloc(n + 1))) {
     for (i = 0; i < n;) {
+      k = NextUnescapedSpan(&u, p + i, n - i);
+      memcpy(q, p + i, k);
+      q += k;
+      if ((i += k) == n) break;
       c = p[i++] & 0xff;
       if (c >= 0300) {
         if ((c <= 0303) && i < n && (p[i] & 0300) == 0200) {
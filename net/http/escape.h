@@ -7,6 +7,12 @@
 
 COSMOPOLITAN_C_START_
 
+struct UnescapedSpan {
+  const char *T;
+  int hi; /* how simd treats bytes ≥0x80, or -1 if it can't be used */
+  char lut[16];
+};
+
 extern const char kEscapeAuthority[256];
 extern const char kEscapeIp[256];
 extern const char kEscapePath[256];
@@ -26,6 +32,9 @@ char *EscapeFragment(const char *, size_t, size_t *);
 char *EscapeSegment(const char *, size_t, size_t *);
 char *EscapeJsStringLiteral(char **, size_t *, const char *, size_t, size_t *);
 
+size_t UnescapedSpan(const char *, size_t, const char[256]);
+void InitUnescapedSpan(struct UnescapedSpan *, const char[256]);
+size_t NextUnescapedSpan(const struct UnescapedSpan *, const char *, size_t);
 ssize_t HasControlCodes(const char *, size_t, int);
 char *Underlong(const char *, size_t, size_t *);
 char *DecodeLatin1(const char *, size_t, size_t *);
@@ -21,6 +21,10 @@
 #include "libc/x/x.h"
 #include "net/http/escape.h"
 
+static const char kEscapeHtml[256] = {
+    ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1, ['\''] = 1,
+};
+
 /**
  * Escapes HTML entities.
  *
@@ -31,12 +35,18 @@
  */
 char *EscapeHtml(const char *p, size_t n, size_t *z) {
   int c;
-  size_t i;
   char *q, *r;
+  size_t i, k;
+  struct UnescapedSpan s;
   if (z) *z = 0;
   if (n == -1) n = p ? strlen(p) : 0;
   if ((q = r = malloc(n * 6 + 1))) {
+    InitUnescapedSpan(&s, kEscapeHtml);
     for (i = 0; i < n; ++i) {
+      k = NextUnescapedSpan(&s, p + i, n - i);
+      memcpy(q, p + i, k);
+      q += k;
+      if ((i += k) == n) break;
       switch ((c = p[i])) {
         case '&':
           q[0] = '&';
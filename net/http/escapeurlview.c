@@ -16,6 +16,8 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/str/str.h"
+#include "net/http/escape.h"
 #include "net/http/url.h"
 
 /**
@@ -23,16 +25,19 @@
  */
 char *EscapeUrlView(char *p, struct UrlView *v, const char T[256]) {
   int c;
-  size_t i;
+  size_t i, k;
+  struct UnescapedSpan s;
+  InitUnescapedSpan(&s, T);
   for (i = 0; i < v->n; ++i) {
-    if (!T[(c = v->p[i] & 0xFF)]) {
-      *p++ = c;
-    } else {
-      p[0] = '%';
-      p[1] = "0123456789ABCDEF"[(c & 0xF0) >> 4];
-      p[2] = "0123456789ABCDEF"[(c & 0x0F) >> 0];
-      p += 3;
-    }
+    k = NextUnescapedSpan(&s, v->p + i, v->n - i);
+    memcpy(p, v->p + i, k);
+    p += k;
+    if ((i += k) == v->n) break;
+    c = v->p[i] & 0xFF;
+    p[0] = '%';
+    p[1] = "0123456789ABCDEF"[(c & 0xF0) >> 4];
+    p[2] = "0123456789ABCDEF"[(c & 0x0F) >> 0];
+    p += 3;
   }
   return p;
 }
@@ -21,12 +21,15 @@
 
 /**
  * Returns small number for HTTP header, or -1 if not found.
+ *
+ * Standard headers are looked up using a perfect hash table. Anything
+ * else is checked against the names added by RegisterHttpHeader().
  */
 int GetHttpHeader(const char *str, size_t len) {
   const struct HttpHeaderSlot *slot;
   if ((slot = LookupHttpHeader(str, len))) {
     return slot->code;
   } else {
-    return -1;
+    return GetHttpCustomHeader(str, len);
   }
 }
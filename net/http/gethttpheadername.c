@@ -207,6 +207,6 @@ const char *GetHttpHeaderName(int h) {
     case kHttpSecChUaPlatform:
       return "Sec-CH-UA-Platform";
     default:
-      return NULL;
+      return GetHttpCustomHeaderName(h);
   }
 }
@@ -25,7 +25,8 @@
  *
  * @param m is message parsed by ParseHttpMessage
  * @param b is buffer that ParseHttpMessage parsed
- * @param h is known header, e.g. kHttpAcceptEncoding
+ * @param h is known header, e.g. kHttpAcceptEncoding, or a number
+ *     that was returned by RegisterHttpHeader()
  * @param s should not contain comma
  * @param n is byte length of s where -1 implies strlen
  * @return true if substring present
@@ -33,7 +34,7 @@
 bool HeaderHas(struct HttpMessage *m, const char *b, int h, const char *s,
                size_t n) {
   size_t i;
-  unassert(0 <= h && h < kHttpHeadersMax);
+  unassert(0 <= h && h < kHttpHeadersMax + kHttpCustomHeadersMax);
   if (n == -1) n = s ? strlen(s) : 0;
   if (m->headers[h].a) {
     if (memmem(b + m->headers[h].a, m->headers[h].b - m->headers[h].a, s, n)) {
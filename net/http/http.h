@@ -147,6 +147,7 @@
 #define kHttpSecChUaPlatform               91
 #define kHttpCdnLoop                       92
 #define kHttpHeadersMax                    93
+#define kHttpCustomHeadersMax              16
 
 COSMOPOLITAN_C_START_
 
@@ -174,11 +175,40 @@ struct HttpMessage {
   struct HttpSlice uri;
   struct HttpSlice scratch;
   struct HttpSlice message;
-  struct HttpSlice headers[kHttpHeadersMax];
+  struct HttpSlice headers[kHttpHeadersMax + kHttpCustomHeadersMax];
   struct HttpSlice xmethod;
   struct HttpHeaders xheaders;
 };
 
+struct HttpWideSlice {
+  int a, b;
+};
+
+struct HttpWideHeader {
+  struct HttpWideSlice k;
+  struct HttpWideSlice v;
+};
+
+struct HttpWideHeaders {
+  unsigned n, c;
+  struct HttpWideHeader *p;
+};
+
+struct HttpWideMessage {
+  int i, a, status;
+  unsigned char t;
+  unsigned char type;
+  unsigned char method;
+  unsigned char version;
+  struct HttpWideSlice k;
+  struct HttpWideSlice uri;
+  struct HttpWideSlice scratch;
+  struct HttpWideSlice message;
+  struct HttpWideSlice headers[kHttpHeadersMax + kHttpCustomHeadersMax];
+  struct HttpWideSlice xmethod;
+  struct HttpWideHeaders xheaders;
+};
+
 struct HttpUnchunker {
   int t;
   size_t i;
@@ -188,15 +218,23 @@ struct HttpUnchunker {
 
 extern const char kHttpToken[256];
 extern const char kHttpMethod[18][8];
-extern const bool kHttpRepeatable[kHttpHeadersMax];
+extern const bool kHttpRepeatable[kHttpHeadersMax + kHttpCustomHeadersMax];
 
 const char *GetHttpReason(int);
 const char *GetHttpHeaderName(int);
 int GetHttpHeader(const char *, size_t);
+int GetHttpCustomHeader(const char *, size_t);
+const char *GetHttpCustomHeaderName(int);
+int RegisterHttpHeader(const char *, size_t);
+void UnregisterHttpHeaders(void);
 int GetHttpMethod(const char *, size_t);
 void InitHttpMessage(struct HttpMessage *, int);
 void DestroyHttpMessage(struct HttpMessage *);
 int ParseHttpMessage(struct HttpMessage *, const char *, size_t);
+size_t SkipHttpField(const char *, size_t, size_t, int);
+void InitHttpWideMessage(struct HttpWideMessage *, int);
+void DestroyHttpWideMessage(struct HttpWideMessage *);
+int ParseHttpWideMessage(struct HttpWideMessage *, const char *, size_t);
 bool HeaderHas(struct HttpMessage *, const char *, int, const char *, size_t);
 int64_t ParseContentLength(const char *, size_t);
 char *FormatHttpDateTime(char[hasatleast 30], struct tm *);
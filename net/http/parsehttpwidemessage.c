@@ -0,0 +1,67 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/assert.h"
+#include "libc/limits.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/sysv/errfuns.h"
+#include "net/http/http.h"
+
+#define LIMIT (INT_MAX - 2)
+
+/**
+ * Initializes HTTP message parser for messages larger than 32kb.
+ */
+void InitHttpWideMessage(struct HttpWideMessage *r, int type) {
+  unassert(type == kHttpRequest || type == kHttpResponse);
+  bzero(r, sizeof(*r));
+  r->type = type;
+}
+
+/**
+ * Destroys HTTP message parser for messages larger than 32kb.
+ */
+void DestroyHttpWideMessage(struct HttpWideMessage *r) {
+  if (r->xheaders.p) {
+    free(r->xheaders.p);
+    r->xheaders.p = NULL;
+    r->xheaders.n = 0;
+  }
+}
+
+/**
+ * Parses HTTP request or response that may exceed 32kb.
+ *
+ * This is the same as ParseHttpMessage() except slices are 32-bit, so
+ * the header block may be as large as the caller's buffer. It's opt-in
+ * because the compact message is half the size and is good enough for
+ * nearly all clients. Servers that need to accept things like enormous
+ * SSO cookies or JWT bearer tokens should use this instead, and should
+ * bound `n` to whatever maximum they're willing to accept.
+ *
+ * @return bytes of header on success, 0 if message is incomplete, or
+ *     -1 w/ errno if the message is malformed
+ * @raise EBADMSG if message is malformed
+ * @see ParseHttpMessage()
+ */
+int ParseHttpWideMessage(struct HttpWideMessage *r, const char *p, size_t n) {
+#include "net/http/parsehttpmessage.inc"
+}
@@ -29,8 +29,44 @@ struct UrlParser {
   char *p, *q;
   const char *s;
   unsigned c, i, n, f;
+  struct UnescapedSpan span;
 };
 
+#define LATIN1 [0200 ... 0377] = 1
+
+// bytes that need attention in each url component
+static const char kPathSpecial[2][256] = {
+    {['#'] = 1, ['?'] = 1, ['%'] = 1},
+    {['#'] = 1, ['?'] = 1, ['%'] = 1, LATIN1},
+};
+static const char kQuerySpecial[2][256] = {
+    {['#'] = 1, ['%'] = 1, ['+'] = 1, ['&'] = 1, ['='] = 1},
+    {['#'] = 1, ['%'] = 1, ['+'] = 1, ['&'] = 1, ['='] = 1, LATIN1},
+};
+static const char kFragmentSpecial[2][256] = {
+    {['%'] = 1},
+    {['%'] = 1, LATIN1},
+};
+
+static bool CopyPlain(struct UrlParser *u, const char T[2][256]) {
+  size_t k;
+  const char *t = T[!!(u->f & kUrlLatin1)];
+  if (u->n - u->i < 16) {
+    k = UnescapedSpan(u->s + u->i, u->n - u->i, t);
+  } else {
+    // fold table once per component rather than once per escape
+    if (u->span.T != t) InitUnescapedSpan(&u->span, t);
+    k = NextUnescapedSpan(&u->span, u->s + u->i, u->n - u->i);
+  }
+  if (k) {
+    memcpy(u->p, u->s + u->i, k);
+    u->p += k;
+    u->i += k;
+    u->c = u->s[u->i - 1] & 255;
+  }
+  return u->i < u->n;
+}
+
 static void EmitLatin1(char **p, int c) {
   (*p)[0] = 0300 | c >> 6;
   (*p)[1] = 0200 | (c & 077);
@@ -183,7 +219,7 @@ static void ParseAuthority(struct UrlParser *u, struct Url *h) {
 }
 
 static void ParsePath(struct UrlParser *u, struct UrlView *h) {
-  while (u->i < u->n) {
+  while (CopyPlain(u, kPathSpecial)) {
     u->c = u->s[u->i++] & 255;
     if (u->c == '#') {
       break;
@@ -205,7 +241,7 @@ static void ParsePath(struct UrlParser *u, struct UrlView *h) {
 static void ParseQuery(struct UrlParser *u, struct UrlParams *h) {
   bool t = false;
   if (!h->p) h->p = malloc(0);
-  while (u->i < u->n) {
+  while (CopyPlain(u, kQuerySpecial)) {
     u->c = u->s[u->i++] & 255;
     if (u->c == '#') {
       break;
@@ -232,7 +268,7 @@ static void ParseQuery(struct UrlParser *u, struct UrlParams *h) {
 }
 
 static void ParseFragment(struct UrlParser *u, struct UrlView *h) {
-  while (u->i < u->n) {
+  while (CopyPlain(u, kFragmentSpecial)) {
     u->c = u->s[u->i++] & 255;
     if (u->c == '%') {
       ParseEscape(u);
@@ -287,6 +323,7 @@ char *ParseUrl(const char *s, size_t n, struct Url *h, int f) {
   struct UrlParser u;
   if (n == -1) n = s ? strlen(s) : 0;
   u.i = 0;
+  u.span.T = 0;
   u.c = 0;
   u.s = s;
   u.n = n;
@@ -327,6 +364,7 @@ char *ParseParams(const char *s, size_t n, struct UrlParams *h) {
   struct UrlParser u;
   if (n == -1) n = s ? strlen(s) : 0;
   u.i = 0;
+  u.span.T = 0;
   u.s = s;
   u.n = n;
   u.c = '?';
@@ -367,6 +405,7 @@ char *ParseHost(const char *s, size_t n, struct Url *h) {
   struct UrlParser u;
   if (n == -1) n = s ? strlen(s) : 0;
   u.i = 0;
+  u.span.T = 0;
   u.c = 0;
   u.s = s;
   u.n = n;
@@ -0,0 +1,162 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
+#include "libc/mem/mem.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/sysv/errfuns.h"
+#include "net/http/http.h"
+
+#define TABLE 64
+
+static struct HttpCustomHeaders {
+  int n;
+  unsigned char table[TABLE];  // slot+1 or 0 if empty
+  struct HttpCustomHeader {
+    uint64_t hash;
+    size_t len;
+    char *name;
+  } slot[kHttpCustomHeadersMax];
+} g_custom;
+
+// lowercases ascii letters eight bytes at a time
+static inline uint64_t FoldWord(uint64_t w) {
+  uint64_t heptets = w & 0x7f7f7f7f7f7f7f7f;
+  uint64_t is_gt_Z = heptets + 0x2525252525252525;
+  uint64_t is_ge_A = heptets + 0x3f3f3f3f3f3f3f3f;
+  uint64_t is_ascii = ~w & 0x8080808080808080;
+  uint64_t is_upper = is_ascii & (is_ge_A ^ is_gt_Z);
+  return w | (is_upper >> 2);
+}
+
+static inline uint64_t ReadWord(const char *p, size_t n) {
+  uint64_t w;
+  if (n >= 8) return READ64LE(p);
+  for (w = 0; n--;) w = w << 8 | (p[n] & 255);
+  return w;
+}
+
+static uint64_t HashHeader(const char *p, size_t n) {
+  size_t i;
+  uint64_t h = n;
+  for (i = 0; i < n; i += 8) {
+    h ^= FoldWord(ReadWord(p + i, n - i));
+    h *= 0x9e3779b97f4a7c15;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+static bool IsSameHeader(const char *p, const char *q, size_t n) {
+  size_t i;
+  for (i = 0; i < n; i += 8) {
+    if (FoldWord(ReadWord(p + i, n - i)) != FoldWord(ReadWord(q + i, n - i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns number for HTTP header registered by RegisterHttpHeader().
+ *
+ * @return header number, or -1 if not found
+ */
+int GetHttpCustomHeader(const char *s, size_t n) {
+  int i, j;
+  uint64_t h;
+  struct HttpCustomHeader *x;
+  if (!g_custom.n) return -1;
+  h = HashHeader(s, n);
+  i = h & (TABLE - 1);
+  for (; (j = g_custom.table[i]); i = (i + 1) & (TABLE - 1)) {
+    x = g_custom.slot + (j - 1);
+    if (x->hash == h && x->len == n && IsSameHeader(x->name, s, n)) {
+      return kHttpHeadersMax + j - 1;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Returns name of HTTP header registered by RegisterHttpHeader().
+ */
+const char *GetHttpCustomHeaderName(int h) {
+  h -= kHttpHeadersMax;
+  if (0 <= h && h < g_custom.n) {
+    return g_custom.slot[h].name;
+  } else {
+    return 0;
+  }
+}
+
+/**
+ * Adds header name that ParseHttpMessage() should treat as standard.
+ *
+ * Headers the parser doesn't recognize are normally spilled over into
+ * `xheaders`, where they need to be found with a linear scan. Servers
+ * which need particular custom headers, e.g. `X-Tenant-Id`, can assign
+ * them a number, so their value will end up in `headers[]` where it's
+ * O(1) to access, and so GetHttpHeader() will recognize it.
+ *
+ * Names are compared case-insensitively. Registering a name which is
+ * already known returns the existing number. Registered headers aren't
+ * considered repeatable, so only the first instance lands in headers[].
+ *
+ * This function should be called during initialization, since it's not
+ * safe to call while other threads are parsing messages.
+ *
+ * @param s is header name, which must be a valid http token
+ * @param n is byte length of `s` where -1 implies strlen
+ * @return header number in range [kHttpHeadersMax,kHttpHeadersMax +
+ *     kHttpCustomHeadersMax), or -1 w/ errno
+ * @raise EINVAL if `s` isn't a valid http token
+ * @raise ENOSPC if `kHttpCustomHeadersMax` headers are already registered
+ * @raise ENOMEM if we ran out of memory
+ */
+int RegisterHttpHeader(const char *s, size_t n) {
+  int h, i;
+  char *name;
+  if (n == -1) n = s ? strlen(s) : 0;
+  if (!n || !IsValidHttpToken(s, n)) return einval();
+  if ((h = GetHttpHeader(s, n)) != -1) return h;
+  if (g_custom.n == kHttpCustomHeadersMax) return enospc();
+  if (!(name = strndup(s, n))) return -1;
+  g_custom.slot[g_custom.n].hash = HashHeader(s, n);
+  g_custom.slot[g_custom.n].len = n;
+  g_custom.slot[g_custom.n].name = name;
+  i = g_custom.slot[g_custom.n].hash & (TABLE - 1);
+  while (g_custom.table[i]) i = (i + 1) & (TABLE - 1);
+  g_custom.table[i] = ++g_custom.n;
+  return kHttpHeadersMax + g_custom.n - 1;
+}
+
+/**
+ * Forgets every header added by RegisterHttpHeader().
+ *
+ * Numbers handed out earlier may be reused by later registrations. The
+ * same thread safety caveats as RegisterHttpHeader() apply.
+ */
+void UnregisterHttpHeaders(void) {
+  int i;
+  for (i = 0; i < g_custom.n; ++i) {
+    free(g_custom.slot[i].name);
+  }
+  bzero(&g_custom, sizeof(g_custom));
+}
@@ -0,0 +1,41 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/http.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef unsigned char ymm_u
+    __attribute__((__vector_size__(32), __aligned__(1)));
+
+size_t SkipHttpField_avx2(const char *p, size_t i, size_t n, int lim) {
+  unsigned m;
+  ymm_u v, del, c1, c0;
+  del = (ymm_u){} + 0x7f;
+  c1 = (ymm_u){} + 0x21;
+  c0 = (ymm_u){} + (unsigned char)lim;
+  for (; i + 32 <= n; i += 32) {
+    v = *(const ymm_u *)(p + i);
+    if ((m = __builtin_ia32_pmovmskb256((ymm_t)((v < c0) | (v - del < c1))))) {
+      return i + __builtin_ctz(m);
+    }
+  }
+  return i;
+}
+
+#endif /* __x86_64__ */
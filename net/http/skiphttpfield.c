@@ -0,0 +1,69 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
+#include "net/http/http.h"
+
+typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+typedef unsigned char xmm_u
+    __attribute__((__vector_size__(16), __aligned__(1)));
+
+size_t SkipHttpField_avx2(const char *, size_t, size_t, int);
+
+/**
+ * Skips over ordinary characters in HTTP message field.
+ *
+ * This is the inner loop of ParseHttpMessage(), which uses it to find
+ * the next byte in a URI, reason phrase, or header value that the state
+ * machine needs to consider. That's any C0 or C1 control code, which
+ * includes CR, LF, and tab, as well as DEL. If `lim` is 0x21 then space
+ * stops the scan too. Since almost all bytes in a request are ordinary
+ * we can check 16 or 32 of them at a time using SSE2 or AVX2.
+ *
+ * @param p is message buffer
+ * @param i is index of first byte to consider
+ * @param n is length of message buffer
+ * @param lim is 0x20 to stop on controls, or 0x21 to also stop on space
+ * @return index of first non-ordinary byte, or `n` if none were found
+ */
+size_t SkipHttpField(const char *p, size_t i, size_t n, int lim) {
+  unsigned c;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  unsigned m;
+  xmm_u v, del, c1, c0;
+  if (n - i >= 32 && X86_HAVE(AVX2)) {
+    i = SkipHttpField_avx2(p, i, n, lim);
+  }
+  del = (xmm_u){} + 0x7f;
+  c1 = (xmm_u){} + 0x21;
+  c0 = (xmm_u){} + (unsigned char)lim;
+  for (; i + 16 <= n; i += 16) {
+    v = *(const xmm_u *)(p + i);
+    if ((m = __builtin_ia32_pmovmskb128((xmm_t)((v < c0) | (v - del < c1))))) {
+      return i + __builtin_ctz(m);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    c = p[i] & 255;
+    if (c < lim || c - 0x7f < 0x21) {
+      break;
+    }
+  }
+  return i;
+}
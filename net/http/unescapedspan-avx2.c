@@ -0,0 +1,49 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/escape.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+typedef char ymm_t __attribute__((__vector_size__(32), __aligned__(1)));
+typedef unsigned short ymm_h __attribute__((__vector_size__(32), __aligned__(1)));
+
+size_t UnescapedSpan_avx2(const char *p, size_t n, xmm_t lut, int hi) {
+  size_t i;
+  unsigned m;
+  ymm_t v, t, z = {0};
+  ymm_t f = (ymm_t){} + 15;
+  ymm_t l = __builtin_shufflevector(lut, lut, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                    10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5,
+                                    6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  ymm_t b = {1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+             1, 2, 4, 8, 16, 32, 64, -128};
+  for (i = 0; i + 32 <= n; i += 32) {
+    v = *(const ymm_t *)(p + i);
+    t = __builtin_ia32_pshufb256(l, v & f) &
+        __builtin_ia32_pshufb256(b, (ymm_t)((ymm_h)v >> 4) & f);
+    t = t != z;
+    if (hi) t |= v < z;
+    if ((m = __builtin_ia32_pmovmskb256(t))) {
+      return i + __builtin_ctz(m);
+    }
+  }
+  return i;
+}
+
+#endif /* __x86_64__ */
@@ -0,0 +1,44 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/escape.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+typedef unsigned short xmm_h __attribute__((__vector_size__(16), __aligned__(1)));
+
+size_t UnescapedSpan_ssse3(const char *p, size_t n, xmm_t lut, int hi) {
+  size_t i;
+  unsigned m;
+  xmm_t v, t, z = {0};
+  xmm_t f = (xmm_t){} + 15;
+  xmm_t b = {1, 2, 4, 8, 16, 32, 64, -128};
+  for (i = 0; i + 16 <= n; i += 16) {
+    v = *(const xmm_t *)(p + i);
+    t = __builtin_ia32_pshufb128(lut, v & f) &
+        __builtin_ia32_pshufb128(b, (xmm_t)((xmm_h)v >> 4) & f);
+    t = t != z;
+    if (hi) t |= v < z;
+    if ((m = __builtin_ia32_pmovmskb128(t))) {
+      return i + __builtin_ctz(m);
+    }
+  }
+  return i;
+}
+
+#endif /* __x86_64__ */
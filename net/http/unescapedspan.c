@@ -0,0 +1,116 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
+#include "net/http/escape.h"
+
+typedef char xmm_t __attribute__((__vector_size__(16), __aligned__(1)));
+
+size_t UnescapedSpan_ssse3(const char *, size_t, xmm_t, int);
+size_t UnescapedSpan_avx2(const char *, size_t, xmm_t, int);
+
+/**
+ * Prepares table for repeated calls to NextUnescapedSpan().
+ *
+ * The classic nibble lookup technique needs the table's low half folded
+ * into sixteen bytes so PSHUFB can classify 16 or 32 bytes at a time.
+ * Escaping functions call this once and reuse the result for each run
+ * of ordinary text, rather than folding the table again at every byte
+ * that needs escaping.
+ *
+ * @param T is table where nonzero means byte needs special handling
+ */
+void InitUnescapedSpan(struct UnescapedSpan *s, const char T[256]) {
+  s->T = T;
+  s->hi = -1;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  int h;
+  xmm_t t, lut, any, all, z = {0};
+  if (!X86_HAVE(SSSE3)) return;
+  // bytes <0x80 map low nibble to bitmask of high nibbles
+  for (lut = z, h = 0; h < 8; ++h) {
+    t = *(const xmm_t *)(T + h * 16) != z;
+    lut |= t & ((xmm_t){} + (char)(1 << h));
+  }
+  *(xmm_t *)s->lut = lut;
+  // bytes ≥0x80 must all be ordinary or all be special
+  for (any = z, all = ~z, h = 8; h < 16; ++h) {
+    t = *(const xmm_t *)(T + h * 16) != z;
+    any |= t;
+    all &= t;
+  }
+  if (!__builtin_ia32_pmovmskb128(any)) {
+    s->hi = 0;
+  } else if (__builtin_ia32_pmovmskb128(all) == 0xffff) {
+    s->hi = 1;
+  }
+#endif
+}
+
+/**
+ * Returns length of prefix that doesn't need escaping.
+ *
+ * @param s was prepared by InitUnescapedSpan()
+ * @param p is input
+ * @param n is byte length of `p`
+ * @return index of first byte `c` in `p` where `s->T[c]` is nonzero,
+ *     or `n` if there isn't one
+ */
+size_t NextUnescapedSpan(const struct UnescapedSpan *s, const char *p,
+                         size_t n) {
+  size_t i = 0;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (n >= 16 && s->hi != -1) {
+    if (n >= 32 && X86_HAVE(AVX2)) {
+      i = UnescapedSpan_avx2(p, n, *(const xmm_t *)s->lut, s->hi);
+    } else {
+      i = UnescapedSpan_ssse3(p, n, *(const xmm_t *)s->lut, s->hi);
+    }
+  }
+#endif
+  while (i < n && !s->T[p[i] & 255]) ++i;
+  return i;
+}
+
+/**
+ * Returns length of prefix that doesn't need escaping.
+ *
+ * This is the fast path for escaping functions like EscapeHtml() and
+ * EscapeUrl() which lets them copy ordinary runs of text wholesale. It
+ * only vectorizes if the table treats all bytes >=0x80 alike, which is
+ * the case for every table in this package. Otherwise, or if the cpu is
+ * too old, this function goes byte-by-byte. Callers that scan the same
+ * input repeatedly should use InitUnescapedSpan() instead.
+ *
+ * @param p is input
+ * @param n is byte length of `p`
+ * @param T is table where nonzero means byte needs special handling
+ * @return index of first byte `c` in `p` where `T[c]` is nonzero, or
+ *     `n` if there isn't one
+ */
+size_t UnescapedSpan(const char *p, size_t n, const char T[256]) {
+  size_t i;
+  struct UnescapedSpan s;
+  if (n >= 16) {
+    InitUnescapedSpan(&s, T);
+    return NextUnescapedSpan(&s, p, n);
+  }
+  for (i = 0; i < n && !T[p[i] & 255]; ++i) {
+  }
+  return i;
+}
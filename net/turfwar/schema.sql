@@ -6,3 +6,10 @@ CREATE TABLE land (
 
 CREATE INDEX land_by_name ON land (nick);
 CREATE INDEX land_by_created ON land (created DESC) WHERE created NOT NULL;
+
+CREATE TABLE score (
+    nick TEXT NOT NULL,
+    block INTEGER NOT NULL,
+    count INTEGER NOT NULL,
+    PRIMARY KEY (nick, block)
+);
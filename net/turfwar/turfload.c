@@ -0,0 +1,337 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/errno.h"
+#include "libc/fmt/conv.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sock/sock.h"
+#include "libc/sock/struct/pollfd.h"
+#include "libc/sock/struct/sockaddr.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/slice.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/af.h"
+#include "libc/sysv/consts/ex.h"
+#include "libc/sysv/consts/poll.h"
+#include "libc/sysv/consts/sock.h"
+#include "libc/thread/thread.h"
+#include "net/http/http.h"
+#include "net/http/ip.h"
+#include "third_party/getopt/getopt.internal.h"
+
+/**
+ * @fileoverview load generator for turfwar server
+ *
+ * Each thread keeps many keepalive connections busy, sending the next
+ * request as soon as the previous response arrives, and then we print
+ * the request rate and latency percentiles. The server rate limits by
+ * IP so it should be run with `-W 127.0.0.1` or similar when testing.
+ */
+
+#define GETOPTS "t:c:d:p:h:"
+#define USAGE \
+  "\
+Usage: turfload.com [-t INT] [-c INT] [-d INT] [-p INT] [-h IP] [PATH]\n\
+  -t INT      threads (default 4)\n\
+  -c INT      connections (default 100)\n\
+  -d INT      duration in seconds (default 10)\n\
+  -p INT      port (default 8080)\n\
+  -h IP       server ipv4 address (default 127.0.0.1)\n\
+"
+
+#define HasHeader(H)    (!!c->msg.headers[H].a)
+#define HeaderData(H)   (c->buf + c->msg.headers[H].a)
+#define HeaderLength(H) (c->msg.headers[H].b - c->msg.headers[H].a)
+#define HeaderEqualCase(H, S) \
+  SlicesEqualCase(S, strlen(S), HeaderData(H), HeaderLength(H))
+
+struct Conn {
+  int fd;
+  size_t n;   // bytes of response received
+  size_t m;   // bytes allocated for buf
+  char *buf;  // response being received
+  struct timespec sent;
+  struct HttpMessage msg;
+};
+
+struct Loader {
+  pthread_t th;
+  int conns;
+  long errors;
+  long reconnects;
+  size_t count;  // responses received
+  size_t cap;
+  int64_t *micros;  // latency of each response
+};
+
+int g_port = 8080;
+int g_threads = 4;
+int g_conns = 100;
+int g_seconds = 10;
+uint32_t g_ip = 0x7f000001;
+const char *g_path = "/";
+char *g_request;
+size_t g_requestlen;
+atomic_bool g_done;
+
+void GetOpts(int argc, char *argv[]) {
+  int opt;
+  int64_t ip;
+  while ((opt = getopt(argc, argv, GETOPTS)) != -1) {
+    switch (opt) {
+      case 't':
+        g_threads = MAX(1, atoi(optarg));
+        break;
+      case 'c':
+        g_conns = MAX(1, atoi(optarg));
+        break;
+      case 'd':
+        g_seconds = MAX(1, atoi(optarg));
+        break;
+      case 'p':
+        g_port = atoi(optarg);
+        break;
+      case 'h':
+        if ((ip = ParseIp(optarg, -1)) == -1) {
+          kprintf("error: could not parse -h %#s IP address\n", optarg);
+          exit(EX_USAGE);
+        }
+        g_ip = ip;
+        break;
+      case '?':
+        write(1, USAGE, sizeof(USAGE) - 1);
+        exit(0);
+      default:
+        write(2, USAGE, sizeof(USAGE) - 1);
+        exit(EX_USAGE);
+    }
+  }
+  if (optind < argc) {
+    g_path = argv[optind];
+  }
+}
+
+// sends request on connection, reconnecting if needed
+bool SendRequest(struct Conn *c) {
+  if (c->fd == -1) {
+    struct sockaddr_in addr = {.sin_family = AF_INET,
+                               .sin_port = htons(g_port),
+                               .sin_addr.s_addr = htonl(g_ip)};
+    if ((c->fd = socket(AF_INET, SOCK_STREAM, 0)) == -1) return false;
+    if (connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+      close(c->fd);
+      c->fd = -1;
+      return false;
+    }
+  }
+  c->n = 0;
+  DestroyHttpMessage(&c->msg);
+  InitHttpMessage(&c->msg, kHttpResponse);
+  c->sent = timespec_mono();
+  return write(c->fd, g_request, g_requestlen) == g_requestlen;
+}
+
+void Hangup(struct Conn *c) {
+  if (c->fd != -1) {
+    close(c->fd);
+    c->fd = -1;
+  }
+}
+
+void Record(struct Loader *t, int64_t micros) {
+  if (t->count == t->cap) {
+    t->cap += t->cap >> 1;
+    t->cap += 1024;
+    if (!(t->micros = realloc(t->micros, t->cap * sizeof(*t->micros)))) {
+      kprintf("error: out of memory\n");
+      exit(1);
+    }
+  }
+  t->micros[t->count++] = micros;
+}
+
+// reads more of response and returns true if it's complete
+// the connection is closed when something goes wrong
+bool ReceiveResponse(struct Loader *t, struct Conn *c) {
+  int rc;
+  ssize_t got;
+  int64_t paylen;
+  if (c->n == c->m) {
+    c->m += c->m >> 1;
+    c->m += 4096;
+    if (!(c->buf = realloc(c->buf, c->m))) {
+      kprintf("error: out of memory\n");
+      exit(1);
+    }
+  }
+  if ((got = read(c->fd, c->buf + c->n, c->m - c->n)) <= 0) {
+    ++t->errors;
+    Hangup(c);
+    return false;
+  }
+  c->n += got;
+  if ((rc = ParseHttpMessage(&c->msg, c->buf, c->n)) == -1) {
+    ++t->errors;
+    Hangup(c);
+    return false;
+  }
+  if (!rc) return false;  // need more header bytes
+  if (HasHeader(kHttpContentLength)) {
+    if ((paylen = ParseContentLength(HeaderData(kHttpContentLength),
+                                     HeaderLength(kHttpContentLength))) == -1) {
+      ++t->errors;
+      Hangup(c);
+      return false;
+    }
+    if (c->n - rc < paylen) return false;  // need more payload bytes
+  }
+  if (!(200 <= c->msg.status && c->msg.status <= 399)) {
+    ++t->errors;
+  }
+  Record(t, timespec_tomicros(timespec_sub(timespec_mono(), c->sent)));
+  if (!HasHeader(kHttpContentLength) ||
+      HeaderEqualCase(kHttpConnection, "close")) {
+    ++t->reconnects;
+    Hangup(c);
+  }
+  return true;
+}
+
+void *Load(void *arg) {
+  int i, n;
+  struct Conn *c;
+  struct pollfd *fds;
+  struct Loader *t = arg;
+  c = calloc(t->conns, sizeof(*c));
+  fds = calloc(t->conns, sizeof(*fds));
+  if (!c || !fds) {
+    kprintf("error: out of memory\n");
+    exit(1);
+  }
+  for (i = 0; i < t->conns; ++i) {
+    c[i].fd = -1;
+    InitHttpMessage(&c[i].msg, kHttpResponse);
+  }
+  while (!atomic_load_explicit(&g_done, memory_order_relaxed)) {
+    for (i = 0; i < t->conns; ++i) {
+      if (c[i].fd == -1 && !SendRequest(c + i)) {
+        ++t->errors;
+        Hangup(c + i);
+      }
+      fds[i].fd = c[i].fd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+    if ((n = poll(fds, t->conns, 100)) <= 0) continue;
+    for (i = 0; i < t->conns; ++i) {
+      if (!fds[i].revents || c[i].fd == -1) continue;
+      if (ReceiveResponse(t, c + i) && c[i].fd != -1 && !SendRequest(c + i)) {
+        ++t->errors;
+        Hangup(c + i);
+      }
+    }
+  }
+  for (i = 0; i < t->conns; ++i) {
+    Hangup(c + i);
+    DestroyHttpMessage(&c[i].msg);
+    free(c[i].buf);
+  }
+  free(fds);
+  free(c);
+  return 0;
+}
+
+int64_t Percentile(const int64_t *A, size_t n, double p) {
+  if (!n) return 0;
+  return A[MIN(n - 1, (size_t)(p * n))];
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  long errors, reconnects;
+  size_t j, count;
+  int64_t *micros;
+  struct Loader *t;
+  struct timespec start;
+  double secs;
+
+  GetOpts(argc, argv);
+  g_threads = MIN(g_threads, g_conns);
+  g_requestlen = asprintf(&g_request,
+                          "GET %s HTTP/1.1\r\n"
+                          "Host: %hhu.%hhu.%hhu.%hhu\r\n"
+                          "User-Agent: turfload\r\n"
+                          "\r\n",
+                          g_path, g_ip >> 24, g_ip >> 16, g_ip >> 8, g_ip);
+
+  // spread connections evenly across threads
+  start = timespec_mono();
+  t = calloc(g_threads, sizeof(*t));
+  for (i = 0; i < g_threads; ++i) {
+    t[i].conns = g_conns / g_threads + (i < g_conns % g_threads);
+    if (pthread_create(&t[i].th, 0, Load, t + i)) {
+      kprintf("error: pthread_create failed\n");
+      return 1;
+    }
+  }
+  sleep(g_seconds);
+  atomic_store_explicit(&g_done, true, memory_order_relaxed);
+  for (i = 0; i < g_threads; ++i) {
+    pthread_join(t[i].th, 0);
+  }
+  secs = timespec_tonanos(timespec_sub(timespec_mono(), start)) * 1e-9;
+
+  // merge latency samples
+  errors = reconnects = count = 0;
+  for (i = 0; i < g_threads; ++i) {
+    count += t[i].count;
+    errors += t[i].errors;
+    reconnects += t[i].reconnects;
+  }
+  if (!(micros = malloc(MAX(1, count) * sizeof(*micros)))) {
+    kprintf("error: out of memory\n");
+    return 1;
+  }
+  for (j = i = 0; i < g_threads; ++i) {
+    memcpy(micros + j, t[i].micros, t[i].count * sizeof(*micros));
+    j += t[i].count;
+    free(t[i].micros);
+  }
+  radix_sort_int64(micros, count);
+
+  printf("%d threads, %d connections, %.1f seconds\n", g_threads, g_conns,
+         secs);
+  printf("%zu responses, %.0f requests/sec\n", count, count / secs);
+  printf("%ld errors, %ld reconnects\n", errors, reconnects);
+  printf("latency p50 %ldus, p90 %ldus, p99 %ldus, max %ldus\n",
+         Percentile(micros, count, .50), Percentile(micros, count, .90),
+         Percentile(micros, count, .99), Percentile(micros, count, 1));
+
+  free(micros);
+  free(g_request);
+  free(t);
+  return errors ? 1 : 0;
+}
@@ -20,6 +20,7 @@
 #include "libc/calls/calls.h"
 #include "libc/calls/pledge.h"
 #include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/rlimit.h"
 #include "libc/calls/struct/rusage.h"
 #include "libc/calls/struct/sigaction.h"
 #include "libc/calls/struct/sigset.h"
@@ -34,12 +35,14 @@
 #include "libc/intrin/atomic.h"
 #include "libc/serialize.h"
 #include "libc/intrin/bsr.h"
+#include "libc/intrin/dll.h"
 #include "libc/intrin/hilbert.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/intrin/strace.internal.h"
 #include "libc/log/check.h"
 #include "libc/log/log.h"
 #include "libc/macros.internal.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
 #include "libc/mem/sortedints.internal.h"
@@ -49,6 +52,7 @@
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
 #include "libc/runtime/sysconf.h"
+#include "libc/sock/epoll.h"
 #include "libc/sock/sock.h"
 #include "libc/sock/struct/pollfd.h"
 #include "libc/sock/struct/sockaddr.h"
@@ -59,9 +63,12 @@
 #include "libc/str/str.h"
 #include "libc/sysv/consts/af.h"
 #include "libc/sysv/consts/clock.h"
+#include "libc/sysv/consts/epoll.h"
+#include "libc/sysv/consts/limits.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/poll.h"
 #include "libc/sysv/consts/prot.h"
+#include "libc/sysv/consts/rlimit.h"
 #include "libc/sysv/consts/rusage.h"
 #include "libc/sysv/consts/sig.h"
 #include "libc/sysv/consts/so.h"
@@ -99,28 +106,31 @@
 #define CPUS               64      // number of cpus to actually use
 #define XN                 64      // plot width in pixels
 #define YN                 64      // plot height in pixels
-#define WORKERS            500     // size of http client thread pool
+#define WORKERS            0       // http reactor threads (0 = one per cpu)
+#define CONNECTIONS        10000   // max simultaneous client connections
 #define SUPERVISE_MS       1000    // how often to stat() asset files
 #define KEEPALIVE_MS       60000   // max time to keep idle conn open
 #define MELTALIVE_MS       2000    // panic keepalive under heavy load
-#define SCORE_H_UPDATE_MS  10000   // how often to regenerate /score/hour
-#define SCORE_D_UPDATE_MS  30000   // how often to regenerate /score/day
-#define SCORE_W_UPDATE_MS  70000   // how often to regenerate /score/week
-#define SCORE_M_UPDATE_MS  100000  // how often to regenerate /score/month
-#define SCORE_UPDATE_MS    210000  // how often to regenerate /score
+#define SCORE_H_UPDATE_MS  5000    // how often to regenerate /score/hour
+#define SCORE_D_UPDATE_MS  10000   // how often to regenerate /score/day
+#define SCORE_W_UPDATE_MS  15000   // how often to regenerate /score/week
+#define SCORE_M_UPDATE_MS  20000   // how often to regenerate /score/month
+#define SCORE_UPDATE_MS    30000   // how often to regenerate /score
+#define SCORE_BUCKET_SECS  60      // time granularity of windowed scores
 #define PLOTS_UPDATE_MS    999000  // how often to regenerate /plot/xxx
-#define ACCEPT_DEADLINE_MS 100     // how long accept() can take to find worker
-#define CLAIM_DEADLINE_MS  100     // how long /claim may block if queue is full
+#define SWEEP_MS           250     // how often reactors expire idle conns
 #define CONCERN_LOAD       .75     // avoid keepalive, upon this connection load
-#define PANIC_LOAD         .85     // meltdown if this percent of pool connected
+#define PANIC_LOAD         .85     // meltdown if this percent of conns is used
 #define PANIC_MSGS         10      // msgs per conn can't exceed it in meltdown
 #define QUEUE_MAX          800     // maximum pending claim items in queue
 #define BATCH_MAX          64      // max claims to insert per transaction
 #define NICK_MAX           40      // max length of user nickname string
 #define TB_INTERVAL        1000    // millis between token replenishes
 #define TB_CIDR            24      // token bucket cidr specificity
-#define SOCK_MAX           100     // max length of socket queue
+#define EVENTS_MAX         64      // max epoll events per reactor wakeup
+#define ACCEPT_MAX         16      // max accept() calls per reactor wakeup
 #define MSG_BUF            512     // small response lookaside
+#define FDS_SPARE          100     // file descriptors kept for non-clients
 
 #define INBUF_SIZE  FRAMESIZE
 #define OUTBUF_SIZE 8192
@@ -128,7 +138,7 @@
 #define TB_BYTES (1u << TB_CIDR)
 #define TB_WORDS (TB_BYTES / 8)
 
-#define GETOPTS "idvp:w:k:W:"
+#define GETOPTS "idvp:w:k:c:W:"
 #define USAGE \
   "\
 Usage: turfwar.com [-dv] ARGS...\n\
@@ -137,8 +147,9 @@ Usage: turfwar.com [-dv] ARGS...\n\
   -v          verbosity\n\
   -W IP       whitelist\n\
   -p INT      port\n\
-  -w INT      workers\n\
+  -w INT      reactor threads\n\
   -k INT      keepalive\n\
+  -c INT      max connections\n\
 "
 
 #define STANDARD_RESPONSE_HEADERS \
@@ -258,13 +269,15 @@ bool g_daemonize;
 int g_port = PORT;
 int g_workers = WORKERS;
 int g_keepalive = KEEPALIVE_MS;
+int g_maxconns = CONNECTIONS;
 struct SortedInts g_whitelisted;
 
 // lifecycle vars
-pthread_t g_listener;
+int g_server;
 nsync_time g_started;
 nsync_counter g_ready;
 atomic_int g_connections;
+atomic_int g_meltdown;
 nsync_note g_shutdown[3];
 int g_hilbert[YN * XN][2];
 
@@ -304,13 +317,31 @@ union TokenBucket {
   atomic_uint_fast64_t *w;
 } g_tok;
 
-// http worker objects
+// http client connection
+// these are owned by whichever reactor accepted them
+struct Conn {
+  int sock;
+  int msgcount;
+  uint32_t clientip;
+  bool hangup;               // close once output is flushed
+  size_t outpos;             // how much of out has been sent
+  struct Data out;           // response bytes socket wouldn't take
+  struct timespec lastread;  // for expiring idle keepalive conns
+  struct Dll elem;           // position in Worker::idle
+};
+
+// http reactor objects
+// each one multiplexes its connections using its own epoll
 struct Worker {
   pthread_t th;
-  atomic_int msgcount;
-  atomic_int shutdown;
-  atomic_int connected;
-  struct timespec startread;
+  int epfd;
+  long melted;          // last meltdown this reactor swept
+  struct timespec now;  // time of current wakeup
+  struct Dll *idle;     // conns ordered by least recently read
+  char *inbuf;
+  char *outbuf;
+  char *msgbuf;
+  struct HttpMessage *msg;
 } *g_worker;
 
 // recentworker wakeup
@@ -341,20 +372,6 @@ struct Assets {
   struct Asset plot[256];
 } g_asset;
 
-// queues ListenWorker() to HttpWorker()
-struct Clients {
-  int pos;
-  int count;
-  nsync_mu mu;
-  nsync_cv non_full;
-  nsync_cv non_empty;
-  struct Client {
-    int sock;
-    uint32_t size;
-    struct sockaddr_in addr;
-  } data[SOCK_MAX];
-} g_clients;
-
 // queues /claim to ClaimWorker()
 struct Claims {
   int pos;
@@ -369,6 +386,50 @@ struct Claims {
   } data[QUEUE_MAX];
 } g_claims;
 
+// scoreboards, maintained incrementally by ClaimWorker()
+// board 0 counts all land, the others count recent claims
+#define BOARDS     5
+#define SCORE_RING (60L * 60 * 24 * 30 / SCORE_BUCKET_SECS + 2)
+const long kBoardSecs[BOARDS] = {
+    -1,                   // /score
+    60L * 60,             // /score/hour
+    60L * 60 * 24,        // /score/day
+    60L * 60 * 24 * 7,    // /score/week
+    60L * 60 * 24 * 30,   // /score/month
+};
+struct Board {
+  nsync_mu mu;
+  int n, c;               // number of nicks, and capacity
+  int mask;               // hash table size minus one
+  int *hash;              // nick index plus one, or zero if empty
+  bool sorted;            // order is sorted by name
+  int64_t now;            // time of last expiration
+  bool changed[BOARDS];   // asset needs to be regenerated
+  long expired[BOARDS];   // newest bucket that's left the window
+  char *sb;               // scratch space for escaping
+  size_t sblen;
+  struct Nick {
+    char *name;
+    bool valid;
+    bool dirty[BOARDS];   // json needs to be regenerated
+    char *json[BOARDS];   // e.g. "nick":[\n  [block,count]]
+    int n, c;
+    struct Cell {
+      int block;
+      long count[BOARDS];
+    } *cell;              // sorted by block
+  } **nick, **order;
+  struct Bucket {
+    long key;             // time divided by SCORE_BUCKET_SECS
+    int n, c;
+    struct Event {
+      int nick;
+      short block;
+      short delta;
+    } *p;
+  } *ring;                // claims of the last month
+} g_board;
+
 long GetTotalRam(void) {
   struct sysinfo si;
   si.totalram = 256 * 1024 * 1024;
@@ -521,57 +582,6 @@ char *FormatDate(char *p) {
   return p;
 }
 
-bool AddClient(struct Clients *q, const struct Client *v, nsync_time dead) {
-  bool wake = false;
-  bool added = false;
-  nsync_mu_lock(&q->mu);
-  while (q->count == ARRAYLEN(q->data)) {
-    if (nsync_cv_wait_with_deadline(&q->non_full, &q->mu, dead,
-                                    g_shutdown[0])) {
-      break;  // must be ETIMEDOUT or ECANCELED
-    }
-  }
-  if (q->count != ARRAYLEN(q->data)) {
-    int i = q->pos + q->count;
-    if (ARRAYLEN(q->data) <= i) i -= ARRAYLEN(q->data);
-    memcpy(q->data + i, v, sizeof(*v));
-    if (!q->count) wake = true;
-    q->count++;
-    added = true;
-  }
-  nsync_mu_unlock(&q->mu);
-  if (wake) {
-    nsync_cv_broadcast(&q->non_empty);
-  }
-  return added;
-}
-
-int GetClient(struct Clients *q, struct Client *out) {
-  int got = 0;
-  int len = 1;
-  nsync_mu_lock(&q->mu);
-  while (!q->count) {
-    if (nsync_cv_wait_with_deadline(&q->non_empty, &q->mu,
-                                    nsync_time_no_deadline, g_shutdown[1])) {
-      break;  // must be ECANCELED
-    }
-  }
-  while (got < len && q->count) {
-    memcpy(out + got, q->data + q->pos, sizeof(*out));
-    if (q->count == ARRAYLEN(q->data)) {
-      nsync_cv_broadcast(&q->non_full);
-    }
-    ++got;
-    q->pos++;
-    q->count--;
-    if (q->pos == ARRAYLEN(q->data)) {
-      q->pos = 0;
-    }
-  }
-  nsync_mu_unlock(&q->mu);
-  return got;
-}
-
 // inserts ip:name claim into blocking message queue
 // may be interrupted by absolute deadline
 // may be cancelled by server shutdown
@@ -678,14 +688,6 @@ void BlockSignals(void) {
   sigprocmask(SIG_SETMASK, &mask, 0);
 }
 
-// main thread uses sigusr1 to deliver io cancellations
-void AllowSigusr1(void) {
-  sigset_t mask;
-  sigfillset(&mask);
-  sigdelset(&mask, SIGUSR1);
-  sigprocmask(SIG_SETMASK, &mask, 0);
-}
-
 char *Statusz(char *p, const char *s, long x) {
   p = stpcpy(p, s);
   p = stpcpy(p, ": ");
@@ -694,8 +696,53 @@ char *Statusz(char *p, const char *s, long x) {
   return p;
 }
 
+// sends response to client without blocking the reactor
+// whatever the kernel won't take right now is kept for EPOLLOUT
+void SendV(struct Conn *c, const struct iovec *iov, int iovlen) {
+  int i;
+  char *p;
+  ssize_t rc;
+  size_t need, sent = 0;
+  if (!c->out.n) {
+    if ((rc = writev(c->sock, iov, iovlen)) != -1) {
+      sent = rc;
+    } else if (errno != EAGAIN) {
+      c->hangup = true;
+      return;
+    }
+  }
+  for (need = i = 0; i < iovlen; ++i) {
+    need += iov[i].iov_len;
+  }
+  if (sent == need) return;
+  CHECK_MEM((p = realloc(c->out.p, c->out.n + (need - sent))));
+  for (i = 0; i < iovlen; ++i) {
+    if (sent >= iov[i].iov_len) {
+      sent -= iov[i].iov_len;
+    } else {
+      memcpy(p + c->out.n, (char *)iov[i].iov_base + sent,
+             iov[i].iov_len - sent);
+      c->out.n += iov[i].iov_len - sent;
+      sent = 0;
+    }
+  }
+  c->out.p = p;
+  return;
+OnError:
+  c->hangup = true;
+}
+
+void Send(struct Conn *c, const void *data, size_t size) {
+  struct iovec iov[1] = {{(void *)data, size}};
+  SendV(c, iov, 1);
+}
+
+void SendString(struct Conn *c, const char *s) {
+  Send(c, s, strlen(s));
+}
+
 // public /statusz endpoint for monitoring server internals
-void ServeStatusz(int client, char *outbuf) {
+void ServeStatusz(struct Conn *c, char *outbuf) {
   char *p;
   struct rusage ru;
   struct timespec now;
@@ -712,6 +759,7 @@ void ServeStatusz(int client, char *outbuf) {
   p = Statusz(p, "now", now.tv_sec);
   p = Statusz(p, "messages", g_messages);
   p = Statusz(p, "connections", g_connections);
+  p = Statusz(p, "maxconns", g_maxconns);
   p = Statusz(p, "banned", g_banned);
   p = Statusz(p, "workers", g_workers);
   p = Statusz(p, "accepts", g_accepts);
@@ -761,482 +809,593 @@ void ServeStatusz(int client, char *outbuf) {
     p = Statusz(p, "ru_nvcsw", ru.ru_nvcsw);
     p = Statusz(p, "ru_nivcsw", ru.ru_nivcsw);
   }
-  write(client, outbuf, p - outbuf);
+  Send(c, outbuf, p - outbuf);
 }
 
-void *ListenWorker(void *arg) {
-  int server;
-  int no = 0;
-  int yes = 1;
-  int fastopen = 5;
-  struct Client client;
-  struct timeval timeo = {g_keepalive / 1000, g_keepalive % 1000};
-  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(g_port)};
-  AllowSigusr1();
-  pthread_setname_np(pthread_self(), "Listener");
-  CHECK_NE(-1, (server = socket(AF_INET, SOCK_STREAM, 0)));
-  setsockopt(server, SOL_SOCKET, SO_RCVTIMEO, &timeo, sizeof(timeo));
-  setsockopt(server, SOL_SOCKET, SO_SNDTIMEO, &timeo, sizeof(timeo));
-  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
-  setsockopt(server, SOL_TCP, TCP_FASTOPEN, &fastopen, sizeof(fastopen));
-  setsockopt(server, SOL_TCP, TCP_QUICKACK, &no, sizeof(no));
-  setsockopt(server, SOL_TCP, TCP_CORK, &no, sizeof(no));
-  setsockopt(server, SOL_TCP, TCP_NODELAY, &yes, sizeof(yes));
-  bind(server, (struct sockaddr *)&addr, sizeof(addr));
-  CHECK_NE(-1, listen(server, 1));
-  while (!nsync_note_is_notified(g_shutdown[0])) {
-    client.size = sizeof(client.addr);
-    client.sock = accept(server, (struct sockaddr *)&client.addr, &client.size);
-    if (client.sock == -1) {
-      if (errno != EAGAIN) {  // spinning on SO_RCVTIMEO
-        ++g_acceptfails;
-      }
-      continue;
-    }
-    if (!AddClient(&g_clients, &client, WaitFor(ACCEPT_DEADLINE_MS))) {
-      ++g_rejected;
-      LOG("503 Accept Queue Full\n");
-      Write(client.sock, "HTTP/1.1 503 Accept Queue Full\r\n"
-                         "Content-Type: text/plain\r\n"
-                         "Connection: close\r\n"
-                         "\r\n"
-                         "Accept Queue Full\n");
-      close(client.sock);
-    }
+// handles one http message that was read from client
+//
+// let's assume we're behind a well-behaved frontend
+// each read() should give us just *one* HTTP message
+// if we get less than one message, we drop connection
+// if we get more than one message, we Connection: close
+// let's not bother with cray proto stuff like 100-expect
+//
+// returns true if connection may be kept alive
+bool HandleMessage(struct Worker *w, struct Conn *c, ssize_t got) {
+  struct Data d;
+  struct Asset *a;
+  bool comp, ipv6;
+  int tok, inmsglen;
+  uint32_t ip, clientip;
+  char ipbuf[32], *p, *q, cashbuf[64];
+  char *inbuf = w->inbuf;
+  char *outbuf = w->outbuf;
+  char *msgbuf = w->msgbuf;
+  struct HttpMessage *msg = w->msg;
+
+  // parse http message
+  // we're only doing one-shot parsing right now
+  DestroyHttpMessage(msg);
+  InitHttpMessage(msg, kHttpRequest);
+  if ((inmsglen = ParseHttpMessage(msg, inbuf, got)) <= 0) {
+    ++g_parsefails;
+    return false;
   }
-  close(server);
-  nsync_note_notify(g_shutdown[1]);
-  return 0;
-}
-
-// make thousands of http client handler threads
-// load balance incoming connections for port 8080 across all threads
-// hangup on any browser clients that lag for more than a few seconds
-void *HttpWorker(void *arg) {
-  struct Client client;
-  int id = (intptr_t)arg;
-  char *msgbuf = _gc(xmalloc(MSG_BUF));
-  char *inbuf = NewSafeBuffer(INBUF_SIZE);
-  char *outbuf = NewSafeBuffer(OUTBUF_SIZE);
-  struct HttpMessage *msg = _gc(xcalloc(1, sizeof(struct HttpMessage)));
-
-  BlockSignals();
-  pthread_setname_np(pthread_self(), _gc(xasprintf("HTTP%d", id)));
-
-  // connection loop
-  while (GetClient(&g_clients, &client)) {
-    struct Data d;
-    ssize_t got, sent;
-    uint32_t ip, clientip;
-    int tok, inmsglen, outmsglen;
-    char ipbuf[32], *p, *q, cashbuf[64];
-
-    clientip = ntohl(client.addr.sin_addr.s_addr);
-    g_worker[id].connected = true;
-    g_worker[id].msgcount = 0;
-    ++g_accepts;
-    ++g_connections;
-
-    // simple http/1.1 message loop
-    // let's assume we're behind a well-behaved frontend
-    // each read() should give us just *one* HTTP message
-    // if we get less than one message, we drop connection
-    // if we get more than one message, we Connection: close
-    // let's not bother with cray proto stuff like 100-expect
-    do {
-      struct Asset *a;
-      bool comp, ipv6;
-
-      // wait for http message
-      // this may be cancelled by sigusr1
-      AllowSigusr1();
-      DestroyHttpMessage(msg);
-      InitHttpMessage(msg, kHttpRequest);
-      g_worker[id].startread = timespec_real();
-      if ((got = read(client.sock, inbuf, INBUF_SIZE)) <= 0) {
-        ++g_readfails;
-        break;
-      }
-      BlockSignals();
-
-      // parse http message
-      // we're only doing one-shot parsing right now
-      if ((inmsglen = ParseHttpMessage(msg, inbuf, got)) <= 0) {
-        ++g_parsefails;
-        break;
-      }
-      ++g_messages;
-      ++g_worker[id].msgcount;
-
+  ++g_messages;
+  ++c->msgcount;
+
+  ipv6 = false;
+  ip = clientip = c->clientip;
+
+  // get client address from frontend
+  if (HasHeader(kHttpXForwardedFor)) {
+    if (!IsLoopbackIp(clientip) &&  //
+        !IsPrivateIp(clientip) &&   //
+        !IsCloudflareIp(clientip)) {
+      LOG("Got X-Forwarded-For from untrusted IPv4 client address "
+          "%hhu.%hhu.%hhu.%hhu\n",
+          clientip >> 24, clientip >> 16, clientip >> 8, clientip);
       ipv6 = false;
       ip = clientip;
+      ++g_unproxied;
+    } else if (ParseForwarded(HeaderData(kHttpXForwardedFor),
+                              HeaderLength(kHttpXForwardedFor), &ip,
+                              0) != -1) {
+      ipv6 = false;
+      ++g_proxied;
+    } else {
+      ipv6 = true;
+      ip = clientip;
+      ++g_ipv6forwards;
+      ++g_proxied;
+    }
+  } else {
+    ipv6 = false;
+    ip = clientip;
+    ++g_unproxied;
+  }
 
-      // get client address from frontend
-      if (HasHeader(kHttpXForwardedFor)) {
-        if (!IsLoopbackIp(clientip) &&  //
-            !IsPrivateIp(clientip) &&   //
-            !IsCloudflareIp(clientip)) {
-          LOG("Got X-Forwarded-For from untrusted IPv4 client address "
-              "%hhu.%hhu.%hhu.%hhu\n",
-              clientip >> 24, clientip >> 16, clientip >> 8, clientip);
-          ipv6 = false;
-          ip = clientip;
-          ++g_unproxied;
-        } else if (ParseForwarded(HeaderData(kHttpXForwardedFor),
-                                  HeaderLength(kHttpXForwardedFor), &ip,
-                                  0) != -1) {
-          ipv6 = false;
-          ++g_proxied;
-        } else {
-          ipv6 = true;
-          ip = clientip;
-          ++g_ipv6forwards;
-          ++g_proxied;
-        }
-      } else {
-        ipv6 = false;
-        ip = clientip;
-        ++g_unproxied;
-      }
+  ksnprintf(ipbuf, sizeof(ipbuf), "%hhu.%hhu.%hhu.%hhu", ip >> 24, ip >> 16,
+            ip >> 8, ip);
 
-      ksnprintf(ipbuf, sizeof(ipbuf), "%hhu.%hhu.%hhu.%hhu", ip >> 24, ip >> 16,
-                ip >> 8, ip);
+  if (UrlStartsWith("/plot/") && (_rand64() % 256)) {
+    goto SkipSecurity;
+  }
+  if (!ipv6 && !ContainsInt(&g_whitelisted, ip) &&
+      (tok = AcquireToken(g_tok.b, ip, TB_CIDR)) < 32) {
+    if (tok > 4) {
+      LOG("%s rate limiting client\n", ipbuf, msg->version);
+      SendString(c, "HTTP/1.1 429 Too Many Requests\r\n"
+                    "Content-Type: text/plain\r\n"
+                    "Connection: close\r\n"
+                    "\r\n"
+                    "429 Too Many Requests\n");
+    } else {
+      Blackhole(ip);
+      ++g_banned;
+    }
+    ++g_ratelimits;
+    return false;
+  }
+SkipSecurity:
+
+  // we don't support http/1.0 and http/0.9 right now
+  if (msg->version != 11) {
+    LOG("%s used unsupported http/%d version\n", ipbuf, msg->version);
+    SendString(c, "HTTP/1.1 505 HTTP Version Not Supported\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Connection: close\r\n"
+                  "\r\n"
+                  "HTTP Version Not Supported\n");
+    ++g_badversions;
+    return false;
+  }
 
-      if (UrlStartsWith("/plot/") && (_rand64() % 256)) {
-        goto SkipSecurity;
-      }
-      if (!ipv6 && !ContainsInt(&g_whitelisted, ip) &&
-          (tok = AcquireToken(g_tok.b, ip, TB_CIDR)) < 32) {
-        if (tok > 4) {
-          LOG("%s rate limiting client\n", ipbuf, msg->version);
-          Write(client.sock, "HTTP/1.1 429 Too Many Requests\r\n"
-                             "Content-Type: text/plain\r\n"
-                             "Connection: close\r\n"
-                             "\r\n"
-                             "429 Too Many Requests\n");
-        } else {
-          Blackhole(ip);
-          ++g_banned;
-        }
-        ++g_ratelimits;
-        break;
-      }
-    SkipSecurity:
-
-      // we don't support http/1.0 and http/0.9 right now
-      if (msg->version != 11) {
-        LOG("%s used unsupported http/%d version\n", ipbuf, msg->version);
-        Write(client.sock, "HTTP/1.1 505 HTTP Version Not Supported\r\n"
-                           "Content-Type: text/plain\r\n"
-                           "Connection: close\r\n"
-                           "\r\n"
-                           "HTTP Version Not Supported\n");
-        ++g_badversions;
-        break;
-      }
+  // access log
+  LOG("%6P %16s %.*s %.*s %.*s %.*s %#.*s\n", ipbuf,
+      msg->xmethod.b - msg->xmethod.a, inbuf + msg->xmethod.a,
+      msg->uri.b - msg->uri.a, inbuf + msg->uri.a,
+      HeaderLength(kHttpCfIpcountry), HeaderData(kHttpCfIpcountry),
+      HeaderLength(kHttpSecChUaPlatform), HeaderData(kHttpSecChUaPlatform),
+      HeaderLength(kHttpReferer), HeaderData(kHttpReferer));
+
+  // export monitoring data
+  if (UrlEqual("/statusz")) {
+    ServeStatusz(c, outbuf);
+    ++g_statuszrequests;
+    return false;
+  }
 
-      // access log
-      LOG("%6P %16s %.*s %.*s %.*s %.*s %#.*s\n", ipbuf,
-          msg->xmethod.b - msg->xmethod.a, inbuf + msg->xmethod.a,
-          msg->uri.b - msg->uri.a, inbuf + msg->uri.a,
-          HeaderLength(kHttpCfIpcountry), HeaderData(kHttpCfIpcountry),
-          HeaderLength(kHttpSecChUaPlatform), HeaderData(kHttpSecChUaPlatform),
-          HeaderLength(kHttpReferer), HeaderData(kHttpReferer));
-
-      // export monitoring data
-      if (UrlEqual("/statusz")) {
-        ServeStatusz(client.sock, outbuf);
-        ++g_statuszrequests;
-        break;
-      }
+  // asset routing
+  if (UrlEqual("/") || UrlStartsWith("/index.html")) {
+    a = &g_asset.index;
+  } else if (UrlStartsWith("/favicon.ico")) {
+    a = &g_asset.favicon;
+  } else if (UrlStartsWith("/about.html")) {
+    a = &g_asset.about;
+  } else if (UrlStartsWith("/user.html")) {
+    a = &g_asset.user;
+  } else if (UrlStartsWith("/score/hour")) {
+    a = &g_asset.score_hour;
+  } else if (UrlStartsWith("/score/day")) {
+    a = &g_asset.score_day;
+  } else if (UrlStartsWith("/score/week")) {
+    a = &g_asset.score_week;
+  } else if (UrlStartsWith("/score/month")) {
+    a = &g_asset.score_month;
+  } else if (UrlStartsWith("/score")) {
+    a = &g_asset.score;
+  } else if (UrlStartsWith("/recent")) {
+    a = &g_asset.recent;
+  } else if (UrlStartsWith("/plot/")) {
+    int i, block = 0;
+    for (i = msg->uri.a + 6; i < msg->uri.b && isdigit(inbuf[i]); ++i) {
+      block *= 10;
+      block += inbuf[i] - '0';
+      block &= 255;
+    }
+    a = g_asset.plot + block;
+  } else {
+    a = 0;
+  }
 
-      // asset routing
-      if (UrlEqual("/") || UrlStartsWith("/index.html")) {
-        a = &g_asset.index;
-      } else if (UrlStartsWith("/favicon.ico")) {
-        a = &g_asset.favicon;
-      } else if (UrlStartsWith("/about.html")) {
-        a = &g_asset.about;
-      } else if (UrlStartsWith("/user.html")) {
-        a = &g_asset.user;
-      } else if (UrlStartsWith("/score/hour")) {
-        a = &g_asset.score_hour;
-      } else if (UrlStartsWith("/score/day")) {
-        a = &g_asset.score_day;
-      } else if (UrlStartsWith("/score/week")) {
-        a = &g_asset.score_week;
-      } else if (UrlStartsWith("/score/month")) {
-        a = &g_asset.score_month;
-      } else if (UrlStartsWith("/score")) {
-        a = &g_asset.score;
-      } else if (UrlStartsWith("/recent")) {
-        a = &g_asset.recent;
-      } else if (UrlStartsWith("/plot/")) {
-        int i, block = 0;
-        for (i = msg->uri.a + 6; i < msg->uri.b && isdigit(inbuf[i]); ++i) {
-          block *= 10;
-          block += inbuf[i] - '0';
-          block &= 255;
-        }
-        a = g_asset.plot + block;
-      } else {
-        a = 0;
-      }
+  // assert serving
+  if (a) {
+    struct iovec iov[2];
+    ++g_assetrequests;
+    comp = a->gzip.n < a->data.n &&
+           HeaderHas(msg, inbuf, kHttpAcceptEncoding, "gzip", 4);
+    ////////////////////////////////////////
+    nsync_mu_rlock(&a->lock);
+    if (HasHeader(kHttpIfModifiedSince) &&
+        a->mtim.tv_sec <=
+            ParseHttpDateTime(HeaderData(kHttpIfModifiedSince),
+                              HeaderLength(kHttpIfModifiedSince))) {
+      p = stpcpy(outbuf,
+                 "HTTP/1.1 304 Not Modified\r\n" STANDARD_RESPONSE_HEADERS
+                 "Vary: Accept-Encoding\r\n"
+                 "Date: ");
+      p = FormatDate(p);
+      p = stpcpy(p, "\r\nLast-Modified: ");
+      p = stpcpy(p, a->lastmodified);
+      p = stpcpy(p, "\r\nContent-Type: ");
+      p = stpcpy(p, a->type);
+      p = stpcpy(p, "\r\nCache-Control: ");
+      ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
+                a->cash);
+      p = stpcpy(p, cashbuf);
+      p = stpcpy(p, "\r\n\r\n");
+      Send(c, outbuf, p - outbuf);
+    } else {
+      p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
+                         "Vary: Accept-Encoding\r\n"
+                         "Date: ");
+      p = FormatDate(p);
+      p = stpcpy(p, "\r\nLast-Modified: ");
+      p = stpcpy(p, a->lastmodified);
+      p = stpcpy(p, "\r\nContent-Type: ");
+      p = stpcpy(p, a->type);
+      p = stpcpy(p, "\r\nCache-Control: ");
+      ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
+                a->cash);
+      p = stpcpy(p, cashbuf);
+      if (comp) p = stpcpy(p, "\r\nContent-Encoding: gzip");
+      p = stpcpy(p, "\r\nContent-Length: ");
+      d = comp ? a->gzip : a->data;
+      p = FormatInt32(p, d.n);
+      p = stpcpy(p, "\r\n\r\n");
+      iov[0].iov_base = outbuf;
+      iov[0].iov_len = p - outbuf;
+      iov[1].iov_base = d.p;
+      iov[1].iov_len = msg->method == kHttpHead ? 0 : d.n;
+      SendV(c, iov, 2);  // copies unsent bytes while we hold the lock
+    }
+    nsync_mu_runlock(&a->lock);
+    ////////////////////////////////////////
+
+  } else if (UrlStartsWith("/ip")) {
+    // what is my ip endpoint
+    ++g_iprequests;
+    if (!ipv6) {
+      p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
+                         "Vary: Accept\r\n"
+                         "Content-Type: text/plain\r\n"
+                         "Cache-Control: max-age=3600, private\r\n"
+                         "Date: ");
+      p = FormatDate(p);
+      p = stpcpy(p, "\r\nContent-Length: ");
+      p = FormatInt32(p, strlen(ipbuf));
+      p = stpcpy(p, "\r\n\r\n");
+      p = stpcpy(p, ipbuf);
+      Send(c, outbuf, p - outbuf);
+    } else {
+    Ipv6Warning:
+      DEBUG("%.*s via %s: 400 Need IPv4\n", HeaderLength(kHttpXForwardedFor),
+            HeaderData(kHttpXForwardedFor), ipbuf);
+      q = "IPv4 Games only supports IPv4 right now";
+      p = stpcpy(outbuf, "HTTP/1.1 400 Need IPv4\r\n" STANDARD_RESPONSE_HEADERS
+                         "Vary: Accept\r\n"
+                         "Content-Type: text/plain\r\n"
+                         "Cache-Control: private\r\n"
+                         "Connection: close\r\n"
+                         "Date: ");
+      p = FormatDate(p);
+      p = stpcpy(p, "\r\nContent-Length: ");
+      p = FormatInt32(p, strlen(q));
+      p = stpcpy(p, "\r\n\r\n");
+      p = stpcpy(p, q);
+      Send(c, outbuf, p - outbuf);
+      return false;
+    }
 
-      // assert serving
-      if (a) {
-        struct iovec iov[2];
-        ++g_assetrequests;
-        comp = a->gzip.n < a->data.n &&
-               HeaderHas(msg, inbuf, kHttpAcceptEncoding, "gzip", 4);
-        ////////////////////////////////////////
-        nsync_mu_rlock(&a->lock);
-        if (HasHeader(kHttpIfModifiedSince) &&
-            a->mtim.tv_sec <=
-                ParseHttpDateTime(HeaderData(kHttpIfModifiedSince),
-                                  HeaderLength(kHttpIfModifiedSince))) {
-          p = stpcpy(outbuf,
-                     "HTTP/1.1 304 Not Modified\r\n" STANDARD_RESPONSE_HEADERS
-                     "Vary: Accept-Encoding\r\n"
-                     "Date: ");
-          p = FormatDate(p);
-          p = stpcpy(p, "\r\nLast-Modified: ");
-          p = stpcpy(p, a->lastmodified);
-          p = stpcpy(p, "\r\nContent-Type: ");
-          p = stpcpy(p, a->type);
-          p = stpcpy(p, "\r\nCache-Control: ");
-          ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
-                    a->cash);
-          p = stpcpy(p, cashbuf);
-          p = stpcpy(p, "\r\n\r\n");
-          outmsglen = p - outbuf;
-          sent = write(client.sock, outbuf, outmsglen);
-        } else {
+  } else if (UrlStartsWith("/claim")) {
+    // ip:name registration endpoint
+    ++g_claimrequests;
+    if (ipv6) goto Ipv6Warning;
+    struct Claim v = {.ip = ip, .created = g_nowish.ts.tv_sec};
+    if (GetNick(inbuf, msg, &v)) {
+      // reactors mustn't block so a full queue is reported right away
+      if (AddClaim(&g_claims, &v, nsync_time_zero)) {
+        ++g_claimsenqueued;
+        DEBUG("%s claimed by %s\n", ipbuf, v.name);
+        if (HasHeader(kHttpAccept) &&
+            (HeaderHas(msg, inbuf, kHttpAccept, "image/*", 7) ||
+             HeaderHas(msg, inbuf, kHttpAccept, "image/gif", 9))) {
+          ++g_imageclaims;
           p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
-                             "Vary: Accept-Encoding\r\n"
+                             "Vary: Accept\r\n"
+                             "Cache-Control: private\r\n"
+                             "Content-Type: image/gif\r\n"
+                             "Connection: close\r\n"
                              "Date: ");
           p = FormatDate(p);
-          p = stpcpy(p, "\r\nLast-Modified: ");
-          p = stpcpy(p, a->lastmodified);
-          p = stpcpy(p, "\r\nContent-Type: ");
-          p = stpcpy(p, a->type);
-          p = stpcpy(p, "\r\nCache-Control: ");
-          ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
-                    a->cash);
-          p = stpcpy(p, cashbuf);
-          if (comp) p = stpcpy(p, "\r\nContent-Encoding: gzip");
           p = stpcpy(p, "\r\nContent-Length: ");
-          d = comp ? a->gzip : a->data;
-          p = FormatInt32(p, d.n);
+          p = FormatInt32(p, sizeof(kPixel));
           p = stpcpy(p, "\r\n\r\n");
-          iov[0].iov_base = outbuf;
-          iov[0].iov_len = p - outbuf;
-          iov[1].iov_base = d.p;
-          iov[1].iov_len = msg->method == kHttpHead ? 0 : d.n;
-          outmsglen = iov[0].iov_len + iov[1].iov_len;
-          sent = writev(client.sock, iov, 2);
-        }
-        nsync_mu_runlock(&a->lock);
-        ////////////////////////////////////////
-
-      } else if (UrlStartsWith("/ip")) {
-        // what is my ip endpoint
-        ++g_iprequests;
-        if (!ipv6) {
+          p = mempcpy(p, kPixel, sizeof(kPixel));
+        } else if (HasHeader(kHttpAccept) &&
+                   HeaderHas(msg, inbuf, kHttpAccept, "text/plain", 10) &&
+                   !HeaderHas(msg, inbuf, kHttpAccept, "text/html", 9)) {
+          ++g_plainclaims;
+          ksnprintf(msgbuf, MSG_BUF, "The land at %s was claimed for %s\n",
+                    ipbuf, v.name);
+          q = msgbuf;
           p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
                              "Vary: Accept\r\n"
+                             "Cache-Control: private\r\n"
                              "Content-Type: text/plain\r\n"
-                             "Cache-Control: max-age=3600, private\r\n"
+                             "Connection: close\r\n"
                              "Date: ");
           p = FormatDate(p);
           p = stpcpy(p, "\r\nContent-Length: ");
-          p = FormatInt32(p, strlen(ipbuf));
+          p = FormatInt32(p, strlen(q));
           p = stpcpy(p, "\r\n\r\n");
-          p = stpcpy(p, ipbuf);
-          outmsglen = p - outbuf;
-          sent = write(client.sock, outbuf, outmsglen);
-        } else {
-        Ipv6Warning:
-          DEBUG("%.*s via %s: 400 Need IPv4\n",
-                HeaderLength(kHttpXForwardedFor),
-                HeaderData(kHttpXForwardedFor), ipbuf);
-          q = "IPv4 Games only supports IPv4 right now";
-          p = stpcpy(outbuf,
-                     "HTTP/1.1 400 Need IPv4\r\n" STANDARD_RESPONSE_HEADERS
-                     "Vary: Accept\r\n"
-                     "Content-Type: text/plain\r\n"
-                     "Cache-Control: private\r\n"
-                     "Connection: close\r\n"
-                     "Date: ");
+          p = stpcpy(p, q);
+        } else if (!HasHeader(kHttpAccept) ||
+                   (HeaderHas(msg, inbuf, kHttpAccept, "text/html", 9) ||
+                    HeaderHas(msg, inbuf, kHttpAccept, "text/*", 6) ||
+                    HeaderHas(msg, inbuf, kHttpAccept, "*/*", 3))) {
+          ++g_htmlclaims;
+          ksnprintf(msgbuf, MSG_BUF,
+                    "<!doctype html>\n"
+                    "<title>The land at %s was claimed for %s.</title>\n"
+                    "<meta name=\"viewport\" "
+                    "content=\"width=device-width, initial-scale=1\">\n"
+                    "The land at %s was claimed for <a "
+                    "href=\"/user.html?name=%s\">%s</a>.\n"
+                    "<p>\n<a href=/>Back to homepage</a>\n",
+                    ipbuf, v.name, ipbuf, v.name, v.name);
+          q = msgbuf;
+          p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
+                             "Vary: Accept\r\n"
+                             "Cache-Control: private\r\n"
+                             "Content-Type: text/html\r\n"
+                             "Connection: close\r\n"
+                             "Date: ");
           p = FormatDate(p);
           p = stpcpy(p, "\r\nContent-Length: ");
           p = FormatInt32(p, strlen(q));
           p = stpcpy(p, "\r\n\r\n");
           p = stpcpy(p, q);
-          outmsglen = p - outbuf;
-          sent = write(client.sock, outbuf, p - outbuf);
-          break;
-        }
-
-      } else if (UrlStartsWith("/claim")) {
-        // ip:name registration endpoint
-        ++g_claimrequests;
-        if (ipv6) goto Ipv6Warning;
-        struct Claim v = {.ip = ip, .created = g_nowish.ts.tv_sec};
-        if (GetNick(inbuf, msg, &v)) {
-          if (AddClaim(&g_claims, &v,
-                       timespec_add(timespec_real(),
-                                    timespec_frommillis(CLAIM_DEADLINE_MS)))) {
-            ++g_claimsenqueued;
-            DEBUG("%s claimed by %s\n", ipbuf, v.name);
-            if (HasHeader(kHttpAccept) &&
-                (HeaderHas(msg, inbuf, kHttpAccept, "image/*", 7) ||
-                 HeaderHas(msg, inbuf, kHttpAccept, "image/gif", 9))) {
-              ++g_imageclaims;
-              p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
-                                 "Vary: Accept\r\n"
-                                 "Cache-Control: private\r\n"
-                                 "Content-Type: image/gif\r\n"
-                                 "Connection: close\r\n"
-                                 "Date: ");
-              p = FormatDate(p);
-              p = stpcpy(p, "\r\nContent-Length: ");
-              p = FormatInt32(p, sizeof(kPixel));
-              p = stpcpy(p, "\r\n\r\n");
-              p = mempcpy(p, kPixel, sizeof(kPixel));
-            } else if (HasHeader(kHttpAccept) &&
-                       HeaderHas(msg, inbuf, kHttpAccept, "text/plain", 10) &&
-                       !HeaderHas(msg, inbuf, kHttpAccept, "text/html", 9)) {
-              ++g_plainclaims;
-              ksnprintf(msgbuf, MSG_BUF, "The land at %s was claimed for %s\n",
-                        ipbuf, v.name);
-              q = msgbuf;
-              p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
-                                 "Vary: Accept\r\n"
-                                 "Cache-Control: private\r\n"
-                                 "Content-Type: text/plain\r\n"
-                                 "Connection: close\r\n"
-                                 "Date: ");
-              p = FormatDate(p);
-              p = stpcpy(p, "\r\nContent-Length: ");
-              p = FormatInt32(p, strlen(q));
-              p = stpcpy(p, "\r\n\r\n");
-              p = stpcpy(p, q);
-            } else if (!HasHeader(kHttpAccept) ||
-                       (HeaderHas(msg, inbuf, kHttpAccept, "text/html", 9) ||
-                        HeaderHas(msg, inbuf, kHttpAccept, "text/*", 6) ||
-                        HeaderHas(msg, inbuf, kHttpAccept, "*/*", 3))) {
-              ++g_htmlclaims;
-              ksnprintf(msgbuf, MSG_BUF,
-                        "<!doctype html>\n"
-                        "<title>The land at %s was claimed for %s.</title>\n"
-                        "<meta name=\"viewport\" "
-                        "content=\"width=device-width, initial-scale=1\">\n"
-                        "The land at %s was claimed for <a "
-                        "href=\"/user.html?name=%s\">%s</a>.\n"
-                        "<p>\n<a href=/>Back to homepage</a>\n",
-                        ipbuf, v.name, ipbuf, v.name, v.name);
-              q = msgbuf;
-              p = stpcpy(outbuf, "HTTP/1.1 200 OK\r\n" STANDARD_RESPONSE_HEADERS
-                                 "Vary: Accept\r\n"
-                                 "Cache-Control: private\r\n"
-                                 "Content-Type: text/html\r\n"
-                                 "Connection: close\r\n"
-                                 "Date: ");
-              p = FormatDate(p);
-              p = stpcpy(p, "\r\nContent-Length: ");
-              p = FormatInt32(p, strlen(q));
-              p = stpcpy(p, "\r\n\r\n");
-              p = stpcpy(p, q);
-            } else {
-              ++g_emptyclaims;
-              p = stpcpy(outbuf,
-                         "HTTP/1.1 204 No Content\r\n" STANDARD_RESPONSE_HEADERS
-                         "Vary: Accept\r\n"
-                         "Cache-Control: private\r\n"
-                         "Content-Length: 0\r\n"
-                         "Connection: close\r\n"
-                         "Date: ");
-              p = FormatDate(p);
-              p = stpcpy(p, "\r\n\r\n");
-            }
-            outmsglen = p - outbuf;
-            sent = write(client.sock, outbuf, p - outbuf);
-            break;
-          } else {
-            LOG("%s: 503 Claims Queue Full\n", ipbuf);
-            Write(client.sock, "HTTP/1.1 503 Claims Queue Full\r\n"
-                               "Content-Type: text/plain\r\n"
-                               "Connection: close\r\n"
-                               "\r\n"
-                               "Claims Queue Full\n");
-            ++g_queuefulls;
-            break;
-          }
         } else {
-          ++g_invalidnames;
-          LOG("%s: 400 invalid name\n", ipbuf);
-          q = "invalid name";
+          ++g_emptyclaims;
           p = stpcpy(outbuf,
-                     "HTTP/1.1 400 Invalid Name\r\n" STANDARD_RESPONSE_HEADERS
-                     "Content-Type: text/plain\r\n"
+                     "HTTP/1.1 204 No Content\r\n" STANDARD_RESPONSE_HEADERS
+                     "Vary: Accept\r\n"
                      "Cache-Control: private\r\n"
+                     "Content-Length: 0\r\n"
                      "Connection: close\r\n"
                      "Date: ");
           p = FormatDate(p);
-          p = stpcpy(p, "\r\nContent-Length: ");
-          p = FormatInt32(p, strlen(q));
           p = stpcpy(p, "\r\n\r\n");
-          p = stpcpy(p, q);
-          outmsglen = p - outbuf;
-          sent = write(client.sock, outbuf, p - outbuf);
-          break;
         }
+        Send(c, outbuf, p - outbuf);
+        return false;
+      } else {
+        LOG("%s: 503 Claims Queue Full\n", ipbuf);
+        SendString(c, "HTTP/1.1 503 Claims Queue Full\r\n"
+                      "Content-Type: text/plain\r\n"
+                      "Connection: close\r\n"
+                      "\r\n"
+                      "Claims Queue Full\n");
+        ++g_queuefulls;
+        return false;
+      }
+    } else {
+      ++g_invalidnames;
+      LOG("%s: 400 invalid name\n", ipbuf);
+      q = "invalid name";
+      p = stpcpy(outbuf,
+                 "HTTP/1.1 400 Invalid Name\r\n" STANDARD_RESPONSE_HEADERS
+                 "Content-Type: text/plain\r\n"
+                 "Cache-Control: private\r\n"
+                 "Connection: close\r\n"
+                 "Date: ");
+      p = FormatDate(p);
+      p = stpcpy(p, "\r\nContent-Length: ");
+      p = FormatInt32(p, strlen(q));
+      p = stpcpy(p, "\r\n\r\n");
+      p = stpcpy(p, q);
+      Send(c, outbuf, p - outbuf);
+      return false;
+    }
 
+  } else {
+    // default endpoint
+    ++g_notfounds;
+    LOG("%s: 400 not found %#.*s\n", ipbuf, msg->uri.b - msg->uri.a,
+        inbuf + msg->uri.a);
+    q = "<!doctype html>\r\n"
+        "<title>404 not found</title>\r\n"
+        "<h1>404 not found</h1>\r\n";
+    p = stpcpy(outbuf, "HTTP/1.1 404 Not Found\r\n" STANDARD_RESPONSE_HEADERS
+                       "Content-Type: text/html; charset=utf-8\r\n"
+                       "Date: ");
+    p = FormatDate(p);
+    p = stpcpy(p, "\r\nContent-Length: ");
+    p = FormatInt32(p, strlen(q));
+    p = stpcpy(p, "\r\n\r\n");
+    p = stpcpy(p, q);
+    Send(c, outbuf, p - outbuf);
+  }
+
+  // if the client isn't pipelining and the response was queued, then
+  // since we sent the content length and checked that the client did
+  // not attach a payload, we are so synced thus we can safely process
+  // more messages. any unsent output is flushed before we read again.
+  return got == inmsglen &&                                  //
+         !c->hangup &&                                       //
+         !HasHeader(kHttpContentLength) &&                   //
+         !HasHeader(kHttpTransferEncoding) &&                //
+         !HeaderEqualCase(kHttpConnection, "close") &&       //
+         (msg->method == kHttpGet ||                         //
+          msg->method == kHttpHead) &&                       //
+         1. / g_maxconns * g_connections < CONCERN_LOAD &&  //
+         !nsync_note_is_notified(g_shutdown[1]);
+}
+
+#define CONN(e) DLL_CONTAINER(struct Conn, elem, e)
+
+void CloseClient(struct Worker *w, struct Conn *c) {
+  dll_remove(&w->idle, &c->elem);
+  close(c->sock);  // also removes it from epoll
+  free(c->out.p);
+  free(c);
+  --g_connections;
+}
+
+// changes which event reactor waits for on client socket
+// we only read the next message once the last one is fully sent
+bool WatchClient(struct Worker *w, struct Conn *c) {
+  struct epoll_event ev = {c->out.n ? EPOLLOUT : EPOLLIN, {.ptr = c}};
+  if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->sock, &ev) != -1) return true;
+  kprintf("%s:%d: %P: epoll_ctl failed: %s\n", __FILE__, __LINE__,
+          strerror(errno));
+  ++g_sysfails;
+  return false;
+}
+
+// takes ownership of new connections from the shared listen socket
+// reactors race to accept so losing with EAGAIN is perfectly normal
+void AcceptClients(struct Worker *w) {
+  int i, sock;
+  uint32_t size;
+  struct Conn *c;
+  struct epoll_event ev;
+  struct sockaddr_in addr;
+  for (i = 0; i < ACCEPT_MAX; ++i) {
+    size = sizeof(addr);
+    if ((sock = accept4(g_server, (struct sockaddr *)&addr, &size,
+                        SOCK_NONBLOCK | SOCK_CLOEXEC)) == -1) {
+      if (errno != EAGAIN) {
+        ++g_acceptfails;
+      }
+      break;
+    }
+    ++g_accepts;
+    if (g_connections >= g_maxconns) {
+      ++g_rejected;
+      LOG("503 Too Many Connections\n");
+      Write(sock, "HTTP/1.1 503 Too Many Connections\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Connection: close\r\n"
+                  "\r\n"
+                  "Too Many Connections\n");
+      close(sock);
+      continue;
+    }
+    if (!(c = calloc(1, sizeof(*c)))) {
+      ++g_memfails;
+      close(sock);
+      continue;
+    }
+    c->sock = sock;
+    c->clientip = ntohl(addr.sin_addr.s_addr);
+    c->lastread = w->now;
+    dll_init(&c->elem);
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, sock, &ev) == -1) {
+      ++g_sysfails;
+      close(sock);
+      free(c);
+      continue;
+    }
+    dll_make_last(&w->idle, &c->elem);
+    ++g_connections;
+  }
+}
+
+// reads one http message from client and responds to it
+void ReadClient(struct Worker *w, struct Conn *c) {
+  ssize_t got;
+  if ((got = read(c->sock, w->inbuf, INBUF_SIZE)) <= 0) {
+    if (got == -1 && errno == EAGAIN) return;
+    ++g_readfails;
+    CloseClient(w, c);
+    return;
+  }
+  c->lastread = w->now;
+  dll_remove(&w->idle, &c->elem);
+  dll_make_last(&w->idle, &c->elem);
+  if (!HandleMessage(w, c, got)) {
+    c->hangup = true;
+  }
+  if (c->out.n) {
+    if (!WatchClient(w, c)) {
+      CloseClient(w, c);
+    }
+  } else if (c->hangup) {
+    CloseClient(w, c);
+  }
+}
+
+// sends response bytes that didn't fit in the socket buffer earlier
+void FlushClient(struct Worker *w, struct Conn *c) {
+  ssize_t rc;
+  if ((rc = write(c->sock, c->out.p + c->outpos, c->out.n - c->outpos)) ==
+      -1) {
+    if (errno == EAGAIN) return;
+    CloseClient(w, c);
+    return;
+  }
+  if ((c->outpos += rc) < c->out.n) return;
+  free(c->out.p);
+  c->out.p = 0;
+  c->out.n = 0;
+  c->outpos = 0;
+  if (c->hangup || !WatchClient(w, c)) {
+    CloseClient(w, c);
+  }
+}
+
+// we're permissive in allowing http connection keepalive until the
+// moment connection slots start becoming scarce. when that happens
+// we'll (1) hang up on connections that haven't sent us a message
+// in a while; (2) hang up on clients who are sending lots of them.
+void ExpireClients(struct Worker *w) {
+  long melted;
+  struct Conn *c;
+  struct Dll *e, *e2;
+  struct timespec ttl;
+  bool meltdown = g_meltdown;
+  ttl = timespec_frommillis(meltdown ? MELTALIVE_MS : g_keepalive);
+  while ((e = dll_first(w->idle))) {
+    c = CONN(e);
+    if (timespec_cmp(timespec_sub(w->now, c->lastread), ttl) < 0) break;
+    CloseClient(w, c);
+  }
+  if (meltdown && w->melted != (melted = g_meltdowns)) {
+    w->melted = melted;
+    for (e = dll_first(w->idle); e; e = e2) {
+      e2 = dll_next(w->idle, e);
+      c = CONN(e);
+      if (c->msgcount > PANIC_MSGS) {
+        CloseClient(w, c);
+      }
+    }
+  }
+}
+
+// creates the listening socket which all reactors share
+int Listen(void) {
+  int server;
+  int no = 0;
+  int yes = 1;
+  int fastopen = 5;
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(g_port)};
+  CHECK_NE(-1, (server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)));
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  setsockopt(server, SOL_TCP, TCP_FASTOPEN, &fastopen, sizeof(fastopen));
+  setsockopt(server, SOL_TCP, TCP_QUICKACK, &no, sizeof(no));
+  setsockopt(server, SOL_TCP, TCP_CORK, &no, sizeof(no));
+  setsockopt(server, SOL_TCP, TCP_NODELAY, &yes, sizeof(yes));
+  bind(server, (struct sockaddr *)&addr, sizeof(addr));
+  CHECK_NE(-1, listen(server, SOMAXCONN));
+  return server;
+}
+
+// make one http reactor per cpu
+// load balance incoming connections for port 8080 across all reactors
+// hangup on any browser clients that lag for more than a few seconds
+void *HttpWorker(void *arg) {
+  int i, n;
+  struct Conn *c;
+  struct Dll *e;
+  int id = (intptr_t)arg;
+  struct Worker *w = g_worker + id;
+  struct epoll_event ev[EVENTS_MAX];
+  struct timespec swept = {0};
+
+  BlockSignals();
+  pthread_setname_np(pthread_self(), _gc(xasprintf("HTTP%d", id)));
+
+  // event loop
+  while (!nsync_note_is_notified(g_shutdown[1])) {
+    n = epoll_wait(w->epfd, ev, EVENTS_MAX, SWEEP_MS);
+    w->now = timespec_real();
+    for (i = 0; i < n; ++i) {
+      if (!(c = ev[i].data.ptr)) {
+        AcceptClients(w);
+      } else if (c->out.n) {
+        FlushClient(w, c);
       } else {
-        // default endpoint
-        ++g_notfounds;
-        LOG("%s: 400 not found %#.*s\n", ipbuf, msg->uri.b - msg->uri.a,
-            inbuf + msg->uri.a);
-        q = "<!doctype html>\r\n"
-            "<title>404 not found</title>\r\n"
-            "<h1>404 not found</h1>\r\n";
-        p = stpcpy(outbuf,
-                   "HTTP/1.1 404 Not Found\r\n" STANDARD_RESPONSE_HEADERS
-                   "Content-Type: text/html; charset=utf-8\r\n"
-                   "Date: ");
-        p = FormatDate(p);
-        p = stpcpy(p, "\r\nContent-Length: ");
-        p = FormatInt32(p, strlen(q));
-        p = stpcpy(p, "\r\n\r\n");
-        p = stpcpy(p, q);
-        outmsglen = p - outbuf;
-        sent = write(client.sock, outbuf, p - outbuf);
+        ReadClient(w, c);
       }
+    }
+    if (timespec_cmp(timespec_sub(w->now, swept),
+                     timespec_frommillis(SWEEP_MS)) >= 0) {
+      ExpireClients(w);
+      swept = w->now;
+    }
+  }
 
-      // if the client isn't pipelining and write() wrote the full
-      // amount, then since we sent the content length and checked
-      // that the client didn't attach a payload, we are so synced
-      // thus we can safely process more messages
-    } while (got == inmsglen &&                                //
-             sent == outmsglen &&                              //
-             !HasHeader(kHttpContentLength) &&                 //
-             !HasHeader(kHttpTransferEncoding) &&              //
-             !HeaderEqualCase(kHttpConnection, "close") &&     //
-             (msg->method == kHttpGet ||                       //
-              msg->method == kHttpHead) &&                     //
-             1. / g_workers * g_connections < CONCERN_LOAD &&  //
-             !nsync_note_is_notified(g_shutdown[1]));
-    DestroyHttpMessage(msg);
-    close(client.sock);
-    g_worker[id].connected = false;
-    --g_connections;
+  // hang up on whoever is left
+  while ((e = dll_first(w->idle))) {
+    CloseClient(w, CONN(e));
   }
 
   LOG("HttpWorker #%d exiting", id);
-  g_worker[id].shutdown = true;
-  FreeSafeBuffer(outbuf);
-  FreeSafeBuffer(inbuf);
   return 0;
 }
 
@@ -1337,29 +1496,12 @@ void FreeAsset(struct Asset *a) {
   free(a->gzip.p);
 }
 
-void IgnoreSignal(int sig) {
-  // so worker i/o routines may eintr safely
-}
-
 // asynchronous handler of sigint, sigterm, and sighup signals
 // this handler is always invoked from within the main thread,
 // because our helper and worker threads always block signals.
 void OnCtrlC(int sig) {
-  if (!nsync_note_is_notified(g_shutdown[0])) {
-    LOG("Received %s shutting down...\n", strsignal(sig));
-    nsync_note_notify(g_shutdown[0]);
-  } else {
-    // there's no way to deliver signals to workers atomically, unless
-    // we pay the cost of ppoll() which isn't necessary in this design
-    // so if a user smashes that ctrl-c then we tkill the workers more
-    LOG("Received %s again so sending another volley...\n", strsignal(sig));
-    for (int i = 0; i < g_workers; ++i) {
-      pthread_kill(g_listener, SIGUSR1);
-      if (!g_worker[i].shutdown) {
-        pthread_kill(g_worker[i].th, SIGUSR1);
-      }
-    }
-  }
+  LOG("Received %s shutting down...\n", strsignal(sig));
+  nsync_note_notify(g_shutdown[0]);
 }
 
 // parses cli arguments
@@ -1383,6 +1525,9 @@ void GetOpts(int argc, char *argv[]) {
       case 'k':
         g_keepalive = atoi(optarg);
         break;
+      case 'c':
+        g_maxconns = MAX(1, atoi(optarg));
+        break;
       case 'v':
         ++__log_level;
         break;
@@ -1429,18 +1574,223 @@ void Update(struct Asset *a, bool gen(struct Asset *, long, long), long x,
   }
 }
 
+uint32_t HashNick(const char *name) {
+  return crc32c(0, name, strlen(name));
+}
+
+// returns index of nick on scoreboard, adding it if needed
+int InternNick(const char *name) {
+  int j, *hash;
+  struct Nick *k, **v;
+  uint32_t i, h, m, n;
+  h = HashNick(name);
+  for (i = h;; ++i) {
+    if (!(j = g_board.hash[i & g_board.mask])) break;
+    if (!strcmp(g_board.nick[j - 1]->name, name)) return j - 1;
+  }
+  if (g_board.n + 1 > (g_board.mask + 1) / 2) {
+    m = g_board.mask * 2 + 1;
+    CHECK_MEM((hash = calloc(m + 1, sizeof(*hash))));
+    for (j = 0; j < g_board.n; ++j) {
+      for (i = HashNick(g_board.nick[j]->name); hash[i & m];) ++i;
+      hash[i & m] = j + 1;
+    }
+    free(g_board.hash);
+    g_board.hash = hash;
+    g_board.mask = m;
+    for (i = h; hash[i & m];) ++i;
+  }
+  if (g_board.n == g_board.c) {
+    n = g_board.c + (g_board.c >> 1) + 64;
+    CHECK_MEM((v = realloc(g_board.nick, n * sizeof(*v))));
+    g_board.nick = v;
+    CHECK_MEM((v = realloc(g_board.order, n * sizeof(*v))));
+    g_board.order = v;
+    g_board.c = n;
+  }
+  CHECK_MEM((k = calloc(1, sizeof(*k))));
+  if (!(k->name = strdup(name))) {
+    free(k);
+    CHECK_MEM(0);
+  }
+  k->valid = IsValidNick(name, -1);
+  g_board.nick[g_board.n] = k;
+  g_board.order[g_board.n] = k;
+  g_board.hash[i & g_board.mask] = ++g_board.n;
+  g_board.sorted = false;
+  return g_board.n - 1;
+OnError:
+  return -1;
+}
+
+// returns counters for land owned by nick in /8 block
+struct Cell *GetCell(struct Nick *k, int block) {
+  int l, r, m;
+  struct Cell *p;
+  l = 0;
+  r = k->n;
+  while (l < r) {
+    m = (l + r) >> 1;
+    if (k->cell[m].block < block) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  if (l < k->n && k->cell[l].block == block) return k->cell + l;
+  if (k->n == k->c) {
+    m = k->c ? k->c * 2 : 4;
+    CHECK_MEM((p = realloc(k->cell, m * sizeof(*k->cell))));
+    k->cell = p;
+    k->c = m;
+  }
+  memmove(k->cell + l + 1, k->cell + l, (k->n - l) * sizeof(*k->cell));
+  bzero(k->cell + l, sizeof(*k->cell));
+  k->cell[l].block = block;
+  k->n++;
+  return k->cell + l;
+OnError:
+  return 0;
+}
+
+void Bump(struct Nick *k, struct Cell *c, int board, long delta) {
+  c->count[board] += delta;
+  k->dirty[board] = true;
+  g_board.changed[board] = true;
+}
+
+// adds delta to how much land nick currently owns in block
+void CountLand(int nick, int block, long delta) {
+  struct Cell *c;
+  struct Nick *k = g_board.nick[nick];
+  if ((c = GetCell(k, block))) {
+    Bump(k, c, 0, delta);
+  }
+}
+
+// adds delta to windowed boards for a claim made at a certain time
+// the claim is remembered so it can be subtracted once it gets old
+void CountClaim(int nick, int block, int64_t created, int delta) {
+  int b;
+  long key;
+  struct Cell *c;
+  struct Event *p;
+  struct Bucket *q;
+  struct Nick *k = g_board.nick[nick];
+  key = MIN(created, g_board.now) / SCORE_BUCKET_SECS;
+  if (key <= g_board.expired[BOARDS - 1]) return;
+  if (!(c = GetCell(k, block))) return;
+  q = g_board.ring + key % SCORE_RING;
+  if (q->key != key) {
+    q->key = key;
+    q->n = 0;
+  }
+  if (q->n == q->c) {
+    b = q->c + (q->c >> 1) + 16;
+    CHECK_MEM((p = realloc(q->p, b * sizeof(*q->p))));
+    q->p = p;
+    q->c = b;
+  }
+  q->p[q->n++] = (struct Event){nick, block, delta};
+  for (b = 1; b < BOARDS; ++b) {
+    if (key > g_board.expired[b]) {
+      Bump(k, c, b, delta);
+    }
+  }
+OnError:
+  return;
+}
+
+// subtracts claims that have become too old from the windowed boards
+void ExpireScores(int64_t now) {
+  int b, i;
+  long key, end;
+  struct Nick *k;
+  struct Cell *c;
+  struct Event *e;
+  struct Bucket *q;
+  g_board.now = now;
+  for (b = 1; b < BOARDS; ++b) {
+    end = (now - kBoardSecs[b]) / SCORE_BUCKET_SECS - 1;
+    for (key = g_board.expired[b] + 1; key <= end; ++key) {
+      q = g_board.ring + key % SCORE_RING;
+      if (q->key != key) continue;
+      for (i = 0; i < q->n; ++i) {
+        e = q->p + i;
+        k = g_board.nick[e->nick];
+        if ((c = GetCell(k, e->block))) {
+          Bump(k, c, b, -e->delta);
+        }
+      }
+      if (b == BOARDS - 1) {
+        free(q->p);
+        bzero(q, sizeof(*q));
+      }
+    }
+    g_board.expired[b] = MAX(g_board.expired[b], end);
+  }
+}
+
+int CompareNicks(const void *a, const void *b) {
+  return strcmp((*(struct Nick **)a)->name, (*(struct Nick **)b)->name);
+}
+
+// regenerates json for nick's land on board
+bool RenderNick(struct Nick *k, int board) {
+  int i;
+  char *s = 0;
+  for (i = 0; i < k->n; ++i) {
+    if (k->cell[i].count[board] <= 0) continue;
+    if (!s) {
+      CHECK_SYS(appendf(&s, "\"%s\":[\n",
+                        EscapeJsStringLiteral(&g_board.sb, &g_board.sblen,
+                                              k->name, -1, 0)));
+    } else {
+      CHECK_SYS(appends(&s, ",\n"));
+    }
+    CHECK_SYS(appendf(&s, "  [%d,%ld]", k->cell[i].block,
+                      k->cell[i].count[board]));
+  }
+  if (s) CHECK_SYS(appends(&s, "]"));
+  free(k->json[board]);
+  k->json[board] = s;
+  k->dirty[board] = false;
+  return true;
+OnError:
+  free(s);
+  return false;
+}
+
+// concatenates json of every nick, only regenerating what changed
+bool RenderScore(char **p, int board) {
+  int i;
+  struct Nick *k;
+  bool once = false;
+  if (!g_board.sorted) {
+    qsort(g_board.order, g_board.n, sizeof(*g_board.order), CompareNicks);
+    g_board.sorted = true;
+  }
+  for (i = 0; i < g_board.n; ++i) {
+    k = g_board.order[i];
+    if (!k->valid) continue;
+    if (k->dirty[board] && !RenderNick(k, board)) return false;
+    if (!k->json[board]) continue;
+    if (once && appends(p, ",\n") == -1) return false;
+    if (appendd(p, k->json[board], appendz(k->json[board]).i) == -1) {
+      return false;
+    }
+    once = true;
+  }
+  if (once && appends(p, "\n") == -1) return false;
+  g_board.changed[board] = false;
+  return true;
+}
+
 // generator function for the big board
-bool GenerateScore(struct Asset *out, long secs, long cash) {
-  int rc;
-  char *sb = 0;
-  sqlite3 *db = 0;
-  size_t sblen = 0;
+bool GenerateScore(struct Asset *out, long board, long cash) {
+  bool ok;
   struct Asset a = {0};
-  sqlite3_stmt *stmt = 0;
-  bool namestate = false;
-  char name1[NICK_MAX + 1] = {0};
-  char name2[NICK_MAX + 1];
-  DEBUG("GenerateScore %ld\n", secs);
+  DEBUG("GenerateScore %ld\n", board);
   a.type = "application/json";
   a.cash = cash;
   a.mtim = timespec_real();
@@ -1449,60 +1799,119 @@ bool GenerateScore(struct Asset *out, long secs, long cash) {
   CHECK_SYS(appendf(&a.data.p, "\"now\":[%ld,%ld],\n", a.mtim.tv_sec,
                     a.mtim.tv_nsec));
   CHECK_SYS(appends(&a.data.p, "\"score\":{\n"));
-  CHECK_SQL(DbOpen("db.sqlite3", &db));
-  if (secs == -1) {
-    CHECK_DB(DbPrepare(db, &stmt,
-                       "SELECT nick, (ip >> 24), COUNT(*)\n"
-                       "FROM land\n"
-                       "GROUP BY nick, (ip >> 24)"));
+  //!//!//!//!//!//!//!//!//!//!//!//!//!/
+  nsync_mu_lock(&g_board.mu);
+  ExpireScores(a.mtim.tv_sec);
+  if (g_board.changed[board]) {
+    ok = RenderScore(&a.data.p, board);
   } else {
-    CHECK_DB(DbPrepare(db, &stmt,
-                       "SELECT nick, (ip >> 24), COUNT(*)\n"
-                       " FROM land\n"
-                       "WHERE created NOT NULL\n"
-                       "  AND created >= ?1\n"
-                       "GROUP BY nick, (ip >> 24)"));
-    CHECK_DB(sqlite3_bind_int64(stmt, 1, a.mtim.tv_sec - secs));
-  }
-  // be sure to always use transactions with sqlite as in always
-  // otherwise.. you can use --strace to see the fcntl bloodbath
-  CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
-  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
-    if (rc != SQLITE_ROW) CHECK_DB(rc);
-    strlcpy(name2, (void *)sqlite3_column_text(stmt, 0), sizeof(name2));
-    if (!IsValidNick(name2, -1)) continue;
-    if (strcmp(name1, name2)) {
-      // name changed
-      if (namestate) CHECK_SYS(appends(&a.data.p, "],\n"));
-      namestate = true;
-      CHECK_SYS(appendf(
-          &a.data.p, "\"%s\":[\n",
-          EscapeJsStringLiteral(&sb, &sblen, strcpy(name1, name2), -1, 0)));
-    } else {
-      // name repeated
-      CHECK_SYS(appends(&a.data.p, ",\n"));
-    }
-    CHECK_SYS(appendf(&a.data.p, "  [%ld,%ld]", sqlite3_column_int64(stmt, 1),
-                      sqlite3_column_int64(stmt, 2)));
+    ok = false;  // keep serving the old one
   }
-  CHECK_SQL(sqlite3_exec(db, "END TRANSACTION", 0, 0, 0));
-  if (namestate) CHECK_SYS(appends(&a.data.p, "]\n"));
+  nsync_mu_unlock(&g_board.mu);
+  //!//!//!//!//!//!//!//!//!//!//!//!//!/
+  if (!ok) goto OnError;
   CHECK_SYS(appends(&a.data.p, "}}\n"));
-  CHECK_DB(sqlite3_finalize(stmt));
-  CHECK_SQL(sqlite3_close(db));
   a.data.n = appendz(a.data.p).i;
   a.gzip = Gzip(a.data);
-  free(sb);
   *out = a;
   return true;
 OnError:
-  sqlite3_finalize(stmt);
-  sqlite3_close(db);
   free(a.data.p);
-  free(sb);
   return false;
 }
 
+// loads scoreboards at startup
+// all-time counts are persisted by ClaimWorker() in the score table
+// windowed counts are rebuilt from the last month of claims in land
+void InitScores(void) {
+  int rc, k;
+  int64_t now;
+  sqlite3 *db = 0;
+  sqlite3_stmt *stmt = 0;
+  LOG("Loading scores...\n");
+  now = timespec_real().tv_sec;
+  g_board.now = now;
+  g_board.mask = 1023;
+  CHECK_MEM((g_board.hash = calloc(g_board.mask + 1, sizeof(*g_board.hash))));
+  CHECK_MEM((g_board.ring = calloc(SCORE_RING, sizeof(*g_board.ring))));
+  for (int b = 0; b < BOARDS; ++b) {
+    g_board.changed[b] = true;
+    g_board.expired[b] = (now - kBoardSecs[b]) / SCORE_BUCKET_SECS - 1;
+  }
+  CHECK_SQL(DbOpen("db.sqlite3", &db));
+  // the first time this runs, count land the old fashioned way
+  CHECK_DB(sqlite3_exec(db,
+                        "BEGIN TRANSACTION;\n"
+                        "CREATE TABLE IF NOT EXISTS score (\n"
+                        "  nick TEXT NOT NULL,\n"
+                        "  block INTEGER NOT NULL,\n"
+                        "  count INTEGER NOT NULL,\n"
+                        "  PRIMARY KEY (nick, block)\n"
+                        ");\n"
+                        "INSERT INTO score (nick, block, count)\n"
+                        "SELECT nick, ip >> 24, COUNT(*)\n"
+                        "  FROM land\n"
+                        " WHERE NOT EXISTS (SELECT 1 FROM score)\n"
+                        " GROUP BY nick, ip >> 24;\n"
+                        "COMMIT TRANSACTION",
+                        0, 0, 0));
+  CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
+  CHECK_DB(DbPrepare(db, &stmt,
+                     "SELECT nick, block, count\n"
+                     "  FROM score\n"
+                     " WHERE count > 0"));
+  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
+    if (rc != SQLITE_ROW) CHECK_DB(rc);
+    if ((k = InternNick((void *)sqlite3_column_text(stmt, 0))) == -1) {
+      goto OnError;
+    }
+    CountLand(k, sqlite3_column_int64(stmt, 1) & 255,
+              sqlite3_column_int64(stmt, 2));
+  }
+  CHECK_DB(sqlite3_finalize(stmt));
+  CHECK_DB(DbPrepare(db, &stmt,
+                     "SELECT nick, (ip >> 24), created\n"
+                     "  FROM land\n"
+                     " WHERE created NOT NULL\n"
+                     "   AND created >= ?1"));
+  CHECK_DB(sqlite3_bind_int64(stmt, 1, now - kBoardSecs[BOARDS - 1]));
+  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
+    if (rc != SQLITE_ROW) CHECK_DB(rc);
+    if ((k = InternNick((void *)sqlite3_column_text(stmt, 0))) == -1) {
+      goto OnError;
+    }
+    CountClaim(k, sqlite3_column_int64(stmt, 1),
+               sqlite3_column_int64(stmt, 2), +1);
+  }
+  CHECK_SQL(sqlite3_exec(db, "END TRANSACTION", 0, 0, 0));
+  CHECK_DB(sqlite3_finalize(stmt));
+  CHECK_SQL(sqlite3_close(db));
+  LOG("Loaded scores for %d nicks\n", g_board.n);
+  return;
+OnError:
+  exit(1);
+}
+
+void FreeScores(void) {
+  int b, i;
+  for (i = 0; i < g_board.n; ++i) {
+    for (b = 0; b < BOARDS; ++b) {
+      free(g_board.nick[i]->json[b]);
+    }
+    free(g_board.nick[i]->cell);
+    free(g_board.nick[i]->name);
+    free(g_board.nick[i]);
+  }
+  for (i = 0; i < SCORE_RING; ++i) {
+    free(g_board.ring[i].p);
+  }
+  free(g_board.ring);
+  free(g_board.order);
+  free(g_board.nick);
+  free(g_board.hash);
+  free(g_board.sb);
+}
+
 // generator function for the big board
 bool GeneratePlot(struct Asset *out, long block, long cash) {
   _Static_assert(IS2POW(XN * YN), "area must be 2-power");
@@ -1571,10 +1980,10 @@ void *ScoreWorker(void *arg) {
   pthread_setname_np(pthread_self(), "ScoreAll");
   LOG("%P Score started\n");
   long wait = SCORE_UPDATE_MS;
-  Update(&g_asset.score, GenerateScore, -1, MS2CASH(wait));
+  Update(&g_asset.score, GenerateScore, 0, MS2CASH(wait));
   nsync_counter_add(g_ready, -1);  // #1
   do {
-    Update(&g_asset.score, GenerateScore, -1, MS2CASH(wait));
+    Update(&g_asset.score, GenerateScore, 0, MS2CASH(wait));
   } while (!nsync_note_wait(g_shutdown[1], WaitFor(wait)));
   LOG("Score exiting\n");
   return 0;
@@ -1585,12 +1994,12 @@ void *ScoreHourWorker(void *arg) {
   BlockSignals();
   pthread_setname_np(pthread_self(), "ScoreHour");
   LOG("%P ScoreHour started\n");
-  long secs = 60L * 60;
+  long board = 1;
   long wait = SCORE_H_UPDATE_MS;
-  Update(&g_asset.score_hour, GenerateScore, secs, MS2CASH(wait));
+  Update(&g_asset.score_hour, GenerateScore, board, MS2CASH(wait));
   nsync_counter_add(g_ready, -1);  // #2
   do {
-    Update(&g_asset.score_hour, GenerateScore, secs, MS2CASH(wait));
+    Update(&g_asset.score_hour, GenerateScore, board, MS2CASH(wait));
   } while (!nsync_note_wait(g_shutdown[1], WaitFor(wait)));
   LOG("ScoreHour exiting\n");
   return 0;
@@ -1601,12 +2010,12 @@ void *ScoreDayWorker(void *arg) {
   BlockSignals();
   pthread_setname_np(pthread_self(), "ScoreDay");
   LOG("%P ScoreDay started\n");
-  long secs = 60L * 60 * 24;
+  long board = 2;
   long wait = SCORE_D_UPDATE_MS;
-  Update(&g_asset.score_day, GenerateScore, secs, MS2CASH(wait));
+  Update(&g_asset.score_day, GenerateScore, board, MS2CASH(wait));
   nsync_counter_add(g_ready, -1);  // #3
   do {
-    Update(&g_asset.score_day, GenerateScore, secs, MS2CASH(wait));
+    Update(&g_asset.score_day, GenerateScore, board, MS2CASH(wait));
   } while (!nsync_note_wait(g_shutdown[1], WaitFor(wait)));
   LOG("ScoreDay exiting\n");
   return 0;
@@ -1617,12 +2026,12 @@ void *ScoreWeekWorker(void *arg) {
   BlockSignals();
   pthread_setname_np(pthread_self(), "ScoreWeek");
   LOG("%P ScoreWeek started\n");
-  long secs = 60L * 60 * 24 * 7;
+  long board = 3;
   long wait = SCORE_W_UPDATE_MS;
-  Update(&g_asset.score_week, GenerateScore, secs, MS2CASH(wait));
+  Update(&g_asset.score_week, GenerateScore, board, MS2CASH(wait));
   nsync_counter_add(g_ready, -1);  // #4
   do {
-    Update(&g_asset.score_week, GenerateScore, secs, MS2CASH(wait));
+    Update(&g_asset.score_week, GenerateScore, board, MS2CASH(wait));
   } while (!nsync_note_wait(g_shutdown[1], WaitFor(wait)));
   LOG("ScoreWeek exiting\n");
   return 0;
@@ -1633,12 +2042,12 @@ void *ScoreMonthWorker(void *arg) {
   BlockSignals();
   pthread_setname_np(pthread_self(), "ScoreMonth");
   LOG("%P ScoreMonth started\n");
-  long secs = 60L * 60 * 24 * 30;
+  long board = 4;
   long wait = SCORE_M_UPDATE_MS;
-  Update(&g_asset.score_month, GenerateScore, secs, MS2CASH(wait));
+  Update(&g_asset.score_month, GenerateScore, board, MS2CASH(wait));
   nsync_counter_add(g_ready, -1);  // #5
   do {
-    Update(&g_asset.score_month, GenerateScore, secs, MS2CASH(wait));
+    Update(&g_asset.score_month, GenerateScore, board, MS2CASH(wait));
   } while (!nsync_note_wait(g_shutdown[1], WaitFor(wait)));
   LOG("ScoreMonth exiting\n");
   return 0;
@@ -1755,20 +2164,38 @@ OnError:
 
 // single thread for inserting batched claims into the database
 // this helps us avoid over 9000 threads having fcntl bloodbath
+// it also keeps the scoreboards up to date as land changes hands
 void *ClaimWorker(void *arg) {
   sqlite3 *db;
-  int i, n, rc;
+  int i, k, m, n, rc;
   long processed;
-  sqlite3_stmt *stmt;
+  int64_t oldcreated;
+  bool found, changed, moved;
+  char oldnick[NICK_MAX + 1];
+  sqlite3_stmt *stmt, *lookup, *score;
   bool warmedup = false;
   struct Claim *v = _gc(xcalloc(BATCH_MAX, sizeof(struct Claim)));
+  struct Delta {
+    char *nick;
+    int block;
+    int land;   // how owned land changed
+    int claim;  // how claims made at created changed
+    int64_t created;
+    char oldnick[NICK_MAX + 1];
+  } *d = _gc(xcalloc(BATCH_MAX * 2, sizeof(struct Delta)));
   BlockSignals();
   pthread_setname_np(pthread_self(), "ClaimWorker");
   LOG("%P ClaimWorker started\n");
 StartOver:
   db = 0;
   stmt = 0;
+  lookup = 0;
+  score = 0;
   CHECK_SQL(DbOpen("db.sqlite3", &db));
+  CHECK_DB(DbPrepare(db, &lookup,
+                     "SELECT nick, created\n"
+                     "  FROM land\n"
+                     " WHERE ip = ?1"));
   CHECK_DB(DbPrepare(db, &stmt,
                      "INSERT INTO land (ip, nick, created)\n"
                      "VALUES (?1, ?2, ?3)\n"
@@ -1777,6 +2204,11 @@ StartOver:
                      " WHERE nick != ?2\n"
                      "    OR created IS NULL\n"
                      "    OR ?3 - created > 3600"));
+  CHECK_DB(DbPrepare(db, &score,
+                     "INSERT INTO score (nick, block, count)\n"
+                     "VALUES (?1, ?2, ?3)\n"
+                     "ON CONFLICT (nick, block) DO\n"
+                     "UPDATE SET count = count + ?3"));
   if (!warmedup) {
     nsync_counter_add(g_ready, -1);  // #8
     warmedup = true;
@@ -1784,29 +2216,84 @@ StartOver:
   while ((n = GetClaims(&g_claims, v, BATCH_MAX))) {
     processed = 0;
     CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
-    for (i = 0; i < n; ++i) {
+    for (m = i = 0; i < n; ++i) {
+      // find out who owned it before, so scores can be adjusted
+      CHECK_DB(sqlite3_bind_int64(lookup, 1, v[i].ip));
+      if ((rc = DbStep(lookup)) == SQLITE_ROW) {
+        found = true;
+        strlcpy(oldnick, (void *)sqlite3_column_text(lookup, 0),
+                sizeof(oldnick));
+        oldcreated = sqlite3_column_int64(lookup, 1);
+      } else {
+        CHECK_DB(rc == SQLITE_DONE ? SQLITE_OK : rc);
+        found = false;
+        oldcreated = 0;
+      }
+      CHECK_DB(sqlite3_reset(lookup));
+      // this must be kept in sync with the on conflict clause
+      moved = !found || strcmp(oldnick, v[i].name);
+      changed = moved ||        //
+                !oldcreated ||  //
+                v[i].created - oldcreated > 3600;
       CHECK_DB(sqlite3_bind_int64(stmt, 1, v[i].ip));
       CHECK_DB(sqlite3_bind_text(stmt, 2, v[i].name, -1, SQLITE_TRANSIENT));
       CHECK_DB(sqlite3_bind_int64(stmt, 3, v[i].created));
-      CHECK_DB(sqlite3_bind_int64(stmt, 3, v[i].created));
       CHECK_DB((rc = DbStep(stmt)) == SQLITE_DONE ? SQLITE_OK : rc);
       CHECK_DB(sqlite3_reset(stmt));
       ++processed;
+      if (!changed) continue;
+      if (found) {
+        d[m].nick = strcpy(d[m].oldnick, oldnick);
+        d[m].block = v[i].ip >> 24;
+        d[m].land = moved ? -1 : 0;
+        d[m].claim = oldcreated ? -1 : 0;
+        d[m].created = oldcreated;
+        ++m;
+      }
+      d[m].nick = v[i].name;
+      d[m].block = v[i].ip >> 24;
+      d[m].land = moved ? +1 : 0;
+      d[m].claim = +1;
+      d[m].created = v[i].created;
+      ++m;
+    }
+    for (i = 0; i < m; ++i) {
+      if (!d[i].land) continue;
+      CHECK_DB(sqlite3_bind_text(score, 1, d[i].nick, -1, SQLITE_TRANSIENT));
+      CHECK_DB(sqlite3_bind_int64(score, 2, d[i].block));
+      CHECK_DB(sqlite3_bind_int64(score, 3, d[i].land));
+      CHECK_DB((rc = DbStep(score)) == SQLITE_DONE ? SQLITE_OK : rc);
+      CHECK_DB(sqlite3_reset(score));
     }
     CHECK_SQL(sqlite3_exec(db, "COMMIT TRANSACTION", 0, 0, 0));
     atomic_fetch_add(&g_claimsprocessed, processed);
     DEBUG("Committed %d claims\n", n);
+    // update scoreboards
+    //!//!//!//!//!//!//!//!//!//!//!//!//!/
+    nsync_mu_lock(&g_board.mu);
+    ExpireScores(timespec_real().tv_sec);
+    for (i = 0; i < m; ++i) {
+      if ((k = InternNick(d[i].nick)) == -1) continue;
+      if (d[i].land) CountLand(k, d[i].block, d[i].land);
+      if (d[i].claim) CountClaim(k, d[i].block, d[i].created, d[i].claim);
+    }
+    nsync_mu_unlock(&g_board.mu);
+    //!//!//!//!//!//!//!//!//!//!//!//!//!/
     // wake up RecentWorker()
     nsync_mu_lock(&g_recent.mu);
     nsync_cv_signal(&g_recent.cv);
     nsync_mu_unlock(&g_recent.mu);
   }
+  CHECK_DB(sqlite3_finalize(score));
   CHECK_DB(sqlite3_finalize(stmt));
+  CHECK_DB(sqlite3_finalize(lookup));
   CHECK_SQL(sqlite3_close(db));
   LOG("ClaimWorker exiting\n");
   return 0;
 OnError:
+  sqlite3_finalize(score);
   sqlite3_finalize(stmt);
+  sqlite3_finalize(lookup);
   sqlite3_close(db);
   goto StartOver;
 }
@@ -1847,35 +2334,23 @@ void *ReplenishWorker(void *arg) {
   return 0;
 }
 
-// we're permissive in allowing http connection keepalive until the
-// moment worker resources start becoming scarce. when that happens
-// we'll (1) cancel read operations that have not sent us a message
-// in a while; (2) cancel clients who are sending lots of messages.
+// once too many connection slots are in use, reactors are asked to
+// shorten keepalive and shed chatty clients, see ExpireClients()
 void Meltdown(void) {
-  int i, marks;
-  struct timespec now;
   ++g_meltdowns;
-  LOG("Panicking because %d out of %d workers is connected\n", g_connections,
-      g_workers);
-  now = timespec_real();
-  for (marks = i = 0; i < g_workers; ++i) {
-    if (g_worker[i].connected &&
-        (g_worker[i].msgcount > PANIC_MSGS ||
-         timespec_cmp(timespec_sub(now, g_worker[i].startread),
-                      timespec_frommillis(MELTALIVE_MS)) >= 0)) {
-      pthread_kill(g_worker[i].th, SIGUSR1);
-      ++marks;
-    }
-  }
-  LOG("Melted down %d connections\n", marks);
+  LOG("Panicking because %d out of %d connections are in use\n",
+      g_connections, g_maxconns);
+  g_meltdown = true;
 }
 
 // main thread worker
 void *Supervisor(void *arg) {
   for (;;) {
     if (!nsync_note_wait(g_shutdown[0], WaitFor(SUPERVISE_MS))) {
-      if (g_workers > 1 && 1. / g_workers * g_connections > PANIC_LOAD) {
+      if (1. / g_maxconns * g_connections > PANIC_LOAD) {
         Meltdown();
+      } else {
+        g_meltdown = false;
       }
       ReloadAsset(&g_asset.index);
       ReloadAsset(&g_asset.about);
@@ -1911,14 +2386,25 @@ int main(int argc, char *argv[]) {
     system("sudo sh -c 'echo 3 >/proc/sys/net/ipv4/tcp_fastopen'");
   }
 
-  // we don't have proper futexes on these platforms
-  // we'll be somewhat less aggressive about workers
-  if (IsXnu() || IsNetbsd()) {
-    g_workers = MIN(g_workers, (unsigned)__get_cpu_count());
-  }
-
   // user interface
   GetOpts(argc, argv);
+  if (g_workers <= 0) {
+    g_workers = MIN(__get_cpu_count(), CPUS);
+  }
+
+  // each client connection needs a file descriptor
+  struct rlimit rl;
+  if (!getrlimit(RLIMIT_NOFILE, &rl)) {
+    if (rl.rlim_cur < g_maxconns + FDS_SPARE) {
+      rl.rlim_cur = MIN(rl.rlim_max, g_maxconns + FDS_SPARE);
+      setrlimit(RLIMIT_NOFILE, &rl);
+      getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    if (rl.rlim_cur < g_maxconns + FDS_SPARE) {
+      g_maxconns = MAX(1, (long)rl.rlim_cur - FDS_SPARE);
+      LOG("RLIMIT_NOFILE limits us to %d connections\n", g_maxconns);
+    }
+  }
   kprintf("\
  |               _|                    \n\
  __| |   |  __| | \\ \\  \\   / _` |  __|\n\
@@ -1960,6 +2446,7 @@ int main(int argc, char *argv[]) {
   // library init
   sqlite3_initialize();
   CheckDatabase();
+  InitScores();
 
   // fill token buckets
   g_tok.b = malloc(TB_BYTES);
@@ -1994,8 +2481,6 @@ int main(int argc, char *argv[]) {
   sigaction(SIGHUP, &sa, 0);
   sigaction(SIGINT, &sa, 0);
   sigaction(SIGTERM, &sa, 0);
-  sa.sa_handler = IgnoreSignal;
-  sigaction(SIGUSR1, &sa, 0);
 
   // make 9 helper threads
   g_ready = nsync_counter_new(10);
@@ -2017,13 +2502,25 @@ int main(int argc, char *argv[]) {
     nsync_counter_wait(g_ready, nsync_time_no_deadline);
   }
 
-  // create one thread to listen
-  CHECK_EQ(0, pthread_create(&g_listener, 0, ListenWorker, 0));
+  // create one socket to listen
+  g_server = Listen();
 
-  // create lots of http workers to serve those assets
+  // create one http reactor per cpu to serve those assets
+  // the kernel wakes only one of them for each new connection
   LOG("Online\n");
   g_worker = xcalloc(g_workers, sizeof(*g_worker));
   for (intptr_t i = 0; i < g_workers; ++i) {
+    struct epoll_event ev = {EPOLLIN | EPOLLEXCLUSIVE, {.ptr = 0}};
+    CHECK_NE(-1, (g_worker[i].epfd = epoll_create1(EPOLL_CLOEXEC)));
+    if (epoll_ctl(g_worker[i].epfd, EPOLL_CTL_ADD, g_server, &ev) == -1) {
+      CHECK_EQ(EINVAL, errno);  // EPOLLEXCLUSIVE needs linux 4.5+
+      ev.events = EPOLLIN;
+      CHECK_NE(-1, epoll_ctl(g_worker[i].epfd, EPOLL_CTL_ADD, g_server, &ev));
+    }
+    g_worker[i].inbuf = NewSafeBuffer(INBUF_SIZE);
+    g_worker[i].outbuf = NewSafeBuffer(OUTBUF_SIZE);
+    g_worker[i].msgbuf = xmalloc(MSG_BUF);
+    g_worker[i].msg = xcalloc(1, sizeof(struct HttpMessage));
     CHECK_EQ(0, pthread_create(&g_worker[i].th, 0, HttpWorker, (void *)i));
   }
 
@@ -2031,22 +2528,22 @@ int main(int argc, char *argv[]) {
   LOG("Ready\n");
   Supervisor(0);
 
-  // cancel listen() so we stop accepting new clients
-  LOG("Interrupting listen...\n");
-  pthread_kill(g_listener, SIGUSR1);
-  pthread_join(g_listener, 0);
-
-  // cancel read() so that keepalive clients finish faster
+  // tell reactors to hang up on their clients and exit
   LOG("Interrupting workers...\n");
-  for (int i = 0; i < g_workers; ++i) {
-    pthread_kill(g_worker[i].th, SIGUSR1);
-  }
+  nsync_note_notify(g_shutdown[1]);
 
   // wait for producers to finish
   LOG("Waiting for workers to finish...\n");
   for (int i = 0; i < g_workers; ++i) {
     CHECK_EQ(0, pthread_join(g_worker[i].th, 0));
+    DestroyHttpMessage(g_worker[i].msg);
+    FreeSafeBuffer(g_worker[i].outbuf);
+    FreeSafeBuffer(g_worker[i].inbuf);
+    free(g_worker[i].msgbuf);
+    free(g_worker[i].msg);
+    close(g_worker[i].epfd);
   }
+  close(g_server);
   LOG("Waiting for helpers to finish...\n");
   CHECK_EQ(0, pthread_join(nower, 0));
   CHECK_EQ(0, pthread_join(scorer, 0));
@@ -2085,6 +2582,7 @@ int main(int argc, char *argv[]) {
     nsync_note_free(g_shutdown[i]);
   }
   nsync_counter_free(g_ready);
+  FreeScores();
   free(g_worker);
   free(g_tok.b);
 
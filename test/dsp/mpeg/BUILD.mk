@@ -0,0 +1,53 @@
+#-*-mode:makefile-gmake;indent-tabs-mode:t;tab-width:8;coding:utf-8-*-┐
+#── vi: set et ft=make ts=8 sw=8 fenc=utf-8 :vi ──────────────────────┘
+
+PKGS += TEST_DSP_MPEG
+
+TEST_DSP_MPEG_SRCS := $(wildcard test/dsp/mpeg/*.c)
+TEST_DSP_MPEG_SRCS_TEST = $(filter %_test.c,$(TEST_DSP_MPEG_SRCS))
+TEST_DSP_MPEG_BINS = $(TEST_DSP_MPEG_COMS) $(TEST_DSP_MPEG_COMS:%=%.dbg)
+
+TEST_DSP_MPEG_OBJS =					\
+	$(TEST_DSP_MPEG_SRCS:%.c=o/$(MODE)/%.o)
+
+TEST_DSP_MPEG_COMS =					\
+	$(TEST_DSP_MPEG_SRCS:%.c=o/$(MODE)/%.com)
+
+TEST_DSP_MPEG_TESTS =					\
+	$(TEST_DSP_MPEG_SRCS_TEST:%.c=o/$(MODE)/%.com.ok)
+
+TEST_DSP_MPEG_CHECKS =					\
+	$(TEST_DSP_MPEG_SRCS_TEST:%.c=o/$(MODE)/%.com.runs)
+
+TEST_DSP_MPEG_DIRECTDEPS =				\
+	DSP_MPEG					\
+	LIBC_CALLS					\
+	LIBC_INTRIN					\
+	LIBC_MEM					\
+	LIBC_NEXGEN32E					\
+	LIBC_RUNTIME					\
+	LIBC_STDIO					\
+	LIBC_STR					\
+	LIBC_TESTLIB					\
+	LIBC_THREAD
+
+TEST_DSP_MPEG_DEPS :=					\
+	$(call uniq,$(foreach x,$(TEST_DSP_MPEG_DIRECTDEPS),$($(x))))
+
+o/$(MODE)/test/dsp/mpeg/mpeg.pkg:			\
+		$(TEST_DSP_MPEG_OBJS)			\
+		$(foreach x,$(TEST_DSP_MPEG_DIRECTDEPS),$($(x)_A).pkg)
+
+o/$(MODE)/test/dsp/mpeg/%.com.dbg:			\
+		$(TEST_DSP_MPEG_DEPS)			\
+		o/$(MODE)/test/dsp/mpeg/%.o		\
+		o/$(MODE)/test/dsp/mpeg/mpeg.pkg	\
+		$(LIBC_TESTMAIN)			\
+		$(CRT)					\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
+.PHONY: o/$(MODE)/test/dsp/mpeg
+o/$(MODE)/test/dsp/mpeg:				\
+		$(TEST_DSP_MPEG_BINS)			\
+		$(TEST_DSP_MPEG_CHECKS)
@@ -0,0 +1,179 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/idct.h"
+#include "dsp/mpeg/mpeg.h"
+#include "dsp/mpeg/rgb.internal.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+#define MACROBLOCKS_1080P (120 * 68)  // 1920x1088 in 16x16 pieces
+#define BLOCKS_1080P      (MACROBLOCKS_1080P * 6)
+
+int blocks[64][64];
+
+// coefficients are sparse and scaled by the premultiplier matrix
+void RandomBlock(int b[64]) {
+  int i;
+  for (i = 0; i < 64; ++i) {
+    if (!(rand() & 7)) {
+      b[i] = (rand() % 4096 - 2048) * (rand() % 63);
+    } else {
+      b[i] = 0;
+    }
+  }
+  b[0] = (rand() % 4096 - 2048) * 32;
+}
+
+void CheckIdct(void idct(int *)) {
+  int i, a[64], b[64];
+  for (i = 0; i < 10000; ++i) {
+    RandomBlock(a);
+    memcpy(b, a, sizeof(a));
+    plm_video_idct_k8(a);
+    idct(b);
+    ASSERT_EQ(0, memcmp(a, b, sizeof(a)));
+  }
+}
+
+plm_frame_t *NewFrame(int width, int height) {
+  plm_frame_t *f;
+  int w = (width + 15) & -16;
+  int h = (height + 15) & -16;
+  f = gc(calloc(1, sizeof(plm_frame_t)));
+  f->width = width;
+  f->height = height;
+  f->y.width = w;
+  f->y.height = h;
+  f->cr.width = f->cb.width = w >> 1;
+  f->cr.height = f->cb.height = h >> 1;
+  f->y.data = rngset(gc(malloc(w * h)), w * h, 0, 0);
+  f->cr.data = rngset(gc(malloc(w * h / 4)), w * h / 4, 0, 0);
+  f->cb.data = rngset(gc(malloc(w * h / 4)), w * h / 4, 0, 0);
+  return f;
+}
+
+void CheckRgb(plm_rows_to_rgb_f *kernel) {
+  size_t n;
+  int i, j;
+  plm_frame_t *f;
+  uint8_t *a, *b;
+  static const int kSizes[][2] = {
+      {1920, 1080}, {352, 240}, {50, 6}, {34, 34}, {66, 20}, {2, 2},
+  };
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    for (j = 0; j < 3; ++j) {
+      f = NewFrame(kSizes[i][0], kSizes[i][1]);
+      n = f->width * f->height * 3;
+      a = gc(malloc(n));
+      b = gc(malloc(n));
+      memset(a, 1, n);
+      memset(b, 2, n);
+      plm_frame_to_rgb_with(f, a, 0);
+      plm_frame_to_rgb_with(f, b, kernel);
+      ASSERT_EQ(0, memcmp(a, b, n));
+    }
+  }
+}
+
+TEST(plm_video_idct, test) {
+  CheckIdct(plm_video_idct);
+}
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+TEST(plm_video_idct_avx2, test) {
+  if (!X86_HAVE(AVX2)) return;
+  CheckIdct(plm_video_idct_avx2);
+}
+
+TEST(plm_video_idct_sse2, test) {
+  CheckIdct(plm_video_idct_sse2);
+}
+
+TEST(plm_rows_to_rgb_avx2, test) {
+  if (!X86_HAVE(AVX2)) return;
+  CheckRgb(plm_rows_to_rgb_avx2);
+}
+
+TEST(plm_rows_to_rgb_ssse3, test) {
+  if (!X86_HAVE(SSSE3)) return;
+  CheckRgb(plm_rows_to_rgb_ssse3);
+}
+
+#endif /* __x86_64__ */
+
+void IdctFrame(void idct(int *)) {
+  int i;
+  for (i = 0; i < BLOCKS_1080P; ++i) {
+    idct(blocks[i & 63]);
+  }
+}
+
+void ReportFramesPerSecond(const char *name, void idct(int *),
+                           plm_rows_to_rgb_f *kernel) {
+  long n;
+  uint8_t *rgb;
+  plm_frame_t *f;
+  struct timespec t, d;
+  f = NewFrame(1920, 1080);
+  rgb = gc(malloc(1920 * 1080 * 3));
+  t = timespec_mono();
+  n = 0;
+  do {
+    IdctFrame(idct);
+    plm_frame_to_rgb_with(f, rgb, kernel);
+    ++n;
+  } while (timespec_tomicros((d = timespec_sub(timespec_mono(), t))) < 500000);
+  printf(" *     %-19s %8.1f frames/sec (1080p idct+rgb)\n", name,
+         n / (timespec_tonanos(d) * 1e-9));
+}
+
+BENCH(plm_video_idct, bench) {
+  int i, b[64];
+  for (i = 0; i < 64; ++i) RandomBlock(blocks[i]);
+  printf("\n");
+  EZBENCH2("plm_video_idct_k8", memcpy(b, blocks[0], sizeof(b)),
+           plm_video_idct_k8(b));
+#if defined(__x86_64__) && !defined(__chibicc__)
+  EZBENCH2("plm_video_idct_sse2", memcpy(b, blocks[0], sizeof(b)),
+           plm_video_idct_sse2(b));
+  if (X86_HAVE(AVX2)) {
+    EZBENCH2("plm_video_idct_avx2", memcpy(b, blocks[0], sizeof(b)),
+             plm_video_idct_avx2(b));
+  }
+#endif
+  ReportFramesPerSecond("k8", plm_video_idct_k8, 0);
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(SSSE3)) {
+    ReportFramesPerSecond("sse2+ssse3", plm_video_idct_sse2,
+                          plm_rows_to_rgb_ssse3);
+  }
+  if (X86_HAVE(AVX2)) {
+    ReportFramesPerSecond("avx2", plm_video_idct_avx2, plm_rows_to_rgb_avx2);
+  }
+#endif
+}
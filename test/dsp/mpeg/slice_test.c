@@ -0,0 +1,149 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/mpeg.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/forkjoin.h"
+
+// writes a tiny intra-only mpeg-1 video elementary stream
+
+unsigned char stream[65536];
+size_t bits;
+unsigned seed;
+
+unsigned Rand(void) {
+  return (seed = seed * 1103515245 + 12345) >> 16;
+}
+
+void Put(unsigned v, int n) {
+  while (n--) {
+    if ((v >> n) & 1) stream[bits >> 3] |= 0x80 >> (bits & 7);
+    ++bits;
+  }
+}
+
+void StartCode(int c) {
+  bits = (bits + 7) & -8;
+  Put(0x000001, 24);
+  Put(c, 8);
+}
+
+void Macroblock(int increment) {
+  int i;
+  static const char *kIncrement[] = {
+      0, "1", "011", "010", "0011", "0010", "00011", "00010", "0000111",
+  };
+  for (i = 0; kIncrement[increment][i]; ++i) {
+    Put(kIncrement[increment][i] - '0', 1);
+  }
+  Put(1, 1);  // intra
+  for (i = 0; i < 6; ++i) {
+    if (i < 4) {
+      Put(1, 2);  // luma dc size 2
+      Put(Rand() & 3, 2);
+    } else {
+      Put(1, 2);  // chroma dc size 1
+      Put(Rand() & 1, 1);
+    }
+    Put(2, 2);  // end of block
+  }
+}
+
+// splits rows into two slices if `split`
+size_t MakeStream(int width, int height, int frames, bool split) {
+  int f, y, x, cut, mbw, mbh;
+  bzero(stream, sizeof(stream));
+  bits = 0;
+  mbw = (width + 15) / 16;
+  mbh = (height + 15) / 16;
+  StartCode(0xB3);
+  Put(width, 12);
+  Put(height, 12);
+  Put(1, 4);  // aspect
+  Put(3, 4);  // 25 fps
+  Put(0x3ffff, 18);
+  Put(1, 1);
+  Put(20, 10);
+  Put(0, 3);
+  for (f = 0; f < frames; ++f) {
+    StartCode(0x00);
+    Put(f, 10);
+    Put(1, 3);  // intra picture
+    Put(0xffff, 16);
+    Put(0, 1);
+    for (y = 0; y < mbh; ++y) {
+      cut = split ? 1 + Rand() % (mbw - 1) : mbw;
+      StartCode(y + 1);
+      Put(8 + (Rand() & 7), 5);
+      Put(0, 1);
+      for (x = 0; x < cut; ++x) Macroblock(1);
+      if (cut < mbw) {
+        StartCode(y + 1);
+        Put(8, 5);
+        Put(0, 1);
+        Macroblock(cut + 1);
+        for (x = cut + 1; x < mbw; ++x) Macroblock(1);
+      }
+    }
+  }
+  StartCode(0xB7);
+  Put(0, 32);
+  return bits >> 3;
+}
+
+// decodes all frames and returns their planes concatenated
+char *Decode(size_t n, bool threaded) {
+  char *p, *q;
+  plm_frame_t *f;
+  plm_video_t *v;
+  v = plm_video_create_with_buffer(
+      plm_buffer_create_with_memory(stream, n, false), true);
+  plm_video_set_no_delay(v, true);
+  plm_video_set_slice_threading(v, threaded);
+  p = q = gc(calloc(1, 65536));
+  while ((f = plm_video_decode(v))) {
+    q = mempcpy(q, f->y.data, f->y.width * f->y.height);
+    q = mempcpy(q, f->cb.data, f->cb.width * f->cb.height);
+    q = mempcpy(q, f->cr.data, f->cr.width * f->cr.height);
+  }
+  plm_video_destroy(v);
+  return p;
+}
+
+void SetUp(void) {
+  forkjoin_setconcurrency(4);
+}
+
+void TearDownOnce(void) {
+  forkjoin_shutdown();
+}
+
+TEST(plm_video_set_slice_threading, decodesSameAsSerial) {
+  size_t n;
+  int i, w, h;
+  for (i = 0; i < 20; ++i) {
+    w = 16 * (2 + i % 7);
+    h = 16 * (1 + i % 5);
+    seed = i;
+    n = MakeStream(w, h, 3, i & 1);
+    ASSERT_EQ(0, memcmp(Decode(n, false), Decode(n, true), 65536));
+  }
+}
@@ -30,6 +30,7 @@ TEST_DSP_SCALE_DIRECTDEPS =				\
 	LIBC_RUNTIME					\
 	LIBC_STDIO					\
 	LIBC_STR					\
+	LIBC_THREAD					\
 	LIBC_TINYMATH					\
 	LIBC_X						\
 	TOOL_VIZ_LIB					\
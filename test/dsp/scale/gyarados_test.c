@@ -0,0 +1,126 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/scale/gyarados.internal.h"
+#include "dsp/scale/scale.h"
+#include "libc/macros.internal.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/forkjoin.h"
+
+void TearDownOnce(void) {
+  forkjoin_shutdown();
+  FreeGyaradosCache();
+}
+
+unsigned char *Scale(int threads, long dyn, long dxn, long syn, long sxn,
+                     const unsigned char *src) {
+  unsigned char *dst;
+  forkjoin_setconcurrency(threads);
+  dst = gc(malloc(3 * dyn * dxn));
+  EzGyarados(3, dyn, dxn, dst, 3, syn, sxn, src, 0, 3, dyn, dxn, syn, sxn, 0,
+             0, 0, 0);
+  return dst;
+}
+
+TEST(GyaradosVerticalAvx2, test) {
+  int i, n, k;
+  short y[12], w[12];
+  int s[12][61], a[61], b[61];
+  if (!X86_HAVE(AVX2)) return;
+  for (i = 0; i < 1000; ++i) {
+    n = 1 + rand() % 61;
+    k = 1 + rand() % 12;
+    for (int j = 0; j < k; ++j) {
+      y[j] = rand() % 12;
+      w[j] = rand() % 8192;
+    }
+    for (int j = 0; j < 12 * 61; ++j) {
+      s[j / 61][j % 61] = rand() % 32768;
+    }
+    GyaradosVertical(a, n, *s, 61, y, w, k);
+    GyaradosVerticalAvx2(b, n, *s, 61, y, w, k);
+    ASSERT_EQ(0, memcmp(a, b, n * sizeof(int)));
+  }
+}
+
+TEST(GyaradosHorizontalAvx2, test) {
+  int i, j, n, w, p[128], first[40], t[40 * 16], a[40], b[40];
+  if (!X86_HAVE(AVX2)) return;
+  for (i = 0; i < 1000; ++i) {
+    n = 1 + rand() % 40;
+    w = 4 * (1 + rand() % 4);
+    for (j = 0; j < n; ++j) first[j] = rand() % (128 - w);
+    for (j = 0; j < n * w; ++j) t[j] = rand() % 8192 - 512;
+    for (j = 0; j < 128; ++j) p[j] = rand() % 32768;
+    GyaradosHorizontal(a, n, p, first, t, w);
+    GyaradosHorizontalAvx2(b, n, p, first, t, w);
+    ASSERT_EQ(0, memcmp(a, b, n * sizeof(int)));
+  }
+}
+
+TEST(GyaradosUint8, inPlace_isSameAsOutOfPlace) {
+  long y, syn = 37, sxn = 53, dyn = 71, dxn = 29;
+  unsigned char(*a)[71][53] = gc(malloc(71 * 53));
+  unsigned char(*b)[71][53] = gc(malloc(71 * 53));
+  struct SamplingSolution *cy = ComputeSamplingSolution(dyn, syn, 0, 0, 1);
+  struct SamplingSolution *cx = ComputeSamplingSolution(dxn, sxn, 0, 0, 1);
+  rngset(a, 71 * 53, 0, 0);
+  GyaradosUint8(71, 53, *b, 71, 53, *a, dyn, dxn, syn, sxn, 0, 255, cy, cx,
+                true);
+  GyaradosUint8(71, 53, *a, 71, 53, *a, dyn, dxn, syn, sxn, 0, 255, cy, cx,
+                true);
+  FreeSamplingSolution(cx);
+  FreeSamplingSolution(cy);
+  for (y = 0; y < dyn; ++y) {
+    ASSERT_EQ(0, memcmp((*a)[y], (*b)[y], dxn));
+  }
+}
+
+TEST(EzGyarados, threads_produceSameOutputAsSerial) {
+  unsigned char *src = rngset(gc(malloc(3 * 400 * 600)), 3 * 400 * 600, 0, 0);
+  ASSERT_EQ(0, memcmp(Scale(1, 150, 250, 400, 600, src),
+                      Scale(4, 150, 250, 400, 600, src), 3 * 150 * 250));
+  ASSERT_EQ(0, memcmp(Scale(1, 300, 480, 100, 160, src),
+                      Scale(4, 300, 480, 100, 160, src), 3 * 300 * 480));
+}
+
+BENCH(EzGyarados, bench) {
+  unsigned char *src, *dst;
+  src = rngset(gc(malloc(3 * 1080 * 1920)), 3 * 1080 * 1920, 0, 0);
+  dst = gc(malloc(3 * 720 * 960));
+  forkjoin_setconcurrency(1);
+  EZBENCH2("1080p → 160x120", donothing,
+           EzGyarados(3, 120, 160, dst, 3, 1080, 1920, src, 0, 3, 120, 160,
+                      1080, 1920, 0, 0, 0, 0));
+  EZBENCH2("1080p → 480x270", donothing,
+           EzGyarados(3, 270, 480, dst, 3, 1080, 1920, src, 0, 3, 270, 480,
+                      1080, 1920, 0, 0, 0, 0));
+  EZBENCH2("320x240 → 960x720", donothing,
+           EzGyarados(3, 720, 960, dst, 3, 240, 320, src, 0, 3, 720, 960, 240,
+                      320, 0, 0, 0, 0));
+  forkjoin_setconcurrency(0);
+  EZBENCH2("1080p → 480x270 mt", donothing,
+           EzGyarados(3, 270, 480, dst, 3, 1080, 1920, src, 0, 3, 270, 480,
+                      1080, 1920, 0, 0, 0, 0));
+}
@@ -34,6 +34,10 @@
 
 short *bingblit(int ys, int xs, unsigned char[ys][xs], int, int);
 
+void TearDownOnce(void) {
+  FreeGyaradosCache();
+}
+
 void *AbsoluteDifference(int yn, int xn, unsigned char C[yn][xn], int ays,
                          int axs, const unsigned char A[ays][axs], int bys,
                          int bxs, const unsigned char B[bys][bxs]) {
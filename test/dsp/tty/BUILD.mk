@@ -21,6 +21,7 @@ TEST_DSP_TTY_CHECKS =					\
 
 TEST_DSP_TTY_DIRECTDEPS =				\
 	DSP_TTY						\
+	LIBC_CALLS					\
 	LIBC_INTRIN					\
 	LIBC_LOG					\
 	LIBC_MEM					\
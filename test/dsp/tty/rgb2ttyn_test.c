@@ -0,0 +1,80 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/quant.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+uint8_t R[256 * 256], G[256 * 256], B[256 * 256];
+struct TtyRgb P[256 * 256];
+
+// checks every color whose blue is a multiple of three
+void CheckQuantizer(void) {
+  int r, g, b, i, n;
+  struct TtyRgb want;
+  for (r = 0; r < 256; ++r) {
+    for (n = g = 0; g < 256; ++g) {
+      for (b = 0; b < 256; b += 3, ++n) {
+        R[n] = r;
+        G[n] = g;
+        B[n] = b;
+      }
+    }
+    n -= r & 3;
+    rgb2ttyn(P, R, G, B, n);
+    for (i = 0; i < n; ++i) {
+      want = rgb2tty(R[i], G[i], B[i]);
+      ASSERT_EQ(0, memcmp(&want, &P[i], sizeof(want)));
+    }
+  }
+}
+
+TEST(rgb2ttyn, ansi) {
+  ttyquantsetup(kTtyQuantAnsi, kTtyQuantRgb, kTtyBlocksUnicode);
+  CheckQuantizer();
+}
+
+TEST(rgb2ttyn, xterm256) {
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+  CheckQuantizer();
+}
+
+TEST(rgb2ttyn, true) {
+  ttyquantsetup(kTtyQuantTrue, kTtyQuantRgb, kTtyBlocksUnicode);
+  CheckQuantizer();
+}
+
+void QuantizeEach(void) {
+  int i;
+  for (i = 0; i < 1024; ++i) {
+    P[i] = rgb2tty(R[i], G[i], B[i]);
+  }
+}
+
+BENCH(rgb2ttyn, bench) {
+  int i;
+  for (i = 0; i < 1024; ++i) {
+    R[i] = i * 7;
+    G[i] = i * 13;
+    B[i] = i * 29;
+  }
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+  EZBENCH2("rgb2tty xterm256", donothing, QuantizeEach());
+  EZBENCH2("rgb2ttyn xterm256", donothing, rgb2ttyn(P, R, G, B, 1024));
+}
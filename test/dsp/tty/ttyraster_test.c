@@ -16,7 +16,14 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/internal.h"
 #include "dsp/tty/quant.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 #include "net/http/csscolor.h"
@@ -130,6 +137,113 @@ TEST(ttyraster_xterm256, testCornerRepeat3) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+void RandomCells(struct TtyRgb t[4]) {
+  for (int i = 0; i < 4; ++i) {
+    t[i] = (struct TtyRgb){rand(), rand(), rand(), rand()};
+  }
+}
+
+void CheckPicks(void ttypicks(uint16_t *, const uint16_t[4][4],
+                              const uint8_t *, size_t)) {
+  uint8_t c[4][96];
+  uint16_t d[4][4], a[96], b[96];
+  for (int n = 0; n < 1000; ++n) {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) d[i][j] = rand() % 766;
+      for (int k = 0; k < 96; ++k) c[i][k] = rand() & 3;
+    }
+    ttypicks_k8(a, d, c[0], 96);
+    ttypicks(b, d, c[0], 96);
+    ASSERT_EQ(0, memcmp(a, b, sizeof(a)));
+  }
+}
+
+void CheckMix(void ttymix(uint16_t[32], const struct TtyRgb[4],
+                          const struct TtyRgb[4], const struct TtyMix *)) {
+  struct TtyMix m;
+  uint16_t a[32], b[32];
+  struct TtyRgb t[4], q[4];
+  for (int n = 0; n < 1000; ++n) {
+    RandomCells(t);
+    RandomCells(q);
+    for (int k = 0; k < 32; ++k) {
+      m.from[k] = rand() & 3;
+      m.to[k] = rand() & 3;
+      m.ratio[k] = rand();
+    }
+    ttymix_k8(a, t, q, &m);
+    ttymix(b, t, q, &m);
+    ASSERT_EQ(0, memcmp(a, b, sizeof(a)));
+  }
+}
+
+TEST(ttypicks_ssse3, test) {
+  if (!X86_HAVE(SSSE3)) return;
+  CheckPicks(ttypicks_ssse3);
+  CheckMix(ttymix_ssse3);
+}
+
+TEST(ttypicks_avx2, test) {
+  if (!X86_HAVE(AVX2)) return;
+  CheckPicks(ttypicks_avx2);
+  CheckMix(ttymix_avx2);
+}
+
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////
+
+// smooth gradients with some noise, since runs are cheaper than detail
+void RenderTestCard(uint8_t *rgb[3], int yn, int xn) {
+  for (int y = 0; y < yn; ++y) {
+    for (int x = 0; x < xn; ++x) {
+      rgb[0][y * xn + x] = x * 255 / xn;
+      rgb[1][y * xn + x] = y * 255 / yn;
+      rgb[2][y * xn + x] = (x + y) % 64 * 4 + (rand() & 3);
+    }
+  }
+}
+
+void ReportFramesPerSecond(const char *name, int cols, int rows) {
+  long n;
+  char *vt;
+  uint8_t *rgb[3];
+  struct TtyRgb *tty;
+  struct timespec t, d;
+  int i, y, yn = rows * 2, xn = cols * 2;
+  vt = malloc(yn * xn * 16 + yn * 64);
+  tty = malloc(yn * xn * sizeof(*tty));
+  for (i = 0; i < 3; ++i) rgb[i] = malloc(yn * xn);
+  RenderTestCard(rgb, yn, xn);
+  t = timespec_mono();
+  n = 0;
+  do {
+    for (y = 0; y < yn; ++y) {
+      rgb2ttyn(tty + y * xn, rgb[0] + y * xn, rgb[1] + y * xn,
+               rgb[2] + y * xn, xn);
+    }
+    ttyraster(vt, tty, yn, xn, kBlack, kBlack);
+    ++n;
+  } while (timespec_tomicros((d = timespec_sub(timespec_mono(), t))) < 500000);
+  printf(" *     %-9s %3dx%-3d %8.1f frames/sec\n", name, cols, rows,
+         n / (timespec_tonanos(d) * 1e-9));
+  for (i = 0; i < 3; ++i) free(rgb[i]);
+  free(tty);
+  free(vt);
+}
+
+BENCH(ttyraster, frames) {
+  printf("\n");
+  ttyraster_true_setup();
+  ReportFramesPerSecond("true", 80, 24);
+  ReportFramesPerSecond("true", 400, 120);
+  ttyraster_xterm256_setup();
+  ReportFramesPerSecond("xterm256", 80, 24);
+  ReportFramesPerSecond("xterm256", 400, 120);
+}
+
 BENCH(ttyraster_true, bench) {
   ttyraster_true_setup();
   EZBENCH(donothing, ttyraster2x2_true());
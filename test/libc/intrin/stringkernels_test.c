@@ -0,0 +1,166 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/macros.internal.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+// exercises the avx2 / avx512 / erms / non-temporal tiers of the
+// string kernels at the sizes where they switch over
+
+#define kMax  (8 * 1024 * 1024)
+#define SLACK 128
+
+static const size_t kSizes[] = {
+    0,    1,    15,   16,   31,   32,   33,   63,   64,   65,   95,
+    96,   97,   127,  128,  129,  255,  256,  899,  900,  1023, 4095,
+    4096, 4097, 8191, 65537, 1048577, 2097153, 4194305, kMax - SLACK,
+};
+
+static const size_t kAligns[] = {0, 1, 15, 17, 31, 33, 63};
+
+static char *a, *b, *c;
+
+void SetUp(void) {
+  size_t i;
+  a = malloc(kMax + SLACK);
+  b = malloc(kMax + SLACK);
+  c = malloc(kMax + SLACK);
+  for (i = 0; i < kMax + SLACK; ++i) {
+    a[i] = 'A' + lemur64() % 26;
+  }
+}
+
+void TearDown(void) {
+  free(c);
+  free(b);
+  free(a);
+}
+
+static void *golden_memchr(const void *s, int c, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    if (((const unsigned char *)s)[i] == (c & 255)) {
+      return (void *)((const char *)s + i);
+    }
+  }
+  return 0;
+}
+
+TEST(memchr, tiers) {
+  size_t i, j, k, n;
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    for (j = 0; j < ARRAYLEN(kAligns); ++j) {
+      n = kSizes[i];
+      ASSERT_EQ(NULL, memchr(a + kAligns[j], 0, n));
+      if (!n) continue;
+      k = kAligns[j] + lemur64() % n;
+      a[k] = 0;
+      ASSERT_EQ(golden_memchr(a + kAligns[j], 0, n),
+                memchr(a + kAligns[j], 0, n), "n=%zu k=%zu", n, k);
+      a[k] = 'A';
+    }
+  }
+}
+
+TEST(strlen, tiers) {
+  size_t i, j, n;
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    for (j = 0; j < ARRAYLEN(kAligns); ++j) {
+      n = kSizes[i];
+      a[kAligns[j] + n] = 0;
+      ASSERT_EQ(n, strlen(a + kAligns[j]));
+      ASSERT_EQ(a + kAligns[j] + n, strchr(a + kAligns[j], 0));
+      ASSERT_EQ(golden_memchr(a + kAligns[j], 'Z', n),
+                strchr(a + kAligns[j], 'Z'));
+      a[kAligns[j] + n] = 'A';
+    }
+  }
+}
+
+TEST(memcmp, tiers) {
+  int x;
+  size_t i, j, k, n;
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    for (j = 0; j < ARRAYLEN(kAligns); ++j) {
+      n = kSizes[i];
+      memcpy(b + kAligns[j], a, n);
+      ASSERT_EQ(0, memcmp(a, b + kAligns[j], n));
+      if (!n) continue;
+      k = lemur64() % n;
+      x = b[kAligns[j] + k];
+      b[kAligns[j] + k] = x - 1;
+      ASSERT_EQ(true, memcmp(a, b + kAligns[j], n) > 0, "n=%zu k=%zu", n, k);
+      b[kAligns[j] + k] = x + 1;
+      ASSERT_EQ(true, memcmp(a, b + kAligns[j], n) < 0, "n=%zu k=%zu", n, k);
+    }
+  }
+}
+
+TEST(memmove, tiers) {
+  size_t i, j, n, o;
+  for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+    for (j = 0; j < ARRAYLEN(kAligns); ++j) {
+      n = kSizes[i];
+      o = kAligns[j];
+      memset(b, 0, n + SLACK);
+      memcpy(b + o, a, n);
+      ASSERT_EQ(0, memcmp(b + o, a, n), "n=%zu o=%zu", n, o);
+      ASSERT_EQ(0, b[o + n]);
+      // overlapping both directions
+      memcpy(b, a, n + SLACK);
+      memcpy(c, a, n + SLACK);
+      memmove(b + o, b + SLACK - 1 - o, n);
+      ASSERT_EQ(0, memcmp(b + o, c + SLACK - 1 - o, n), "n=%zu o=%zu", n, o);
+      memcpy(b, a, n + SLACK);
+      memmove(b + SLACK - 1 - o, b + o, n);
+      ASSERT_EQ(0, memcmp(b + SLACK - 1 - o, c + o, n), "n=%zu o=%zu", n, o);
+    }
+  }
+}
+
+BENCH(stringkernels, bench) {
+  int i;
+  size_t n, o;
+  char name[32];
+  char *volatile p = gc(calloc(64 * 1024 * 1024 + SLACK, 1));
+  char *volatile q = gc(malloc(64 * 1024 * 1024 + SLACK));
+  memset(q, 'x', 64 * 1024 * 1024 + SLACK);
+  for (i = 0; i < 3; ++i) {
+    o = (size_t[]){0, 1, 33}[i];
+    for (n = 1; n <= 64 * 1024 * 1024; n *= 4) {
+      snprintf(name, sizeof(name), "memmove+%zu", o);
+      EZBENCH_N(name, n, memmove(p + o, q, n));
+      snprintf(name, sizeof(name), "memchr+%zu", o);
+      EZBENCH_N(name, n, memchr(q + o, 0, n));
+      snprintf(name, sizeof(name), "memcmp+%zu", o);
+      EZBENCH_N(name, n, memcmp(p + o, q + o, n));
+      q[o + n] = 0;
+      snprintf(name, sizeof(name), "strlen+%zu", o);
+      EZBENCH_N(name, n, strlen(q + o));
+      snprintf(name, sizeof(name), "strchr+%zu", o);
+      EZBENCH_N(name, n, strchr(q + o, 'y'));
+      q[o + n] = 'x';
+    }
+  }
+}
@@ -40,7 +40,8 @@ TEST_LIBC_RUNTIME_DIRECTDEPS =						\
 	LIBC_X								\
 	TOOL_BUILD_LIB							\
 	THIRD_PARTY_XED							\
-	THIRD_PARTY_ZLIB
+	THIRD_PARTY_ZLIB						\
+	THIRD_PARTY_ZSTD
 
 TEST_LIBC_RUNTIME_DEPS :=						\
 	$(call uniq,$(foreach x,$(TEST_LIBC_RUNTIME_DIRECTDEPS),$($(x))))
@@ -0,0 +1,68 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/internal.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/hyperion.h"
+#include "libc/testlib/testlib.h"
+#include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
+
+size_t zn, dn;
+char *zp, *dp, *out;
+
+void SetUpOnce(void) {
+  z_stream zs = {0};
+  out = malloc(kHyperionSize);
+  zp = malloc((zn = ZSTD_compressBound(kHyperionSize)));
+  zn = ZSTD_compress(zp, zn, kHyperion, kHyperionSize, 19);
+  ASSERT_FALSE(ZSTD_isError(zn));
+  ASSERT_EQ(Z_OK, deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED,
+                               -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY));
+  zs.next_in = (void *)kHyperion;
+  zs.avail_in = kHyperionSize;
+  zs.avail_out = compressBound(kHyperionSize);
+  zs.next_out = (void *)(dp = malloc(zs.avail_out));
+  ASSERT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  ASSERT_EQ(Z_OK, deflateEnd(&zs));
+  dn = zs.total_out;
+}
+
+TEST(unzstd, test) {
+  bzero(out, kHyperionSize);
+  ASSERT_EQ(0, __unzstd(out, kHyperionSize, zp, zn));
+  ASSERT_EQ(0, memcmp(out, kHyperion, kHyperionSize));
+}
+
+TEST(unzstd, wrongSize_fails) {
+  ASSERT_NE(0, __unzstd(out, kHyperionSize - 1, zp, zn));
+}
+
+TEST(unzstd, corrupted_fails) {
+  char *p = gc(memcpy(malloc(zn), zp, zn));
+  p[zn / 2] ^= 0x55;
+  ASSERT_NE(0, __unzstd(out, kHyperionSize, p, zn));
+}
+
+BENCH(unzstd, bench) {
+  EZBENCH2("__inflate", donothing, __inflate(out, kHyperionSize, dp, dn));
+  EZBENCH2("__unzstd", donothing, __unzstd(out, kHyperionSize, zp, zn));
+}
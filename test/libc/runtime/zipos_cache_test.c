@@ -0,0 +1,113 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+
+__static_yoink("zipos");
+__static_yoink("libc/testlib/blocktronics.txt");  // 3,193 bytes
+__static_yoink("libc/testlib/hyperion.txt");      // 22,851 bytes
+__static_yoink("libc/testlib/viewables.txt");     // 76,529 bytes
+__static_yoink("libc/testlib/moby.txt");          // 1,228,127 bytes
+__static_yoink("_Cz_inflate");
+__static_yoink("_Cz_inflateInit2");
+__static_yoink("_Cz_inflateEnd");
+
+#define BLOCKTRONICS 3193
+#define HYPERION     22851
+#define VIEWABLES    76529
+
+// budget is read once, the first time the cache is used
+void SetUpOnce(void) {
+  ASSERT_SYS(0, 0, setenv("COSMOPOLITAN_ZIPOS_CACHE", "100000", true));
+}
+
+struct CosmoZiposStats Touch(const char *path) {
+  int fd;
+  struct CosmoZiposStats st;
+  ASSERT_NE(-1, (fd = open(path, O_RDONLY)));
+  ASSERT_SYS(0, 0, close(fd));
+  cosmo_zipos_stats(&st);
+  return st;
+}
+
+TEST(zipos_cache, fillPastBudget_evictsLeastRecentlyUsed) {
+  struct CosmoZiposStats st, st0;
+  cosmo_zipos_stats(&st0);
+  ASSERT_EQ(100000, st0.budget);
+  ASSERT_EQ(0, st0.idlebytes);
+
+  st = Touch("/zip/libc/testlib/blocktronics.txt");
+  EXPECT_EQ(BLOCKTRONICS, st.idlebytes);
+  st = Touch("/zip/libc/testlib/hyperion.txt");
+  EXPECT_EQ(BLOCKTRONICS + HYPERION, st.idlebytes);
+  EXPECT_EQ(st0.misses + 2, st.misses);
+  EXPECT_EQ(st0.evictions, st.evictions);
+
+  // going over budget drops blocktronics, which was used longest ago
+  st = Touch("/zip/libc/testlib/viewables.txt");
+  EXPECT_EQ(HYPERION + VIEWABLES, st.idlebytes);
+  EXPECT_EQ(st0.evictions + 1, st.evictions);
+
+  // hyperion is still there, and is now the most recently used
+  st = Touch("/zip/libc/testlib/hyperion.txt");
+  EXPECT_EQ(st0.hits + 1, st.hits);
+  EXPECT_EQ(st0.misses + 3, st.misses);
+
+  // blocktronics has to be decoded again, which pushes out viewables
+  st = Touch("/zip/libc/testlib/blocktronics.txt");
+  EXPECT_EQ(st0.misses + 4, st.misses);
+  EXPECT_EQ(st0.evictions + 2, st.evictions);
+  EXPECT_EQ(BLOCKTRONICS + HYPERION, st.idlebytes);
+  st = Touch("/zip/libc/testlib/hyperion.txt");
+  EXPECT_EQ(st0.hits + 2, st.hits);
+  st = Touch("/zip/libc/testlib/viewables.txt");
+  EXPECT_EQ(st0.misses + 5, st.misses);
+  EXPECT_EQ(HYPERION + VIEWABLES, st.idlebytes);
+  EXPECT_EQ(st0.evictions + 3, st.evictions);
+}
+
+TEST(zipos_cache, oversizeEntry_isSharedButNotKept) {
+  int fd1, fd2;
+  char buf[16];
+  struct CosmoZiposStats st, st0;
+  st0 = Touch("/zip/libc/testlib/hyperion.txt");
+  ASSERT_NE(-1, (fd1 = open("/zip/libc/testlib/moby.txt", O_RDONLY)));
+  ASSERT_NE(-1, (fd2 = open("/zip/libc/testlib/moby.txt", O_RDONLY)));
+  cosmo_zipos_stats(&st);
+  EXPECT_EQ(st0.misses + 1, st.misses);
+  EXPECT_EQ(st0.hits + 1, st.hits);
+  ASSERT_SYS(0, 16, pread(fd2, buf, 16, 1000000));
+  ASSERT_SYS(0, 16, pread(fd1, buf, 16, 1000000));
+  ASSERT_SYS(0, 0, close(fd2));
+  cosmo_zipos_stats(&st);
+  EXPECT_EQ(st0.evictions, st.evictions);
+  ASSERT_SYS(0, 0, close(fd1));
+  cosmo_zipos_stats(&st);
+  EXPECT_EQ(st0.evictions + 1, st.evictions);
+  EXPECT_EQ(st0.idlebytes, st.idlebytes);
+  // the idle blobs that fit in the budget weren't pushed out
+  st = Touch("/zip/libc/testlib/hyperion.txt");
+  EXPECT_EQ(st0.hits + 2, st.hits);
+  EXPECT_EQ(st0.misses + 1, st.misses);
+  st = Touch("/zip/libc/testlib/moby.txt");
+  EXPECT_EQ(st0.misses + 2, st.misses);
+}
@@ -0,0 +1,63 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/subprocess.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+__static_yoink("zipos");
+__static_yoink("libc/testlib/moby.txt");
+__static_yoink("_Cz_inflate");
+__static_yoink("_Cz_inflateInit2");
+__static_yoink("_Cz_inflateEnd");
+
+#define MOBY 1228127
+
+char buf[512];
+
+// with no cache budget, moby.txt is inflated anew after each close
+void SetUpOnce(void) {
+  ASSERT_SYS(0, 0, setenv("COSMOPOLITAN_ZIPOS_CACHE", "0", true));
+}
+
+void *Inflater(void *arg) {
+  char tmp[512];
+  ASSERT_SYS(0, 512, pread((intptr_t)arg, tmp, 512, MOBY - 512));
+  return 0;
+}
+
+TEST(zipos, forkWhileInflating_childCanStillRead) {
+  int i;
+  pthread_t th;
+  for (i = 0; i < 20; ++i) {
+    // child forks while the thread may be halfway through inflating
+    ASSERT_SYS(0, 3, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+    ASSERT_SYS(0, 0, pthread_create(&th, 0, Inflater, (void *)3));
+    SPAWN(fork);
+    ASSERT_SYS(0, 512, pread(3, buf, 512, MOBY - 512));
+    ASSERT_SYS(0, 13, pread(3, buf, 13, 0));
+    ASSERT_EQ(0, memcmp(buf, "\357\273\277MOBY-DICK;", 13));
+    EXITS(0);
+    ASSERT_SYS(0, 0, pthread_join(th, 0));
+    ASSERT_SYS(0, 0, close(3));
+  }
+}
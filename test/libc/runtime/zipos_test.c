@@ -18,6 +18,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/stat.h"
+#include "libc/cosmo.h"
 #include "libc/errno.h"
 #include "libc/limits.h"
 #include "libc/mem/gc.h"
@@ -25,12 +26,15 @@
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/zipos.internal.h"
+#include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/o.h"
+#include "libc/testlib/ezbench.h"
 #include "libc/testlib/hyperion.h"
 #include "libc/testlib/subprocess.h"
 #include "libc/testlib/testlib.h"
 #include "libc/thread/thread.h"
+#include "libc/zip.internal.h"
 
 __static_yoink("zipos");
 __static_yoink("libc/testlib/hyperion.txt");
@@ -113,6 +117,35 @@ TEST(zipos, lseek) {
   EXPECT_SYS(0, 0, close(3));
 }
 
+TEST(zipos, lazyInflate_outOfOrderReads) {
+  char buf[512];
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
+  EXPECT_SYS(0, 512, pread(3, buf, 512, kHyperionSize - 1000));
+  EXPECT_EQ(0, memcmp(buf, kHyperion + kHyperionSize - 1000, 512));
+  EXPECT_SYS(0, 512, pread(3, buf, 512, 100));
+  EXPECT_EQ(0, memcmp(buf, kHyperion + 100, 512));
+  EXPECT_SYS(0, 100, pread(3, buf, 512, kHyperionSize - 100));
+  EXPECT_EQ(0, memcmp(buf, kHyperion + kHyperionSize - 100, 100));
+  EXPECT_SYS(0, 0, close(3));
+}
+
+TEST(zipos, concurrentOpens_shareInflation) {
+  char buf[512];
+  struct CosmoZiposStats st1, st2;
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
+  cosmo_zipos_stats(&st1);
+  ASSERT_SYS(0, 4, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
+  cosmo_zipos_stats(&st2);
+  EXPECT_EQ(st1.hits + 1, st2.hits);
+  EXPECT_EQ(st1.misses, st2.misses);
+  EXPECT_SYS(0, 512, read(4, buf, 512));
+  EXPECT_EQ(0, memcmp(buf, kHyperion, 512));
+  EXPECT_SYS(0, 512, read(3, buf, 512));
+  EXPECT_EQ(0, memcmp(buf, kHyperion, 512));
+  EXPECT_SYS(0, 0, close(4));
+  EXPECT_SYS(0, 0, close(3));
+}
+
 TEST(zipos, closeAfterVfork) {
   ASSERT_SYS(0, 3, open("/zip/libc/testlib/hyperion.txt", O_RDONLY));
   SPAWN(vfork);
@@ -182,3 +215,76 @@ TEST(zipos, ultraPosixAtomicSeekRead) {
   EXPECT_EQ(960, lseek(3, 0, SEEK_CUR));
   ASSERT_SYS(0, 0, close(3));
 }
+
+ssize_t ScanWithoutHashTable(struct Zipos *z, struct ZiposUri *u) {
+  ssize_t cf;
+  struct ZiposNode *nodes = z->nodes;
+  z->nodes = 0;
+  cf = __zipos_scan(z, u);
+  z->nodes = nodes;
+  return cf;
+}
+
+TEST(zipos, hashTable_agreesWithBinarySearch) {
+  size_t i, j, n;
+  const char *s;
+  struct ZiposUri u;
+  struct Zipos *z = __zipos_get();
+  ASSERT_NE(NULL, z);
+  ASSERT_NE(NULL, z->nodes);
+  for (i = 0; i < z->records; ++i) {
+    s = ZIP_CFILE_NAME(z->map + z->index[i]);
+    n = ZIP_CFILE_NAMESIZE(z->map + z->index[i]);
+    for (j = 1; j <= n; ++j) {
+      if (j < n && s[j] != '/') continue;
+      memcpy(u.path, s, j);
+      u.path[u.len = j] = 0;
+      EXPECT_EQ(ScanWithoutHashTable(z, &u), __zipos_scan(z, &u), "%s", u.path);
+      u.path[u.len = j - 1] = 0;
+      EXPECT_EQ(ScanWithoutHashTable(z, &u), __zipos_scan(z, &u), "%s", u.path);
+    }
+  }
+}
+
+TEST(zipos, children_coverDirectory) {
+  size_t i, r[2];
+  struct Zipos *z = __zipos_get();
+  __zipos_children(z, "libc/testlib/", 13, r);
+  ASSERT_LT(r[0], r[1]);
+  for (i = r[0]; i < r[1]; ++i) {
+    EXPECT_EQ(0, memcmp(ZIP_CFILE_NAME(z->map + z->index[i]), "libc/testlib/",
+                        13));
+  }
+  if (r[0]) {
+    EXPECT_NE(0, memcmp(ZIP_CFILE_NAME(z->map + z->index[r[0] - 1]),
+                        "libc/testlib/", 13));
+  }
+  if (r[1] < z->records) {
+    EXPECT_NE(0, memcmp(ZIP_CFILE_NAME(z->map + z->index[r[1]]),
+                        "libc/testlib/", 13));
+  }
+}
+
+// simulates the path finder of an interpreter importing 2,000 modules
+// from /zip, where each import probes several candidates, most absent
+void ImportModules(ssize_t scan(struct Zipos *, struct ZiposUri *)) {
+  int i;
+  struct ZiposUri u;
+  struct Zipos *z = __zipos_get();
+  for (i = 0; i < 2000; ++i) {
+    u.len = sprintf(u.path, ".python/pkg%d", i % 50);
+    scan(z, &u);
+    u.len = sprintf(u.path, ".python/pkg%d/mod%d.py", i % 50, i);
+    scan(z, &u);
+    u.len = sprintf(u.path, ".python/pkg%d/mod%d.pyc", i % 50, i);
+    scan(z, &u);
+    u.len = sprintf(u.path, "libc/testlib/hyperion.txt");
+    scan(z, &u);
+  }
+}
+
+BENCH(zipos, bench) {
+  EZBENCH2("import 2000 (hash)", donothing, ImportModules(__zipos_scan));
+  EZBENCH2("import 2000 (bsearch)", donothing,
+           ImportModules(ScanWithoutHashTable));
+}
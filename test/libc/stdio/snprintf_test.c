@@ -16,8 +16,10 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 
 TEST(snprintf, testVeryLargePrecision) {
@@ -27,3 +29,50 @@ TEST(snprintf, testVeryLargePrecision) {
   ASSERT_EQ(i, 9999);
   ASSERT_EQ(strlen(buf), 511);
 }
+
+TEST(snprintf, paddingLongerThanStagingBuffer) {
+  char buf[1024];
+  ASSERT_EQ(600, snprintf(buf, sizeof(buf), "%600s", "hi"));
+  ASSERT_EQ(' ', buf[0]);
+  ASSERT_EQ(' ', buf[597]);
+  ASSERT_STREQ("hi", buf + 598);
+  ASSERT_EQ(700, snprintf(buf, sizeof(buf), "x%-698dy", 42));
+  ASSERT_EQ(0, memcmp(buf, "x42 ", 4));
+  ASSERT_EQ('y', buf[699]);
+  ASSERT_EQ(500, snprintf(buf, sizeof(buf), "%0500d", -7));
+  ASSERT_EQ('-', buf[0]);
+  ASSERT_EQ('0', buf[498]);
+  ASSERT_EQ('7', buf[499]);
+}
+
+TEST(snprintf, fragmentsStraddlingStagingBuffer) {
+  int i;
+  char s[300], buf[1024], want[1024];
+  for (i = 0; i < 299; ++i) s[i] = 'a' + i % 26;
+  s[299] = 0;
+  for (i = 0; i < 300; i += 7) {
+    ASSERT_EQ(i + 299 + 5, snprintf(buf, sizeof(buf), "%.*s%s%d", i, s, s,
+                                    12345));
+    memcpy(want, s, i);
+    memcpy(want + i, s, 299);
+    strcpy(want + i + 299, "12345");
+    ASSERT_STREQ(want, buf);
+  }
+}
+
+BENCH(snprintf, logLines) {
+  char b[256];
+  errno = ENOENT;
+  EZBENCH2("snprintf access log", donothing,
+           snprintf(b, sizeof(b), "%s - - [%s] \"%s %s HTTP/1.1\" %d %ld\n",
+                    "127.0.0.1", "19/Oct/2026:12:00:00 +0000", "GET",
+                    "/index.html", 200, 31337L));
+  EZBENCH2("snprintf padded columns", donothing,
+           snprintf(b, sizeof(b), "%-16s|%8d|%08x|%12.3f|%-8s\n", "worker",
+                    42, 0xdeadbeef, 3.14159, "ok"));
+  EZBENCH2("snprintf error line", donothing,
+           snprintf(b, sizeof(b), "%s:%d: %s failed: %m (%#x)\n", "foo.c",
+                    123, "open", 0x42));
+  EZBENCH2("snprintf wide pad", donothing,
+           snprintf(b, sizeof(b), "%40s%-40s%040d", "a", "b", 7));
+}
@@ -0,0 +1,196 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/stdio.h"
+#include "libc/stdio/stdio_ext.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+#define N (8 * 1024 * 1024)
+
+char *line;
+size_t linecap;
+
+void SetUpOnce(void) {
+  int i;
+  FILE *f;
+  testlib_enable_tmp_setup_teardown_once();
+  ASSERT_NE(NULL, (f = fopen("log", "w")));
+  for (i = 0; ftell(f) < N; ++i) {
+    ASSERT_LT(0, fprintf(f, "%d GET /index.html HTTP/1.1 200 %d\n", i, i * 7));
+  }
+  ASSERT_EQ(0, fclose(f));
+}
+
+TEST(fread, largeSequentialStream_growsBuffer) {
+  FILE *f;
+  char buf[100];
+  ASSERT_NE(NULL, (f = fopen("log", "r")));
+  ASSERT_EQ(BUFSIZ, __fbufsize(f));
+  while (fread(buf, 1, sizeof(buf), f) == sizeof(buf)) donothing;
+  ASSERT_TRUE(feof(f));
+  ASSERT_GT(__fbufsize(f), BUFSIZ);
+  ASSERT_EQ(0, fclose(f));
+}
+
+TEST(fwrite, manySmallWrites_growsBuffer) {
+  int i;
+  FILE *f;
+  ASSERT_NE(NULL, (f = fopen("out", "w")));
+  for (i = 0; i < 100000; ++i) {
+    ASSERT_EQ(1, fwrite("hello world\n", 12, 1, f));
+  }
+  ASSERT_GT(__fbufsize(f), BUFSIZ);
+  ASSERT_EQ(0, fclose(f));
+  ASSERT_NE(NULL, (f = fopen("out", "r")));
+  for (i = 0; i < 100000; ++i) {
+    ASSERT_EQ(12, getline(&line, &linecap, f));
+    ASSERT_STREQ("hello world\n", line);
+  }
+  ASSERT_EQ(-1, getline(&line, &linecap, f));
+  ASSERT_EQ(0, fclose(f));
+}
+
+TEST(setvbuf, nullBufferWithSize_allocatesThatSize) {
+  FILE *f;
+  ASSERT_NE(NULL, (f = fopen("log", "r")));
+  ASSERT_EQ(0, setvbuf(f, 0, _IOFBF, 65536));
+  ASSERT_EQ(65536, __fbufsize(f));
+  ASSERT_EQ(0, fclose(f));
+}
+
+char zeroes[1000];
+
+void *Dribble(void *arg) {
+  int i, fd = (intptr_t)arg;
+  for (i = 0; i < 16; ++i) {
+    write(fd, zeroes, sizeof(zeroes));
+    usleep(1000);
+  }
+  close(fd);
+  return 0;
+}
+
+TEST(fread, largeReadFromPipe_isntMistakenForEof) {
+  FILE *f;
+  int fds[2];
+  pthread_t th;
+  char buf[16000];
+  ASSERT_SYS(0, 0, pipe(fds));
+  ASSERT_NE(NULL, (f = fdopen(fds[0], "r")));
+  ASSERT_EQ(0, pthread_create(&th, 0, Dribble, (void *)(intptr_t)fds[1]));
+  ASSERT_EQ(1, fread(buf, sizeof(buf), 1, f));
+  ASSERT_FALSE(feof(f));
+  ASSERT_EQ(0, fread(buf, 1, 1, f));
+  ASSERT_TRUE(feof(f));
+  ASSERT_EQ(0, pthread_join(th, 0));
+  ASSERT_EQ(0, fclose(f));
+}
+
+TEST(fread, smallReadFromPipe_isntMistakenForEof) {
+  FILE *f;
+  int fds[2];
+  pthread_t th;
+  char buf[3000];
+  ASSERT_SYS(0, 0, pipe(fds));
+  ASSERT_NE(NULL, (f = fdopen(fds[0], "r")));
+  ASSERT_EQ(0, setvbuf(f, NULL, _IOFBF, 8192));
+  ASSERT_EQ(0, pthread_create(&th, 0, Dribble, (void *)(intptr_t)fds[1]));
+  ASSERT_EQ(1, fread(buf, sizeof(buf), 1, f));
+  ASSERT_FALSE(feof(f));
+  ASSERT_EQ(0, pthread_join(th, 0));
+  ASSERT_EQ(4, fread(buf, 3000, 5, f));
+  ASSERT_TRUE(feof(f));
+  ASSERT_EQ(0, fclose(f));
+}
+
+// leaves ten bytes in the buffer, then makes the next read fail
+FILE *OpenLogThatFails(void) {
+  FILE *f;
+  int dirfd;
+  char buf[BUFSIZ];
+  size_t n;
+  ASSERT_NE(NULL, (f = fopen("log", "r")));
+  ASSERT_EQ(1, fread(buf, 1, 1, f));
+  ASSERT_GT((n = __freadahead(f)), 10);
+  ASSERT_EQ(n - 10, fread(buf, 1, n - 10, f));
+  ASSERT_EQ(10, __freadahead(f));
+  ASSERT_NE(-1, (dirfd = open(".", O_RDONLY | O_DIRECTORY)));
+  ASSERT_SYS(0, fileno(f), dup2(dirfd, fileno(f)));
+  ASSERT_SYS(0, 0, close(dirfd));
+  return f;
+}
+
+TEST(fread, smallReadFailsPartway_setsError) {
+  FILE *f;
+  char buf[100];
+  f = OpenLogThatFails();
+  ASSERT_EQ(10, fread(buf, 1, sizeof(buf), f));
+  ASSERT_TRUE(ferror(f));
+  ASSERT_FALSE(feof(f));
+  fclose(f);
+}
+
+TEST(fread, largeReadFailsPartway_setsError) {
+  FILE *f;
+  char *buf = gc(malloc(BUFSIZ * 4));
+  f = OpenLogThatFails();
+  ASSERT_EQ(10, fread(buf, 1, BUFSIZ * 4, f));
+  ASSERT_TRUE(ferror(f));
+  ASSERT_FALSE(feof(f));
+  fclose(f);
+}
+
+void ReadLog(size_t chunk) {
+  FILE *f;
+  char *buf = malloc(chunk);
+  f = fopen("log", "r");
+  while (fread(buf, 1, chunk, f) == chunk) donothing;
+  fclose(f);
+  free(buf);
+}
+
+void GetlineLog(void) {
+  FILE *f;
+  f = fopen("log", "r");
+  while (getline(&line, &linecap, f) != -1) donothing;
+  fclose(f);
+}
+
+void WriteLog(void) {
+  int i;
+  FILE *f;
+  f = fopen("out", "w");
+  for (i = 0; i < N / 32; ++i) {
+    fwrite("GET /index.html HTTP/1.1 200 42\n", 32, 1, f);
+  }
+  fclose(f);
+}
+
+BENCH(stdio, throughput) {
+  EZBENCH2("fread 100 (8mb)", donothing, ReadLog(100));
+  EZBENCH2("fread 64k (8mb)", donothing, ReadLog(65536));
+  EZBENCH2("getline (8mb)", donothing, GetlineLog());
+  EZBENCH2("fwrite 32 (8mb)", donothing, WriteLog());
+}
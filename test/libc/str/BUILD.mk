@@ -44,6 +44,7 @@ TEST_LIBC_STR_DIRECTDEPS =						\
 	LIBC_SYSV							\
 	LIBC_SYSV_CALLS							\
 	LIBC_TESTLIB							\
+	LIBC_THREAD							\
 	LIBC_X								\
 	THIRD_PARTY_COMPILER_RT						\
 	THIRD_PARTY_MBEDTLS						\
@@ -21,6 +21,7 @@
 #include "libc/mem/mem.h"
 #include "libc/nexgen32e/crc32.h"
 #include "libc/nexgen32e/x86feature.h"
+#include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/testlib/ezbench.h"
@@ -50,6 +51,32 @@ TEST(crc32c, test) {
   EXPECT_EQ(0xecc9871d, crc32c(0, kHyperion, kHyperionSize));
 }
 
+static uint32_t crc32c_bitwise(uint32_t h, const void *data, size_t n) {
+  int i;
+  const unsigned char *p = data;
+  for (h = ~h; n--;) {
+    h ^= *p++;
+    for (i = 0; i < 8; ++i) {
+      h = h >> 1 ^ (h & 1 ? 0x82f63b78 : 0);
+    }
+  }
+  return ~h;
+}
+
+TEST(crc32c, interleavedStreams_matchBitwise) {
+  size_t i, n, o;
+  uint32_t init;
+  char *p = gc(malloc(20000));
+  for (i = 0; i < 20000; ++i) p[i] = lemur64();
+  for (i = 0; i < 300; ++i) {
+    o = lemur64() % 8;
+    n = i < 200 ? lemur64() % 1000 : lemur64() % (20000 - 8);
+    init = lemur64();
+    ASSERT_EQ(crc32c_bitwise(init, p + o, n), crc32c(init, p + o, n),
+              "n=%zu o=%zu", n, o);
+  }
+}
+
 dontinline uint64_t fnv_hash(char *s, int len) {
   uint64_t hash = 0xcbf29ce484222325;
   for (int i = 0; i < len; i++) {
@@ -78,6 +105,13 @@ BENCH(crc32c, bench) {
               __expropriate(KMH(__veil("r", kHyperion), __veil("r", i))));
     fprintf(stderr, "\n");
   }
+  char *p = gc(calloc(1, 1024 * 1024));
+  EZBENCH_N("crc32c", 64, __expropriate(crc32c(0, p, 64)));
+  EZBENCH_N("crc32c", 4096, __expropriate(crc32c(0, p, 4096)));
+  EZBENCH_N("crc32c", 1048576, __expropriate(crc32c(0, p, 1048576)));
+  EZBENCH_N("crc32_z", 64, __expropriate(crc32_z(0, p, 64)));
+  EZBENCH_N("crc32_z", 4096, __expropriate(crc32_z(0, p, 4096)));
+  EZBENCH_N("crc32_z", 1048576, __expropriate(crc32_z(0, p, 1048576)));
   EZBENCH_N("crc32c", kHyperionSize,
             __expropriate(crc32c(0, kHyperion, kHyperionSize)));
   EZBENCH_N("crc32_z", kHyperionSize,
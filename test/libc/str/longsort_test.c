@@ -16,6 +16,8 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/macros.internal.h"
+#include "libc/math.h"
 #include "libc/mem/alg.h"
 #include "libc/mem/gc.internal.h"
 #include "libc/mem/mem.h"
@@ -25,6 +27,7 @@
 #include "libc/str/str.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
+#include "libc/thread/forkjoin.h"
 #include "third_party/vqsort/vqsort.h"
 
 void InsertionSort(int *A, int n) {
@@ -260,3 +263,204 @@ BENCH(InsertionSort, bench) {
   EZBENCH2("qsort(int)", memcpy(p2, p1, n * sizeof(int)),
            qsort(p2, n, sizeof(int), CompareInt));
 }
+
+int CompareUint64(const void *a, const void *b) {
+  const uint64_t *x = a;
+  const uint64_t *y = b;
+  if (*x < *y) return -1;
+  if (*x > *y) return +1;
+  return 0;
+}
+
+int CompareDouble(const void *a, const void *b) {
+  const double *x = a;
+  const double *y = b;
+  if (*x < *y) return -1;
+  if (*x > *y) return +1;
+  return 0;
+}
+
+int CompareFloat(const void *a, const void *b) {
+  const float *x = a;
+  const float *y = b;
+  if (*x < *y) return -1;
+  if (*x > *y) return +1;
+  return 0;
+}
+
+TEST(vqsort_uint64, test) {
+  size_t n = 5000;
+  uint64_t *a = gc(calloc(n, sizeof(uint64_t)));
+  uint64_t *b = gc(calloc(n, sizeof(uint64_t)));
+  rngset(a, n * sizeof(uint64_t), 0, 0);
+  memcpy(b, a, n * sizeof(uint64_t));
+  qsort(a, n, sizeof(uint64_t), CompareUint64);
+  vqsort_uint64(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(uint64_t)));
+}
+
+TEST(vqsort_uint32, test) {
+  size_t i, n = 5000;
+  uint32_t *a = gc(calloc(n, sizeof(uint32_t)));
+  rngset(a, n * sizeof(uint32_t), 0, 0);
+  vqsort_uint32(a, n);
+  for (i = 1; i < n; ++i) {
+    ASSERT_EQ(true, a[i - 1] <= a[i], "%zu", i);
+  }
+}
+
+TEST(vqsort_double, test) {
+  size_t n = 5000;
+  double *a = gc(calloc(n, sizeof(double)));
+  double *b = gc(calloc(n, sizeof(double)));
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = (double)(int64_t)lemur64() / (lemur64() | 1);
+  }
+  memcpy(b, a, n * sizeof(double));
+  qsort(a, n, sizeof(double), CompareDouble);
+  vqsort_double(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(double)));
+}
+
+TEST(vqsort_double, specials) {
+  double A[] = {1., -0., INFINITY, -1., 0., -INFINITY, 2.};
+  vqsort_double(A, ARRAYLEN(A));
+  EXPECT_EQ(-INFINITY, A[0]);
+  EXPECT_EQ(-1., A[1]);
+  EXPECT_TRUE(signbit(A[2]));
+  EXPECT_FALSE(signbit(A[3]));
+  EXPECT_EQ(1., A[4]);
+  EXPECT_EQ(2., A[5]);
+  EXPECT_EQ(INFINITY, A[6]);
+}
+
+TEST(vqsort_float, test) {
+  size_t n = 5000;
+  float *a = gc(calloc(n, sizeof(float)));
+  float *b = gc(calloc(n, sizeof(float)));
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = (float)(int32_t)lemur64() / 1000;
+  }
+  memcpy(b, a, n * sizeof(float));
+  qsort(a, n, sizeof(float), CompareFloat);
+  vqsort_float(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(float)));
+}
+
+TEST(radix_sort_uint64_pairs, isStable) {
+  size_t i, n = 100000;
+  uint64_t(*a)[2] = gc(calloc(n, sizeof(*a)));
+  uint64_t(*b)[2] = gc(calloc(n, sizeof(*b)));
+  for (i = 0; i < n; ++i) {
+    a[i][0] = lemur64() % 1000 << 40 | lemur64() % 3;
+    a[i][1] = i;
+  }
+  memcpy(b, a, n * sizeof(*a));
+  mergesort(a, n, sizeof(*a), CompareUint64);
+  ASSERT_EQ(0, radix_sort_uint64_pairs(b, n));
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(*a)));
+}
+
+TEST(argsort_double, isStable) {
+  size_t i, n = 10000;
+  double *k = gc(calloc(n, sizeof(double)));
+  size_t *p = gc(calloc(n, sizeof(size_t)));
+  for (i = 0; i < n; ++i) k[i] = (double)((int)(lemur64() % 100) - 50) / 3;
+  ASSERT_EQ(0, argsort_double(k, n, p));
+  for (i = 1; i < n; ++i) {
+    ASSERT_EQ(true, k[p[i - 1]] <= k[p[i]], "%zu", i);
+    if (k[p[i - 1]] == k[p[i]]) {
+      ASSERT_EQ(true, p[i - 1] < p[i], "%zu", i);
+    }
+  }
+}
+
+TEST(argsort_float, isStable) {
+  size_t i, n = 10000;
+  float *k = gc(calloc(n, sizeof(float)));
+  size_t *p = gc(calloc(n, sizeof(size_t)));
+  for (i = 0; i < n; ++i) k[i] = (float)((int)(lemur64() % 100) - 50) / 3;
+  ASSERT_EQ(0, argsort_float(k, n, p));
+  for (i = 1; i < n; ++i) {
+    ASSERT_EQ(true, k[p[i - 1]] <= k[p[i]], "%zu", i);
+    if (k[p[i - 1]] == k[p[i]]) {
+      ASSERT_EQ(true, p[i - 1] < p[i], "%zu", i);
+    }
+  }
+}
+
+TEST(argsort_int64, test) {
+  size_t i, n = 5000;
+  int64_t *k = gc(calloc(n, sizeof(int64_t)));
+  size_t *p = gc(calloc(n, sizeof(size_t)));
+  rngset(k, n * sizeof(int64_t), 0, 0);
+  ASSERT_EQ(0, argsort_int64(k, n, p));
+  for (i = 1; i < n; ++i) {
+    ASSERT_EQ(true, k[p[i - 1]] <= k[p[i]], "%zu", i);
+  }
+}
+
+TEST(argsort_uint32, test) {
+  size_t i, n = 5000;
+  uint32_t *k = gc(calloc(n, sizeof(uint32_t)));
+  size_t *p = gc(calloc(n, sizeof(size_t)));
+  rngset(k, n * sizeof(uint32_t), 0, 0);
+  ASSERT_EQ(0, argsort_uint32(k, n, p));
+  for (i = 1; i < n; ++i) {
+    ASSERT_EQ(true, k[p[i - 1]] <= k[p[i]], "%zu", i);
+  }
+}
+
+BENCH(vqsort_double, bench) {
+  printf("\n");
+  size_t i, n = 100000;
+  double *p1 = gc(malloc(n * sizeof(double)));
+  double *p2 = gc(malloc(n * sizeof(double)));
+  size_t *ix = gc(malloc(n * sizeof(size_t)));
+  uint64_t(*q1)[2] = gc(malloc(n * sizeof(*q1)));
+  uint64_t(*q2)[2] = gc(malloc(n * sizeof(*q2)));
+  for (i = 0; i < n; ++i) p1[i] = (double)(int64_t)lemur64() / 3;
+  for (i = 0; i < n; ++i) q1[i][0] = lemur64(), q1[i][1] = i;
+  EZBENCH2("vqsort_double", memcpy(p2, p1, n * sizeof(double)),
+           vqsort_double(p2, n));
+  EZBENCH2("qsort(double)", memcpy(p2, p1, n * sizeof(double)),
+           qsort(p2, n, sizeof(double), CompareDouble));
+  EZBENCH2("argsort_double", donothing, argsort_double(p1, n, ix));
+  EZBENCH2("radix_sort_uint64_pairs", memcpy(q2, q1, n * sizeof(*q1)),
+           radix_sort_uint64_pairs(q2, n));
+  EZBENCH2("qsort(pairs)", memcpy(q2, q1, n * sizeof(*q1)),
+           qsort(q2, n, sizeof(*q2), CompareUint64));
+}
+
+void TearDownOnce(void) {
+  forkjoin_shutdown();
+}
+
+TEST(vqsort_int64_parallel, test) {
+  size_t n = 300000;
+  int64_t *a = gc(calloc(n, sizeof(int64_t)));
+  int64_t *b = gc(calloc(n, sizeof(int64_t)));
+  rngset(a, n * sizeof(int64_t), 0, 0);
+  memcpy(b, a, n * sizeof(int64_t));
+  vqsort_int64(a, n);
+  vqsort_int64_parallel(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(int64_t)));
+}
+
+BENCH(vqsort_int64_parallel, scaling) {
+  char name[40];
+  size_t n = 1 << 20;
+  int64_t *p1 = gc(malloc(n * sizeof(int64_t)));
+  int64_t *p2 = gc(malloc(n * sizeof(int64_t)));
+  rngset(p1, n * sizeof(int64_t), 0, 0);
+  printf("\n");
+  EZBENCH2("vqsort_int64", memcpy(p2, p1, n * sizeof(int64_t)),
+           vqsort_int64(p2, n));
+  for (int c = 1;; c *= 2) {
+    c = forkjoin_setconcurrency(c);
+    snprintf(name, sizeof(name), "vqsort_int64_parallel %d threads", c);
+    EZBENCH2(name, memcpy(p2, p1, n * sizeof(int64_t)),
+             vqsort_int64_parallel(p2, n));
+    if (c == forkjoin_setconcurrency(0)) break;
+  }
+}
@@ -0,0 +1,146 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/intrin/atomic.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/forkjoin.h"
+
+struct Fib {
+  int n;
+  long r;
+};
+
+long Fib(int);
+
+void FibWorker(void *arg) {
+  struct Fib *f = arg;
+  f->r = Fib(f->n);
+}
+
+long Fib(int n) {
+  if (n < 2) return n;
+  struct Fib a = {n - 1}, b = {n - 2};
+  forkjoin_invoke2(FibWorker, &a, FibWorker, &b);
+  return a.r + b.r;
+}
+
+int CompareLong(const void *a, const void *b) {
+  const long *x = a;
+  const long *y = b;
+  if (*x < *y) return -1;
+  if (*x > *y) return +1;
+  return 0;
+}
+
+atomic_long g_sum;
+
+void SumRange(void *arg, size_t lo, size_t hi) {
+  long sum = 0;
+  for (size_t i = lo; i < hi; ++i) sum += i;
+  atomic_fetch_add(&g_sum, sum);
+}
+
+void TearDown(void) {
+  forkjoin_setconcurrency(0);
+}
+
+void TearDownOnce(void) {
+  forkjoin_shutdown();
+}
+
+TEST(forkjoin_invoke2, fib) {
+  for (int c = 1; c <= 4; ++c) {
+    forkjoin_setconcurrency(c);
+    ASSERT_EQ(6765, Fib(20));
+  }
+}
+
+TEST(forkjoin_for, coversRangeExactlyOnce) {
+  for (int c = 1; c <= 4; ++c) {
+    forkjoin_setconcurrency(c);
+    g_sum = 0;
+    forkjoin_for(1000000, 0, SumRange, 0);
+    ASSERT_EQ(499999500000, g_sum);
+  }
+}
+
+TEST(forkjoin_shutdown, restartsOnNextUse) {
+  forkjoin_shutdown();
+  forkjoin_shutdown();
+  ASSERT_EQ(6765, Fib(20));
+  forkjoin_shutdown();
+  forkjoin_setconcurrency(2);
+  g_sum = 0;
+  forkjoin_for(1000000, 0, SumRange, 0);
+  ASSERT_EQ(499999500000, g_sum);
+}
+
+TEST(qsort_parallel, test) {
+  size_t n = 100000;
+  long *a = gc(malloc(n * sizeof(long)));
+  long *b = gc(malloc(n * sizeof(long)));
+  rngset(a, n * sizeof(long), 0, 0);
+  memcpy(b, a, n * sizeof(long));
+  qsort(a, n, sizeof(long), CompareLong);
+  qsort_parallel(b, n, sizeof(long), CompareLong);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(long)));
+}
+
+TEST(merge_parallel, isStable) {
+  size_t i, nx = 50000, ny = 30000;
+  long(*x)[2] = gc(malloc(nx * sizeof(*x)));
+  long(*y)[2] = gc(malloc(ny * sizeof(*y)));
+  long(*z)[2] = gc(malloc((nx + ny) * sizeof(*z)));
+  for (i = 0; i < nx; ++i) x[i][0] = lemur64() % 1000, x[i][1] = 0;
+  for (i = 0; i < ny; ++i) y[i][0] = lemur64() % 1000, y[i][1] = 1;
+  qsort(x, nx, sizeof(*x), CompareLong);
+  qsort(y, ny, sizeof(*y), CompareLong);
+  merge_parallel(x, nx, y, ny, z, sizeof(*z), CompareLong);
+  for (i = 1; i < nx + ny; ++i) {
+    ASSERT_EQ(true, z[i - 1][0] <= z[i][0], "%zu", i);
+    if (z[i - 1][0] == z[i][0]) {
+      ASSERT_EQ(true, z[i - 1][1] <= z[i][1], "%zu", i);
+    }
+  }
+}
+
+BENCH(qsort_parallel, scaling) {
+  char name[32];
+  size_t n = 1 << 18;
+  long *p1 = gc(malloc(n * sizeof(long)));
+  long *p2 = gc(malloc(n * sizeof(long)));
+  rngset(p1, n * sizeof(long), 0, 0);
+  printf("\n");
+  EZBENCH2("qsort", memcpy(p2, p1, n * sizeof(long)),
+           qsort(p2, n, sizeof(long), CompareLong));
+  for (int c = 1;; c *= 2) {
+    c = forkjoin_setconcurrency(c);
+    snprintf(name, sizeof(name), "qsort_parallel %d threads", c);
+    EZBENCH2(name, memcpy(p2, p1, n * sizeof(long)),
+             qsort_parallel(p2, n, sizeof(long), CompareLong));
+    if (c == forkjoin_setconcurrency(0)) break;
+  }
+}
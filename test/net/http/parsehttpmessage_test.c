@@ -24,6 +24,7 @@
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 #include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
 #include "net/http/http.h"
 
 struct HttpMessage req[1];
@@ -419,6 +420,55 @@ TEST(ParseHttpResponse, testHttp100) {
   EXPECT_EQ(10, req->version);
 }
 
+TEST(ParseHttpWideMessage, hugeCookie_onlyWorksWithWideSlices) {
+  char *m;
+  size_t n;
+  struct HttpWideMessage w;
+  m = gc(xasprintf("GET / HTTP/1.1\r\n"
+                   "Host: sso.example\r\n"
+                   "Cookie: jwt=%0*d\r\n"
+                   "X-Trace: %0*d\r\n"
+                   "\r\n",
+                   100000, 0, 50000, 0));
+  n = strlen(m);
+  InitHttpMessage(req, kHttpRequest);
+  EXPECT_SYS(EBADMSG, -1, ParseHttpMessage(req, m, n));
+  InitHttpWideMessage(&w, kHttpRequest);
+  EXPECT_EQ(n, ParseHttpWideMessage(&w, m, n));
+  EXPECT_EQ(kHttpGet, w.method);
+  EXPECT_EQ(11, w.version);
+  EXPECT_EQ(100004, w.headers[kHttpCookie].b - w.headers[kHttpCookie].a);
+  EXPECT_EQ(0, memcmp(m + w.headers[kHttpCookie].a, "jwt=000", 7));
+  ASSERT_EQ(1, w.xheaders.n);
+  EXPECT_EQ(50000, w.xheaders.p[0].v.b - w.xheaders.p[0].v.a);
+  EXPECT_EQ('\r', m[w.xheaders.p[0].v.b]);
+  DestroyHttpWideMessage(&w);
+}
+
+TEST(ParseHttpWideMessage, smallMessage_slicesSameAsCompact) {
+  int i;
+  struct HttpWideMessage w;
+  static const char m[] = "\
+POST /foo?bar%20hi HTTP/1.0\r\n\
+Host: foo.example\r\n\
+X-Whatever: x\r\n\
+Content-Length: 0\r\n\
+\r\n";
+  InitHttpMessage(req, kHttpRequest);
+  InitHttpWideMessage(&w, kHttpRequest);
+  EXPECT_EQ(strlen(m), ParseHttpMessage(req, m, strlen(m)));
+  EXPECT_EQ(strlen(m), ParseHttpWideMessage(&w, m, strlen(m)));
+  EXPECT_EQ(req->uri.a, w.uri.a);
+  EXPECT_EQ(req->uri.b, w.uri.b);
+  for (i = 0; i < kHttpHeadersMax; ++i) {
+    EXPECT_EQ(req->headers[i].a, w.headers[i].a);
+    EXPECT_EQ(req->headers[i].b, w.headers[i].b);
+  }
+  ASSERT_EQ(req->xheaders.n, w.xheaders.n);
+  EXPECT_EQ(req->xheaders.p[0].v.a, w.xheaders.p[0].v.a);
+  DestroyHttpWideMessage(&w);
+}
+
 void DoTiniestHttpRequest(void) {
   static const char m[] = "\
 GET /\r\n\
@@ -551,6 +601,29 @@ BENCH(ParseHttpMessage, bench) {
   EZBENCH2("DoUnstandardHttpResponse", donothing, DoUnstandardHttpResponse());
 }
 
+void DoWideChromeRequest(void) {
+  static const char m[] = "\
+GET /tool/net/redbean.png HTTP/1.1\r\n\
+Host: 10.10.10.124:8080\r\n\
+Connection: keep-alive\r\n\
+User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/89.0.4389.90 Safari/537.36\r\n\
+DNT:  \t1   \r\n\
+Accept: image/avif,image/webp,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n\
+Referer: http://10.10.10.124:8080/\r\n\
+Accept-Encoding: gzip, deflate\r\n\
+Accept-Language: en-US,en;q=0.9\r\n\
+\r\n";
+  struct HttpWideMessage w;
+  InitHttpWideMessage(&w, kHttpRequest);
+  CHECK_EQ(sizeof(m) - 1, ParseHttpWideMessage(&w, m, sizeof(m)));
+  DestroyHttpWideMessage(&w);
+}
+
+BENCH(ParseHttpWideMessage, bench) {
+  EZBENCH2("DoStandardChromeRequest", donothing, DoStandardChromeRequest());
+  EZBENCH2("DoWideChromeRequest", donothing, DoWideChromeRequest());
+}
+
 BENCH(HeaderHas, bench) {
   static const char m[] = "\
 GET / HTTP/1.1\r\n\
@@ -0,0 +1,156 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/hyperion.h"
+#include "libc/testlib/testlib.h"
+#include "net/http/escape.h"
+#include "net/http/url.h"
+
+size_t UnescapedSpanScalar(const char *p, size_t n, const char T[256]) {
+  size_t i;
+  for (i = 0; i < n && !T[p[i] & 255]; ++i) donothing;
+  return i;
+}
+
+TEST(UnescapedSpan, empty) {
+  EXPECT_EQ(0, UnescapedSpan("", 0, kEscapePath));
+}
+
+TEST(UnescapedSpan, stopsAtFirstSpecial) {
+  const char *s = "/the/quick/brown/fox/jumped/over/the/lazy dog";
+  EXPECT_EQ(strchr(s, ' ') - s, UnescapedSpan(s, strlen(s), kEscapePath));
+  EXPECT_EQ(0, UnescapedSpan(s, strlen(s), kEscapeParam));
+}
+
+TEST(UnescapedSpan, highBytes) {
+  char b[100];
+  memset(b, 'x', sizeof(b));
+  b[70] = 0200;
+  EXPECT_EQ(70, UnescapedSpan(b, sizeof(b), kEscapePath));
+}
+
+TEST(UnescapedSpan, mixedHighTable_stillWorks) {
+  char T[256] = {[0377] = 1};
+  char b[100];
+  memset(b, 0200, sizeof(b));
+  b[77] = 0377;
+  EXPECT_EQ(77, UnescapedSpan(b, sizeof(b), T));
+}
+
+TEST(UnescapedSpan, fuzz) {
+  int i, j, k;
+  char T[256], b[300];
+  for (i = 0; i < 20000; ++i) {
+    bzero(T, sizeof(T));
+    for (j = lemur64() % 8; j--;) T[lemur64() % 128] = 1;
+    if (lemur64() & 1) memset(T + 128, 1, 128);
+    if (!(lemur64() % 10)) T[128 + lemur64() % 128] ^= 1;
+    k = lemur64() % sizeof(b);
+    for (j = 0; j < k; ++j) {
+      b[j] = lemur64() % 4 ? lemur64() % 128 : lemur64();
+    }
+    ASSERT_EQ(UnescapedSpanScalar(b, k, T), UnescapedSpan(b, k, T));
+  }
+}
+
+TEST(NextUnescapedSpan, reusesPreparedTable) {
+  int i, j, k;
+  char b[300];
+  struct UnescapedSpan s;
+  InitUnescapedSpan(&s, kEscapeParam);
+  for (i = 0; i < 2000; ++i) {
+    k = lemur64() % sizeof(b);
+    for (j = 0; j < k; ++j) {
+      b[j] = lemur64() % 16 ? 'a' + lemur64() % 26 : lemur64();
+    }
+    ASSERT_EQ(UnescapedSpanScalar(b, k, kEscapeParam),
+              NextUnescapedSpan(&s, b, k));
+  }
+}
+
+TEST(EscapeHtml, longRun) {
+  EXPECT_STREQ("abcdefghijklmnopqrstuvwxyz0123456789&lt;"
+               "abcdefghijklmnopqrstuvwxyz0123456789&amp;",
+               gc(EscapeHtml("abcdefghijklmnopqrstuvwxyz0123456789<"
+                             "abcdefghijklmnopqrstuvwxyz0123456789&",
+                             -1, 0)));
+}
+
+TEST(ParseUrl, longComponents) {
+  struct Url h;
+  gc(ParseUrl("/abcdefghijklmnopqrstuvwxyz/%41bcdefghijklmnopqrstuvwxyz"
+              "?abcdefghijklmnopqrstuvwxyz=abcdefghijklmnopqrstuvwxyz+0"
+              "#abcdefghijklmnopqrstuvwxyz%2Fabcdefghijklmnopqrstuvwxyz",
+              -1, &h, kUrlPlus));
+  gc(h.params.p);
+  ASSERT_EQ(54, h.path.n);
+  EXPECT_BINEQ(u"/abcdefghijklmnopqrstuvwxyz/Abcdefghijklmnopqrstuvwxyz",
+               h.path.p);
+  ASSERT_EQ(1, h.params.n);
+  ASSERT_EQ(26, h.params.p[0].key.n);
+  ASSERT_EQ(28, h.params.p[0].val.n);
+  EXPECT_BINEQ(u"abcdefghijklmnopqrstuvwxyz 0", h.params.p[0].val.p);
+  ASSERT_EQ(53, h.fragment.n);
+  EXPECT_BINEQ(u"abcdefghijklmnopqrstuvwxyz/abcdefghijklmnopqrstuvwxyz",
+               h.fragment.p);
+}
+
+TEST(ParseUrl, longLatin1) {
+  struct Url h;
+  char b[40];
+  memset(b, 'a', sizeof(b));
+  b[0] = '/';
+  b[33] = 0351;
+  gc(ParseUrl(b, sizeof(b), &h, kUrlLatin1));
+  ASSERT_EQ(41, h.path.n);
+  EXPECT_EQ(0303, h.path.p[33] & 255);
+  EXPECT_EQ(0251, h.path.p[34] & 255);
+}
+
+TEST(ParseUrl, opaqueQuestionMarkAtEnd_doesntStartQuery) {
+  struct Url h;
+  gc(ParseUrl("s:abcdefghijklmnopqrstuvwxyz?abcdefghijklmnopqrstuvwxyz", -1,
+              &h, 0));
+  EXPECT_EQ(53, h.path.n);
+  EXPECT_EQ(NULL, h.params.p);
+}
+
+BENCH(UnescapedSpan, bench) {
+  struct Url h;
+  EZBENCH2("UnescapedSpan hyperion", donothing,
+           UnescapedSpan(kHyperion, kHyperionSize, kEscapeFragment));
+  EZBENCH2("UnescapedSpanScalar hyperion", donothing,
+           UnescapedSpanScalar(kHyperion, kHyperionSize, kEscapeFragment));
+  EZBENCH2("EscapeHtml hyperion", donothing,
+           free(EscapeHtml(kHyperion, kHyperionSize, 0)));
+  EZBENCH2("EscapePath hyperion", donothing,
+           free(EscapePath(kHyperion, kHyperionSize, 0)));
+  EZBENCH2("EscapeParam hyperion", donothing,
+           free(EscapeParam(kHyperion, kHyperionSize, 0)));
+  EZBENCH2("EncodeLatin1 hyperion", donothing,
+           free(EncodeLatin1(kHyperion, kHyperionSize, 0, 0)));
+  EZBENCH2("ParseUrl hyperion", donothing, ({
+             free(ParseUrl(kHyperion, kHyperionSize, &h, 0));
+             free(h.params.p);
+           }));
+}
@@ -70,6 +70,36 @@ o/$(MODE)/test/tool/net/%.com.dbg:				\
 		$(APE_NO_MODIFY_SELF)
 	@$(APELINK)
 
+o/$(MODE)/test/tool/net/ziposvfs_test.com.dbg:			\
+		$(TEST_TOOL_NET_DEPS)				\
+		$(TEST_TOOL_NET_A)				\
+		o/$(MODE)/test/tool/net/ziposvfs_test.o		\
+		o/$(MODE)/test/tool/net/ziposvfs_test.db.zip.o	\
+		o/$(MODE)/test/tool/net/ziposvfs_test.deflated.db.zip.o \
+		$(TEST_TOOL_NET_A).pkg				\
+		$(LIBC_TESTMAIN)				\
+		$(CRT)						\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
+# the vfs has separate paths for stored and compressed entries, so the
+# fixture database gets linked into the test both ways
+o/$(MODE)/test/tool/net/ziposvfs_test.db:			\
+		test/tool/net/ziposvfs_test.sql			\
+		o/$(MODE)/third_party/sqlite3/sqlite3.com
+	@$(COMPILE) -wASQLITE3 -T$@				\
+		o/$(MODE)/third_party/sqlite3/sqlite3.com	\
+		$@ ".read $<"
+
+o/$(MODE)/test/tool/net/ziposvfs_test.db.zip.o: private	\
+		ZIPOBJ_FLAGS +=					\
+			-B -0
+
+o/$(MODE)/test/tool/net/ziposvfs_test.deflated.db.zip.o:	\
+		o/$(MODE)/test/tool/net/ziposvfs_test.db
+	@$(COMPILE) -wAZIPOBJ $(ZIPOBJ) $(ZIPOBJ_FLAGS)		\
+		-N ziposvfs_test.deflated.db $(OUTPUT_OPTION) $<
+
 o/$(MODE)/test/tool/net/redbean-tester.com.dbg:			\
 		$(TOOL_NET_DEPS)				\
 		o/$(MODE)/tool/net/redbean.o			\
@@ -0,0 +1,254 @@
+-- Copyright 2023 Justine Alexandra Roberts Tunney
+--
+-- Permission to use, copy, modify, and/or distribute this software for
+-- any purpose with or without fee is hereby granted, provided that the
+-- above copyright notice and this permission notice appear in all copies.
+--
+-- THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+-- WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+-- WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+-- AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+-- DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+-- PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+-- TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+-- PERFORMANCE OF THIS SOFTWARE.
+
+maxmind = require 'maxmind'
+tmpdir = "%s/o/tmp/maxmind_test.%d" % {os.getenv('TMPDIR'), unix.getpid()}
+
+--------------------------------------------------------------------------------
+-- build tiny geoip database with the same layout as GeoLite2-City.mmdb
+-- where ipv4 addresses live at ::a.b.c.d in an ipv6 search tree, or if
+-- ipversion is 4, like GeoLite2-Country-IPv4 with a 32-bit deep tree
+
+local function Str(s)
+   assert(#s < 29)
+   return string.char(0x40 | #s) .. s
+end
+
+local function Map(...)
+   local t = {...}
+   local b = {string.char(0xe0 | (#t // 2))}
+   for i = 1, #t, 2 do
+      b[#b + 1] = Str(t[i]) .. t[i + 1]
+   end
+   return table.concat(b)
+end
+
+local function Array(...)
+   local t = {...}
+   return string.char(#t, 11 - 7) .. table.concat(t)
+end
+
+local function U16(x) return '\xa2' .. string.pack('>I2', x) end
+local function U32(x) return '\xc4' .. string.pack('>I4', x) end
+local function U64(x) return '\x08' .. string.char(9 - 7) .. string.pack('>I8', x) end
+
+local function Insert(nodes, pad, ip, bits, record)
+   local cur = 0
+   for b = 0, pad + bits - 1 do
+      local bit = 0
+      if b >= pad then
+         bit = (ip >> (31 - (b - pad))) & 1
+      end
+      local node = nodes[cur + 1]
+      if b == pad + bits - 1 then
+         node[bit + 1] = {data=record}
+      else
+         if not node[bit + 1] then
+            nodes[#nodes + 1] = {}
+            node[bit + 1] = {node=#nodes - 1}
+         end
+         cur = node[bit + 1].node
+      end
+   end
+end
+
+local function MakeDatabase(ipversion)
+   local pad = ipversion == 6 and 96 or 0
+   local data = {}
+   local records = {}
+   local size = 0
+   for _, x in ipairs({{'US', 'Boston'},
+                       {'DE', 'Berlin'},
+                       {'JP', 'Tokyo'},
+                       {'NZ'}}) do
+      local r
+      if x[2] then
+         r = Map('country', Map('iso_code', Str(x[1])),
+                 'city', Map('names', Map('en', Str(x[2]))))
+      else
+         r = Map('country', Map('iso_code', Str(x[1])))
+      end
+      records[#records + 1] = size
+      data[#data + 1] = r
+      size = size + #r
+   end
+   -- every /8 below 224 is a network, except 10/8, which only has two
+   -- /25 networks, so not all ips in 10.0.0.0/24 have the same result
+   local nodes = {{}}
+   for n = 0, 223 do
+      if n ~= 10 then
+         Insert(nodes, pad, n << 24, 8, records[n % 4 + 1])
+      end
+   end
+   Insert(nodes, pad, ParseIp('10.0.0.0'), 25, records[3])
+   Insert(nodes, pad, ParseIp('10.0.0.128'), 25, records[1])
+   local tree = {}
+   for i, node in ipairs(nodes) do
+      for k = 1, 2 do
+         local x = node[k]
+         if not x then
+            x = #nodes
+         elseif x.node then
+            x = x.node
+         else
+            x = #nodes + 16 + x.data
+         end
+         tree[#tree + 1] = string.pack('>I3', x)
+      end
+   end
+   return table.concat(tree) ..
+      string.rep('\0', 16) ..
+      table.concat(data) ..
+      '\xab\xcd\xefMaxMind.com' ..
+      Map('node_count', U32(#nodes),
+          'record_size', U16(24),
+          'ip_version', U16(ipversion),
+          'database_type', Str('Test-City'),
+          'languages', Array(Str('en')),
+          'binary_format_major_version', U16(2),
+          'binary_format_minor_version', U16(0),
+          'build_epoch', U64(1700000000),
+          'description', Map('en', Str('test')))
+end
+
+--------------------------------------------------------------------------------
+
+local function MaxmindTest()
+   local path = tmpdir .. '/test.mmdb'
+   assert(Barf(path, MakeDatabase(6)))
+   db = maxmind.open(path)
+
+   -- lookup same /24 twice, where the second time is served by cache
+   for i = 1, 2 do
+      r = assert(db:lookup(ParseIp('1.2.3.%d' % {i})))
+      assert(r:country() == 'DE')
+      assert(r:city() == 'Berlin')
+      assert(r:netmask() == 8)
+      assert(r:get('country', 'iso_code') == 'DE')
+      assert(r:get('city', 'names', 'en') == 'Berlin')
+      assert(r:get('nope') == nil)
+      assert(r:get().country.iso_code == 'DE')
+   end
+
+   r = assert(db:lookup(ParseIp('3.1.1.1')))
+   assert(r:country() == 'NZ')
+   assert(r:city() == nil)
+   assert(db:lookup(ParseIp('224.0.0.1')) == nil)
+   assert(db:lookup(-1) == nil)
+
+   -- networks more specific than /24 mustn't be cached
+   for i = 1, 2 do
+      r = assert(db:lookup(ParseIp('10.0.0.1')))
+      assert(r:country() == 'JP')
+      assert(r:netmask() == 25)
+      r = assert(db:lookup(ParseIp('10.0.0.129')))
+      assert(r:country() == 'US')
+      assert(r:netmask() == 25)
+   end
+   assert(db:lookup(ParseIp('10.0.1.1')) == nil)
+
+   t = db:lookupmany({ParseIp('2.2.2.2'),
+                      ParseIp('224.0.0.1'),
+                      'x',
+                      ParseIp('10.0.0.129')})
+   assert(#t == 4)
+   assert(t[1]:country() == 'JP')
+   assert(t[1]:city() == 'Tokyo')
+   assert(t[2] == false)
+   assert(t[3] == false)
+   assert(t[4]:country() == 'US')
+
+   -- results keep database alive
+   local db2 = maxmind.open(path)
+   local r2 = assert(db2:lookup(ParseIp('10.0.0.129')))
+   db2 = nil
+   collectgarbage()
+   assert(r2:city() == 'Boston')
+end
+
+-- MMDB_lookup() used to walk ipv4 databases with the upper 32 bits of
+-- ::a.b.c.d which are always zero, so every ip resolved to 0.0.0.0/8
+local function Ipv4DatabaseTest()
+   local path = tmpdir .. '/test4.mmdb'
+   assert(Barf(path, MakeDatabase(4)))
+   local db4 = maxmind.open(path)
+   r = assert(db4:lookup(ParseIp('0.1.2.3')))
+   assert(r:country() == 'US')
+   assert(r:netmask() == 8)
+   r = assert(db4:lookup(ParseIp('1.2.3.4')))
+   assert(r:country() == 'DE')
+   assert(r:city() == 'Berlin')
+   assert(r:netmask() == 8)
+   r = assert(db4:lookup(ParseIp('3.1.1.1')))
+   assert(r:country() == 'NZ')
+   assert(r:get('country', 'iso_code') == 'NZ')
+   r = assert(db4:lookup(ParseIp('10.0.0.1')))
+   assert(r:country() == 'JP')
+   assert(r:netmask() == 25)
+   r = assert(db4:lookup(ParseIp('10.0.0.129')))
+   assert(r:country() == 'US')
+   assert(r:netmask() == 25)
+   assert(db4:lookup(ParseIp('10.0.1.1')) == nil)
+   assert(db4:lookup(ParseIp('224.0.0.1')) == nil)
+end
+
+--------------------------------------------------------------------------------
+-- benchmark, printing lookups per second
+
+IPS = {}
+for i = 1, 1000 do
+   IPS[i] = Rand64() & 0xffffffff
+end
+
+function MaxmindLookup()
+   for i = 1, #IPS do
+      r = db:lookup(IPS[i])
+      if r then r:country() end
+   end
+end
+
+function MaxmindLookupMany()
+   for _, r in ipairs(db:lookupmany(IPS)) do
+      if r then r:country() end
+   end
+end
+
+function bench()
+   print("MaxmindLookup", "%d lookups/sec" % {
+            #IPS * 1e9 // Benchmark(MaxmindLookup)})
+   print("MaxmindLookupMany", "%d lookups/sec" % {
+            #IPS * 1e9 // Benchmark(MaxmindLookupMany)})
+end
+
+--------------------------------------------------------------------------------
+
+local function main()
+   assert(unix.makedirs(tmpdir))
+   unix.unveil(tmpdir, "rwc")
+   unix.unveil(nil, nil)
+   assert(unix.pledge("stdio rpath wpath cpath"))
+   ok, err = pcall(MaxmindTest)
+   if ok then
+      ok, err = pcall(Ipv4DatabaseTest)
+   end
+   if ok then
+      assert(unix.rmrf(tmpdir))
+   else
+      print(err)
+      error('MaxmindTest failed (%s)' % {tmpdir})
+   end
+end
+
+main()
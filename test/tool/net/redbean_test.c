@@ -287,4 +287,41 @@ Z\n",
   EXPECT_NE(-1, sigprocmask(SIG_SETMASK, &savemask, 0));
 }
 
+TEST(redbean, testGcFreeze) {
+  if (IsWindows()) return;
+  char portbuf[16];
+  int pid, pipefds[2];
+  sigset_t chldmask, savemask;
+  sigaddset(&chldmask, SIGCHLD);
+  EXPECT_NE(-1, sigprocmask(SIG_BLOCK, &chldmask, &savemask));
+  ASSERT_NE(-1, pipe(pipefds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    setpgrp();
+    close(0);
+    open("/dev/null", O_RDWR);
+    close(1);
+    close(pipefds[0]);
+    dup2(pipefds[1], 1);
+    sigprocmask(SIG_SETMASK, &savemask, NULL);
+    execv("bin/redbean-tester.com",
+          (char *const[]){"bin/redbean-tester.com", "-vvszXp0", "-l127.0.0.1",
+                          "-e", "ProgramGcFreeze(true)",
+                          "-e", "ProgramWorkerGc('generational', 20, 400)",
+                          __strace > 0 ? "--strace" : 0, 0});
+    _exit(127);
+  }
+  EXPECT_NE(-1, close(pipefds[1]));
+  EXPECT_NE(-1, read(pipefds[0], portbuf, sizeof(portbuf)));
+  port = atoi(portbuf);
+  EXPECT_TRUE(Matches("HTTP/1\\.1 200 OK\r\n.*"
+                      "lua\\.frozen: [1-9][0-9]*\r\n.*"
+                      "self\\.ru_minflt: [1-9][0-9]*\r\n",
+                      gc(SendHttpRequest("GET /statusz HTTP/1.1\n\n"))));
+  EXPECT_EQ(0, close(pipefds[0]));
+  EXPECT_NE(-1, kill(pid, SIGTERM));
+  EXPECT_NE(-1, wait(0));
+  EXPECT_NE(-1, sigprocmask(SIG_SETMASK, &savemask, 0));
+}
+
 #endif /* __x86_64__ */
@@ -0,0 +1,135 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/runtime/zipos.internal.h"
+#include "libc/testlib/testlib.h"
+#include "libc/zip.internal.h"
+#include "third_party/sqlite3/extensions.h"
+#include "third_party/sqlite3/sqlite3.h"
+
+__static_yoink("zipos");
+
+#define STORED   "file:/zip/ziposvfs_test.db?vfs=zipos"
+#define DEFLATED "file:/zip/ziposvfs_test.deflated.db?vfs=zipos"
+
+sqlite3 *db;
+
+void SetUpOnce(void) {
+  sqlite3_initialize();
+  ASSERT_EQ(SQLITE_OK_LOAD_PERMANENTLY, sqlite3_ziposvfs_init(0, 0, 0));
+}
+
+void TearDown(void) {
+  ASSERT_EQ(SQLITE_OK, sqlite3_close(db));
+  db = 0;
+}
+
+int GetCompressionMethod(const char *path) {
+  ssize_t cf;
+  struct Zipos *z;
+  struct ZiposUri uri;
+  ASSERT_NE(-1, __zipos_parseuri(path, &uri));
+  ASSERT_NE(NULL, (z = __zipos_get()));
+  ASSERT_NE(-1, (cf = __zipos_find(z, &uri)));
+  return ZIP_LFILE_COMPRESSIONMETHOD(z->map + GetZipCfileOffset(z->map + cf));
+}
+
+void Open(const char *uri, int flags) {
+  ASSERT_EQ(SQLITE_OK, sqlite3_open_v2(uri, &db, flags | SQLITE_OPEN_URI, 0));
+}
+
+int64_t GetInt(const char *sql) {
+  int64_t x;
+  sqlite3_stmt *stmt;
+  ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(db, sql, -1, &stmt, 0));
+  ASSERT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  x = sqlite3_column_int64(stmt, 0);
+  ASSERT_EQ(SQLITE_OK, sqlite3_finalize(stmt));
+  return x;
+}
+
+void CheckQuery(void) {
+  sqlite3_stmt *stmt;
+  ASSERT_EQ(1000, GetInt("SELECT COUNT(*) FROM t"));
+  ASSERT_EQ(500500, GetInt("SELECT SUM(id) FROM t"));
+  ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(
+                           db, "SELECT name FROM t WHERE id = 777", -1, &stmt,
+                           0));
+  ASSERT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  ASSERT_STREQ("row 777", (const char *)sqlite3_column_text(stmt, 0));
+  ASSERT_EQ(SQLITE_OK, sqlite3_finalize(stmt));
+}
+
+void CheckFileControl(void) {
+  char *name = 0;
+  sqlite3_int64 mmapsize = -1;
+  ASSERT_EQ(SQLITE_OK, sqlite3_file_control(db, "main", SQLITE_FCNTL_VFSNAME,
+                                            &name));
+  ASSERT_STREQ("zipos", name);
+  sqlite3_free(name);
+  ASSERT_EQ(SQLITE_OK, sqlite3_file_control(db, "main", SQLITE_FCNTL_MMAP_SIZE,
+                                            &mmapsize));
+  ASSERT_EQ(GetInt("PRAGMA page_count") * GetInt("PRAGMA page_size"),
+            mmapsize);
+  ASSERT_EQ(mmapsize, GetInt("PRAGMA mmap_size"));
+}
+
+void CheckWritesAreRejected(void) {
+  ASSERT_EQ(1, sqlite3_db_readonly(db, "main"));
+  ASSERT_EQ(SQLITE_READONLY,
+            sqlite3_exec(db, "INSERT INTO t (name) VALUES ('hi')", 0, 0, 0));
+  ASSERT_EQ(SQLITE_READONLY, sqlite3_exec(db, "DELETE FROM t", 0, 0, 0));
+  CheckQuery();
+}
+
+TEST(ziposvfs, storedEntry_isServedFromTheMapping) {
+  ASSERT_EQ(kZipCompressionNone, GetCompressionMethod("/zip/ziposvfs_test.db"));
+  Open(STORED, SQLITE_OPEN_READONLY);
+  CheckFileControl();
+  CheckQuery();
+}
+
+TEST(ziposvfs, deflatedEntry_isInflatedOnOpen) {
+  ASSERT_EQ(kZipCompressionDeflate,
+            GetCompressionMethod("/zip/ziposvfs_test.deflated.db"));
+  Open(DEFLATED, SQLITE_OPEN_READONLY);
+  CheckFileControl();
+  CheckQuery();
+}
+
+TEST(ziposvfs, withoutMmap_usesRead) {
+  Open(STORED, SQLITE_OPEN_READONLY);
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, "PRAGMA mmap_size=0", 0, 0, 0));
+  CheckQuery();
+}
+
+TEST(ziposvfs, openedForWriting_rejectsWrites) {
+  Open(STORED, SQLITE_OPEN_READWRITE);
+  CheckWritesAreRejected();
+}
+
+TEST(ziposvfs, deflatedOpenedForWriting_rejectsWrites) {
+  Open(DEFLATED, SQLITE_OPEN_READWRITE);
+  CheckWritesAreRejected();
+}
+
+TEST(ziposvfs, missingEntry_cantOpen) {
+  ASSERT_EQ(SQLITE_CANTOPEN,
+            sqlite3_open_v2("file:/zip/doesnotexist.db?vfs=zipos", &db,
+                            SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, 0));
+}
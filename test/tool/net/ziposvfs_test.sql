@@ -0,0 +1,10 @@
+-- fixture database for ziposvfs_test.c
+-- it's linked into the test twice, once stored and once deflated
+PRAGMA journal_mode=OFF;
+DROP TABLE IF EXISTS t;
+CREATE TABLE t (
+  id INTEGER PRIMARY KEY,
+  name TEXT
+);
+WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000)
+INSERT INTO t SELECT x, printf('row %d', x) FROM c;
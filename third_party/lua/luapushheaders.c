@@ -27,7 +27,7 @@ int LuaPushHeaders(lua_State *L, struct HttpMessage *m, const char *b) {
   size_t i, h;
   struct HttpHeader *x;
   lua_newtable(L);
-  for (h = 0; h < kHttpHeadersMax; ++h) {
+  for (h = 0; h < kHttpHeadersMax + kHttpCustomHeadersMax; ++h) {
     if (m->headers[h].a) {
       LuaPushHeader(L, m, b, h);
       lua_setfield(L, -2, GetHttpHeaderName(h));
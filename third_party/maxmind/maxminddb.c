@@ -888,7 +888,9 @@ MMDB_lookup_result_s MMDB_lookup(const MMDB_s *mmdb, uint32_t ip, int *error) {
   a[0xd] = (ip & 0x00ff0000) >> 020;
   a[0xe] = (ip & 0x0000ff00) >> 010;
   a[0xf] = (ip & 0x000000ff) >> 000;
-  *error = find_address_in_search_tree(mmdb, a, AF_INET, &result);
+  // ipv4 databases have a 32-bit deep search tree
+  *error = find_address_in_search_tree(
+      mmdb, a + (mmdb->metadata.ip_version == 4 ? 12 : 0), AF_INET, &result);
   return result;
 }
 
@@ -3903,6 +3903,27 @@ $(THIRD_PARTY_PYTHON_STAGE2_A_DATA_OBJS): private ZIPOBJ_FLAGS += -P.python -C3
 $(THIRD_PARTY_PYTHON_PYTEST_A_PYS_OBJS): private PYFLAGS += -P.python -C3
 $(THIRD_PARTY_PYTHON_PYTEST_A_DATA_OBJS): private ZIPOBJ_FLAGS += -P.python -C3
 
+# modules imported by every interpreter startup are stored rather than
+# deflated, so CosmoImporter can unmarshal them from the zip in place
+o/$(MODE)/third_party/python/Lib/_bootlocale.o				\
+o/$(MODE)/third_party/python/Lib/_collections_abc.o			\
+o/$(MODE)/third_party/python/Lib/_sitebuiltins.o			\
+o/$(MODE)/third_party/python/Lib/_sysconfigdata_m_cosmo_x86_64_cosmo.o	\
+o/$(MODE)/third_party/python/Lib/_weakrefset.o				\
+o/$(MODE)/third_party/python/Lib/abc.o					\
+o/$(MODE)/third_party/python/Lib/codecs.o				\
+o/$(MODE)/third_party/python/Lib/encodings/__init__.o			\
+o/$(MODE)/third_party/python/Lib/encodings/aliases.o			\
+o/$(MODE)/third_party/python/Lib/encodings/latin_1.o			\
+o/$(MODE)/third_party/python/Lib/encodings/utf_8.o			\
+o/$(MODE)/third_party/python/Lib/genericpath.o				\
+o/$(MODE)/third_party/python/Lib/io.o					\
+o/$(MODE)/third_party/python/Lib/os.o					\
+o/$(MODE)/third_party/python/Lib/posixpath.o				\
+o/$(MODE)/third_party/python/Lib/site.o					\
+o/$(MODE)/third_party/python/Lib/stat.o					\
+o/$(MODE)/third_party/python/Lib/sysconfig.o: private PYFLAGS += -0
+
 o/$(MODE)/third_party/python/Python/ceval.o: private QUOTA = -C64 -M1024m -L300
 o/$(MODE)/third_party/python/Objects/unicodeobject.o: private QUOTA += -C64 -M1024m -L300
 
@@ -18,5 +18,36 @@ class SubprocessTest(unittest.TestCase):
         self.assertEqual(0, proc.wait())
 
 
+class ZipStoreImportTest(unittest.TestCase):
+    def find_spec(self, name):
+        import _imp
+        return _imp.CosmoImporter.find_spec(name)
+
+    def test_module(self):
+        spec = self.find_spec('encodings.utf_8')
+        self.assertEqual('/zip/.python/encodings/utf_8.pyc', spec.origin)
+        self.assertIsNone(spec.submodule_search_locations)
+
+    def test_package(self):
+        spec = self.find_spec('json')
+        self.assertEqual('/zip/.python/json/__init__.pyc', spec.origin)
+        self.assertEqual(['/zip/.python/json'],
+                         spec.submodule_search_locations)
+
+    def test_missing(self):
+        self.assertIsNone(self.find_spec('json.doesnotexist'))
+        self.assertIsNone(self.find_spec('doesnotexist'))
+
+    def test_loadsCode(self):
+        spec = self.find_spec('json.decoder')
+        code = spec.loader.get_code('json.decoder')
+        self.assertEqual('<module>', code.co_name)
+
+    def test_storedStartupModule(self):
+        spec = self.find_spec('codecs')
+        code = spec.loader.get_code('codecs')
+        self.assertIn('lookup', code.co_names)
+
+
 if __name__ == '__main__':
     unittest.main()
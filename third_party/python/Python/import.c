@@ -14,9 +14,12 @@
 #include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
+#include "libc/runtime/internal.h"
+#include "libc/runtime/zipos.internal.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/s.h"
 #include "libc/x/x.h"
+#include "libc/zip.internal.h"
 #include "third_party/python/Include/Python-ast.h"
 #include "third_party/python/Include/abstract.h"
 #include "third_party/python/Include/bltinmodule.h"
@@ -2391,6 +2394,7 @@ typedef struct {
   Py_ssize_t namelen;
   Py_ssize_t pathlen;
   Py_ssize_t present;
+  size_t cfile; /* zip store central directory record, or zero */
 } SourcelessFileLoader;
 
 static PyTypeObject SourcelessFileLoaderType;
@@ -2406,6 +2410,7 @@ static SourcelessFileLoader *SFLObject_new(PyObject *cls, PyObject *args,
   obj->namelen = 0;
   obj->pathlen = 0;
   obj->present = 0;
+  obj->cfile = 0;
   return obj;
 }
 
@@ -2446,6 +2451,7 @@ static int SFLObject_init(SourcelessFileLoader *self, PyObject *args,
       self->name = strndup(name, namelen);
       self->path = strndup(path, pathlen);
       self->present = 0;
+      self->cfile = 0;
   }
   return result;
 }
@@ -2480,6 +2486,174 @@ static PyObject *SFLObject_get_source(SourcelessFileLoader *self,
   Py_RETURN_NONE;
 }
 
+/* Index of the bytecode in the zip store, built on first import.
+ *
+ * Maps dotted module names like "encodings.utf_8" to the central
+ * directory record of ".python/encodings/utf_8.pyc", or of
+ * ".python/encodings/__init__.pyc" for packages, so CosmoImporter can
+ * resolve a module with one probe instead of two stat() calls, and the
+ * loader can unmarshal the entry without opening a zipos file handle.
+ */
+typedef struct {
+  uint32_t hash;
+  uint32_t len;   /* length of module name */
+  uint32_t ispkg; /* true if record is the package __init__.pyc */
+  size_t cfile;   /* central directory record offset, or 0 if empty */
+} ZipStoreEntry;
+
+static struct {
+  bool once;
+  uint32_t mask;
+  ZipStoreEntry *p;
+} ZipStore;
+
+static const char kZipStorePrefix[] = ".python/";
+
+static uint32_t ZipStoreHash(const char *s, size_t n) {
+  size_t i;
+  uint32_t h;
+  for (h = ZIPOS_HASH_INIT, i = 0; i < n; ++i) {
+    h = ZIPOS_HASH_STEP(h, s[i] == '/' ? '.' : s[i]);
+  }
+  return h;
+}
+
+static bool ZipStoreEqual(const char *zname, const char *name, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    if ((zname[i] == '/' ? '.' : zname[i]) != name[i]) return false;
+  }
+  return true;
+}
+
+static const char *ZipStoreName(struct Zipos *z, size_t cfile) {
+  return ZIP_CFILE_NAME(z->map + cfile) + sizeof(kZipStorePrefix) - 1;
+}
+
+static void ZipStoreInsert(struct Zipos *z, size_t cfile, const char *name,
+                           size_t len, bool ispkg) {
+  uint32_t h, i;
+  ZipStoreEntry *e;
+  h = ZipStoreHash(name, len);
+  for (i = h & ZipStore.mask;; i = (i + 1) & ZipStore.mask) {
+    e = ZipStore.p + i;
+    if (!e->cfile) {
+      e->hash = h;
+      e->len = len;
+      e->ispkg = ispkg;
+      e->cfile = cfile;
+      return;
+    }
+    if (e->hash == h && e->len == len &&
+        ZipStoreEqual(ZipStoreName(z, e->cfile), name, len)) {
+      /* foo.pyc takes precedence over foo/__init__.pyc */
+      if (e->ispkg && !ispkg) {
+        e->ispkg = false;
+        e->cfile = cfile;
+      }
+      return;
+    }
+  }
+}
+
+static void ZipStoreInit(void) {
+  size_t i, n, m, len, cfile, range[2];
+  const char *name;
+  struct Zipos *z;
+  ZipStore.once = true;
+  if (!(z = __zipos_get())) return;
+  __zipos_children(z, kZipStorePrefix, sizeof(kZipStorePrefix) - 1, range);
+  for (n = 0, i = range[0]; i < range[1]; ++i) {
+    cfile = z->index[i];
+    len = ZIP_CFILE_NAMESIZE(z->map + cfile);
+    name = ZIP_CFILE_NAME(z->map + cfile);
+    if (len > sizeof(kZipStorePrefix) - 1 + 4 &&
+        !memcmp(name, kZipStorePrefix, sizeof(kZipStorePrefix) - 1) &&
+        !memcmp(name + len - 4, ".pyc", 4)) {
+      ++n;
+    }
+  }
+  m = 16;
+  while (m < n * 2) m <<= 1;
+  if (!(ZipStore.p = calloc(m, sizeof(ZipStoreEntry)))) return;
+  ZipStore.mask = m - 1;
+  for (i = range[0]; i < range[1]; ++i) {
+    cfile = z->index[i];
+    len = ZIP_CFILE_NAMESIZE(z->map + cfile);
+    name = ZIP_CFILE_NAME(z->map + cfile);
+    if (len > sizeof(kZipStorePrefix) - 1 + 4 &&
+        !memcmp(name, kZipStorePrefix, sizeof(kZipStorePrefix) - 1) &&
+        !memcmp(name + len - 4, ".pyc", 4)) {
+      name += sizeof(kZipStorePrefix) - 1;
+      len -= sizeof(kZipStorePrefix) - 1 + 4;
+      if (len > 9 && !memcmp(name + len - 9, "/__init__", 9)) {
+        ZipStoreInsert(z, cfile, name, len - 9, true);
+      } else if (len != 8 || memcmp(name, "__init__", 8)) {
+        ZipStoreInsert(z, cfile, name, len, false);
+      }
+    }
+  }
+}
+
+static ZipStoreEntry *ZipStoreFind(const char *name, size_t len) {
+  uint32_t h, i;
+  ZipStoreEntry *e;
+  h = ZipStoreHash(name, len);
+  for (i = h & ZipStore.mask; (e = ZipStore.p + i)->cfile;
+       i = (i + 1) & ZipStore.mask) {
+    if (e->hash == h && e->len == len &&
+        ZipStoreEqual(ZipStoreName(__zipos_get(), e->cfile), name, len)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+/* Unmarshals code object from zip store without opening the file.
+ * Stored entries are read in place from the executable mapping, and
+ * deflated entries are inflated into a temporary buffer. */
+static PyObject *ZipStoreGetCode(size_t cfile, const char *name) {
+  int32_t magic;
+  size_t size;
+  uint8_t *lf;
+  struct Zipos *z;
+  char *data, *rawbuf = NULL;
+  PyObject *res = NULL;
+  z = __zipos_get();
+  lf = z->map + GetZipCfileOffset(z->map + cfile);
+  size = GetZipCfileUncompressedSize(z->map + cfile);
+  if (ZIP_LFILE_MAGIC(lf) != kZipLfileHdrMagic) {
+    PyErr_Format(PyExc_ImportError, "corrupt zip store entry for %s\n", name);
+    return NULL;
+  }
+  if (ZIP_CFILE_COMPRESSIONMETHOD(z->map + cfile) == kZipCompressionNone) {
+    data = (char *)ZIP_LFILE_CONTENT(lf);
+  } else {
+    if (!(data = rawbuf = PyMem_RawMalloc(MAX(1, size)))) {
+      return PyErr_NoMemory();
+    }
+    if (__inflate(rawbuf, size, ZIP_LFILE_CONTENT(lf),
+                  GetZipCfileCompressedSize(z->map + cfile))) {
+      PyErr_Format(PyExc_ImportError, "failed to inflate %s\n", name);
+      goto exit;
+    }
+  }
+  if (size < 4 || (magic = READ32LE(data)) != PyImport_GetMagicNumber()) {
+    PyErr_Format(PyExc_ImportError, "bad magic number in %s: %d\n", name,
+                 size < 4 ? 0 : magic);
+    goto exit;
+  }
+  if (size < 12) {
+    PyErr_Format(PyExc_ImportError,
+                 "reached EOF while reading timestamp in %s\n", name);
+    goto exit;
+  }
+  res = PyMarshal_ReadObjectFromString(data + 12, size - 12);
+exit:
+  if (rawbuf) PyMem_RawFree(rawbuf);
+  return res;
+}
+
 static PyObject *SFLObject_get_code(SourcelessFileLoader *self, PyObject *arg) {
   struct stat stinfo;
   char bytecode_header[12] = {0};
@@ -2500,6 +2674,7 @@ static PyObject *SFLObject_get_code(SourcelessFileLoader *self, PyObject *arg) {
                  self->name, name);
     goto exit;
   }
+  if (self->cfile) return ZipStoreGetCode(self->cfile, name);
   self->present = self->present || !stat(self->path, &stinfo);
   if (!self->present || !(fp = fopen(self->path, "rb"))) {
     PyErr_Format(PyExc_ImportError, "%s does not exist\n", self->path);
@@ -2736,6 +2911,8 @@ static PyObject *CosmoImporter_find_spec(PyObject *cls, PyObject **args,
 
   SourcelessFileLoader *loader = NULL;
   PyObject *origin = NULL;
+  PyObject *spec = NULL;
+  struct Zipos *z;
   int inside_zip = 0;
   int is_package = 0;
   int is_available = 0;
@@ -2767,6 +2944,47 @@ static PyObject *CosmoImporter_find_spec(PyObject *cls, PyObject **args,
   }
 
   if (!PyArg_Parse(fullname, "z#:find_spec", &cname, &cnamelen)) return 0;
+
+  if (!ZipStore.once) ZipStoreInit();
+  if (ZipStore.p) {
+    ZipStoreEntry *e;
+    if (!(e = ZipStoreFind(cname, cnamelen))) Py_RETURN_NONE;
+    z = __zipos_get();
+    newpathlen = 5 + ZIP_CFILE_NAMESIZE(z->map + e->cfile);
+    if (!(newpath = malloc(newpathlen + 1))) return PyErr_NoMemory();
+    memcpy(newpath, "/zip/", 5);
+    memcpy(newpath + 5, ZIP_CFILE_NAME(z->map + e->cfile), newpathlen - 5);
+    newpath[newpathlen] = 0;
+    loader = SFLObject_new(NULL, NULL, NULL);
+    origin = PyUnicode_FromStringAndSize(newpath, newpathlen);
+    if (loader == NULL || origin == NULL) {
+      free(newpath);
+      Py_XDECREF(loader);
+      Py_XDECREF(origin);
+      return NULL;
+    }
+    loader->name = strdup(cname);
+    loader->namelen = cnamelen;
+    loader->path = newpath;
+    loader->pathlen = newpathlen;
+    loader->present = 1;
+    switch (ZIP_CFILE_COMPRESSIONMETHOD(z->map + e->cfile)) {
+      case kZipCompressionNone:
+      case kZipCompressionDeflate:
+        loader->cfile = e->cfile;
+        break;
+      default:
+        break; /* fall back to reading it through zipos */
+    }
+    spec = _PyObject_CallMethodIdObjArgs(interp->importlib,
+                                         &PyId__get_zipstore_spec, fullname,
+                                         (PyObject *)loader, origin,
+                                         e->ispkg ? Py_True : Py_False, NULL);
+    Py_DECREF(loader);
+    Py_DECREF(origin);
+    return spec;
+  }
+
   /* before checking within the zip store,
    * we can check cname here to skip any values
    * of cname that we know for sure won't be there,
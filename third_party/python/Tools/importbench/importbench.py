@@ -162,6 +162,41 @@ tabnanny_using_bytecode = _using_bytecode(tabnanny)
 decimal_using_bytecode = _using_bytecode(decimal)
 
 
+STARTUP_MODULES = (
+    '__future__', 'abc', 'argparse', 'ast', 'base64', 'bdb', 'bisect', 'bz2',
+    'calendar', 'cmd', 'code', 'codecs', 'codeop', 'collections',
+    'collections.abc', 'colorsys', 'configparser', 'contextlib', 'copy',
+    'copyreg', 'csv', 'datetime', 'decimal', 'difflib', 'dis', 'email',
+    'email.message', 'email.parser', 'email.utils', 'enum', 'filecmp',
+    'fnmatch', 'fractions', 'ftplib', 'functools', 'getopt', 'gettext', 'glob',
+    'gzip', 'hashlib', 'heapq', 'hmac', 'html', 'html.parser', 'http',
+    'http.client', 'imp', 'importlib', 'importlib.util', 'inspect', 'io',
+    'ipaddress', 'json', 'json.decoder', 'keyword', 'linecache', 'locale',
+    'logging', 'mimetypes', 'numbers', 'opcode', 'operator', 'optparse', 'os',
+    'pathlib', 'pdb', 'pickle', 'pkgutil', 'platform', 'pprint', 'queue',
+    'quopri', 'random', 're', 'reprlib', 'selectors', 'shlex', 'shutil',
+    'socket', 'stat', 'string', 'stringprep', 'struct', 'subprocess',
+    'tarfile', 'tempfile', 'textwrap', 'threading', 'token', 'tokenize',
+    'traceback', 'types', 'typing', 'unittest', 'urllib.parse', 'uuid',
+    'warnings', 'weakref', 'xml.etree.ElementTree', 'zipfile',
+)
+
+
+def startup_100_modules(seconds, repeat):
+    """Startup: fresh interpreter importing 100 modules"""
+    import subprocess
+    args = [sys.executable, '-c', 'import ' + ','.join(STARTUP_MODULES)]
+    subprocess.check_call(args)
+    for x in range(repeat):
+        total_time = 0
+        count = 0
+        while total_time < seconds:
+            total_time += timeit.timeit(lambda: subprocess.check_call(args),
+                                        number=1)
+            count += 1
+        yield count // seconds
+
+
 def main(import_, options):
     if options.source_file:
         with options.source_file:
@@ -176,6 +211,7 @@ def main(import_, options):
                   tabnanny_wo_bytecode, tabnanny_using_bytecode,
                   decimal_writing_bytecode,
                   decimal_wo_bytecode, decimal_using_bytecode,
+                  startup_100_modules,
                 )
     if options.benchmark:
         for b in benchmarks:
@@ -229,7 +229,7 @@ static char *outpath;
 static struct stat st;
 static PyObject *code;
 static PyObject *marsh;
-static bool nocompress;
+static int zipmethod = kZipCompressionDeflate;
 static bool isunittest;
 static bool insertrunner;
 static bool insertlauncher;
@@ -254,7 +254,7 @@ GetOpts(int argc, char *argv[])
             isunittest = true;
             break;
         case '0':
-            nocompress = true;
+            zipmethod = kZipCompressionNone;
             break;
         case 'r':
             insertrunner = true;
@@ -650,16 +650,16 @@ Objectify(void)
     if (ispkg) {
         elfwriter_zip(elf, zipdir, zipdir, strlen(zipdir),
                       pydata, 0, 040755, timestamp, timestamp,
-                      timestamp, nocompress);
+                      timestamp, zipmethod);
     }
     if (!binonly) {
         elfwriter_zip(elf, gc(xstrcat("py:", modname)), zipfile,
                       strlen(zipfile), pydata, pysize, st.st_mode, timestamp,
-                      timestamp, timestamp, nocompress);
+                      timestamp, timestamp, zipmethod);
     }
     elfwriter_zip(elf, gc(xstrcat("pyc:", modname)), gc(xstrcat(zipfile, 'c')),
                   strlen(zipfile) + 1, pycdata, pycsize, st.st_mode, timestamp,
-                  timestamp, timestamp, nocompress);
+                  timestamp, timestamp, zipmethod);
     elfwriter_align(elf, 1, 0);
     elfwriter_startsection(elf, ".yoink", SHT_PROGBITS, 0);
     if (!(rc = AnalyzeModule(modname))) {
@@ -147,11 +147,32 @@ o/$(MODE)/third_party/quickjs/repl.c:						\
 		o/$(MODE)/third_party/quickjs/qjsc.com
 	@$(COMPILE) -wAQJSC o/$(MODE)/third_party/quickjs/qjsc.com -o $@ -m -c $<
 
+# qjs looks for /zip/.qjs/HASH.jsb before it parses a script, where
+# HASH is the BLAKE2B256 of the source. `qjsc -b` writes the snapshots
+# next to a manifest of their names, and they're stored uncompressed so
+# qjs can load them in place from the executable.
+THIRD_PARTY_QUICKJS_SNAPSHOT_SRCS =						\
+	third_party/quickjs/examples/hello.js					\
+	third_party/quickjs/examples/hello_module.js				\
+	third_party/quickjs/examples/pi_bigint.js
+
+o/$(MODE)/third_party/quickjs/snapshots/snapshots.txt:				\
+		$(THIRD_PARTY_QUICKJS_SNAPSHOT_SRCS)				\
+		o/$(MODE)/third_party/quickjs/qjsc.com
+	@$(MKDIR) $(@D)
+	@$(RM) $(@D)/*.jsb
+	@$(COMPILE) -wAQJSC o/$(MODE)/third_party/quickjs/qjsc.com -b -o $@ $(THIRD_PARTY_QUICKJS_SNAPSHOT_SRCS)
+
+o/$(MODE)/third_party/quickjs/snapshots.zip.o:					\
+		o/$(MODE)/third_party/quickjs/snapshots/snapshots.txt
+	@$(COMPILE) -wAZIPOBJ $(ZIPOBJ) $(ZIPOBJ_FLAGS) -0 -B -P.qjs $(OUTPUT_OPTION) $(<D)/*.jsb
+
 o/$(MODE)/third_party/quickjs/qjs.com.dbg:					\
 		$(THIRD_PARTY_QUICKJS)						\
 		o/$(MODE)/third_party/quickjs/qjs.o				\
 		o/$(MODE)/third_party/quickjs/repl.o				\
 		o/$(MODE)/third_party/quickjs/qjscalc.o				\
+		o/$(MODE)/third_party/quickjs/snapshots.zip.o			\
 		$(CRT)								\
 		$(APE_NO_MODIFY_SELF)
 	@$(APELINK)
@@ -212,5 +233,6 @@ o/$(MODE)/third_party/quickjs/quickjs.o: private QUOTA = -M512m -C32 -L180
 
 .PHONY: o/$(MODE)/third_party/quickjs
 o/$(MODE)/third_party/quickjs:							\
+		o/$(MODE)/third_party/quickjs/test				\
 		$(THIRD_PARTY_QUICKJS_BINS)					\
 		$(THIRD_PARTY_QUICKJS_CHECKS)
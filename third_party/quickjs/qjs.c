@@ -29,10 +29,14 @@
 #include "libc/fmt/conv.h"
 #include "libc/log/log.h"
 #include "libc/mem/mem.h"
+#include "libc/macros.internal.h"
+#include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
+#include "libc/runtime/zipos.internal.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
+#include "libc/zip.internal.h"
 #include "third_party/quickjs/cutils.h"
 #include "third_party/quickjs/quickjs-libc.h"
 #include "tool/args/args.h"
@@ -82,11 +86,145 @@ static int eval_buf(JSContext *ctx, const void *buf, int buf_len,
     return ret;
 }
 
-static int eval_file(JSContext *ctx, const char *filename, int module)
+/* load the bytecode snapshot of a source file from the zip store
+
+   qjsc -b writes JS_WriteObject() output under /zip/.qjs/ named by the
+   hash of the source text, so a tool bundled into the executable can
+   skip the parser. Stored entries are read in place from the mapped
+   executable; deflated ones are inflated into a temporary buffer.
+   Bytecode can only be used in place if the snapshot's atoms get the
+   same numbers they had when it was written, which is the case when
+   the context holds no atoms besides the builtin ones. See main().
+   Returns JS_UNDEFINED if there is no usable snapshot, in which case
+   the caller should parse the source as usual. */
+static JSValue eval_snapshot_load(JSContext *ctx, const uint8_t *buf,
+                                  size_t buf_len, const char *filename,
+                                  int module)
+{
+    char name[5 + JS_SNAPSHOT_NAME_MAX];
+    struct ZiposUri uri;
+    struct Zipos *z;
+    const uint8_t *lf, *data;
+    uint8_t *tmp;
+    ssize_t cf;
+    size_t size;
+    JSValue obj;
+    JSAtom atom;
+    const char *mname;
+    BOOL ok;
+
+#ifdef CONFIG_BIGNUM
+    /* snapshots are compiled without the bignum extensions */
+    if (bignum_ext)
+        return JS_UNDEFINED;
+#endif
+    if (!(z = __zipos_get()))
+        return JS_UNDEFINED;
+    stpcpy(name, "/zip/");
+    js_snapshot_name(name + 5, buf, buf_len);
+    if (__zipos_parseuri(name, &uri) == -1 ||
+        (cf = __zipos_find(z, &uri)) == -1 ||
+        cf == ZIPOS_SYNTHETIC_DIRECTORY)
+        return JS_UNDEFINED;
+    lf = z->map + GetZipCfileOffset(z->map + cf);
+    if (ZIP_LFILE_MAGIC(lf) != kZipLfileHdrMagic)
+        return JS_UNDEFINED;
+    size = GetZipCfileUncompressedSize(z->map + cf);
+    tmp = NULL;
+    if (ZIP_CFILE_COMPRESSIONMETHOD(z->map + cf) == kZipCompressionNone) {
+        data = ZIP_LFILE_CONTENT(lf);
+        obj = JS_ReadObject(ctx, data, size,
+                            JS_READ_OBJ_BYTECODE | JS_READ_OBJ_ROM_DATA);
+    } else if (ZIP_CFILE_COMPRESSIONMETHOD(z->map + cf) ==
+                   kZipCompressionDeflate &&
+               (tmp = malloc(MAX(1, size))) &&
+               !__inflate(tmp, size, ZIP_LFILE_CONTENT(lf),
+                          GetZipCfileCompressedSize(z->map + cf))) {
+        obj = JS_ReadObject(ctx, tmp, size, JS_READ_OBJ_BYTECODE);
+    } else {
+        free(tmp);
+        return JS_UNDEFINED;
+    }
+    free(tmp);
+    if (JS_IsException(obj)) {
+        /* e.g. written by a qjsc with a different bytecode version */
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return JS_UNDEFINED;
+    }
+    /* the snapshot must agree with how the source would have been
+       evaluated, and relative imports and import.meta of a module
+       depend on the name it was compiled with */
+    if (module) {
+        ok = JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE;
+        if (ok) {
+            atom = JS_GetModuleName(ctx, JS_VALUE_GET_PTR(obj));
+            mname = JS_AtomToCString(ctx, atom);
+            JS_FreeAtom(ctx, atom);
+            ok = mname && !strcmp(mname, filename);
+            JS_FreeCString(ctx, mname);
+        }
+    } else {
+        ok = JS_VALUE_GET_TAG(obj) == JS_TAG_FUNCTION_BYTECODE;
+    }
+    if (!ok) {
+        JS_FreeValue(ctx, obj);
+        return JS_UNDEFINED;
+    }
+    return obj;
+}
+
+static int eval_snapshot(JSContext *ctx, JSValue obj)
+{
+    JSValue val;
+    int ret;
+
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE) {
+        if (JS_ResolveModule(ctx, obj) < 0) {
+            JS_FreeValue(ctx, obj);
+            val = JS_EXCEPTION;
+            goto done;
+        }
+        js_module_set_import_meta(ctx, obj, TRUE, TRUE);
+    }
+    val = JS_EvalFunction(ctx, obj);
+ done:
+    if (JS_IsException(val)) {
+        js_std_dump_error(ctx);
+        ret = -1;
+    } else {
+        ret = 0;
+    }
+    JS_FreeValue(ctx, val);
+    return ret;
+}
+
+/* load the snapshot of a source file without evaluating it */
+static JSValue eval_file_snapshot(JSContext *ctx, const char *filename,
+                                  int module)
+{
+    uint8_t *buf;
+    size_t buf_len;
+    JSValue obj;
+
+    buf = js_load_file(ctx, &buf_len, filename);
+    if (!buf)
+        return JS_UNDEFINED; /* eval_file() reports it */
+    if (module < 0) {
+        module = (has_suffix(filename, ".mjs") ||
+                  JS_DetectModule((const char *)buf, buf_len));
+    }
+    obj = eval_snapshot_load(ctx, buf, buf_len, filename, module);
+    js_free(ctx, buf);
+    return obj;
+}
+
+static int eval_file(JSContext *ctx, const char *filename, int module,
+                     BOOL use_snapshot)
 {
     uint8_t *buf;
     int ret, eval_flags;
     size_t buf_len;
+    JSValue obj;
 
     buf = js_load_file(ctx, &buf_len, filename);
     if (!buf) {
@@ -98,6 +236,14 @@ static int eval_file(JSContext *ctx, const char *filename, int module)
         module = (has_suffix(filename, ".mjs") ||
                   JS_DetectModule((const char *)buf, buf_len));
     }
+    if (use_snapshot)
+        obj = eval_snapshot_load(ctx, buf, buf_len, filename, module);
+    else
+        obj = JS_UNDEFINED;
+    if (!JS_IsUndefined(obj)) {
+        js_free(ctx, buf);
+        return eval_snapshot(ctx, obj);
+    }
     if (module)
         eval_flags = JS_EVAL_TYPE_MODULE;
     else
@@ -107,13 +253,22 @@ static int eval_file(JSContext *ctx, const char *filename, int module)
     return ret;
 }
 
-/* also used to initialize the worker context */
-static JSContext *JS_NewCustomContext(JSRuntime *rt)
+/* everything JS_NewContext() adds to JS_NewContextRaw(), and more */
+static void add_custom_intrinsics(JSContext *ctx)
 {
-    JSContext *ctx;
-    ctx = JS_NewContext(rt);
-    if (!ctx)
-        return NULL;
+    JS_AddIntrinsicBaseObjects(ctx);
+    JS_AddIntrinsicDate(ctx);
+    JS_AddIntrinsicEval(ctx);
+    JS_AddIntrinsicStringNormalize(ctx);
+    JS_AddIntrinsicRegExp(ctx);
+    JS_AddIntrinsicJSON(ctx);
+    JS_AddIntrinsicProxy(ctx);
+    JS_AddIntrinsicMapSet(ctx);
+    JS_AddIntrinsicTypedArrays(ctx);
+    JS_AddIntrinsicPromise(ctx);
+#ifdef CONFIG_BIGNUM
+    JS_AddIntrinsicBigInt(ctx);
+#endif
 #ifdef CONFIG_BIGNUM
     if (bignum_ext) {
         JS_AddIntrinsicBigFloat(ctx);
@@ -125,6 +280,16 @@ static JSContext *JS_NewCustomContext(JSRuntime *rt)
     /* system modules */
     js_init_module_std(ctx, "std");
     js_init_module_os(ctx, "os");
+}
+
+/* also used to initialize the worker context */
+static JSContext *JS_NewCustomContext(JSRuntime *rt)
+{
+    JSContext *ctx;
+    ctx = JS_NewContextRaw(rt);
+    if (!ctx)
+        return NULL;
+    add_custom_intrinsics(ctx);
     return ctx;
 }
 
@@ -311,6 +476,7 @@ int main(int argc, char **argv)
 {
     JSRuntime *rt;
     JSContext *ctx;
+    JSValue snapshot, obj;
     struct trace_malloc_data trace_data = { NULL };
     int optind;
     char *expr = NULL;
@@ -484,11 +650,18 @@ int main(int argc, char **argv)
         JS_SetMaxStackSize(rt, stack_size);
     js_std_set_worker_new_context_func(JS_NewCustomContext);
     js_std_init_handlers(rt);
-    ctx = JS_NewCustomContext(rt);
+    ctx = JS_NewContextRaw(rt);
     if (!ctx) {
         fprintf(stderr, "qjs: cannot allocate JS context\n");
         exit(2);
     }
+    /* read the snapshot of the script before the intrinsics and system
+       modules intern their atoms, so that its bytecode can be used in
+       place rather than copied; it's evaluated later, as usual */
+    snapshot = JS_UNDEFINED;
+    if (!empty_run && !expr && optind < argc)
+        snapshot = eval_file_snapshot(ctx, argv[optind], module);
+    add_custom_intrinsics(ctx);
 
     /* loader for ES6 modules */
     JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
@@ -516,7 +689,7 @@ int main(int argc, char **argv)
         }
 
         for(i = 0; i < include_count; i++) {
-            if (eval_file(ctx, include_list[i], module))
+            if (eval_file(ctx, include_list[i], module, TRUE))
                 goto fail;
         }
 
@@ -528,7 +701,13 @@ int main(int argc, char **argv)
         } else {
           const char *filename;
           filename = argv[optind];
-          if (eval_file(ctx, filename, module)) goto fail;
+          if (!JS_IsUndefined(snapshot)) {
+            obj = snapshot;
+            snapshot = JS_UNDEFINED;
+            if (eval_snapshot(ctx, obj)) goto fail;
+          } else {
+            if (eval_file(ctx, filename, module, FALSE)) goto fail;
+          }
         }
         if (interactive) {
           js_std_eval_binary(ctx, qjsc_repl, qjsc_repl_size, 0);
@@ -571,6 +750,7 @@ int main(int argc, char **argv)
     }
     return 0;
  fail:
+    JS_FreeValue(ctx, snapshot);
     js_std_free_handlers(rt);
     JS_FreeContext(ctx);
     JS_FreeRuntime(rt);
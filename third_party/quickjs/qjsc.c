@@ -25,6 +25,7 @@
 #include "libc/calls/calls.h"
 #include "libc/dce.h"
 #include "libc/fmt/conv.h"
+#include "libc/fmt/libgen.h"
 #include "libc/log/log.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
@@ -282,21 +283,12 @@ JSModuleDef *jsc_module_loader(JSContext *ctx,
     return m;
 }
 
-static void compile_file(JSContext *ctx, FILE *fo,
-                         const char *filename,
-                         const char *c_name1,
-                         int module)
+static JSValue compile_buf(JSContext *ctx, const uint8_t *buf,
+                           size_t buf_len, const char *filename,
+                           int module)
 {
-    uint8_t *buf;
-    char c_name[1024];
     int eval_flags;
     JSValue obj;
-    size_t buf_len;
-    buf = js_load_file(ctx, &buf_len, filename);
-    if (!buf) {
-        fprintf(stderr, "Could not load '%s'\n", filename);
-        exit(1);
-    }
     eval_flags = JS_EVAL_FLAG_COMPILE_ONLY;
     if (module < 0) {
         module = (has_suffix(filename, ".mjs") ||
@@ -311,6 +303,24 @@ static void compile_file(JSContext *ctx, FILE *fo,
         js_std_dump_error(ctx);
         exit(1);
     }
+    return obj;
+}
+
+static void compile_file(JSContext *ctx, FILE *fo,
+                         const char *filename,
+                         const char *c_name1,
+                         int module)
+{
+    uint8_t *buf;
+    char c_name[1024];
+    JSValue obj;
+    size_t buf_len;
+    buf = js_load_file(ctx, &buf_len, filename);
+    if (!buf) {
+        fprintf(stderr, "Could not load '%s'\n", filename);
+        exit(1);
+    }
+    obj = compile_buf(ctx, buf, buf_len, filename, module);
     js_free(ctx, buf);
     if (c_name1) {
         pstrcpy(c_name, sizeof(c_name), c_name1);
@@ -321,6 +331,55 @@ static void compile_file(JSContext *ctx, FILE *fo,
     JS_FreeValue(ctx, obj);
 }
 
+/* imported modules are not part of a snapshot: qjs loads them when the
+   snapshot is resolved, so only placeholders are needed to compile */
+JSModuleDef *jsc_snapshot_module_loader(JSContext *ctx,
+                                        const char *module_name, void *opaque)
+{
+    return JS_NewCModule(ctx, module_name, js_module_dummy_init);
+}
+
+/* write the bytecode of a source file as a snapshot that qjs finds in
+   /zip/.qjs/ by the hash of the source, and list it in the manifest */
+static void snapshot_file(JSContext *ctx, FILE *fo, const char *dir,
+                          const char *filename, int module)
+{
+    uint8_t *buf, *out_buf;
+    size_t buf_len, out_buf_len;
+    char name[JS_SNAPSHOT_NAME_MAX];
+    char *path;
+    JSValue obj;
+    FILE *f;
+    int flags;
+    buf = js_load_file(ctx, &buf_len, filename);
+    if (!buf) {
+        fprintf(stderr, "Could not load '%s'\n", filename);
+        exit(1);
+    }
+    js_snapshot_name(name, buf, buf_len);
+    obj = compile_buf(ctx, buf, buf_len, filename, module);
+    js_free(ctx, buf);
+    flags = JS_WRITE_OBJ_BYTECODE;
+    if (byte_swap)
+        flags |= JS_WRITE_OBJ_BSWAP;
+    out_buf = JS_WriteObject(ctx, &out_buf_len, obj, flags);
+    if (!out_buf) {
+        js_std_dump_error(ctx);
+        exit(1);
+    }
+    JS_FreeValue(ctx, obj);
+    path = xasprintf("%s/%s", dir, strchr(name, '/') + 1);
+    f = fopen(path, "wb");
+    if (!f || fwrite(out_buf, 1, out_buf_len, f) != out_buf_len ||
+        fclose(f)) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(fo, "%s\t%s\n", name, filename);
+    js_free(ctx, out_buf);
+    free(path);
+}
+
 static const char main_c_template1[] =
     "int main(int argc, char **argv)\n"
     "{\n"
@@ -348,6 +407,7 @@ void help(void)
            "options are:\n"
            "-c          only output bytecode in a C file\n"
            "-e          output main() and bytecode in a C file (default = executable output)\n"
+           "-b          output bytecode snapshots for qjs next to the output manifest\n"
            "-o output   set the output filename\n"
            "-N cname    set the C name of the generated data\n"
            "-m          compile as Javascript module (default=autodetect)\n"
@@ -471,6 +531,7 @@ typedef enum {
     OUTPUT_C,
     OUTPUT_C_MAIN,
     OUTPUT_EXECUTABLE,
+    OUTPUT_SNAPSHOT,
 } OutputTypeEnum;
 
 int main(int argc, char **argv)
@@ -509,7 +570,7 @@ int main(int argc, char **argv)
     namelist_add(&cmodule_list, "std", "std", 0);
     namelist_add(&cmodule_list, "os", "os", 0);
     for(;;) {
-        c = getopt(argc, argv, "ho:cN:f:mxevM:p:S:D:");
+        c = getopt(argc, argv, "ho:bcN:f:mxevM:p:S:D:");
         if (c == -1)
             break;
         switch(c) {
@@ -518,6 +579,9 @@ int main(int argc, char **argv)
         case 'o':
             out_filename = optarg;
             break;
+        case 'b':
+            output_type = OUTPUT_SNAPSHOT;
+            break;
         case 'c':
             output_type = OUTPUT_C;
             break;
@@ -599,6 +663,8 @@ int main(int argc, char **argv)
     if (!out_filename) {
         if (output_type == OUTPUT_EXECUTABLE) {
             out_filename = "a.out";
+        } else if (output_type == OUTPUT_SNAPSHOT) {
+            out_filename = "snapshots.txt";
         } else {
             out_filename = "out.c";
         }
@@ -624,6 +690,28 @@ int main(int argc, char **argv)
         JS_EnableBignumExt(ctx, TRUE);
     }
 #endif
+    if (output_type == OUTPUT_SNAPSHOT) {
+        char *copy, *dir;
+#ifdef CONFIG_BIGNUM
+        if (bignum_ext) {
+            fprintf(stderr, "qjs doesn't load snapshots with bignum extensions\n");
+            exit(1);
+        }
+#endif
+        copy = strdup(out_filename);
+        dir = dirname(copy);
+        JS_SetModuleLoaderFunc(rt, NULL, jsc_snapshot_module_loader, NULL);
+        for(i = optind; i < argc; i++)
+            snapshot_file(ctx, fo, dir, argv[i], module);
+        free(copy);
+        JS_FreeContext(ctx);
+        JS_FreeRuntime(rt);
+        if (fclose(fo)) {
+            perror(cfilename);
+            exit(1);
+        }
+        return 0;
+    }
     /* loader for ES6 modules */
     JS_SetModuleLoaderFunc(rt, NULL, jsc_module_loader, NULL);
     fprintf(fo, "/* File generated automatically by the QuickJS compiler. */\n"
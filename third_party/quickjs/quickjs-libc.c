@@ -41,6 +41,7 @@
 #include "libc/runtime/sysconf.h"
 #include "libc/sock/select.h"
 #include "libc/temp.h"
+#include "libc/str/blake2.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/clock.h"
 #include "libc/sysv/consts/o.h"
@@ -393,6 +394,25 @@ uint8_t *js_load_file(JSContext *ctx, size_t *pbuf_len, const char *filename)
     return buf;
 }
 
+/* compute the zip name of the bytecode snapshot of a source buffer,
+   i.e. ".qjs/" followed by the hex BLAKE2B256 digest and ".jsb" */
+char *js_snapshot_name(char name[JS_SNAPSHOT_NAME_MAX],
+                       const void *buf, size_t buf_len)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint8_t digest[BLAKE2B256_DIGEST_LENGTH];
+    char *p;
+    int i;
+    BLAKE2B256(buf, buf_len, digest);
+    p = stpcpy(name, ".qjs/");
+    for(i = 0; i < BLAKE2B256_DIGEST_LENGTH; i++) {
+        *p++ = hex[digest[i] >> 4];
+        *p++ = hex[digest[i] & 15];
+    }
+    stpcpy(p, ".jsb");
+    return name;
+}
+
 /* load and evaluate a file */
 static JSValue js_loadScript(JSContext *ctx, JSValueConst this_val,
                              int argc, JSValueConst *argv)
@@ -3,6 +3,8 @@
 #include "third_party/quickjs/quickjs.h"
 COSMOPOLITAN_C_START_
 
+#define JS_SNAPSHOT_NAME_MAX 74 /* ".qjs/" + 64 hex digits + ".jsb" + nul */
+
 JSModuleDef *js_init_module_std(JSContext *ctx, const char *module_name);
 JSModuleDef *js_init_module_os(JSContext *ctx, const char *module_name);
 void js_std_add_helpers(JSContext *ctx, int argc, char **argv);
@@ -11,6 +13,8 @@ void js_std_init_handlers(JSRuntime *rt);
 void js_std_free_handlers(JSRuntime *rt);
 void js_std_dump_error(JSContext *ctx);
 uint8_t *js_load_file(JSContext *ctx, size_t *pbuf_len, const char *filename);
+char *js_snapshot_name(char name[JS_SNAPSHOT_NAME_MAX],
+                       const void *buf, size_t buf_len);
 int js_module_set_import_meta(JSContext *ctx, JSValueConst func_val,
                               JS_BOOL use_realpath, JS_BOOL is_main);
 JSModuleDef *js_module_loader(JSContext *ctx,
@@ -0,0 +1,93 @@
+#-*-mode:makefile-gmake;indent-tabs-mode:t;tab-width:8;coding:utf-8-*-┐
+#── vi: set et ft=make ts=8 sw=8 fenc=utf-8 :vi ──────────────────────┘
+
+PKGS += THIRD_PARTY_QUICKJS_TEST
+
+THIRD_PARTY_QUICKJS_TEST_FILES := $(wildcard third_party/quickjs/test/*)
+THIRD_PARTY_QUICKJS_TEST_SRCS = $(filter %.c,$(THIRD_PARTY_QUICKJS_TEST_FILES))
+THIRD_PARTY_QUICKJS_TEST_SRCS_TEST = $(filter %_test.c,$(THIRD_PARTY_QUICKJS_TEST_SRCS))
+THIRD_PARTY_QUICKJS_TEST_OBJS = $(THIRD_PARTY_QUICKJS_TEST_SRCS:%.c=o/$(MODE)/%.o)
+THIRD_PARTY_QUICKJS_TEST_COMS = $(THIRD_PARTY_QUICKJS_TEST_SRCS_TEST:%.c=o/$(MODE)/%.com)
+
+THIRD_PARTY_QUICKJS_TEST_BINS =							\
+	$(THIRD_PARTY_QUICKJS_TEST_COMS)					\
+	$(THIRD_PARTY_QUICKJS_TEST_COMS:%=%.dbg)				\
+	o/$(MODE)/third_party/quickjs/test/qjs.com				\
+	o/$(MODE)/third_party/quickjs/test/qjs.com.dbg
+
+THIRD_PARTY_QUICKJS_TEST_TESTS =						\
+	$(THIRD_PARTY_QUICKJS_TEST_SRCS_TEST:%.c=o/$(MODE)/%.com.ok)
+
+THIRD_PARTY_QUICKJS_TEST_CHECKS =						\
+	$(THIRD_PARTY_QUICKJS_TEST_SRCS_TEST:%.c=o/$(MODE)/%.com.runs)
+
+THIRD_PARTY_QUICKJS_TEST_DIRECTDEPS =						\
+	LIBC_CALLS								\
+	LIBC_INTRIN								\
+	LIBC_NEXGEN32E								\
+	LIBC_PROC								\
+	LIBC_RUNTIME								\
+	LIBC_STDIO								\
+	LIBC_STR								\
+	LIBC_SYSV								\
+	LIBC_TESTLIB								\
+	LIBC_X
+
+THIRD_PARTY_QUICKJS_TEST_DEPS :=						\
+	$(call uniq,$(foreach x,$(THIRD_PARTY_QUICKJS_TEST_DIRECTDEPS),$($(x))))
+
+o/$(MODE)/third_party/quickjs/test/test.pkg:					\
+		$(THIRD_PARTY_QUICKJS_TEST_OBJS)				\
+		$(foreach x,$(THIRD_PARTY_QUICKJS_TEST_DIRECTDEPS),$($(x)_A).pkg)
+
+o/$(MODE)/third_party/quickjs/test/snapshot_test.com.dbg:			\
+		$(THIRD_PARTY_QUICKJS_TEST_DEPS)				\
+		o/$(MODE)/third_party/quickjs/test/snapshot_test.o		\
+		o/$(MODE)/third_party/quickjs/test/snapshot_test.js.zip.o	\
+		o/$(MODE)/third_party/quickjs/test/qjs.com.zip.o		\
+		o/$(MODE)/third_party/quickjs/test/test.pkg			\
+		$(LIBC_TESTMAIN)						\
+		$(CRT)								\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
+# a qjs whose zip store only has the snapshot of snapshot_test.js,
+# which the test runs on matching and on edited copies of the script
+o/$(MODE)/third_party/quickjs/test/snapshots/snapshots.txt:			\
+		third_party/quickjs/test/snapshot_test.js			\
+		o/$(MODE)/third_party/quickjs/qjsc.com
+	@$(MKDIR) $(@D)
+	@$(RM) $(@D)/*.jsb
+	@$(COMPILE) -wAQJSC o/$(MODE)/third_party/quickjs/qjsc.com -b -o $@ $<
+
+o/$(MODE)/third_party/quickjs/test/snapshots.zip.o:				\
+		o/$(MODE)/third_party/quickjs/test/snapshots/snapshots.txt
+	@$(COMPILE) -wAZIPOBJ $(ZIPOBJ) $(ZIPOBJ_FLAGS) -0 -B -P.qjs $(OUTPUT_OPTION) $(<D)/*.jsb
+
+o/$(MODE)/third_party/quickjs/test/qjs.com.dbg:					\
+		$(THIRD_PARTY_QUICKJS)						\
+		o/$(MODE)/third_party/quickjs/qjs.o				\
+		o/$(MODE)/third_party/quickjs/repl.o				\
+		o/$(MODE)/third_party/quickjs/qjscalc.o				\
+		o/$(MODE)/third_party/quickjs/test/snapshots.zip.o		\
+		$(CRT)								\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
+o/$(MODE)/third_party/quickjs/test/qjs.com:					\
+		o/$(MODE)/third_party/quickjs/test/qjs.com.dbg			\
+		o/$(MODE)/third_party/zip/zip.com				\
+		o/$(MODE)/tool/build/symtab.com
+	@$(MAKE_OBJCOPY)
+	@$(MAKE_SYMTAB_CREATE)
+	@$(MAKE_SYMTAB_ZIP)
+
+o/$(MODE)/third_party/quickjs/test/qjs.com.zip.o				\
+o/$(MODE)/third_party/quickjs/test/snapshot_test.js.zip.o: private		\
+		ZIPOBJ_FLAGS +=							\
+			-B
+
+.PHONY: o/$(MODE)/third_party/quickjs/test
+o/$(MODE)/third_party/quickjs/test:						\
+		$(THIRD_PARTY_QUICKJS_TEST_BINS)				\
+		$(THIRD_PARTY_QUICKJS_TEST_CHECKS)
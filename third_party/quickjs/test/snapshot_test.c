@@ -0,0 +1,114 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/mem/gc.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+#include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
+
+/**
+ * @fileoverview qjs bytecode snapshot tests
+ *
+ * bin/qjs.com has /zip/.qjs/HASH.jsb for snapshot_test.js as qjsc saw
+ * it at build time. The script prints a stack trace, which names the
+ * path it was compiled under. That's third_party/quickjs/test/ for the
+ * snapshot, and the path we pass on the command line otherwise.
+ */
+
+__static_yoink("zipos");
+
+char *script;
+size_t scriptsize;
+
+void Extract(const char *from, const char *to, int mode) {
+  int fdin, fdout;
+  char buf[4096];
+  ssize_t n;
+  ASSERT_NE(-1, (fdin = open(from, O_RDONLY)));
+  ASSERT_NE(-1, (fdout = creat(to, mode)));
+  for (;;) {
+    ASSERT_NE(-1, (n = read(fdin, buf, sizeof(buf))));
+    if (!n) break;
+    ASSERT_EQ(n, write(fdout, buf, n));
+  }
+  ASSERT_SYS(0, 0, close(fdout));
+  ASSERT_SYS(0, 0, close(fdin));
+}
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown_once();
+  ASSERT_SYS(0, 0, mkdir("bin", 0755));
+  Extract("/zip/qjs.com", "bin/qjs.com", 0755);
+  ASSERT_NE(NULL, (script = xslurp("/zip/snapshot_test.js", &scriptsize)));
+}
+
+void TearDownOnce(void) {
+  free(script);
+}
+
+char *RunQjs(const char *path) {
+  char *p;
+  size_t n;
+  ssize_t rc;
+  int ws, pid, fds[2];
+  ASSERT_SYS(0, 0, pipe(fds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    dup2(fds[1], 1);
+    close(fds[0]);
+    close(fds[1]);
+    execv("bin/qjs.com", (char *const[]){"bin/qjs.com", (char *)path, 0});
+    _Exit(127);
+  }
+  ASSERT_SYS(0, 0, close(fds[1]));
+  for (p = 0, n = 0;; n += rc) {
+    p = xrealloc(p, n + 512);
+    ASSERT_NE(-1, (rc = read(fds[0], p + n, 512)));
+    if (!rc) break;
+  }
+  p[n] = 0;
+  ASSERT_SYS(0, 0, close(fds[0]));
+  ASSERT_NE(-1, wait(&ws));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(0, WEXITSTATUS(ws));
+  return p;
+}
+
+TEST(qjs, matchingSnapshot_isUsedInsteadOfSource) {
+  char *out;
+  ASSERT_EQ(0, xbarf("script.js", script, scriptsize));
+  out = gc(RunQjs("script.js"));
+  EXPECT_STARTSWITH("2,4,6\n", out);
+  EXPECT_NE(NULL, strstr(out, "(third_party/quickjs/test/snapshot_test.js:"));
+  EXPECT_EQ(NULL, strstr(out, "(script.js:"));
+}
+
+TEST(qjs, staleSnapshot_fallsBackToSource) {
+  char *out, *edited;
+  edited = gc(xasprintf("%.*s// edited\n", (int)scriptsize, script));
+  ASSERT_EQ(0, xbarf("script.js", edited, -1));
+  out = gc(RunQjs("script.js"));
+  EXPECT_STARTSWITH("2,4,6\n", out);
+  EXPECT_NE(NULL, strstr(out, "(script.js:"));
+  EXPECT_EQ(NULL, strstr(out, "third_party/quickjs/test/"));
+}
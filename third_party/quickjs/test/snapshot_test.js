@@ -0,0 +1,4 @@
+// run by snapshot_test.c. the stack trace names the file this script
+// was compiled as, which tells a build time snapshot from a fresh parse
+print([1, 2, 3].map(x => x * 2).join(","));
+print(new Error().stack);
@@ -18,6 +18,7 @@ int sqlite3_shathree_init(sqlite3 *, char **, const sqlite3_api_routines *);
 int sqlite3_sqlar_init(sqlite3 *, char **, const sqlite3_api_routines *);
 int sqlite3_uint_init(sqlite3 *, char **, const sqlite3_api_routines *);
 int sqlite3_zipfile_init(sqlite3 *, char **, const sqlite3_api_routines *);
+int sqlite3_ziposvfs_init(sqlite3 *, char **, const sqlite3_api_routines *);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_THIRD_PARTY_SQLITE3_EXTENSIONS_H_ */
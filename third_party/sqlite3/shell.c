@@ -11734,6 +11734,7 @@ int SQLITE_CDECL wmain(int argc, wchar_t **wargv){
   data.out = stdout;
 #ifndef SQLITE_SHELL_FIDDLE
   sqlite3_appendvfs_init(0,0,0);
+  sqlite3_ziposvfs_init(0,0,0);
 #endif
 
   /* Go ahead and open the database file if it already exists.  If the
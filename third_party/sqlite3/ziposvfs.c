@@ -0,0 +1,513 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/zip.internal.h"
+#include "third_party/sqlite3/sqlite3ext.h"
+
+SQLITE_EXTENSION_INIT1
+
+/*
+** This file implements a read-only VFS named "zipos" that serves
+** database files directly out of the /zip filesystem of the running
+** executable, e.g.
+**
+**     sqlite3_open_v2("file:/zip/db.sqlite?vfs=zipos", &db,
+**                     SQLITE_OPEN_READONLY|SQLITE_OPEN_URI, 0);
+**
+** Entries that were stored without compression (zip -0) are served
+** straight out of the executable mapping that zipos already holds, so
+** no bytes get copied when opening. Compressed entries get inflated
+** into a private buffer once when they're opened. Either way the whole
+** database lives in memory, so an auto-extension enables memory-mapped
+** i/o on connections whose main database uses this VFS, and xFetch()
+** then hands the pager pointers into that memory rather than having
+** xRead() memcpy each page into the page cache.
+**
+** The file is reported as SQLITE_IOCAP_IMMUTABLE, so no locks are taken
+** and no hot journal checks happen. Databases should be put into the
+** rollback journal mode (PRAGMA journal_mode=DELETE) before they're
+** added to the zip, since there's no shared memory for WAL. Attached
+** databases work too, but only use xRead() since the auto-extension
+** only sees the main database. Paths outside /zip and other kinds of
+** files (e.g. temp databases) are passed through to the default VFS.
+*/
+
+/*
+** Forward declaration of objects used by this utility
+*/
+typedef struct sqlite3_vfs ZiposVfs;
+typedef struct ZiposFile ZiposFile;
+
+/* Access to a lower-level VFS that implements everything else.
+*/
+#define ORIGVFS(p)  ((sqlite3_vfs*)((p)->pAppData))
+
+/* An open zipos file
+*/
+struct ZiposFile {
+  sqlite3_file base;        /* Subclass.  MUST BE FIRST! */
+  const unsigned char *aData;  /* Content of the database file */
+  sqlite3_int64 nData;      /* Size of the database file in bytes */
+  void *pFree;              /* Inflated copy we own, or NULL if mapped */
+};
+
+/*
+** Methods for ZiposFile
+*/
+static int ziposClose(sqlite3_file*);
+static int ziposRead(sqlite3_file*, void*, int iAmt, sqlite3_int64 iOfst);
+static int ziposWrite(sqlite3_file*,const void*,int iAmt, sqlite3_int64 iOfst);
+static int ziposTruncate(sqlite3_file*, sqlite3_int64 size);
+static int ziposSync(sqlite3_file*, int flags);
+static int ziposFileSize(sqlite3_file*, sqlite3_int64 *pSize);
+static int ziposLock(sqlite3_file*, int);
+static int ziposUnlock(sqlite3_file*, int);
+static int ziposCheckReservedLock(sqlite3_file*, int *pResOut);
+static int ziposFileControl(sqlite3_file*, int op, void *pArg);
+static int ziposSectorSize(sqlite3_file*);
+static int ziposDeviceCharacteristics(sqlite3_file*);
+static int ziposFetch(sqlite3_file*, sqlite3_int64 iOfst, int iAmt, void **pp);
+static int ziposUnfetch(sqlite3_file*, sqlite3_int64 iOfst, void *p);
+
+/*
+** Methods for ZiposVfs
+*/
+static int ziposOpen(sqlite3_vfs*, const char *, sqlite3_file*, int , int *);
+static int ziposDelete(sqlite3_vfs*, const char *zName, int syncDir);
+static int ziposAccess(sqlite3_vfs*, const char *zName, int flags, int *);
+static int ziposFullPathname(sqlite3_vfs*, const char *zName, int, char *zOut);
+static void *ziposDlOpen(sqlite3_vfs*, const char *zFilename);
+static void ziposDlError(sqlite3_vfs*, int nByte, char *zErrMsg);
+static void (*ziposDlSym(sqlite3_vfs *pVfs, void *p, const char*zSym))(void);
+static void ziposDlClose(sqlite3_vfs*, void*);
+static int ziposRandomness(sqlite3_vfs*, int nByte, char *zOut);
+static int ziposSleep(sqlite3_vfs*, int microseconds);
+static int ziposCurrentTime(sqlite3_vfs*, double*);
+static int ziposGetLastError(sqlite3_vfs*, int, char *);
+static int ziposCurrentTimeInt64(sqlite3_vfs*, sqlite3_int64*);
+
+static sqlite3_vfs zipos_vfs = {
+  2,                            /* iVersion */
+  0,                            /* szOsFile (set when registered) */
+  1024,                         /* mxPathname */
+  0,                            /* pNext */
+  "zipos",                      /* zName */
+  0,                            /* pAppData (set when registered) */
+  ziposOpen,                    /* xOpen */
+  ziposDelete,                  /* xDelete */
+  ziposAccess,                  /* xAccess */
+  ziposFullPathname,            /* xFullPathname */
+  ziposDlOpen,                  /* xDlOpen */
+  ziposDlError,                 /* xDlError */
+  ziposDlSym,                   /* xDlSym */
+  ziposDlClose,                 /* xDlClose */
+  ziposRandomness,              /* xRandomness */
+  ziposSleep,                   /* xSleep */
+  ziposCurrentTime,             /* xCurrentTime */
+  ziposGetLastError,            /* xGetLastError */
+  ziposCurrentTimeInt64,        /* xCurrentTimeInt64 */
+  0,                            /* xSetSystemCall */
+  0,                            /* xGetSystemCall */
+  0                             /* xNextSystemCall */
+};
+
+/* The iVersion must be 3 or the pager won't ever call xFetch(). The
+** shared memory methods are left empty, which tells the pager that
+** WAL mode isn't available for these files.
+*/
+static const sqlite3_io_methods zipos_io_methods = {
+  3,                              /* iVersion */
+  ziposClose,                     /* xClose */
+  ziposRead,                      /* xRead */
+  ziposWrite,                     /* xWrite */
+  ziposTruncate,                  /* xTruncate */
+  ziposSync,                      /* xSync */
+  ziposFileSize,                  /* xFileSize */
+  ziposLock,                      /* xLock */
+  ziposUnlock,                    /* xUnlock */
+  ziposCheckReservedLock,         /* xCheckReservedLock */
+  ziposFileControl,               /* xFileControl */
+  ziposSectorSize,                /* xSectorSize */
+  ziposDeviceCharacteristics,     /* xDeviceCharacteristics */
+  0,                              /* xShmMap */
+  0,                              /* xShmLock */
+  0,                              /* xShmBarrier */
+  0,                              /* xShmUnmap */
+  ziposFetch,                     /* xFetch */
+  ziposUnfetch                    /* xUnfetch */
+};
+
+/*
+** Close a zipos-file.
+*/
+static int ziposClose(sqlite3_file *pFile){
+  ZiposFile *p = (ZiposFile *)pFile;
+  sqlite3_free(p->pFree);
+  return SQLITE_OK;
+}
+
+/*
+** Read data from a zipos-file.
+*/
+static int ziposRead(
+  sqlite3_file *pFile,
+  void *zBuf,
+  int iAmt,
+  sqlite_int64 iOfst
+){
+  ZiposFile *p = (ZiposFile *)pFile;
+  sqlite3_int64 nAvail;
+  if( iOfst>=p->nData ){
+    memset(zBuf, 0, iAmt);
+    return SQLITE_IOERR_SHORT_READ;
+  }
+  nAvail = p->nData - iOfst;
+  if( iAmt>nAvail ){
+    memcpy(zBuf, p->aData+iOfst, nAvail);
+    memset((char*)zBuf+nAvail, 0, iAmt-nAvail);
+    return SQLITE_IOERR_SHORT_READ;
+  }
+  memcpy(zBuf, p->aData+iOfst, iAmt);
+  return SQLITE_OK;
+}
+
+/*
+** Zipos files are read-only.
+*/
+static int ziposWrite(
+  sqlite3_file *pFile,
+  const void *zBuf,
+  int iAmt,
+  sqlite_int64 iOfst
+){
+  return SQLITE_READONLY;
+}
+
+static int ziposTruncate(sqlite3_file *pFile, sqlite_int64 size){
+  return SQLITE_READONLY;
+}
+
+static int ziposSync(sqlite3_file *pFile, int flags){
+  return SQLITE_OK;
+}
+
+/*
+** Return the current file-size of a zipos-file.
+*/
+static int ziposFileSize(sqlite3_file *pFile, sqlite_int64 *pSize){
+  *pSize = ((ZiposFile *)pFile)->nData;
+  return SQLITE_OK;
+}
+
+/*
+** Nothing can change the executable's zip content so locks are no-ops.
+*/
+static int ziposLock(sqlite3_file *pFile, int eLock){
+  return SQLITE_OK;
+}
+
+static int ziposUnlock(sqlite3_file *pFile, int eLock){
+  return SQLITE_OK;
+}
+
+static int ziposCheckReservedLock(sqlite3_file *pFile, int *pResOut){
+  *pResOut = 0;
+  return SQLITE_OK;
+}
+
+/*
+** File control method. For custom operations on a zipos-file.
+*/
+static int ziposFileControl(sqlite3_file *pFile, int op, void *pArg){
+  ZiposFile *p = (ZiposFile *)pFile;
+  switch( op ){
+    case SQLITE_FCNTL_VFSNAME:
+      *(char**)pArg = sqlite3_mprintf("%s", zipos_vfs.zName);
+      return SQLITE_OK;
+    case SQLITE_FCNTL_MMAP_SIZE:
+      /* The whole file is always mapped, whatever limit is requested. */
+      *(sqlite3_int64*)pArg = p->nData;
+      return SQLITE_OK;
+    default:
+      return SQLITE_NOTFOUND;
+  }
+}
+
+/*
+** Return the sector-size in bytes for a zipos-file.
+*/
+static int ziposSectorSize(sqlite3_file *pFile){
+  return 4096;
+}
+
+/*
+** Return the device characteristic flags supported by a zipos-file.
+*/
+static int ziposDeviceCharacteristics(sqlite3_file *pFile){
+  return SQLITE_IOCAP_IMMUTABLE;
+}
+
+/* Fetch a page of a memory-mapped file */
+static int ziposFetch(
+  sqlite3_file *pFile,
+  sqlite3_int64 iOfst,
+  int iAmt,
+  void **pp
+){
+  ZiposFile *p = (ZiposFile *)pFile;
+  if( iOfst+iAmt<=p->nData ){
+    *pp = (void*)(p->aData+iOfst);
+  }else{
+    *pp = 0;  /* Makes the pager fall back to xRead() */
+  }
+  return SQLITE_OK;
+}
+
+/* Release a memory-mapped page */
+static int ziposUnfetch(sqlite3_file *pFile, sqlite3_int64 iOfst, void *pPage){
+  return SQLITE_OK;
+}
+
+/*
+** Read a compressed zip entry into memory. Zipos already knows how to
+** inflate deflate and zstd entries, so we just ask for its bytes.
+*/
+static int ziposSlurp(ZiposFile *p, const char *zName){
+  sqlite3_int64 i;
+  ssize_t rc;
+  int fd;
+  if( (p->pFree = sqlite3_malloc64(p->nData ? p->nData : 1))==0 ){
+    return SQLITE_NOMEM;
+  }
+  if( (fd = open(zName, O_RDONLY|O_CLOEXEC))==-1 ){
+    return SQLITE_CANTOPEN;
+  }
+  for(i=0; i<p->nData; i+=rc){
+    rc = pread(fd, (char*)p->pFree+i, p->nData-i, i);
+    if( rc<=0 ) break;
+  }
+  close(fd);
+  if( i<p->nData ) return SQLITE_IOERR_READ;
+  p->aData = p->pFree;
+  return SQLITE_OK;
+}
+
+/*
+** Open a zipos file handle.
+*/
+static int ziposOpen(
+  sqlite3_vfs *pZiposVfs,
+  const char *zName,
+  sqlite3_file *pFile,
+  int flags,
+  int *pOutFlags
+){
+  ZiposFile *p = (ZiposFile*)pFile;
+  sqlite3_vfs *pBaseVfs = ORIGVFS(pZiposVfs);
+  struct ZiposUri uri;
+  struct Zipos *zipos;
+  const uint8_t *lf;
+  ssize_t cf;
+  int rc;
+  if( (flags & SQLITE_OPEN_MAIN_DB)==0
+   || zName==0
+   || __zipos_parseuri(zName, &uri)==-1
+  ){
+    /* Temp files and databases outside /zip are handled as usual.
+    */
+    return pBaseVfs->xOpen(pBaseVfs, zName, pFile, flags, pOutFlags);
+  }
+  memset(p, 0, sizeof(ZiposFile));
+  if( !(zipos = __zipos_get())
+   || (cf = __zipos_find(zipos, &uri))==-1
+   || cf==ZIPOS_SYNTHETIC_DIRECTORY
+  ){
+    return SQLITE_CANTOPEN;
+  }
+  lf = zipos->map + GetZipCfileOffset(zipos->map + cf);
+  if( ZIP_LFILE_MAGIC(lf)!=kZipLfileHdrMagic ){
+    return SQLITE_CORRUPT;
+  }
+  p->nData = GetZipLfileUncompressedSize(lf);
+  if( ZIP_LFILE_COMPRESSIONMETHOD(lf)==kZipCompressionNone ){
+    p->aData = (const unsigned char *)ZIP_LFILE_CONTENT(lf);
+  }else if( (rc = ziposSlurp(p, zName))!=SQLITE_OK ){
+    sqlite3_free(p->pFree);
+    p->pFree = 0;
+    return rc;
+  }
+  pFile->pMethods = &zipos_io_methods;
+  if( pOutFlags ){
+    *pOutFlags = (flags & ~(SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE))
+               | SQLITE_OPEN_READONLY;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Zipos files can't be deleted.
+*/
+static int ziposDelete(sqlite3_vfs *pVfs, const char *zPath, int dirSync){
+  struct ZiposUri uri;
+  if( __zipos_parseuri(zPath, &uri)!=-1 ) return SQLITE_IOERR_DELETE;
+  return ORIGVFS(pVfs)->xDelete(ORIGVFS(pVfs), zPath, dirSync);
+}
+
+/*
+** Only the database itself exists in /zip. It's never writable and it
+** never has a journal, so there's nothing to roll back.
+*/
+static int ziposAccess(
+  sqlite3_vfs *pVfs,
+  const char *zPath,
+  int flags,
+  int *pResOut
+){
+  struct ZiposUri uri;
+  struct Zipos *zipos;
+  if( __zipos_parseuri(zPath, &uri)!=-1 ){
+    *pResOut = flags!=SQLITE_ACCESS_READWRITE
+            && (zipos = __zipos_get())!=0
+            && __zipos_find(zipos, &uri)!=-1;
+    return SQLITE_OK;
+  }
+  return ORIGVFS(pVfs)->xAccess(ORIGVFS(pVfs), zPath, flags, pResOut);
+}
+
+/*
+** Paths in /zip are already absolute and there's no symlinks to follow.
+*/
+static int ziposFullPathname(
+  sqlite3_vfs *pVfs,
+  const char *zPath,
+  int nOut,
+  char *zOut
+){
+  struct ZiposUri uri;
+  if( __zipos_parseuri(zPath, &uri)!=-1 ){
+    if( (int)strlen(zPath)>=nOut ) return SQLITE_CANTOPEN;
+    sqlite3_snprintf(nOut, zOut, "%s", zPath);
+    return SQLITE_OK;
+  }
+  return ORIGVFS(pVfs)->xFullPathname(ORIGVFS(pVfs),zPath,nOut,zOut);
+}
+
+/*
+** All other VFS methods are pass-thrus.
+*/
+static void *ziposDlOpen(sqlite3_vfs *pVfs, const char *zPath){
+  return ORIGVFS(pVfs)->xDlOpen(ORIGVFS(pVfs), zPath);
+}
+
+static void ziposDlError(sqlite3_vfs *pVfs, int nByte, char *zErrMsg){
+  ORIGVFS(pVfs)->xDlError(ORIGVFS(pVfs), nByte, zErrMsg);
+}
+
+static void (*ziposDlSym(sqlite3_vfs *pVfs, void *p, const char *zSym))(void){
+  return ORIGVFS(pVfs)->xDlSym(ORIGVFS(pVfs), p, zSym);
+}
+
+static void ziposDlClose(sqlite3_vfs *pVfs, void *pHandle){
+  ORIGVFS(pVfs)->xDlClose(ORIGVFS(pVfs), pHandle);
+}
+
+static int ziposRandomness(sqlite3_vfs *pVfs, int nByte, char *zBufOut){
+  return ORIGVFS(pVfs)->xRandomness(ORIGVFS(pVfs), nByte, zBufOut);
+}
+
+static int ziposSleep(sqlite3_vfs *pVfs, int nMicro){
+  return ORIGVFS(pVfs)->xSleep(ORIGVFS(pVfs), nMicro);
+}
+
+static int ziposCurrentTime(sqlite3_vfs *pVfs, double *pTimeOut){
+  return ORIGVFS(pVfs)->xCurrentTime(ORIGVFS(pVfs), pTimeOut);
+}
+
+static int ziposGetLastError(sqlite3_vfs *pVfs, int a, char *b){
+  return ORIGVFS(pVfs)->xGetLastError(ORIGVFS(pVfs), a, b);
+}
+
+static int ziposCurrentTimeInt64(sqlite3_vfs *pVfs, sqlite3_int64 *p){
+  return ORIGVFS(pVfs)->xCurrentTimeInt64(ORIGVFS(pVfs), p);
+}
+
+/*
+** The pager only calls xFetch() if the mmap_size of the connection is
+** positive, and it's zero by default. This runs whenever a connection
+** is opened, and turns memory-mapped i/o on if the main database came
+** from this VFS, so that b-tree pages get read in place.
+*/
+static int ziposEnableMmap(
+  sqlite3 *db,
+  char **pzErrMsg,
+  const sqlite3_api_routines *pApi
+){
+  sqlite3_file *pFile = 0;
+  char *zSql;
+  SQLITE_EXTENSION_INIT2(pApi);
+  (void)pzErrMsg;
+  if( sqlite3_file_control(db, "main", SQLITE_FCNTL_FILE_POINTER, &pFile)
+   || pFile==0
+   || pFile->pMethods!=&zipos_io_methods
+   || ((ZiposFile *)pFile)->nData==0
+  ){
+    return SQLITE_OK;
+  }
+  zSql = sqlite3_mprintf("PRAGMA main.mmap_size=%lld",
+                         ((ZiposFile *)pFile)->nData);
+  if( zSql ){
+    sqlite3_exec(db, zSql, 0, 0, 0);
+    sqlite3_free(zSql);
+  }
+  return SQLITE_OK;
+}
+
+/*
+** This routine is called when the extension is loaded.
+** Register the new VFS. It's safe to call this more than once.
+*/
+int sqlite3_ziposvfs_init(
+  sqlite3 *db,
+  char **pzErrMsg,
+  const sqlite3_api_routines *pApi
+){
+  int rc = SQLITE_OK;
+  sqlite3_vfs *pOrig;
+  SQLITE_EXTENSION_INIT2(pApi);
+  (void)pzErrMsg;
+  (void)db;
+  if( sqlite3_vfs_find(zipos_vfs.zName)==0 ){
+    pOrig = sqlite3_vfs_find(0);
+    if( pOrig==0 ) return SQLITE_ERROR;
+    zipos_vfs.pAppData = pOrig;
+    zipos_vfs.szOsFile = sizeof(ZiposFile);
+    if( zipos_vfs.szOsFile<pOrig->szOsFile ){
+      zipos_vfs.szOsFile = pOrig->szOsFile;
+    }
+    rc = sqlite3_vfs_register(&zipos_vfs, 0);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_auto_extension((void(*)(void))ziposEnableMmap);
+  }
+  if( rc==SQLITE_OK ) rc = SQLITE_OK_LOAD_PERMANENTLY;
+  return rc;
+}
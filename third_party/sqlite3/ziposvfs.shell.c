@@ -0,0 +1 @@
+#include "third_party/sqlite3/ziposvfs.c"
@@ -26,6 +26,7 @@ THIRD_PARTY_VQSORT_A_DIRECTDEPS =		\
 	LIBC_NEXGEN32E				\
 	LIBC_RUNTIME				\
 	LIBC_STR				\
+	LIBC_THREAD				\
 	THIRD_PARTY_COMPILER_RT
 
 THIRD_PARTY_VQSORT_A_DEPS :=			\
@@ -0,0 +1,153 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/limits.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "third_party/vqsort/vqsort.h"
+
+// Argsort turns each key into an unsigned integer with the same order.
+// For 32-bit keys, the index is packed beneath the key so a single 64-bit
+// vectorized sort orders by key and then by index, which makes it stable.
+// Wider keys (or more than 2³² elements) go through the pair radix sort.
+
+#define KEY_UINT(x)   (x)
+#define KEY_INT32(x)  ((uint32_t)(x) ^ 0x80000000)
+#define KEY_INT64(x)  ((uint64_t)(x) ^ 0x8000000000000000)
+#define KEY_FLOAT(x)  ((x) ^ ((uint32_t)((int32_t)(x) >> 31) | 0x80000000))
+#define KEY_DOUBLE(x) \
+  ((x) ^ ((uint64_t)((int64_t)(x) >> 63) | 0x8000000000000000))
+
+typedef uint32_t uint32_alias_t __attribute__((__may_alias__));
+typedef uint64_t uint64_alias_t __attribute__((__may_alias__));
+
+static int argsort_finish_packed(int64_t *P, size_t n, size_t *I) {
+  size_t i;
+  vqsort_int64(P, n);
+  for (i = 0; i < n; ++i) I[i] = (uint32_t)P[i];
+  free(P);
+  return 0;
+}
+
+static int argsort_finish_pairs(uint64_t (*P)[2], size_t n, size_t *I) {
+  size_t i;
+  if (radix_sort_uint64_pairs(P, n) == -1) {
+    free(P);
+    return -1;
+  }
+  for (i = 0; i < n; ++i) I[i] = P[i][1];
+  free(P);
+  return 0;
+}
+
+#define ARGSORT32(K, n, I, KEY)                                          \
+  do {                                                                   \
+    size_t i;                                                            \
+    if (n <= UINT32_MAX) {                                               \
+      int64_t *P;                                                        \
+      if (!(P = malloc(n * sizeof(*P)))) return -1;                      \
+      for (i = 0; i < n; ++i)                                            \
+        P[i] = ((uint64_t)KEY(K[i]) << 32 | i) ^ 0x8000000000000000;     \
+      return argsort_finish_packed(P, n, I);                             \
+    } else {                                                             \
+      uint64_t(*P)[2];                                                   \
+      if (!(P = malloc(n * sizeof(*P)))) return -1;                      \
+      for (i = 0; i < n; ++i) P[i][0] = KEY(K[i]), P[i][1] = i;          \
+      return argsort_finish_pairs(P, n, I);                              \
+    }                                                                    \
+  } while (0)
+
+#define ARGSORT64(K, n, I, KEY)                                          \
+  do {                                                                   \
+    size_t i;                                                            \
+    uint64_t(*P)[2];                                                     \
+    if (!(P = malloc(n * sizeof(*P)))) return -1;                        \
+    for (i = 0; i < n; ++i) P[i][0] = KEY(K[i]), P[i][1] = i;            \
+    return argsort_finish_pairs(P, n, I);                                \
+  } while (0)
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order.
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_uint32(const uint32_t *K, size_t n, size_t *I) {
+  ARGSORT32(K, n, I, KEY_UINT);
+}
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order.
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_int32(const int32_t *K, size_t n, size_t *I) {
+  ARGSORT32(K, n, I, KEY_INT32);
+}
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order. NaNs are ordered the
+ * same way as vqsort_float().
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_float(const float *K, size_t n, size_t *I) {
+  const uint32_alias_t *B = (const uint32_alias_t *)K;
+  ARGSORT32(B, n, I, KEY_FLOAT);
+}
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order.
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_uint64(const uint64_t *K, size_t n, size_t *I) {
+  ARGSORT64(K, n, I, KEY_UINT);
+}
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order.
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_int64(const int64_t *K, size_t n, size_t *I) {
+  ARGSORT64(K, n, I, KEY_INT64);
+}
+
+/**
+ * Computes permutation `I` such that `K[I[0]] ≤ K[I[1]] ≤ ...`.
+ *
+ * Equal keys keep their original relative order. NaNs are ordered the
+ * same way as vqsort_double().
+ *
+ * @return 0 on success, or -1 w/ errno if out of memory
+ */
+int argsort_double(const double *K, size_t n, size_t *I) {
+  const uint64_alias_t *B = (const uint64_alias_t *)K;
+  ARGSORT64(B, n, I, KEY_DOUBLE);
+}
@@ -7,6 +7,7 @@ void vqsort_int64_avx2(int64_t *, size_t);
 void vqsort_int64_sse4(int64_t *, size_t);
 void vqsort_int64_ssse3(int64_t *, size_t);
 void vqsort_int64_sse2(int64_t *, size_t);
+void vqsort_int64_parallel(int64_t *, size_t);
 
 void vqsort_int32(int32_t *, size_t);
 void vqsort_int32_avx2(int32_t *, size_t);
@@ -14,5 +15,17 @@ void vqsort_int32_sse4(int32_t *, size_t);
 void vqsort_int32_ssse3(int32_t *, size_t);
 void vqsort_int32_sse2(int32_t *, size_t);
 
+void vqsort_uint64(uint64_t *, size_t);
+void vqsort_uint32(uint32_t *, size_t);
+void vqsort_double(double *, size_t);
+void vqsort_float(float *, size_t);
+
+int argsort_int32(const int32_t *, size_t, size_t *);
+int argsort_uint32(const uint32_t *, size_t, size_t *);
+int argsort_float(const float *, size_t, size_t *);
+int argsort_int64(const int64_t *, size_t, size_t *);
+int argsort_uint64(const uint64_t *, size_t, size_t *);
+int argsort_double(const double *, size_t, size_t *);
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_THIRD_PARTY_VQSORT_H_ */
@@ -0,0 +1,37 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "third_party/vqsort/vqsort.h"
+
+typedef int64_t int64_alias_t __attribute__((__may_alias__));
+
+/**
+ * Sorts array of double precision floating point numbers.
+ *
+ * The bits of negative numbers have their magnitude flipped, which is
+ * an involution that turns IEEE 754 order into signed integer order.
+ * Negative zero sorts before positive zero. NaNs with the sign bit set
+ * go at the beginning and all other NaNs go at the end.
+ */
+void vqsort_double(double *A, size_t n) {
+  size_t i;
+  int64_alias_t *P = (int64_alias_t *)A;
+  for (i = 0; i < n; ++i) P[i] ^= (P[i] >> 63) & 0x7fffffffffffffff;
+  vqsort_int64((int64_t *)P, n);
+  for (i = 0; i < n; ++i) P[i] ^= (P[i] >> 63) & 0x7fffffffffffffff;
+}
@@ -0,0 +1,146 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2023 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/macros.internal.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/thread/forkjoin.h"
+#include "third_party/vqsort/vqsort.h"
+
+#define MERGE_GRAIN 16384
+#define SORT_GRAIN  65536
+
+struct MergeInt64 {
+  const int64_t *x, *y;
+  int64_t *z;
+  size_t nx, ny;
+};
+
+struct SortInt64 {
+  int64_t *a, *t;
+  size_t n, leaf;
+  bool where;
+};
+
+static size_t lower_bound_int64(const int64_t *y, size_t n, int64_t k) {
+  size_t l, r, m;
+  for (l = 0, r = n; l < r;) {
+    m = l + (r - l) / 2;
+    if (y[m] < k) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  return l;
+}
+
+static void merge_int64(struct MergeInt64 *m) {
+  int64_t *z = m->z;
+  const int64_t *x = m->x, *xe = m->x + m->nx;
+  const int64_t *y = m->y, *ye = m->y + m->ny;
+  while (x < xe && y < ye) {
+    bool t = *y < *x;
+    *z++ = t ? *y : *x;
+    y += t;
+    x += !t;
+  }
+  memcpy(z, x, (xe - x) * sizeof(int64_t));
+  memcpy(z + (xe - x), y, (ye - y) * sizeof(int64_t));
+}
+
+static void merge_int64_worker(void *arg) {
+  size_t xm, ym;
+  struct MergeInt64 *m = arg, lo, hi;
+  if (m->nx + m->ny <= MERGE_GRAIN) {
+    merge_int64(m);
+    return;
+  }
+  if (m->nx < m->ny) {
+    // equal integers are indistinguishable so stability doesn't matter
+    const int64_t *p = m->x;
+    m->x = m->y;
+    m->y = p;
+    xm = m->nx;
+    m->nx = m->ny;
+    m->ny = xm;
+  }
+  xm = m->nx / 2;
+  ym = lower_bound_int64(m->y, m->ny, m->x[xm]);
+  m->z[xm + ym] = m->x[xm];
+  lo = hi = *m;
+  lo.nx = xm;
+  lo.ny = ym;
+  hi.x += xm + 1;
+  hi.nx -= xm + 1;
+  hi.y += ym;
+  hi.ny -= ym;
+  hi.z += xm + ym + 1;
+  forkjoin_invoke2(merge_int64_worker, &lo, merge_int64_worker, &hi);
+}
+
+static void vqsort_int64_worker(void *arg) {
+  size_t h;
+  struct MergeInt64 m;
+  struct SortInt64 *s = arg, lo, hi;
+  if (s->n <= s->leaf) {
+    vqsort_int64(s->a, s->n);
+    if (s->where) memcpy(s->t, s->a, s->n * sizeof(int64_t));
+    return;
+  }
+  h = s->n / 2;
+  lo = hi = *s;
+  lo.n = h;
+  lo.where = hi.where = !s->where;
+  hi.a += h;
+  hi.t += h;
+  hi.n -= h;
+  forkjoin_invoke2(vqsort_int64_worker, &lo, vqsort_int64_worker, &hi);
+  m.x = s->where ? s->a : s->t;
+  m.y = m.x + h;
+  m.z = s->where ? s->t : s->a;
+  m.nx = h;
+  m.ny = s->n - h;
+  merge_int64_worker(&m);
+}
+
+/**
+ * Sorts array of signed 64-bit integers using multiple threads.
+ *
+ * Runs are sorted by vqsort_int64() on separate threads and are then
+ * merged in parallel. If a temporary buffer as big as the array can't
+ * be allocated, or only one thread is available, this just calls
+ * vqsort_int64().
+ *
+ * @see forkjoin_setconcurrency()
+ */
+void vqsort_int64_parallel(int64_t *A, size_t n) {
+  int c;
+  struct SortInt64 s;
+  if (n < SORT_GRAIN * 2 || (c = forkjoin_concurrency()) <= 1 ||
+      !(s.t = malloc(n * sizeof(int64_t)))) {
+    vqsort_int64(A, n);
+    return;
+  }
+  s.a = A;
+  s.n = n;
+  s.leaf = MAX(SORT_GRAIN, n / (c * 4));
+  s.where = false;
+  forkjoin_run(vqsort_int64_worker, &s);
+  free(s.t);
+}
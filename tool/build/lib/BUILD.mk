@@ -54,7 +54,8 @@ TOOL_BUILD_LIB_A_DIRECTDEPS =				\
 	THIRD_PARTY_COMPILER_RT				\
 	THIRD_PARTY_MBEDTLS				\
 	THIRD_PARTY_XED					\
-	THIRD_PARTY_ZLIB
+	THIRD_PARTY_ZLIB				\
+	THIRD_PARTY_ZSTD
 
 TOOL_BUILD_LIB_A_DEPS :=				\
 	$(call uniq,$(foreach x,$(TOOL_BUILD_LIB_A_DIRECTDEPS),$($(x))))
@@ -73,7 +73,7 @@ void elfwriter_yoink(struct ElfWriter *, const char *, int);
 void elfwriter_setsection(struct ElfWriter *, struct ElfWriterSymRef, uint16_t);
 void elfwriter_zip(struct ElfWriter *, const char *, const char *, size_t,
                    const void *, size_t, uint32_t, struct timespec,
-                   struct timespec, struct timespec, bool);
+                   struct timespec, struct timespec, int);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_TOOL_BUILD_LIB_ELFWRITER_H_ */
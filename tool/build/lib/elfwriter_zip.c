@@ -37,14 +37,17 @@
 #include "libc/zip.internal.h"
 #include "net/http/http.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 #include "tool/build/lib/elfwriter.h"
 
 #define ZIP_CFILE_HDR_SIZE (kZipCfileHdrMinSize + 36)
+#define ZSTD_LEVEL         19 /* assets are compressed once, read often */
 
 static bool ShouldCompress(const char *name, size_t namesize,
                            const unsigned char *data, size_t datasize,
-                           bool nocompress) {
-  return !nocompress && datasize >= 64 && !IsNoCompressExt(name, namesize) &&
+                           int method) {
+  return method != kZipCompressionNone && datasize >= 64 &&
+         !IsNoCompressExt(name, namesize) &&
          (datasize < 1000 || MeasureEntropy((void *)data, 1000) < 7);
 }
 
@@ -57,7 +60,9 @@ static void GetDosLocalTime(int64_t utcunixts, uint16_t *out_time,
 }
 
 static int DetermineVersionNeededToExtract(int method) {
-  if (method == kZipCompressionDeflate) {
+  if (method == kZipCompressionZstd) {
+    return kZipEra2020;
+  } else if (method == kZipCompressionDeflate) {
     return kZipEra1993;
   } else {
     return kZipEra1989;
@@ -133,18 +138,24 @@ static void EmitZipCdirHdr(unsigned char *p, const void *name, size_t namesize,
 
 /**
  * Embeds zip file in elf object.
+ *
+ * @param method is the preferred compression method, which is either
+ *     `kZipCompressionDeflate` or `kZipCompressionZstd`; the content
+ *     will be stored if it's `kZipCompressionNone` or if compressing
+ *     wouldn't make it smaller
  */
 void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
                    size_t namesize, const void *data, size_t size,
                    uint32_t mode, struct timespec mtim, struct timespec atim,
-                   struct timespec ctim, bool nocompress) {
+                   struct timespec ctim, int method) {
+  size_t rc;
   z_stream zs;
   uint8_t era;
   uint32_t crc;
   unsigned char *lfile, *cfile;
   struct ElfWriterSymRef lfilesym;
   size_t lfilehdrsize, uncompsize, compsize, commentsize;
-  uint16_t method, gflags, mtime, mdate, iattrs, dosmode;
+  uint16_t gflags, mtime, mdate, iattrs, dosmode;
 
   CHECK_NE(0, mtim.tv_sec);
 
@@ -169,9 +180,9 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
     iattrs |= kZipIattrText;
   }
   dosmode = !(mode & 0200) ? kNtFileAttributeReadonly : 0;
-  method = ShouldCompress(name, namesize, data, size, nocompress)
-               ? kZipCompressionDeflate
-               : kZipCompressionNone;
+  if (!ShouldCompress(name, namesize, data, size, method)) {
+    method = kZipCompressionNone;
+  }
 
   /* emit embedded file content w/ pkzip local file header */
   elfwriter_align(elf, 1, 0);
@@ -193,13 +204,25 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
     } else {
       method = kZipCompressionNone;
     }
+  } else if (method == kZipCompressionZstd) {
+    lfile = elfwriter_reserve(
+        elf, lfilehdrsize + (compsize = ZSTD_compressBound(uncompsize)));
+    rc = ZSTD_compress(lfile + lfilehdrsize, compsize, data, uncompsize,
+                       ZSTD_LEVEL);
+    CHECK(!ZSTD_isError(rc));
+    if (rc < uncompsize) {
+      compsize = rc;
+    } else {
+      compsize = uncompsize;
+      method = kZipCompressionNone;
+    }
   } else {
     lfile = elfwriter_reserve(elf, lfilehdrsize + uncompsize);
   }
   if (method == kZipCompressionNone) {
     memcpy(lfile + lfilehdrsize, data, uncompsize);
   }
-  era = method ? kZipEra1993 : kZipEra1989;
+  era = DetermineVersionNeededToExtract(method);
   EmitZipLfileHdr(lfile, name, namesize, crc, era, gflags, method, mtime, mdate,
                   compsize, uncompsize);
   elfwriter_commit(elf, lfilehdrsize + compsize);
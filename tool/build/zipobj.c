@@ -49,7 +49,7 @@ char *name_;
 char *yoink_;
 char *symbol_;
 char *outpath_;
-bool nocompress_;
+int method_;
 bool basenamify_;
 int strip_components_;
 const char *path_prefix_;
@@ -77,6 +77,7 @@ FLAGS\n\
   -h              show help\n\
   -o PATH         output path\n\
   -0              disable compression\n\
+  -z              use zstandard rather than deflate compression\n\
   -B              basename-ify zip filename\n\
   -a ARCH         microprocessor architecture\n\
   -N ZIPPATH      zip filename (defaults to input arg)\n\
@@ -109,7 +110,8 @@ static int ParseArch(const char *s) {
 void GetOpts(int *argc, char ***argv) {
   int opt;
   yoink_ = "__zip_eocd";
-  while ((opt = getopt(*argc, *argv, "?0nhBN:C:P:o:s:y:a:")) != -1) {
+  method_ = kZipCompressionDeflate;
+  while ((opt = getopt(*argc, *argv, "?0nhzBN:C:P:o:s:y:a:")) != -1) {
     switch (opt) {
       case 'o':
         outpath_ = optarg;
@@ -138,7 +140,10 @@ void GetOpts(int *argc, char ***argv) {
         basenamify_ = true;
         break;
       case '0':
-        nocompress_ = true;
+        method_ = kZipCompressionNone;
+        break;
+      case 'z':
+        method_ = kZipCompressionZstd;
         break;
       case '?':
       case 'h':
@@ -200,7 +205,7 @@ void ProcessFile(struct ElfWriter *elf, const char *path) {
     }
   }
   elfwriter_zip(elf, name, name, strlen(name), map, st.st_size, st.st_mode,
-                timestamp, timestamp, timestamp, nocompress_);
+                timestamp, timestamp, timestamp, method_);
   if (st.st_size) {
     unassert(!munmap(map, st.st_size));
   }
@@ -23,6 +23,7 @@
 const struct IdName kZipCompressionNames[] = {
     {kZipCompressionNone, "kZipCompressionNone"},
     {kZipCompressionDeflate, "kZipCompressionDeflate"},
+    {kZipCompressionZstd, "kZipCompressionZstd"},
     {0, 0},
 };
 
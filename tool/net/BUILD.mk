@@ -68,6 +68,7 @@ TOOL_NET_DIRECTDEPS =								\
 	THIRD_PARTY_REGEX							\
 	THIRD_PARTY_SQLITE3							\
 	THIRD_PARTY_ZLIB							\
+	THIRD_PARTY_ZSTD							\
 	TOOL_ARGS								\
 	TOOL_BUILD_LIB								\
 	TOOL_DECODE_LIB								\
@@ -1849,6 +1849,39 @@ function ProgramPidPath(str) end
 ---@return boolean
 function ProgramUniprocess(bool) end
 
+--- Freezes the Lua objects created by the main process before workers are
+--- forked. When enabled, redbean switches the Lua garbage collector to
+--- generational mode and performs a full collection after `OnServerStart()`
+--- and after each reload, which makes every surviving object old. The minor
+--- collections done by workers then never mark or sweep those objects, so
+--- their memory pages stay shared with the main process rather than being
+--- copied into each worker. Workers still do a major collection if their heap
+--- grows to the size configured by the `majormul` parameter of
+--- `ProgramWorkerGc()`. The frozen byte count is reported as `lua.frozen` by
+--- `/statusz` and the effect can be observed in `self.ru_minflt` which counts
+--- page faults, including copy-on-write, of the worker serving the request.
+--- This function can only be called from `.init.lua`. The current value is
+--- returned.
+---@param bool boolean?
+---@return boolean
+function ProgramGcFreeze(bool) end
+
+--- Configures the Lua garbage collector of each worker right after it's
+--- forked, before `OnWorkerStart()` is called. `mode` may be `"inherit"` (the
+--- default) to keep the main process settings, `"generational"` in which case
+--- `arg1` and `arg2` are the `minormul` and `majormul` parameters, or
+--- `"incremental"` in which case `arg1`, `arg2`, and `arg3` are the `pause`,
+--- `stepmul`, and `stepsize` parameters. See `collectgarbage()` for their
+--- meanings. Zero or absent arguments leave the corresponding parameter
+--- unchanged. Note that switching to incremental mode has to mark every object
+--- young again, which undoes `ProgramGcFreeze()`. This function can only be
+--- called from `.init.lua`.
+---@param mode "inherit"|"generational"|"incremental"
+---@param arg1 integer?
+---@param arg2 integer?
+---@param arg3 integer?
+function ProgramWorkerGc(mode, arg1, arg2, arg3) end
+
 --- Reads all data from file the easy way.
 ---
 --- This function reads file data from local file system. Zip file assets can be
@@ -3845,6 +3878,11 @@ function path.islink(path) end
 --- website to get a free copy. The database has a generalized structure. For a
 --- concrete example of how this module may be used, please see `maxmind.lua`
 --- in `redbean-demo.com`.
+---
+--- The database should be opened in `.init.lua` so it's memory mapped once
+--- by the main process, and forked workers share its pages. Each process
+--- keeps its own cache of recent lookups, keyed by /24 network, along with
+--- the country and city of each result.
 maxmind = {}
 
 ---@param filepath string the location of the MaxMind database
@@ -3860,6 +3898,14 @@ maxmind.Db = {}
 ---@nodiscard
 function maxmind.Db:lookup(ip) end
 
+--- Looks up many IPs at once, e.g. when processing logs. The returned
+--- array has the same length as `ips`, and has `false` for each IP that
+--- wasn't found.
+---@param ips uint32[] IPv4 addresses as uint32
+---@return (maxmind.Result|false)[] results
+---@nodiscard
+function maxmind.Db:lookupmany(ips) end
+
 ---@class maxmind.Result
 maxmind.Result = {}
 
@@ -3871,6 +3917,16 @@ function maxmind.Result:get() end
 ---@nodiscard
 function maxmind.Result:netmask() end
 
+--- Returns ISO country code, e.g. `"US"`, which is cached with the result.
+---@return string?
+---@nodiscard
+function maxmind.Result:country() end
+
+--- Returns English city name, which is cached with the result.
+---@return string?
+---@nodiscard
+function maxmind.Result:city() end
+
 --- This is an experimental module that, like the maxmind module, gives you insight
 --- into what kind of device is connecting to your redbean. This module can help
 --- you protect your redbean because it provides tools for identifying clients that
@@ -23,17 +23,37 @@
 #include "third_party/lua/luaconf.h"
 #include "third_party/maxmind/maxminddb.h"
 
+#define MAXMIND_CACHE_BITS 12
+#define MAXMIND_CACHE_NETMASK 24  // longest ipv4 prefix a cache line holds
+
+// lookup result for an ipv4 /24 prefix, with the fields most callers
+// want pointing straight into the database mapping
+struct MaxmindEntry {
+  uint32_t key;  // (ip >> 8) + 1 or zero if this cache line is unused
+  bool found;
+  uint16_t netmask;
+  uint16_t countrylen;
+  uint16_t citylen;
+  uint32_t offset;
+  const char *country;
+  const char *city;
+};
+
 struct MaxmindDb {
   int refs;
   MMDB_s mmdb;
+  struct MaxmindEntry *cache;  // direct mapped; private to each process
 };
 
 struct MaxmindResult {
   uint32_t ip;
   struct MaxmindDb *db;
-  MMDB_lookup_result_s mmlr;
+  struct MaxmindEntry e;
 };
 
+static const char *const kMaxmindCountry[] = {"country", "iso_code", 0};
+static const char *const kMaxmindCity[] = {"city", "names", "en", 0};
+
 static const char *GetMmdbError(int err) {
   switch (err) {
     case MMDB_FILE_OPEN_ERROR:
@@ -75,6 +95,7 @@ static int LuaMaxmindOpen(lua_State *L) {
     __builtin_unreachable();
   }
   db->refs = 1;
+  db->cache = 0;
   udb = lua_newuserdatauv(L, sizeof(db), 1);
   luaL_setmetatable(L, "MaxmindDb*");
   *udb = db;
@@ -91,11 +112,96 @@ static wontreturn void LuaThrowMaxmindIpError(lua_State *L,
   __builtin_unreachable();
 }
 
+// returns ipv4 netmask, which can be negative when an ipv6 database
+// has a network wider than ::/96 containing the ipv4 space
+static int GetMaxmindNetmask(struct MaxmindDb *db, uint16_t netmask) {
+  if (db->mmdb.metadata.ip_version == 6) {
+    return netmask - (128 - 32);
+  } else {
+    return netmask;
+  }
+}
+
+static void GetMaxmindString(struct MaxmindDb *db, uint32_t offset,
+                             const char *const *path, const char **s,
+                             uint16_t *n) {
+  MMDB_entry_data_s edata;
+  MMDB_entry_s entry = {&db->mmdb, offset};
+  if (!MMDB_aget_value(&entry, &edata, path) && edata.has_data &&
+      edata.type == MMDB_DATA_TYPE_UTF8_STRING && edata.data_size <= 0xffff) {
+    *s = edata.utf8_string;
+    *n = edata.data_size;
+  } else {
+    *s = 0;
+    *n = 0;
+  }
+}
+
+// looks up ipv4 address, consulting cache of /24 networks first
+//
+// walking the search tree takes one step per bit of netmask and then
+// finding country and city in the data section means decoding maps,
+// so we remember results for any ip whose network is /24 or wider.
+// more specific networks are rare and always take the slow path.
+static int LookupMaxmind(struct MaxmindDb *db, uint32_t ip,
+                         struct MaxmindEntry *out) {
+  int err;
+  uint32_t key;
+  MMDB_lookup_result_s mmlr;
+  struct MaxmindEntry *line;
+  key = (ip >> 8) + 1;
+  if (!db->cache) {
+    db->cache = calloc(1 << MAXMIND_CACHE_BITS, sizeof(struct MaxmindEntry));
+  }
+  if (db->cache) {
+    line = db->cache + ((key * 0x9e3779b1u) >> (32 - MAXMIND_CACHE_BITS));
+    if (line->key == key) {
+      *out = *line;
+      return 0;
+    }
+  } else {
+    line = 0;
+  }
+  mmlr = MMDB_lookup(&db->mmdb, ip, &err);
+  if (err) return err;
+  out->key = 0;
+  out->found = mmlr.found_entry;
+  out->netmask = mmlr.netmask;
+  out->offset = mmlr.entry.offset;
+  if (out->found) {
+    GetMaxmindString(db, out->offset, kMaxmindCountry, &out->country,
+                     &out->countrylen);
+    GetMaxmindString(db, out->offset, kMaxmindCity, &out->city,
+                     &out->citylen);
+  } else {
+    out->country = 0;
+    out->countrylen = 0;
+    out->city = 0;
+    out->citylen = 0;
+  }
+  if (line && GetMaxmindNetmask(db, out->netmask) <= MAXMIND_CACHE_NETMASK) {
+    out->key = key;
+    *line = *out;
+  }
+  return 0;
+}
+
+static void LuaPushMaxmindResult(lua_State *L, struct MaxmindDb *db,
+                                 uint32_t ip, struct MaxmindEntry *e) {
+  struct MaxmindResult *r;
+  r = lua_newuserdatauv(L, sizeof(struct MaxmindResult), 0);
+  luaL_setmetatable(L, "MaxmindResult*");
+  r->ip = ip;
+  r->db = db;
+  r->e = *e;
+  db->refs++;
+}
+
 static int LuaMaxmindDbLookup(lua_State *L) {
   int err;
   lua_Integer ip;
+  struct MaxmindEntry e;
   struct MaxmindDb **udb, *db;
-  struct MaxmindResult **ur, *r;
   udb = luaL_checkudata(L, 1, "MaxmindDb*");
   ip = luaL_checkinteger(L, 2);
   if (ip < 0 || ip > 0xffffffff) {
@@ -103,30 +209,76 @@ static int LuaMaxmindDbLookup(lua_State *L) {
     return 1;
   }
   db = *udb;
-  r = xmalloc(sizeof(struct MaxmindResult));
-  r->mmlr = MMDB_lookup(&db->mmdb, ip, &err);
-  if (err) {
-    free(r);
+  if ((err = LookupMaxmind(db, ip, &e))) {
     LuaThrowMaxmindIpError(L, "MMDB_lookup", ip, err);
   }
-  if (!r->mmlr.found_entry) {
-    free(r);
+  if (!e.found) {
     lua_pushnil(L);
     return 1;
   }
-  r->ip = ip;
-  r->db = db;
-  r->db->refs++;
-  ur = lua_newuserdatauv(L, sizeof(r), 1);
-  luaL_setmetatable(L, "MaxmindResult*");
-  *ur = r;
+  LuaPushMaxmindResult(L, db, ip, &e);
+  return 1;
+}
+
+// looks up array of ips, e.g. from a log file, returning an array of
+// the same length, where entries that can't be found are false
+static int LuaMaxmindDbLookupMany(lua_State *L) {
+  int err;
+  lua_Integer i, n, ip;
+  struct MaxmindEntry e;
+  struct MaxmindDb **udb, *db;
+  udb = luaL_checkudata(L, 1, "MaxmindDb*");
+  luaL_checktype(L, 2, LUA_TTABLE);
+  db = *udb;
+  n = luaL_len(L, 2);
+  lua_createtable(L, n, 0);
+  for (i = 1; i <= n; ++i) {
+    lua_geti(L, 2, i);
+    ip = lua_isinteger(L, -1) ? lua_tointeger(L, -1) : -1;
+    lua_pop(L, 1);
+    if (0 <= ip && ip <= 0xffffffff) {
+      if ((err = LookupMaxmind(db, ip, &e))) {
+        LuaThrowMaxmindIpError(L, "MMDB_lookup", ip, err);
+      }
+    } else {
+      e.found = false;
+    }
+    if (e.found) {
+      LuaPushMaxmindResult(L, db, ip, &e);
+    } else {
+      lua_pushboolean(L, false);
+    }
+    lua_seti(L, -2, i);
+  }
   return 1;
 }
 
 static int LuaMaxmindResultNetmask(lua_State *L) {
-  struct MaxmindResult **ur;
-  ur = luaL_checkudata(L, 1, "MaxmindResult*");
-  lua_pushinteger(L, (*ur)->mmlr.netmask - (128 - 32));
+  struct MaxmindResult *r;
+  r = luaL_checkudata(L, 1, "MaxmindResult*");
+  lua_pushinteger(L, GetMaxmindNetmask(r->db, r->e.netmask));
+  return 1;
+}
+
+static int LuaMaxmindResultCountry(lua_State *L) {
+  struct MaxmindResult *r;
+  r = luaL_checkudata(L, 1, "MaxmindResult*");
+  if (r->e.country) {
+    lua_pushlstring(L, r->e.country, r->e.countrylen);
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+static int LuaMaxmindResultCity(lua_State *L) {
+  struct MaxmindResult *r;
+  r = luaL_checkudata(L, 1, "MaxmindResult*");
+  if (r->e.city) {
+    lua_pushlstring(L, r->e.city, r->e.citylen);
+  } else {
+    lua_pushnil(L);
+  }
   return 1;
 }
 
@@ -193,37 +345,35 @@ static MMDB_entry_data_list_s *LuaMaxmindDump(lua_State *L,
 static int LuaMaxmindResultGet(lua_State *L) {
   int i, n, err;
   const char **path;
-  MMDB_entry_s entry, *ep;
+  MMDB_entry_s entry;
   MMDB_entry_data_s edata;
-  struct MaxmindResult **ur;
+  struct MaxmindResult *r;
   MMDB_entry_data_list_s *dl;
   n = lua_gettop(L) - 1;
-  ur = luaL_checkudata(L, 1, "MaxmindResult*");
-  if (n <= 0) {
-    ep = &(*ur)->mmlr.entry;
-  } else {
+  r = luaL_checkudata(L, 1, "MaxmindResult*");
+  entry.mmdb = &r->db->mmdb;
+  entry.offset = r->e.offset;
+  if (n > 0) {
     path = xcalloc(n + 1, sizeof(const char *));
     for (i = 0; i < n; ++i) path[i] = lua_tostring(L, 2 + i);
-    err = MMDB_aget_value(&(*ur)->mmlr.entry, &edata, path);
+    err = MMDB_aget_value(&entry, &edata, path);
     free(path);
     if (err) {
       if (err == MMDB_LOOKUP_PATH_DOES_NOT_MATCH_DATA_ERROR) {
         lua_pushnil(L);
         return 1;
       } else {
-        LuaThrowMaxmindIpError(L, "getpath", (*ur)->ip, err);
+        LuaThrowMaxmindIpError(L, "getpath", r->ip, err);
       }
     }
     if (!edata.offset) {
       lua_pushnil(L);
       return 1;
     }
-    entry.mmdb = (*ur)->mmlr.entry.mmdb;
     entry.offset = edata.offset;
-    ep = &entry;
   }
-  err = MMDB_get_entry_data_list(ep, &dl);
-  if (err) LuaThrowMaxmindIpError(L, "getlist", (*ur)->ip, err);
+  err = MMDB_get_entry_data_list(&entry, &dl);
+  if (err) LuaThrowMaxmindIpError(L, "getlist", r->ip, err);
   LuaMaxmindDump(L, dl);
   MMDB_free_entry_data_list(dl);
   return 1;
@@ -232,6 +382,7 @@ static int LuaMaxmindResultGet(lua_State *L) {
 static void FreeMaxmindDb(struct MaxmindDb *db) {
   if (!--db->refs) {
     MMDB_close(&db->mmdb);
+    free(db->cache);
     free(db);
   }
 }
@@ -247,12 +398,11 @@ static int LuaMaxmindDbGc(lua_State *L) {
 }
 
 static int LuaMaxmindResultGc(lua_State *L) {
-  struct MaxmindResult **ur;
-  ur = luaL_checkudata(L, 1, "MaxmindResult*");
-  if (*ur) {
-    FreeMaxmindDb((*ur)->db);
-    free(*ur);
-    *ur = 0;
+  struct MaxmindResult *r;
+  r = luaL_checkudata(L, 1, "MaxmindResult*");
+  if (r->db) {
+    FreeMaxmindDb(r->db);
+    r->db = 0;
   }
   return 0;
 }
@@ -263,8 +413,9 @@ static const luaL_Reg kLuaMaxmind[] = {
 };
 
 static const luaL_Reg kLuaMaxmindDbMeth[] = {
-    {"lookup", LuaMaxmindDbLookup},  //
-    {0},                             //
+    {"lookup", LuaMaxmindDbLookup},          //
+    {"lookupmany", LuaMaxmindDbLookupMany},  //
+    {0},                                     //
 };
 
 static const luaL_Reg kLuaMaxmindDbMeta[] = {
@@ -273,6 +424,8 @@ static const luaL_Reg kLuaMaxmindDbMeta[] = {
 };
 
 static const luaL_Reg kLuaMaxmindResultMeth[] = {
+    {"city", LuaMaxmindResultCity},        //
+    {"country", LuaMaxmindResultCountry},  //
     {"get", LuaMaxmindResultGet},          //
     {"netmask", LuaMaxmindResultNetmask},  //
     {0},                                   //
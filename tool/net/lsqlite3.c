@@ -2407,6 +2407,7 @@ static int lsqlite_version(lua_State *L) {
 
 static int lsqlite_do_open(lua_State *L, const char *filename, int flags) {
     sqlite3_initialize(); /* initialize the engine if hasn't been done yet */
+    sqlite3_ziposvfs_init(0, 0, 0); /* so "file:/zip/...?vfs=zipos" works */
     sdb *db = newdb(L); /* create and leave in stack */
 
     if (sqlite3_open_v2(filename, &db->db, flags, 0) == SQLITE_OK) {
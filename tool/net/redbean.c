@@ -129,6 +129,7 @@
 #include "third_party/mbedtls/x509.h"
 #include "third_party/mbedtls/x509_crt.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 #include "tool/args/args.h"
 #include "tool/build/lib/case.h"
 #include "tool/net/lfinger.h"
@@ -379,6 +380,11 @@ struct Blackhole {
   int fd;
 } blackhole;
 
+struct WorkerGc {
+  int mode;  // LUA_GCGEN or LUA_GCINC, or 0 to inherit the main process's
+  int args[3];
+} workergc;
+
 static struct Shared {
   int workers;
   struct timespec nowish;
@@ -465,8 +471,10 @@ static bool hasonprocessdestroy;
 static bool ishandlingconnection;
 static bool hasonclientconnection;
 static bool evadedragnetsurveillance;
+static bool gcfreeze;
 
 static int zfd;
+static long gcfrozen;
 static int gmtoff;
 static int client;
 static int mainpid;
@@ -2070,6 +2078,11 @@ static bool ClientAcceptsGzip(void) {
          HeaderHas(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "gzip", 4);
 }
 
+static bool ClientAcceptsZstd(void) {
+  return cpm.msg.version >= 11 && /* RFC8878 § 7.2 */
+         HeaderHas(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "zstd", 4);
+}
+
 char *FormatUnixHttpDateTime(char *s, int64_t t) {
   struct tm tm;
   gmtime_r(&t, &tm);
@@ -2093,6 +2106,11 @@ static int64_t GetGmtOffset(int64_t t) {
 }
 
 forceinline bool IsCompressed(struct Asset *a) {
+  return !a->file &&
+         ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) != kZipCompressionNone;
+}
+
+forceinline bool IsDeflated(struct Asset *a) {
   return !a->file &&
          ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) == kZipCompressionDeflate;
 }
@@ -2102,7 +2120,8 @@ forceinline int GetMode(struct Asset *a) {
 }
 
 forceinline bool IsCompressionMethodSupported(int method) {
-  return method == kZipCompressionNone || method == kZipCompressionDeflate;
+  return method == kZipCompressionNone || method == kZipCompressionDeflate ||
+         method == kZipCompressionZstd;
 }
 
 static inline unsigned Hash(const void *p, unsigned long n) {
@@ -2340,6 +2359,22 @@ static bool Inflate(void *dp, size_t dn, const void *sp, size_t sn) {
   return !__inflate(dp, dn, sp, sn);
 }
 
+static bool Unzstd(void *dp, size_t dn, const void *sp, size_t sn) {
+  size_t rc;
+  LockInc(&shared->c.unzstds);
+  rc = ZSTD_decompress(dp, dn, sp, sn);
+  return !ZSTD_isError(rc) && rc == dn;
+}
+
+static bool Decompress(struct Asset *a, void *dp, size_t dn, const void *sp,
+                       size_t sn) {
+  if (IsDeflated(a)) {
+    return Inflate(dp, dn, sp, sn);
+  } else {
+    return Unzstd(dp, dn, sp, sn);
+  }
+}
+
 static bool Verify(void *data, size_t size, uint32_t crc) {
   uint32_t got;
   LockInc(&shared->c.verifies);
@@ -2380,8 +2415,8 @@ static void *LoadAsset(struct Asset *a, size_t *out_size) {
     size = GetZipLfileUncompressedSize(zmap + a->lf);
     if (size == SIZE_MAX || !(data = malloc(size + 1))) return NULL;
     if (IsCompressed(a)) {
-      if (!Inflate(data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
-                   GetZipCfileCompressedSize(zmap + a->cf))) {
+      if (!Decompress(a, data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
+                      GetZipCfileCompressedSize(zmap + a->cf))) {
         free(data);
         return NULL;
       }
@@ -2540,7 +2575,7 @@ static char *ServeErrorImpl(unsigned code, const char *reason,
     if (IsCompressed(a)) {
       n = GetZipLfileUncompressedSize(zmap + a->lf);
       if ((s = FreeLater(malloc(n))) &&
-          Inflate(s, n, cpm.content, cpm.contentlength)) {
+          Decompress(a, s, n, cpm.content, cpm.contentlength)) {
         cpm.content = s;
         cpm.contentlength = n;
       } else {
@@ -2756,7 +2791,6 @@ static ssize_t InflateGenerator(struct iovec v[3]) {
 static char *ServeAssetDecompressed(struct Asset *a) {
   char *p;
   size_t size;
-  LockInc(&shared->c.inflates);
   LockInc(&shared->c.decompressedresponses);
   size = GetZipCfileUncompressedSize(zmap + a->cf);
   DEBUGF("(srvr) ServeAssetDecompressed(%ld)→%ld", cpm.contentlength, size);
@@ -2764,7 +2798,8 @@ static char *ServeAssetDecompressed(struct Asset *a) {
     cpm.content = 0;
     cpm.contentlength = size;
     return SetStatus(200, "OK");
-  } else if (!IsTiny()) {
+  } else if (!IsTiny() && IsDeflated(a)) {
+    LockInc(&shared->c.inflates);
     dg.t = 0;
     dg.i = 0;
     dg.c = 0;
@@ -2775,7 +2810,7 @@ static char *ServeAssetDecompressed(struct Asset *a) {
     dg.b = FreeLater(malloc(dg.z));
     return SetStatus(200, "OK");
   } else if ((p = FreeLater(malloc(size))) &&
-             Inflate(p, size, cpm.content, cpm.contentlength) &&
+             Decompress(a, p, size, cpm.content, cpm.contentlength) &&
              Verify(p, size, ZIP_CFILE_CRC32(zmap + a->cf))) {
     cpm.content = p;
     cpm.contentlength = size;
@@ -2804,6 +2839,14 @@ static inline char *ServeAssetPrecompressed(struct Asset *a) {
   return SetStatus(200, "OK");
 }
 
+static inline char *ServeAssetPrecompressedZstd(struct Asset *a) {
+  char *p;
+  DEBUGF("(srvr) ServeAssetPrecompressedZstd()");
+  LockInc(&shared->c.precompressedresponses);
+  p = SetStatus(200, "OK");
+  return stpcpy(p, "Content-Encoding: zstd\r\n");
+}
+
 static char *ServeAssetRange(struct Asset *a) {
   char *p;
   long rangestart, rangelength;
@@ -3147,6 +3190,7 @@ static void ServeCounters(void) {
 
 static char *ServeStatusz(void) {
   char *p;
+  struct rusage ru;
   LockInc(&shared->c.statuszrequests);
   if (cpm.msg.method != kHttpGet && cpm.msg.method != kHttpHead) {
     return BadMethod();
@@ -3165,10 +3209,13 @@ static char *ServeStatusz(void) {
   lua_State *L = GL;
   AppendLong1("lua.memory",
               lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB));
+  AppendLong1("lua.frozen", gcfrozen);
 #endif
   ServeCounters();
   AppendRusage("server", &shared->server);
   AppendRusage("children", &shared->children);
+  getrusage(RUSAGE_SELF, &ru);
+  AppendRusage("self", &ru);
   p = SetStatus(200, "OK");
   p = AppendContentType(p, "text/plain");
   if (cpm.msg.version >= 11) {
@@ -4529,6 +4576,28 @@ static int LuaProgramHeartbeatInterval(lua_State *L) {
   return 1;
 }
 
+static int LuaProgramGcFreeze(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramGcFreeze");
+  if (!lua_isboolean(L, 1) && !lua_isnoneornil(L, 1)) {
+    return luaL_argerror(L, 1, "invalid freeze mode; boolean expected");
+  }
+  lua_pushboolean(L, gcfreeze);
+  if (lua_isboolean(L, 1)) gcfreeze = lua_toboolean(L, 1);
+  return 1;
+}
+
+static int LuaProgramWorkerGc(lua_State *L) {
+  static const char *const kModes[] = {"inherit", "generational",
+                                       "incremental", 0};
+  static const int kModeValues[] = {0, LUA_GCGEN, LUA_GCINC};
+  OnlyCallFromInitLua(L, "ProgramWorkerGc");
+  workergc.mode = kModeValues[luaL_checkoption(L, 1, 0, kModes)];
+  workergc.args[0] = luaL_optinteger(L, 2, 0);
+  workergc.args[1] = luaL_optinteger(L, 3, 0);
+  workergc.args[2] = luaL_optinteger(L, 4, 0);
+  return 0;
+}
+
 static int LuaProgramMaxWorkers(lua_State *L) {
   OnlyCallFromMainProcess(L, "ProgramMaxWorkers");
   if (!lua_isinteger(L, 1) && !lua_isnoneornil(L, 1)) {
@@ -5093,6 +5162,7 @@ static const char *const kDontAutoComplete[] = {
     "ProgramAddr",               // TODO
     "ProgramBrand",              //
     "ProgramCertificate",        // TODO
+    "ProgramGcFreeze",           //
     "ProgramGid",                //
     "ProgramLogPath",            // TODO
     "ProgramMaxPayloadSize",     // TODO
@@ -5105,6 +5175,7 @@ static const char *const kDontAutoComplete[] = {
     "ProgramTimeout",            // TODO
     "ProgramUid",                //
     "ProgramUniprocess",         //
+    "ProgramWorkerGc",           //
     "Respond",                   //
     "Route",                     //
     "RouteHost",                 //
@@ -5236,6 +5307,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ProgramCache", LuaProgramCache},                          //
     {"ProgramContentType", LuaProgramContentType},              //
     {"ProgramDirectory", LuaProgramDirectory},                  //
+    {"ProgramGcFreeze", LuaProgramGcFreeze},                    //
     {"ProgramGid", LuaProgramGid},                              //
     {"ProgramHeader", LuaProgramHeader},                        //
     {"ProgramHeartbeatInterval", LuaProgramHeartbeatInterval},  //
@@ -5251,6 +5323,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ProgramTrustedIp", LuaProgramTrustedIp},                  // undocumented
     {"ProgramUid", LuaProgramUid},                              //
     {"ProgramUniprocess", LuaProgramUniprocess},                //
+    {"ProgramWorkerGc", LuaProgramWorkerGc},                    //
     {"Rand64", LuaRand64},                                      //
     {"Rdrand", LuaRdrand},                                      //
     {"Rdseed", LuaRdseed},                                      //
@@ -5551,6 +5624,37 @@ static void LuaInit(void) {
 #endif
 }
 
+// promotes everything the main process has allocated in lua to the
+// old generation, so the minor collections run by forked workers will
+// neither mark nor sweep those objects and their pages stay shared
+static void LuaFreeze(void) {
+#ifndef STATIC
+  lua_State *L = GL;
+  if (!gcfreeze || uniprocess) return;
+  lua_gc(L, LUA_GCGEN, 0, 0);
+  lua_gc(L, LUA_GCCOLLECT);
+  gcfrozen = lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB);
+  DEBUGF("(lua) froze %,ld bytes of lua objects", gcfrozen);
+#endif
+}
+
+static void LuaConfigureWorkerGc(void) {
+#ifndef STATIC
+  lua_State *L = GL;
+  switch (workergc.mode) {
+    case LUA_GCGEN:
+      lua_gc(L, LUA_GCGEN, workergc.args[0], workergc.args[1]);
+      break;
+    case LUA_GCINC:
+      lua_gc(L, LUA_GCINC, workergc.args[0], workergc.args[1],
+             workergc.args[2]);
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
 static void LuaOnServerReload(bool reindex) {
 #ifndef STATIC
   if (!LuaRunAsset("/.reload.lua", false)) {
@@ -5755,6 +5859,7 @@ static void HandleFrag(size_t got) {
 static void HandleReload(void) {
   LockInc(&shared->c.reloads);
   LuaOnServerReload(Reindex());
+  LuaFreeze();
   invalidated = false;
 }
 
@@ -6161,8 +6266,10 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
       return p;
     }
     if (IsCompressed(a)) {
-      if (ClientAcceptsGzip()) {
+      if (IsDeflated(a) && ClientAcceptsGzip()) {
         p = ServeAssetPrecompressed(a);
+      } else if (!IsDeflated(a) && ClientAcceptsZstd()) {
+        p = ServeAssetPrecompressedZstd(a);
       } else {
         p = ServeAssetDecompressed(a);
       }
@@ -6824,6 +6931,7 @@ static int HandleConnection(size_t i) {
           if (sandboxed) {
             CHECK_NE(-1, EnableSandbox());
           }
+          LuaConfigureWorkerGc();
           if (hasonworkerstart) {
             CallSimpleHook("OnWorkerStart");
           }
@@ -7431,6 +7539,7 @@ void RedBean(int argc, char *argv[]) {
   inbuf = inbuf_actual;
   isinitialized = true;
   CallSimpleHookIfDefined("OnServerStart");
+  LuaFreeze();
   if (!IsTiny()) {
     if (monitortty && (daemonize || uniprocess)) {
       monitortty = 0;
@@ -21,11 +21,9 @@
 #include "tool/viz/lib/graphic.h"
 
 void getxtermcodes(struct TtyRgb *p, const struct Graphic *g) {
-  unsigned y, x;
+  unsigned y;
   unsigned char(*img)[3][g->yn][g->xn] = g->b;
-  for (y = 0; y < g->yn; ++y) {
-    for (x = 0; x < g->xn; ++x) {
-      *p++ = rgb2tty((*img)[0][y][x], (*img)[1][y][x], (*img)[2][y][x]);
-    }
+  for (y = 0; y < g->yn; ++y, p += g->xn) {
+    rgb2ttyn(p, (*img)[0][y], (*img)[1][y], (*img)[2][y], g->xn);
   }
 }
@@ -42,6 +42,7 @@
 #include "libc/errno.h"
 #include "libc/fmt/conv.h"
 #include "libc/fmt/itoa.h"
+#include "libc/intrin/atomic.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/intrin/safemacros.internal.h"
 #include "libc/intrin/xchg.internal.h"
@@ -90,6 +91,7 @@
 #include "libc/sysv/consts/w.h"
 #include "libc/sysv/errfuns.h"
 #include "libc/thread/thread.h"
+#include "libc/thread/thread2.h"
 #include "libc/time/time.h"
 #include "libc/x/xsigaction.h"
 #include "third_party/getopt/getopt.internal.h"
@@ -100,6 +102,13 @@
 
 /**
  * @fileoverview MPEG Video Player for Terminal.
+ *
+ * Playback is a three stage pipeline. The decoder thread paces itself
+ * against the wall clock, decoding slices on the fork-join pool, and
+ * copies pictures into a small ring of decoded frames. The scaler
+ * thread turns those into terminal escape codes, and the main thread
+ * writes them to the tty while handling the keyboard. If the scaler
+ * can't keep up, the decoder drops frames rather than falling behind.
  */
 
 #define GAMMADELTA    0.1
@@ -205,11 +214,26 @@ struct NamedVector {
 };
 
 struct VtFrame {
-  size_t i, n;
+  size_t i, n, size;
   union {
     void *b;
     char *bytes;
   };
+  struct timespec start; /* when decoding began */
+  struct timespec ready; /* when scaling finished */
+};
+
+struct DecodedFrame {
+  plm_frame_t f;
+  double par;
+  size_t size;
+  uint8_t *mem;
+  struct timespec start;
+};
+
+struct Ring {
+  unsigned i, n;
+  void *p[4];
 };
 
 struct FrameCountRing {
@@ -258,7 +282,7 @@ static float gamma_;
 static int volscale_;
 static enum Blur blur_;
 static enum Sharp sharp_;
-static jmp_buf jb_, jbi_;
+static jmp_buf jb_;
 static double pary_, parx_;
 static struct TtyIdent ti_;
 static struct YCbCr *ycbcr_;
@@ -277,21 +301,36 @@ static int lumakernel_, chromakernel_;
 static openspeaker_f tryspeakerfns_[4];
 static int primaries_, lighting_, swing_;
 static uint64_t t1, t2, t3, t4, t5, t6, t8;
+static pthread_t decoder_, scaler_;
+static pthread_cond_t cond_ = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t tunelock_ = PTHREAD_MUTEX_INITIALIZER;
+static struct Ring decodedfree_, decodedready_, vtfree_, vtready_;
+static struct DecodedFrame decoded_[2];
+static volatile bool quit_, pipelining_;
+static bool ended_, drained_, hasaudio_;
+static atomic_bool redisplay_, recolor_;
+static atomic_long dropped_, audiolead_, emit_latency_;
+static long scale_latency_;
+static int wakefd_[2];
+static size_t vtsize_;
 static const char *sox_, *ffplay_, *patharg_;
-static struct VtFrame vtframe_[2], *f1_, *f2_;
+static struct VtFrame vtframe_[3], *f1_;
 static struct Graphic graphic_[2], *g1_, *g2_;
 static struct timespec deadline_, dura_, starttime_;
 static bool yes_, stats_, dither_, ttymode_, istango_;
-static struct timespec decode_start_, f1_start_, f2_start_;
+static struct timespec decode_start_;
 static int16_t pcm_[PLM_AUDIO_SAMPLES_PER_FRAME * 2 / 8][8];
 static int16_t pcmscale_[PLM_AUDIO_SAMPLES_PER_FRAME * 2 / 8][8];
-static bool fullclear_, historyclear_, tuned_, yonly_, gotvideo_;
+static bool tuned_, yonly_, gotvideo_;
+static atomic_bool fullclear_, historyclear_;
 static int homerow_, lastrow_, playfd_, infd_, outfd_, speakerfails_;
 static char status_[7][200], logpath_[PATH_MAX], fifopath_[PATH_MAX],
     chansstr_[32], sratestr_[32];
 
 static void OnCtrlC(void) {
-  longjmp(jb_, 1);
+  if (!pipelining_) longjmp(jb_, 1);
+  quit_ = true; /* main thread might hold lock_ */
 }
 
 static void OnResize(void) {
@@ -377,11 +416,27 @@ static bool CloseSpeaker(void) {
   return !!rc;
 }
 
-static void ResizeVtFrame(struct VtFrame *f, size_t yn, size_t xn) {
-  BALLOC(&f->b, 4096, 64 + yn * (xn * 32 + 8), __FUNCTION__);
+static void ResizeVtFrame(struct VtFrame *f, size_t size) {
+  free(f->b);
+  BALLOC(&f->b, 4096, size, __FUNCTION__);
+  f->size = size;
   f->i = f->n = 0;
 }
 
+static void Push(struct Ring *r, void *p) {
+  r->p[(r->i + r->n++) & (ARRAYLEN(r->p) - 1)] = p;
+}
+
+static void *Pop(struct Ring *r) {
+  if (!r->n) return 0;
+  --r->n;
+  return r->p[r->i++ & (ARRAYLEN(r->p) - 1)];
+}
+
+static void Wake(void) {
+  write(wakefd_[1], "", 1);
+}
+
 static float timespec_tofloat(struct timespec ts) {
   return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
@@ -424,7 +479,7 @@ static void DimensionDisplay(void) {
   size_t yn, xn;
   double ratio, height, width;
   do {
-    resized_ = false;
+    redisplay_ = false;
     if (ShouldUseFrameBuffer()) {
       pary_ = 1;
       parx_ = 1;
@@ -458,19 +513,17 @@ static void DimensionDisplay(void) {
     INFOF("%s 𝑑(%hu×%hu)×(%d,%d): 𝑔₁(%zu×%zu,r=%f) → 𝑔₂(%zu×%zu)",
           "DimensionDisplay", wsize_.ws_row, wsize_.ws_col, g1_->yn, g1_->xn,
           ratio, yn, xn);
+    free(xtcodes_);
     BALLOC(&xtcodes_, 64, ((g2_->yn) * g2_->xn + 8) * sizeof(struct TtyRgb),
            "xtcodes_");
-    ResizeVtFrame(&vtframe_[0], (g2_->yn), g2_->xn);
-    ResizeVtFrame(&vtframe_[1], (g2_->yn), g2_->xn);
-    f1_ = &vtframe_[0];
-    f2_ = &vtframe_[1];
+    vtsize_ = 64 + g2_->yn * (g2_->xn * 32 + 8);
     if (ttymode_) {
       homerow_ = MIN(wsize_.ws_row - HALF(g2_->yn),
                      HALF(wsize_.ws_row - HALF(g2_->yn)));
     }
     lastrow_ = homerow_ + HALF(g2_->yn);
     ComputeColoringSolution();
-  } while (resized_);
+  } while (redisplay_);
 }
 
 static int WriteAudio(int fd, const void *data, size_t size, int deadlinems) {
@@ -622,10 +675,10 @@ static char *StartRender(char *vt) {
   return vt;
 }
 
-static void EndRender(char *vt) {
+static void EndRender(struct VtFrame *f, char *vt) {
   vt += sprintf(vt, "\e[0m");
-  f2_->n = (intptr_t)vt - (intptr_t)f2_->b;
-  f2_->i = 0;
+  f->n = (intptr_t)vt - (intptr_t)f->b;
+  f->i = 0;
 }
 
 static bool IsNonZeroFloat(float f) {
@@ -694,7 +747,7 @@ static const char *DescribeSwing(int swing) {
   }
 }
 
-static void RenderIt(void) {
+static void RenderIt(struct VtFrame *f) {
   long bpf;
   double bpc;
   char *vt, *p;
@@ -702,7 +755,7 @@ static void RenderIt(void) {
   struct TtyRgb bg, fg;
   yn = g2_->yn;
   xn = g2_->xn;
-  vt = f2_->b;
+  vt = f->b;
   p = StartRender(vt);
   if (TTYQUANT()->alg == kTtyQuantTrue) {
     bg = (struct TtyRgb){0, 0, 0, 0};
@@ -726,12 +779,15 @@ static void RenderIt(void) {
             kPrimaries[primaries_].name, DescribeSwing(swing_),
             kLightings[lighting_].name, plm_get_width(plm_),
             plm_get_height(plm_), g2_->xn, g2_->yn);
-    sprintf(status_[5], " decode:%,8luµs | magikarp:%,8luµs ",
-            plmpegdecode_latency_, magikarp_latency_);
-    sprintf(status_[1], " ycbcr2rgb:%,8luµs | gyarados:%,8luµs ",
-            ycbcr2rgb_latency_, gyarados_latency_);
-    sprintf(status_[0], " fx:%,ldµs %.6fbpc %,ldbpf %.6ffps ",
-            lroundl(t6 / 1e3L), bpc, bpf, (size_t)(p - vt), MeasureFrameRate());
+    sprintf(status_[5], " decode:%,8luµs | scale:%,8luµs | emit:%,8luµs ",
+            plmpegdecode_latency_, scale_latency_,
+            atomic_load_explicit(&emit_latency_, memory_order_relaxed));
+    sprintf(status_[1],
+            " ycbcr2rgb:%,8luµs | magikarp:%,8luµs | gyarados:%,8luµs ",
+            ycbcr2rgb_latency_, magikarp_latency_, gyarados_latency_);
+    sprintf(status_[0], " fx:%,ldµs %.6fbpc %,ldbpf %.6ffps %,ld dropped ",
+            lroundl(t6 / 1e3L), bpc, bpf, MeasureFrameRate(),
+            atomic_load_explicit(&dropped_, memory_order_relaxed));
     sprintf(status_[2], " gamma:%.1f %hu columns × %hu lines of text ", gamma_,
             wsize_.ws_col, wsize_.ws_row);
     DescribeAlgorithms(status_[3]);
@@ -758,7 +814,7 @@ static void RenderIt(void) {
     p += sprintf(p, "\e[%d;%dH %s ", lastrow_ - 1, 2,
                  "by justine tunney <jtunney@gmail.com>");
   }
-  EndRender(p);
+  EndRender(f, p);
 }
 
 static void RasterIt(void) {
@@ -774,18 +830,21 @@ static void RasterIt(void) {
   memcpy(fb0_.map, buf, fb0_.size);
 }
 
-static void TranscodeVideo(plm_frame_t *pf) {
+static void TranscodeVideo(struct DecodedFrame *d, struct VtFrame *f) {
+  plm_frame_t *pf = &d->f;
   CHECK_EQ(pf->cb.width, pf->cr.width);
   CHECK_EQ(pf->cb.height, pf->cr.height);
-  DEBUGF("TranscodeVideo() [grace=%,ldns]", timespec_tonanos(GetGraceTime()));
+  DEBUGF("TranscodeVideo()");
   g2_ = &graphic_[1];
   t5 = 0;
+  if (f->size < vtsize_) ResizeVtFrame(f, vtsize_);
+  f->i = f->n = 0;
 
   TIMEIT(t1, {
     pary_ = 2;
     if (pf1_) pary_ = 1.;
     if (pf2_) pary_ = (266 / 64.) * (900 / 1600.);
-    pary_ *= plm_get_pixel_aspect_ratio(plm_);
+    pary_ *= d->par;
     YCbCr2RgbScale(g2_->yn, g2_->xn, g2_->b, pf->y.height, pf->y.width,
                    (void *)pf->y.data, pf->cr.height, pf->cr.width,
                    (void *)pf->cb.data, (void *)pf->cr.data, pf->y.height,
@@ -828,7 +887,7 @@ static void TranscodeVideo(plm_frame_t *pf) {
     TIMEIT(t4, RasterIt());
   } else {
     TIMEIT(t3, getxtermcodes(xtcodes_, g2_));
-    TIMEIT(t4, RenderIt());
+    TIMEIT(t4, RenderIt(f));
   }
 
   INFOF("𝑓%zu(%u×%u) %,zub (%f BPP) "
@@ -838,24 +897,53 @@ static void TranscodeVideo(plm_frame_t *pf) {
         "fx=%,zuns "
         "quantize=%,zuns "
         "render=%,zuns",
-        framecount_++, g2_->yn, g2_->xn, f2_->n,
-        (f1_->n / (double)(g2_->yn * g2_->xn)), t1, t2, t8, t6, t3, t4);
+        framecount_++, g2_->yn, g2_->xn, f->n,
+        (f->n / (double)(g2_->yn * g2_->xn)), t1, t2, t8, t6, t3, t4);
+}
+
+static uint8_t *CopyPlane(plm_plane_t *dst, const plm_plane_t *src,
+                          uint8_t *p) {
+  *dst = *src;
+  dst->data = p;
+  return mempcpy(p, src->data, src->width * src->height);
+}
+
+static void CopyFrame(struct DecodedFrame *d, const plm_frame_t *pf) {
+  size_t n;
+  uint8_t *p;
+  n = pf->y.width * pf->y.height + pf->cr.width * pf->cr.height * 2;
+  if (d->size < n) {
+    free(d->mem);
+    CHECK_NOTNULL((d->mem = malloc(n)));
+    d->size = n;
+  }
+  d->f = *pf;
+  p = CopyPlane(&d->f.y, &pf->y, d->mem);
+  p = CopyPlane(&d->f.cr, &pf->cr, p);
+  p = CopyPlane(&d->f.cb, &pf->cb, p);
 }
 
+/**
+ * Hands decoded picture to scaler thread, or drops it if it's behind.
+ */
 static void OnVideo(plm_t *mpeg, plm_frame_t *pf, void *user) {
+  struct DecodedFrame *d;
   gotvideo_ = true;
-  if (f2_->n) {
+  pthread_mutex_lock(&lock_);
+  d = Pop(&decodedfree_);
+  pthread_mutex_unlock(&lock_);
+  if (!d) {
+    atomic_fetch_add_explicit(&dropped_, 1, memory_order_relaxed);
     WARNF("video frame dropped");
-  } else {
-    TranscodeVideo(pf);
-    if (!f1_->n) {
-      struct VtFrame *t = f1_;
-      f1_ = f2_, f2_ = t;
-      f1_start_ = decode_start_;
-    } else {
-      f2_start_ = decode_start_;
-    }
+    return;
   }
+  CopyFrame(d, pf);
+  d->par = plm_get_pixel_aspect_ratio(mpeg);
+  d->start = decode_start_;
+  pthread_mutex_lock(&lock_);
+  Push(&decodedready_, d);
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&lock_);
 }
 
 static void OpenVideo(void) {
@@ -872,34 +960,51 @@ static void OpenVideo(void) {
   plm_set_video_decode_callback(plm_, OnVideo, NULL);
   plm_set_audio_decode_callback(plm_, OnAudio, NULL);
   plm_set_loop(plm_, false);
+  plm_set_slice_threading(plm_, true);
   FormatInt64(chansstr_, (chans_ = 2));
   FormatInt64(sratestr_, (srate_ = plm_get_samplerate(plm_)));
   if (plm_get_num_audio_streams(plm_) && OpenSpeaker()) {
     plm_set_audio_enabled(plm_, true, 0);
+    hasaudio_ = true;
   } else {
     plm_set_audio_enabled(plm_, false, 0);
   }
   g2_ = g1_ = resizegraphic(&graphic_[0], yn, xn);
 }
 
+/**
+ * Returns fully written frame to scaler thread.
+ */
+static void FinishVideo(void) {
+  struct timespec now;
+  now = timespec_real();
+  if (hasaudio_) {
+    atomic_store_explicit(
+        &audiolead_,
+        max(0, min(timespec_tomicros(timespec_sub(now, f1_->start)),
+                   1000000L * srate_ /
+                       PLM_AUDIO_SAMPLES_PER_FRAME)),
+        memory_order_relaxed);
+  }
+  atomic_store_explicit(&emit_latency_,
+                        timespec_tomicros(timespec_sub(now, f1_->ready)),
+                        memory_order_relaxed);
+  RecordFactThatFrameWasFullyRendered();
+  f1_->i = f1_->n = 0;
+  pthread_mutex_lock(&lock_);
+  Push(&vtfree_, f1_);
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&lock_);
+  f1_ = 0;
+}
+
 static ssize_t WriteVideoCall(void) {
   size_t amt;
   ssize_t rc;
   amt = min(4096 * 4, f1_->n - f1_->i);
   if ((rc = write(outfd_, f1_->bytes + f1_->i, amt)) != -1) {
     if ((f1_->i += rc) == f1_->n) {
-      if (plm_get_audio_enabled(plm_)) {
-        plm_set_audio_lead_time(
-            plm_,
-            max(0,
-                min(timespec_tofloat(timespec_sub(timespec_real(), f1_start_)),
-                    plm_get_samplerate(plm_) / PLM_AUDIO_SAMPLES_PER_FRAME)));
-      }
-      f1_start_ = f2_start_;
-      f1_->i = f1_->n = 0;
-      struct VtFrame *t = f1_;
-      f1_ = f2_, f2_ = t;
-      RecordFactThatFrameWasFullyRendered();
+      FinishVideo();
     }
   }
   return rc;
@@ -910,20 +1015,15 @@ static void DrainVideo(void) {
     ttywrite(outfd_, f1_->bytes + f1_->i, f1_->n - f1_->i);
     f1_->i = f1_->n = 0;
   }
-  if (f2_ && f2_->n) {
-    f2_->i = f2_->n = 0;
-  }
 }
 
 static void WriteVideo(void) {
   ssize_t rc;
-  DEBUGF("write(tty) grace=%,ldns", timespec_tonanos(GetGraceTime()));
+  DEBUGF("write(tty)");
   if ((rc = WriteVideoCall()) != -1) {
-    DEBUGF("write(tty) → %zd [grace=%,ldns]", rc,
-           timespec_tonanos(GetGraceTime()));
+    DEBUGF("write(tty) → %zd", rc);
   } else if (errno == EAGAIN || errno == EINTR) {
     DEBUGF("write(tty) → EINTR");
-    longjmp(jbi_, 1);
   } else if (errno == EPIPE) {
     DEBUGF("write(tty) → EPIPE");
     longjmp(jb_, 1);
@@ -934,8 +1034,7 @@ static void WriteVideo(void) {
 
 static void RefreshDisplay(void) {
   if (f1_ && f1_->n) f1_->i = 0;
-  DimensionDisplay();
-  resized_ = false;
+  redisplay_ = true;
   historyclear_ = true;
   ttysend(outfd_, "\e[0m\e[H\e[3J");
 }
@@ -999,6 +1098,8 @@ static optimizesize void ReadKeyboard(void) {
   memset(b, -1, sizeof(b));
   b[0] = CTRL('B'); /* for eof case */
   if ((n = read(infd_, &b, sizeof(b))) != -1) {
+    /* the scaler thread reads these settings while it transcodes */
+    pthread_mutex_lock(&tunelock_);
     for (;;) {
       i = 0;
       c = b[i++];
@@ -1007,27 +1108,27 @@ static optimizesize void ReadKeyboard(void) {
         switch (c) {
           case 'Y':
             yonly_ = !yonly_;
-            ComputeColoringSolution();
+            recolor_ = true;
             break;
           case 'S':
             swing_ = swing_ == 219 ? 255 : 219;
-            ComputeColoringSolution();
+            recolor_ = true;
             break;
           case 'p':
           case 'P':
             primaries_ = MOD(sgn + primaries_, ARRAYLEN(kPrimaries));
-            ComputeColoringSolution();
+            recolor_ = true;
             break;
           case 'l':
           case 'L':
             lighting_ = MOD(sgn + lighting_, ARRAYLEN(kLightings));
-            ComputeColoringSolution();
+            recolor_ = true;
             break;
           case 'g':
           case 'G':
             gamma_ += sgn * GAMMADELTA;
             g_xterm256_gamma += sgn * GAMMADELTA;
-            ComputeColoringSolution();
+            recolor_ = true;
             break;
           case 'k':
           case 'K':
@@ -1041,11 +1142,14 @@ static optimizesize void ReadKeyboard(void) {
             break;
           case 'q':
           case CTRL('C'):
+            pthread_mutex_unlock(&tunelock_);
             longjmp(jb_, 1);
             break;
           case CTRL('Z'):
             ttyshowcursor(outfd_);
+            pthread_mutex_unlock(&tunelock_);
             raise(SIGSTOP);
+            pthread_mutex_lock(&tunelock_);
             break;
           case CTRL('G'):
             sharp_ = (sharp_ + 1) % kSharpMAX;
@@ -1058,6 +1162,7 @@ static optimizesize void ReadKeyboard(void) {
             break;
           case '\e':
             if (n == 1) {
+              pthread_mutex_unlock(&tunelock_);
               longjmp(jb_, 1); /* \e <𝟷𝟶𝟶ms*VTIME> is ESC */
             }
             switch (b[i++]) {
@@ -1271,23 +1376,23 @@ static optimizesize void ReadKeyboard(void) {
         memmove(b, b + i, sizeof(b) - i);
       }
     }
-  } else if (errno == EINTR) {
-    longjmp(jbi_, 1);
+    pthread_mutex_unlock(&tunelock_);
   }
 }
 
 static void PerformBestEffortIo(void) {
-  int toto, pollms;
+  int toto;
+  char buf[64];
   struct pollfd fds[] = {
       {infd_, POLLIN},
       {outfd_, f1_ && f1_->n ? POLLOUT : 0},
+      {wakefd_[0], POLLIN},
   };
-  pollms = MAX(0, timespec_tomillis(GetGraceTime()));
-  DEBUGF("poll() ms=%,d", pollms);
-  if ((toto = poll(fds, ARRAYLEN(fds), pollms)) != -1) {
-    DEBUGF("poll() toto=%d [grace=%,ldns]", toto,
-           timespec_tonanos(GetGraceTime()));
+  DEBUGF("poll()");
+  if ((toto = poll(fds, ARRAYLEN(fds), -1)) != -1) {
+    DEBUGF("poll() toto=%d", toto);
     if (toto) {
+      if (fds[2].revents & POLLIN) read(wakefd_[0], buf, sizeof(buf));
       if (fds[0].revents & (POLLIN | POLLERR)) ReadKeyboard();
       if (fds[1].revents & (POLLOUT | POLLERR)) WriteVideo();
     }
@@ -1307,25 +1412,33 @@ static void RestoreTty(void) {
 }
 
 static void HandleSignals(void) {
-  if (piped_) {
-    WARNF("SIGPIPE");
-    CloseSpeaker();
-    piped_ = false;
+  if (quit_) {
+    longjmp(jb_, 1);
   }
   if (resized_) {
+    resized_ = false;
     RefreshDisplay();
   }
 }
 
-static void PrintVideo(void) {
+/**
+ * Decodes video at its natural pace on a dedicated thread.
+ */
+static void *DecodeWorker(void *arg) {
   struct timespec decode_last, decode_end, next_tick, lag;
-  dura_ = timespec_frommicros(min(MAX_FRAMERATE, 1 / plm_get_framerate(plm_)) *
-                              1e6);
-  INFOF("framerate=%f dura=%f", plm_get_framerate(plm_), dura_);
   next_tick = deadline_ = decode_last = timespec_real();
   next_tick = timespec_add(next_tick, dura_);
   deadline_ = timespec_add(deadline_, dura_);
-  do {
+  while (!quit_ && !plm_has_ended(plm_)) {
+    if (piped_) {
+      WARNF("SIGPIPE");
+      CloseSpeaker();
+      piped_ = false;
+    }
+    if (hasaudio_) {
+      plm_set_audio_lead_time(
+          plm_, atomic_load_explicit(&audiolead_, memory_order_relaxed) / 1e6);
+    }
     DEBUGF("plm_decode [grace=%,ldns]", timespec_tonanos(GetGraceTime()));
     decode_start_ = timespec_real();
     plm_decode(plm_,
@@ -1339,16 +1452,111 @@ static void PrintVideo(void) {
     deadline_ = timespec_sub(next_tick, lag);
     if (gotvideo_ || !plm_get_video_enabled(plm_)) {
       gotvideo_ = false;
-      INFOF("entering printvideo event loop (lag=%,ldns, grace=%,ldns)",
+      INFOF("decoded picture (lag=%,ldns, grace=%,ldns)",
             timespec_tonanos(lag), timespec_tonanos(GetGraceTime()));
     }
-    do {
-      if (!setjmp(jbi_)) {
-        PerformBestEffortIo();
+    pthread_mutex_lock(&lock_);
+    while (!quit_ &&
+           pthread_cond_timedwait(&cond_, &lock_, &deadline_) != ETIMEDOUT) {
+    }
+    pthread_mutex_unlock(&lock_);
+  }
+  pthread_mutex_lock(&lock_);
+  ended_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&lock_);
+  return 0;
+}
+
+/**
+ * Turns decoded pictures into terminal escape codes on a dedicated thread.
+ */
+static void *ScaleWorker(void *arg) {
+  struct VtFrame *f;
+  struct timespec start;
+  struct DecodedFrame *d;
+  pthread_mutex_lock(&lock_);
+  for (;;) {
+    while (!quit_ && !(ended_ && !decodedready_.n) &&
+           !(decodedready_.n && vtfree_.n)) {
+      pthread_cond_wait(&cond_, &lock_);
+    }
+    if (quit_ || (ended_ && !decodedready_.n)) break;
+    d = Pop(&decodedready_);
+    f = Pop(&vtfree_);
+    pthread_mutex_unlock(&lock_);
+    pthread_mutex_lock(&tunelock_);
+    if (redisplay_) DimensionDisplay();
+    if (atomic_exchange(&recolor_, false)) ComputeColoringSolution();
+    start = timespec_real();
+    TranscodeVideo(d, f);
+    pthread_mutex_unlock(&tunelock_);
+    f->start = d->start;
+    f->ready = timespec_real();
+    scale_latency_ = timespec_tomicros(timespec_sub(f->ready, start));
+    pthread_mutex_lock(&lock_);
+    Push(&decodedfree_, d);
+    Push(&vtready_, f);
+    Wake();
+  }
+  drained_ = true;
+  pthread_mutex_unlock(&lock_);
+  Wake();
+  return 0;
+}
+
+static void StartPipeline(void) {
+  int i;
+  sigset_t block, old;
+  CHECK_NE(-1, pipe2(wakefd_, O_CLOEXEC | O_NONBLOCK));
+  for (i = 0; i < ARRAYLEN(decoded_); ++i) Push(&decodedfree_, decoded_ + i);
+  for (i = 0; i < ARRAYLEN(vtframe_); ++i) Push(&vtfree_, vtframe_ + i);
+  sigfillset(&block);
+  pthread_sigmask(SIG_SETMASK, &block, &old);
+  CHECK_EQ(0, pthread_create(&decoder_, 0, DecodeWorker, 0));
+  CHECK_EQ(0, pthread_create(&scaler_, 0, ScaleWorker, 0));
+  pthread_sigmask(SIG_SETMASK, &old, 0);
+  pipelining_ = true;
+}
+
+static void StopPipeline(void) {
+  if (!pipelining_) return;
+  pthread_mutex_lock(&lock_);
+  quit_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&lock_);
+  pthread_join(decoder_, 0);
+  pthread_join(scaler_, 0);
+  pipelining_ = false;
+  close(wakefd_[0]);
+  close(wakefd_[1]);
+  INFOF("dropped %,ld frames", atomic_load(&dropped_));
+}
+
+/**
+ * Writes scaled frames to the terminal as they become ready.
+ */
+static void PrintVideo(void) {
+  bool done;
+  dura_ = timespec_frommicros(min(MAX_FRAMERATE, 1 / plm_get_framerate(plm_)) *
+                              1e6);
+  INFOF("framerate=%f dura=%f", plm_get_framerate(plm_), dura_);
+  StartPipeline();
+  for (;;) {
+    HandleSignals();
+    if (!f1_) {
+      pthread_mutex_lock(&lock_);
+      f1_ = Pop(&vtready_);
+      done = !f1_ && drained_;
+      pthread_mutex_unlock(&lock_);
+      if (done) break;
+      if (f1_ && !f1_->n) {
+        FinishVideo(); /* frame buffer mode */
+        continue;
       }
-      HandleSignals();
-    } while (timespec_tomillis(GetGraceTime()) > 0);
-  } while (plm_ && !plm_has_ended(plm_));
+    }
+    PerformBestEffortIo();
+  }
 }
 
 static bool AskUserYesOrNoQuestion(const char *prompt) {
@@ -1411,6 +1619,7 @@ static void GetOpts(int argc, char *argv[]) {
 }
 
 static void OnExit(void) {
+  StopPipeline();
   if (playpid_) kill(playpid_, SIGTERM), sched_yield();
   if (plm_) plm_destroy(plm_), plm_ = NULL;
   YCbCrFree(&ycbcr_);
@@ -1422,6 +1631,9 @@ static void OnExit(void) {
   free(graphic_[1].b);
   free(vtframe_[0].b);
   free(vtframe_[1].b);
+  free(vtframe_[2].b);
+  free(decoded_[0].mem);
+  free(decoded_[1].mem);
   free(xtcodes_);
   free(audio_);
   CloseSpeaker();